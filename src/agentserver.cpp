@@ -0,0 +1,477 @@
+#include "agentserver.h"
+
+#define STATS_INTERVAL 1000
+
+// How long (in ms) a new connection has to say hello before it's dropped.
+#define HELLO_TIMEOUT 5000
+
+// Slowest and heaviest resources printed along with the stats.
+#define TOP_RESOURCES 3
+
+static bool isTokenValid(const QByteArray &bytGiven,const QByteArray &bytExpected) {
+    char cDifference=bytGiven.size()!=bytExpected.size();
+    // Every byte is compared, so the time taken tells nothing of the token.
+    for(int iK=0;iK<bytExpected.size();iK++)
+        cDifference|=bytExpected.at(iK)^(iK<bytGiven.size()?bytGiven.at(iK):0);
+    return !cDifference&&!bytExpected.isEmpty();
+}
+
+AgentServer::AgentServer(QObject *objParent):
+QObject(objParent) {
+    sToken.clear();
+    tcpCoordinator=nullptr;
+    viLinkIndexes.clear();
+    viProxyIndexes.clear();
+    connect(
+        &tcsServer,
+        &QTcpServer::newConnection,
+        this,
+        &AgentServer::coordinatorConnected
+    );
+    connect(
+        &tmrStats,
+        &QTimer::timeout,
+        this,
+        &AgentServer::statsTimeout
+    );
+    connect(
+        &engEngine,
+        &HitEngine::hitFinished,
+        this,
+        &AgentServer::hitChanged
+    );
+    connect(
+        &engEngine,
+        &HitEngine::statusChanged,
+        this,
+        &AgentServer::hitChanged
+    );
+}
+
+AgentServer::~AgentServer() {
+    if(engEngine.isRunning())
+        engEngine.stop();
+}
+
+void AgentServer::handleMessage(QJsonObject jsoMessage) {
+    QString sCommand=jsoMessage.value(QStringLiteral("cmd")).toString();
+    if(QStringLiteral("start")==sCommand)
+        this->start(jsoMessage);
+    else if(QStringLiteral("rate")==sCommand) {
+        engEngine.setMaxCooldown(jsoMessage.value(QStringLiteral("cooldown")).toInt());
+        engEngine.setMaxWorkers(qMax(1,jsoMessage.value(QStringLiteral("workers")).toInt()));
+        engEngine.setMemoryBudget(uint(qMax(0,jsoMessage.value(QStringLiteral("memory")).toInt())));
+    }
+    else if(QStringLiteral("reload")==sCommand)
+        this->reload(jsoMessage);
+    else if(QStringLiteral("stop")==sCommand)
+        this->stop();
+    else
+        this->sendError(QStringLiteral("Unknown command: %1").arg(sCommand));
+}
+
+bool AgentServer::listen(const QHostAddress &hadAddress,quint16 uiPort,QString &sError) {
+    if(sToken.isEmpty()) {
+        sError=QStringLiteral("A token is required");
+        return false;
+    }
+    if(!tcsServer.listen(hadAddress,uiPort)) {
+        sError=tcsServer.errorString();
+        return false;
+    }
+    return true;
+}
+
+void AgentServer::readLists(const QJsonObject &jsoMessage,
+                            LinkStore         &llLinks,
+                            ProxyList         &plProxies,
+                            QVector<uint>     &viLinks,
+                            QVector<uint>     &viProxies) {
+    QString sError;
+    // Records are renumbered locally, the coordinator's indexes are kept aside.
+    for(const auto &v:jsoMessage.value(QStringLiteral("links")).toArray()) {
+        LinkStore llLink=HitEngine::getLinksFromText(v.toArray().at(1).toString(),sError);
+        // Links that don't fit are left out, like those that don't parse.
+        if(!llLink.isEmpty())
+            if(llLinks.append(llLink.getUrl(0),llLink.getAssertions(0),llLink.getTemplate(0)))
+                viLinks.append(v.toArray().at(0).toInt());
+    }
+    for(const auto &v:jsoMessage.value(QStringLiteral("proxies")).toArray()) {
+        ProxyList plProxy=HitEngine::getProxiesFromText(v.toArray().at(1).toString());
+        if(!plProxy.isEmpty()) {
+            plProxy[0].uiIndex=plProxies.count();
+            plProxies.append(plProxy.at(0));
+            viProxies.append(v.toArray().at(0).toInt());
+        }
+    }
+}
+
+void AgentServer::rejectClient(QTcpSocket *tcpClient,QString sReason) {
+    QTextStream(stdout) << QStringLiteral("Connection from %1 rejected: %2").arg(
+        tcpClient->peerAddress().toString(),
+        sReason
+    ) << Qt::endl;
+    RemoteProtocol::writeMessage(
+        tcpClient,
+        {
+            {QStringLiteral("evt"),QStringLiteral("error")},
+            {QStringLiteral("message"),sReason}
+        }
+    );
+    tcpClient->disconnect(this);
+    tcpClient->disconnectFromHost();
+}
+
+void AgentServer::reload(QJsonObject jsoMessage) {
+    LinkStore     llLinks;
+    ProxyList     plProxies={};
+    QVector<uint> viNewLinkIndexes,
+                  viNewProxyIndexes;
+    QVector<int>  viLinkSlots,
+                  viProxySlots;
+    QStringList   slAgents;
+    QString       sError;
+    if(!engEngine.isRunning()) {
+        this->sendError(QStringLiteral("Nothing to reload"));
+        return;
+    }
+    this->readLists(jsoMessage,llLinks,plProxies,viNewLinkIndexes,viNewProxyIndexes);
+    for(const auto &a:jsoMessage.value(QStringLiteral("agents")).toArray())
+        slAgents.append(a.toString());
+    // An empty share is fine here: the agent idles until the next reload.
+    if(!engEngine.reload(
+        llLinks,
+        plProxies,
+        HitEngine::getUserAgentsFromText(slAgents.join(QStringLiteral("\n"))),
+        viLinkSlots,
+        viProxySlots,
+        sError)) {
+        this->sendError(sError);
+        return;
+    }
+    // Retired records keep their index, so their last totals still merge.
+    for(int iK=0;iK<viLinkSlots.count();iK++) {
+        if(viLinkSlots.at(iK)>=viLinkIndexes.count())
+            viLinkIndexes.resize(viLinkSlots.at(iK)+1);
+        viLinkIndexes[viLinkSlots.at(iK)]=viNewLinkIndexes.at(iK);
+    }
+    for(int iK=0;iK<viProxySlots.count();iK++) {
+        if(viProxySlots.at(iK)>=viProxyIndexes.count())
+            viProxyIndexes.resize(viProxySlots.at(iK)+1);
+        viProxyIndexes[viProxySlots.at(iK)]=viNewProxyIndexes.at(iK);
+    }
+    QTextStream(stdout) << QStringLiteral("Reloaded: %1 links, %2 proxies").arg(
+        llLinks.count()
+    ).arg(
+        plProxies.count()
+    ) << Qt::endl;
+}
+
+void AgentServer::sendError(QString sMessage) {
+    if(nullptr!=tcpCoordinator)
+        RemoteProtocol::writeMessage(
+            tcpCoordinator,
+            {
+                {QStringLiteral("evt"),QStringLiteral("error")},
+                {QStringLiteral("message"),sMessage}
+            }
+        );
+}
+
+void AgentServer::sendStats() {
+    const LinkStore &llLinks=engEngine.getLinks();
+    const ProxyList &plProxies=engEngine.getProxies();
+    QJsonArray      jsaLinks,
+                    jsaProxies;
+    // Only what changed since the last report is sent, as totals.
+    for(const auto &i:setDirtyLinks) {
+        const LinkRecord &lrLink=llLinks.at(i);
+        jsaLinks.append(
+            QJsonArray({
+                int(viLinkIndexes.at(i)),
+                double(lrLink.uiHits),
+                double(lrLink.uiErrors),
+                double(lrLink.uiFailures),
+                double(lrLink.uiCancels),
+                double(lrLink.uiRetries),
+                double(lrLink.uiRevalidations),
+                ErrorTaxonomy::getJsonFromCounts(llLinks.getErrors(i)),
+                llLinks.getLatency(i).toJson(),
+                QJsonArray({double(llLinks.getTraffic(i).uiSent),double(llLinks.getTraffic(i).uiReceived)})
+            })
+        );
+    }
+    for(const auto &i:setDirtyProxies) {
+        const ProxyRecord &prProxy=plProxies.at(i);
+        jsaProxies.append(
+            QJsonArray({
+                int(viProxyIndexes.at(i)),
+                double(prProxy.uiHits),
+                double(prProxy.uiErrors),
+                double(prProxy.uiCancels),
+                ErrorTaxonomy::getJsonFromCounts(prProxy.ecsErrors),
+                prProxy.lhLatency.toJson(),
+                QJsonArray({double(prProxy.tcTraffic.uiSent),double(prProxy.tcTraffic.uiReceived)})
+            })
+        );
+    }
+    setDirtyLinks.clear();
+    setDirtyProxies.clear();
+    if(nullptr!=tcpCoordinator&&(!jsaLinks.isEmpty()||!jsaProxies.isEmpty()))
+        RemoteProtocol::writeMessage(
+            tcpCoordinator,
+            {
+                {QStringLiteral("evt"),QStringLiteral("stats")},
+                {QStringLiteral("links"),jsaLinks},
+                {QStringLiteral("proxies"),jsaProxies}
+            }
+        );
+}
+
+void AgentServer::setToken(QString sNewToken) {
+    sToken=sNewToken;
+}
+
+void AgentServer::start(QJsonObject jsoMessage) {
+    LinkStore        llLinks;
+    ProxyList        plProxies={};
+    ScenarioStepList sslSteps={};
+    QString          sScenario=jsoMessage.value(QStringLiteral("scenario")).toString(),
+                     sError;
+    QStringList      slAgents;
+    if(engEngine.isRunning())
+        engEngine.stop();
+    tmrStats.stop();
+    viLinkIndexes.clear();
+    viProxyIndexes.clear();
+    setDirtyLinks.clear();
+    setDirtyProxies.clear();
+    // Scenarios come with no links: every agent runs all the steps.
+    this->readLists(jsoMessage,llLinks,plProxies,viLinkIndexes,viProxyIndexes);
+    if(!sScenario.isEmpty()) {
+        if(!ScenarioParser::getStepsFromText(sScenario,sslSteps,sError)) {
+            this->sendError(sError);
+            return;
+        }
+        llLinks=HitEngine::getLinksFromSteps(sslSteps);
+        for(const auto &l:llLinks)
+            viLinkIndexes.append(l.uiIndex);
+    }
+    if(llLinks.isEmpty()) {
+        this->sendError(QStringLiteral("At least one link is required"));
+        return;
+    }
+    for(const auto &a:jsoMessage.value(QStringLiteral("agents")).toArray())
+        slAgents.append(a.toString());
+    engEngine.setLinks(std::move(llLinks));
+    engEngine.setProxies(plProxies);
+    engEngine.setSteps(sslSteps);
+    engEngine.setAgents(HitEngine::getUserAgentsFromText(slAgents.join(QStringLiteral("\n"))));
+    engEngine.setMode(
+        QStringLiteral("browser")==jsoMessage.value(QStringLiteral("mode")).toString()?
+        BrowserWorker::RunMode::RM_WEB_ENGINE:BrowserWorker::RunMode::RM_NETWORK
+    );
+    if(jsoMessage.value(QStringLiteral("warmProfile")).toBool()) {
+        QString sFolder=QStringLiteral("%1/profiles").arg(
+            QStandardPaths::writableLocation(
+                QStandardPaths::StandardLocation::AppDataLocation
+            )
+        );
+        QDir().mkpath(sFolder);
+        engEngine.setProfilePath(sFolder);
+    }
+    else
+        engEngine.setProfilePath(QString());
+    // HAR files are kept on the agent's machine, next to its profiles.
+    if(jsoMessage.value(QStringLiteral("resources")).toBool()&&
+       jsoMessage.value(QStringLiteral("har")).toInt()>0) {
+        QString sFolder=QStringLiteral("%1/har").arg(
+            QStandardPaths::writableLocation(
+                QStandardPaths::StandardLocation::AppDataLocation
+            )
+        );
+        QDir().mkpath(sFolder);
+        engEngine.setResources(true,jsoMessage.value(QStringLiteral("har")).toInt(),sFolder);
+    }
+    else
+        engEngine.setResources(jsoMessage.value(QStringLiteral("resources")).toBool(),0,QString());
+    engEngine.setMaxCooldown(jsoMessage.value(QStringLiteral("cooldown")).toInt());
+    engEngine.setMaxWorkers(qMax(1,jsoMessage.value(QStringLiteral("workers")).toInt()));
+    engEngine.setMemoryBudget(uint(qMax(0,jsoMessage.value(QStringLiteral("memory")).toInt())));
+    engEngine.setCompletion(
+        jsoMessage.value(QStringLiteral("until")).toString(),
+        jsoMessage.value(QStringLiteral("content")).toBool(true)
+    );
+    engEngine.setNetworkPolicy({
+        uint(qMax(0,jsoMessage.value(QStringLiteral("connectTimeout")).toInt())),
+        uint(qMax(0,jsoMessage.value(QStringLiteral("firstByteTimeout")).toInt())),
+        uint(qMax(0,jsoMessage.value(QStringLiteral("totalTimeout")).toInt())),
+        uint(qMax(0,jsoMessage.value(QStringLiteral("retries")).toInt())),
+        uint(qMax(0,jsoMessage.value(QStringLiteral("retryBudget")).toInt())),
+        jsoMessage.value(QStringLiteral("revalidate")).toBool(),
+        uint(qMax(0,jsoMessage.value(QStringLiteral("coldHits")).toInt())),
+        jsoMessage.value(QStringLiteral("resumeTls")).toBool(true),
+        jsoMessage.value(QStringLiteral("rawEngine")).toBool(),
+        uint(qMax(1,jsoMessage.value(QStringLiteral("pipeline")).toInt(1)))
+    });
+    engEngine.reset();
+    engEngine.start();
+    tmrStats.start(STATS_INTERVAL);
+    QTextStream(stdout) << QStringLiteral("Started: %1 links, %2 proxies").arg(
+        engEngine.getLinks().count()
+    ).arg(
+        plProxies.count()
+    ) << Qt::endl;
+}
+
+void AgentServer::stop() {
+    if(engEngine.isRunning()) {
+        engEngine.stop();
+        tmrStats.stop();
+        this->statsTimeout();
+        QTextStream(stdout) << QStringLiteral("Stopped") << Qt::endl;
+    }
+    if(nullptr!=tcpCoordinator)
+        RemoteProtocol::writeMessage(
+            tcpCoordinator,
+            {{QStringLiteral("evt"),QStringLiteral("stopped")}}
+        );
+}
+
+void AgentServer::clientReadyRead() {
+    QTcpSocket         *tcpClient=qobject_cast<QTcpSocket *>(QObject::sender());
+    QList<QJsonObject> ljoMessages;
+    if(nullptr==tcpClient)
+        return;
+    if((ljoMessages=RemoteProtocol::readMessages(tcpClient)).isEmpty())
+        return;
+    // Nothing is read before a hello with the right token.
+    if(QStringLiteral("hello")!=ljoMessages.first().value(QStringLiteral("cmd")).toString()||
+       !isTokenValid(ljoMessages.first().value(QStringLiteral("token")).toString().toUtf8(),sToken.toUtf8())) {
+        this->rejectClient(tcpClient,QStringLiteral("Invalid token"));
+        return;
+    }
+    // One coordinator at a time: a second one would fight over the engine.
+    if(nullptr!=tcpCoordinator) {
+        this->rejectClient(tcpClient,QStringLiteral("Agent already in use"));
+        return;
+    }
+    tcpClient->disconnect(this);
+    tcpCoordinator=tcpClient;
+    connect(
+        tcpCoordinator,
+        &QTcpSocket::readyRead,
+        this,
+        &AgentServer::coordinatorReadyRead
+    );
+    connect(
+        tcpCoordinator,
+        &QTcpSocket::disconnected,
+        this,
+        &AgentServer::coordinatorDisconnected
+    );
+    QTextStream(stdout) << QStringLiteral("Coordinator connected from %1").arg(
+        tcpCoordinator->peerAddress().toString()
+    ) << Qt::endl;
+    // Whatever came along with the hello is handled right away.
+    for(int iK=1;iK<ljoMessages.count()&&tcpCoordinator==tcpClient;iK++)
+        this->handleMessage(ljoMessages.at(iK));
+}
+
+void AgentServer::coordinatorConnected() {
+    while(tcsServer.hasPendingConnections()) {
+        QTcpSocket *tcpClient=tcsServer.nextPendingConnection();
+        // Unknown peers only get to say hello, and only for a while, so ...
+        // ... one that never does can't hold the agent.
+        connect(
+            tcpClient,
+            &QTcpSocket::readyRead,
+            this,
+            &AgentServer::clientReadyRead
+        );
+        connect(
+            tcpClient,
+            &QTcpSocket::disconnected,
+            tcpClient,
+            &QTcpSocket::deleteLater
+        );
+        QTimer::singleShot(
+            HELLO_TIMEOUT,
+            tcpClient,
+            [this,tcpClient]() {
+                if(tcpCoordinator!=tcpClient&&QAbstractSocket::SocketState::ConnectedState==tcpClient->state())
+                    this->rejectClient(tcpClient,QStringLiteral("No hello received"));
+            }
+        );
+    }
+}
+
+void AgentServer::coordinatorDisconnected() {
+    QTcpSocket *tcpClient=tcpCoordinator;
+    tcpCoordinator=nullptr;
+    // Nobody is left to collect the results, so there's no point in going on.
+    if(engEngine.isRunning()) {
+        engEngine.stop();
+        tmrStats.stop();
+    }
+    if(nullptr!=tcpClient) {
+        tcpClient->disconnect(this);
+        tcpClient->deleteLater();
+    }
+    QTextStream(stdout) << QStringLiteral("Coordinator disconnected") << Qt::endl;
+}
+
+void AgentServer::coordinatorReadyRead() {
+    if(nullptr!=tcpCoordinator)
+        for(const auto &m:RemoteProtocol::readMessages(tcpCoordinator))
+            this->handleMessage(m);
+}
+
+void AgentServer::hitChanged(LinkRecord *lrLink,ProxyRecord *prProxy) {
+    if(nullptr!=lrLink)
+        setDirtyLinks.insert(lrLink->uiIndex);
+    if(nullptr!=prProxy)
+        setDirtyProxies.insert(prProxy->uiIndex);
+}
+
+void AgentServer::statsTimeout() {
+    quint64     uiHits=0,
+                uiErrors=0,
+                uiFailures=0,
+                uiCancels=0,
+                uiRetries=0;
+    QString     sResources;
+    ErrorCounts ecsErrors;
+    this->sendStats();
+    for(const auto &l:engEngine.getLinks()) {
+        uiHits+=l.uiHits;
+        uiErrors+=l.uiErrors;
+        uiFailures+=l.uiFailures;
+        uiCancels+=l.uiCancels;
+        uiRetries+=l.uiRetries;
+    }
+    QTextStream(stdout) << QStringLiteral("Hits: %1, errors: %2, failures: %3, cancels: %4, retries: %5").arg(
+        uiHits
+    ).arg(
+        uiErrors
+    ).arg(
+        uiFailures
+    ).arg(
+        uiCancels
+    ).arg(
+        uiRetries
+    ) << Qt::endl;
+    // The coordinator only gets the counts, so the kinds are printed here too.
+    for(int iK=0;iK<ErrorCode::EC_TOTAL;iK++)
+        ecsErrors.uiCounts[iK]=quint32(ErrorTaxonomy::getCount(ErrorCode(iK)));
+    if(!ErrorTaxonomy::isEmpty(ecsErrors))
+        QTextStream(stdout) << QStringLiteral("Errors by kind: %1").arg(
+            ErrorTaxonomy::getTextFromCounts(ecsErrors)
+        ) << Qt::endl;
+    // What the agent itself costs, so a slow target is not blamed for it.
+    QTextStream(stdout) << Diagnostics::getSummary() << Qt::endl;
+    QTextStream(stdout) << MemoryGovernor::getSummary() << Qt::endl;
+    // Resources aren't merged by the coordinator either.
+    if(!(sResources=ResourceStats::getSummary(TOP_RESOURCES)).isEmpty())
+        QTextStream(stdout) << sResources << Qt::endl;
+}
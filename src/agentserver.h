@@ -0,0 +1,43 @@
+#ifndef AGENTSERVER_H
+#define AGENTSERVER_H
+
+#include <QtCore>
+#include <QtNetwork>
+#include "hitengine.h"
+#include "remoteprotocol.h"
+
+class AgentServer:public QObject {
+    Q_OBJECT
+public:
+    AgentServer(QObject * =nullptr);
+    ~AgentServer();
+    bool listen(const QHostAddress &,quint16,QString &);
+    void setToken(QString);
+private slots:
+    void clientReadyRead();
+    void coordinatorConnected();
+    void coordinatorDisconnected();
+    void coordinatorReadyRead();
+    void hitChanged(LinkRecord *,ProxyRecord *);
+    void statsTimeout();
+private:
+    QString       sToken;
+    QTcpServer    tcsServer;
+    QTcpSocket    *tcpCoordinator;
+    QTimer        tmrStats;
+    HitEngine     engEngine;
+    QVector<uint> viLinkIndexes,
+                  viProxyIndexes;
+    QSet<uint>    setDirtyLinks,
+                  setDirtyProxies;
+    void handleMessage(QJsonObject);
+    void readLists(const QJsonObject &,LinkStore &,ProxyList &,QVector<uint> &,QVector<uint> &);
+    void rejectClient(QTcpSocket *,QString);
+    void reload(QJsonObject);
+    void sendError(QString);
+    void sendStats();
+    void start(QJsonObject);
+    void stop();
+};
+
+#endif // AGENTSERVER_H
@@ -0,0 +1,134 @@
+#include "assertionmatcher.h"
+
+#include <cstring>
+
+static int getNextState(const LiteralAutomaton &lauLiterals,int iState,uchar ucByte) {
+    while(iState) {
+        const LiteralState &lstState=lauLiterals.vlsStates.at(iState);
+        for(int iK=lstState.iFirstEdge;iK<lstState.iFirstEdge+lstState.iEdges;iK++)
+            if(ucByte==lauLiterals.vleEdges.at(iK).ucByte)
+                return lauLiterals.vleEdges.at(iK).iTarget;
+        iState=lstState.iFail;
+    }
+    return lauLiterals.viRoot.at(ucByte);
+}
+
+AssertionMatcher::AssertionMatcher(LinkAssertionsPtr lapNewAssertions) {
+    iState=0;
+    iMissing=0;
+    uiSize=0;
+    sFailure.clear();
+    lapAssertions=lapNewAssertions;
+    if(!lapAssertions.isNull()) {
+        vbFound.fill(false,lapAssertions->lbContains.count());
+        iMissing=vbFound.count();
+    }
+}
+
+bool AssertionMatcher::checkStatus(uint uiStatus) {
+    if(sFailure.isEmpty()&&!lapAssertions.isNull())
+        if(lapAssertions->uiStatus&&uiStatus&&lapAssertions->uiStatus!=uiStatus)
+            sFailure=QStringLiteral("Expected status %1, got %2").arg(
+                lapAssertions->uiStatus
+            ).arg(
+                uiStatus
+            );
+    return sFailure.isEmpty();
+}
+
+bool AssertionMatcher::expectsStatus() {
+    return !lapAssertions.isNull()&&lapAssertions->uiStatus;
+}
+
+bool AssertionMatcher::feed(const char *szData,qint64 iLength) {
+    uiSize+=iLength;
+    if(lapAssertions.isNull()||!sFailure.isEmpty())
+        return sFailure.isEmpty();
+    if(lapAssertions->uiMaxSize&&uiSize>lapAssertions->uiMaxSize) {
+        sFailure=QStringLiteral("Response larger than %1 bytes").arg(lapAssertions->uiMaxSize);
+        return false;
+    }
+    // The automaton's state carries over, so literals split between two ...
+    // ... chunks are found as well.
+    if(iMissing||!lapAssertions->lbNotContains.isEmpty())
+        this->search(szData,iLength);
+    // The whole body is only kept when a regex has to run on it.
+    if(!lapAssertions->rxMatch.pattern().isEmpty()) {
+        bytBody.append(szData,iLength);
+        mchBody.set(quint64(bytBody.capacity()));
+    }
+    return sFailure.isEmpty();
+}
+
+QString AssertionMatcher::finish() {
+    if(sFailure.isEmpty()&&!lapAssertions.isNull()) {
+        for(int iK=0;iK<vbFound.count();iK++)
+            if(!vbFound.at(iK)) {
+                sFailure=QStringLiteral("Response lacks \"%1\"").arg(
+                    QString::fromUtf8(lapAssertions->lbContains.at(iK))
+                );
+                break;
+            }
+        if(sFailure.isEmpty()&&!lapAssertions->rxMatch.pattern().isEmpty())
+            if(!lapAssertions->rxMatch.match(QString::fromUtf8(bytBody)).hasMatch())
+                sFailure=QStringLiteral("Response doesn't match /%1/").arg(
+                    lapAssertions->rxMatch.pattern()
+                );
+        bytBody.clear();
+        mchBody.set(0);
+    }
+    return sFailure;
+}
+
+QString AssertionMatcher::getFailure() {
+    return sFailure;
+}
+
+quint64 AssertionMatcher::getSize() {
+    return uiSize;
+}
+
+bool AssertionMatcher::hasFailed() {
+    return !sFailure.isEmpty();
+}
+
+void AssertionMatcher::search(const char *szData,qint64 iLength) {
+    const LiteralAutomaton &lauLiterals=lapAssertions->lauLiterals;
+    const char             *szEnd=szData+iLength;
+    while(szData<szEnd) {
+        // Back at the root, only the first bytes of the literals matter. ...
+        // ... memchr() is vectorized by every mainstream libc, so when ...
+        // ... there is just one, it skips to it in wide strides.
+        if(!iState) {
+            if(1==lauLiterals.bytFirst.size()) {
+                szData=static_cast<const char *>(std::memchr(szData,lauLiterals.bytFirst.at(0),szEnd-szData));
+                if(nullptr==szData)
+                    return;
+            }
+            else {
+                while(szData<szEnd&&!lauLiterals.viRoot.at(uchar(*szData)))
+                    szData++;
+                if(szData==szEnd)
+                    return;
+            }
+        }
+        iState=getNextState(lauLiterals,iState,uchar(*szData++));
+        const LiteralState &lstState=lauLiterals.vlsStates.at(iState);
+        for(int iK=lstState.iFirstMatch;iK<lstState.iFirstMatch+lstState.iMatches;iK++) {
+            int iLiteral=lauLiterals.viMatches.at(iK);
+            if(iLiteral>=vbFound.count()) {
+                sFailure=QStringLiteral("Response contains \"%1\"").arg(
+                    QString::fromUtf8(lapAssertions->lbNotContains.at(iLiteral-vbFound.count()))
+                );
+                return;
+            }
+            if(!vbFound.at(iLiteral)) {
+                vbFound[iLiteral]=true;
+                iMissing--;
+            }
+        }
+        // Nothing left to look for.
+        if(!iMissing&&lapAssertions->lbNotContains.isEmpty())
+            return;
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef ASSERTIONMATCHER_H
+#define ASSERTIONMATCHER_H
+
+#include <QtCore>
+#include "assertionparser.h"
+#include "memorygovernor.h"
+
+class AssertionMatcher {
+public:
+    AssertionMatcher(LinkAssertionsPtr=LinkAssertionsPtr());
+    bool    checkStatus(uint);
+    bool    expectsStatus();
+    bool    feed(const char *,qint64);
+    QString finish();
+    QString getFailure();
+    quint64 getSize();
+    bool    hasFailed();
+private:
+    int               iState,
+                      iMissing;
+    quint64           uiSize;
+    QString           sFailure;
+    QByteArray        bytBody;
+    QVector<bool>     vbFound;
+    LinkAssertionsPtr lapAssertions;
+    MemoryCharge      mchBody;
+    void search(const char *,qint64);
+};
+
+#endif // ASSERTIONMATCHER_H
@@ -0,0 +1,196 @@
+#include "assertionparser.h"
+
+static LiteralAutomaton getAutomatonFromLiterals(const QList<QByteArray> &lbLiterals) {
+    LiteralAutomaton         lauResult;
+    QVector<QMap<uchar,int>> vmpEdges(1);
+    QVector<QVector<int>>    vviMatches(1);
+    QVector<int>             viFail(1,0),
+                             viOrder;
+    // The trie first, state 0 being the root. Matches are literal indexes.
+    for(int iK=0;iK<lbLiterals.count();iK++) {
+        int iState=0;
+        for(const auto &c:lbLiterals.at(iK)) {
+            auto itEdge=vmpEdges.at(iState).constFind(uchar(c));
+            if(vmpEdges.at(iState).constEnd()!=itEdge)
+                iState=*itEdge;
+            else {
+                vmpEdges[iState].insert(uchar(c),vmpEdges.count());
+                iState=vmpEdges.count();
+                vmpEdges.append(QMap<uchar,int>());
+                vviMatches.append(QVector<int>());
+                viFail.append(0);
+            }
+        }
+        vviMatches[iState].append(iK);
+    }
+    // Then the failure links, breadth first, so every state inherits the ...
+    // ... matches of its longest proper suffix, already complete.
+    lauResult.viRoot.fill(0,256);
+    for(auto itEdge=vmpEdges.at(0).constBegin();vmpEdges.at(0).constEnd()!=itEdge;itEdge++) {
+        lauResult.viRoot[itEdge.key()]=itEdge.value();
+        lauResult.bytFirst.append(char(itEdge.key()));
+        viOrder.append(itEdge.value());
+    }
+    for(int iK=0;iK<viOrder.count();iK++) {
+        int iState=viOrder.at(iK);
+        for(auto itEdge=vmpEdges.at(iState).constBegin();vmpEdges.at(iState).constEnd()!=itEdge;itEdge++) {
+            int iFail=viFail.at(iState);
+            while(iFail&&!vmpEdges.at(iFail).contains(itEdge.key()))
+                iFail=viFail.at(iFail);
+            viFail[itEdge.value()]=iFail?vmpEdges.at(iFail).value(itEdge.key()):
+                                         lauResult.viRoot.at(itEdge.key());
+            vviMatches[itEdge.value()].append(vviMatches.at(viFail.at(itEdge.value())));
+            viOrder.append(itEdge.value());
+        }
+    }
+    lauResult.vlsStates.reserve(vmpEdges.count());
+    for(int iK=0;iK<vmpEdges.count();iK++) {
+        lauResult.vlsStates.append({
+            viFail.at(iK),
+            lauResult.vleEdges.count(),
+            vmpEdges.at(iK).count(),
+            lauResult.viMatches.count(),
+            vviMatches.at(iK).count()
+        });
+        for(auto itEdge=vmpEdges.at(iK).constBegin();vmpEdges.at(iK).constEnd()!=itEdge;itEdge++)
+            lauResult.vleEdges.append({itEdge.key(),itEdge.value()});
+        lauResult.viMatches.append(vviMatches.at(iK));
+    }
+    return lauResult;
+}
+
+static QString quoteValue(QString sValue) {
+    // Quoted only when needed, so the usual options stay readable.
+    if(!sValue.isEmpty()&&!sValue.contains(QRegularExpression(QStringLiteral("[\\s\"\\\\]"))))
+        return sValue;
+    return QStringLiteral("\"%1\"").arg(
+        sValue.replace(QStringLiteral("\\"),QStringLiteral("\\\\"))
+              .replace(QStringLiteral("\""),QStringLiteral("\\\""))
+    );
+}
+
+/**
+ * @brief Parses the assertions that may follow a link, on the same line.
+ *
+ * https://staging.example/cart status=200 max-size=65536 contains="Checkout"
+ *                              not-contains="Sign in" regex="Items: \\d+"
+ *
+ * status=N           the expected response code (any 2xx otherwise)
+ * max-size=N         the maximum response size, in bytes
+ * contains=TEXT      a literal the response must contain (repeatable)
+ * not-contains=TEXT  a literal the response must not contain (repeatable)
+ * regex=PATTERN      a regular expression the response must match
+ *
+ * Values with spaces, quotes or backslashes go between double quotes, with
+ * the latter two escaped by a backslash. Everything is compiled here, once,
+ * so the checks only cost a scan of each response: all the literals go in
+ * a single automaton, which finds them in one pass, whatever their number.
+ */
+bool AssertionParser::getAssertionsFromText(QString           sText,
+                                            LinkAssertionsPtr &lapAssertions,
+                                            QString           &sError) {
+    int                            iPos=0;
+    QSharedPointer<LinkAssertions> lasResult(new LinkAssertions());
+    lapAssertions.reset();
+    sError.clear();
+    lasResult->uiStatus=0;
+    lasResult->uiMaxSize=0;
+    while(true) {
+        QString sKey,
+                sValue;
+        int     iEqual;
+        while(iPos<sText.length()&&sText.at(iPos).isSpace())
+            iPos++;
+        if(iPos>=sText.length())
+            break;
+        iEqual=sText.indexOf(QLatin1Char('='),iPos);
+        if(iEqual<0) {
+            sError=QStringLiteral("Option without value: %1").arg(sText.mid(iPos).section(QLatin1Char(' '),0,0));
+            return false;
+        }
+        sKey=sText.mid(iPos,iEqual-iPos).toLower();
+        iPos=iEqual+1;
+        if(iPos<sText.length()&&QLatin1Char('"')==sText.at(iPos)) {
+            bool bClosed=false;
+            for(iPos++;iPos<sText.length();iPos++)
+                if(QLatin1Char('\\')==sText.at(iPos)&&iPos+1<sText.length())
+                    sValue.append(sText.at(++iPos));
+                else if(QLatin1Char('"')==sText.at(iPos)) {
+                    bClosed=true;
+                    iPos++;
+                    break;
+                }
+                else
+                    sValue.append(sText.at(iPos));
+            if(!bClosed) {
+                sError=QStringLiteral("Unterminated quotes in option %1").arg(sKey);
+                return false;
+            }
+        }
+        else
+            while(iPos<sText.length()&&!sText.at(iPos).isSpace())
+                sValue.append(sText.at(iPos++));
+        if(QStringLiteral("status")==sKey) {
+            lasResult->uiStatus=sValue.toUInt();
+            if(lasResult->uiStatus<100||lasResult->uiStatus>599) {
+                sError=QStringLiteral("Invalid status: %1").arg(sValue);
+                return false;
+            }
+        }
+        else if(QStringLiteral("max-size")==sKey) {
+            lasResult->uiMaxSize=sValue.toULongLong();
+            if(!lasResult->uiMaxSize) {
+                sError=QStringLiteral("Invalid max-size: %1").arg(sValue);
+                return false;
+            }
+        }
+        else if(QStringLiteral("contains")==sKey||QStringLiteral("not-contains")==sKey) {
+            if(sValue.isEmpty()) {
+                sError=QStringLiteral("Empty %1 option").arg(sKey);
+                return false;
+            }
+            if(QStringLiteral("contains")==sKey)
+                lasResult->lbContains.append(sValue.toUtf8());
+            else
+                lasResult->lbNotContains.append(sValue.toUtf8());
+        }
+        else if(QStringLiteral("regex")==sKey) {
+            lasResult->rxMatch.setPattern(sValue);
+            if(!lasResult->rxMatch.isValid()) {
+                sError=QStringLiteral("Invalid regex: %1").arg(lasResult->rxMatch.errorString());
+                return false;
+            }
+            lasResult->rxMatch.optimize();
+        }
+        else {
+            sError=QStringLiteral("Unknown option: %1").arg(sKey);
+            return false;
+        }
+    }
+    // Contains literals first, so their matches index vbFound directly.
+    if(!lasResult->lbContains.isEmpty()||!lasResult->lbNotContains.isEmpty())
+        lasResult->lauLiterals=getAutomatonFromLiterals(lasResult->lbContains+lasResult->lbNotContains);
+    // No options at all: the link is just checked for a 2xx, as always.
+    if(lasResult->uiStatus||lasResult->uiMaxSize||
+       !lasResult->lbContains.isEmpty()||!lasResult->lbNotContains.isEmpty()||
+       !lasResult->rxMatch.pattern().isEmpty())
+        lapAssertions=lasResult;
+    return true;
+}
+
+QString AssertionParser::getTextFromAssertions(LinkAssertionsPtr lapAssertions) {
+    QStringList slResult;
+    if(!lapAssertions.isNull()) {
+        if(lapAssertions->uiStatus)
+            slResult.append(QStringLiteral("status=%1").arg(lapAssertions->uiStatus));
+        if(lapAssertions->uiMaxSize)
+            slResult.append(QStringLiteral("max-size=%1").arg(lapAssertions->uiMaxSize));
+        for(const auto &c:lapAssertions->lbContains)
+            slResult.append(QStringLiteral("contains=%1").arg(quoteValue(QString::fromUtf8(c))));
+        for(const auto &c:lapAssertions->lbNotContains)
+            slResult.append(QStringLiteral("not-contains=%1").arg(quoteValue(QString::fromUtf8(c))));
+        if(!lapAssertions->rxMatch.pattern().isEmpty())
+            slResult.append(QStringLiteral("regex=%1").arg(quoteValue(lapAssertions->rxMatch.pattern())));
+    }
+    return slResult.join(QLatin1Char(' '));
+}
@@ -0,0 +1,46 @@
+#ifndef ASSERTIONPARSER_H
+#define ASSERTIONPARSER_H
+
+#include <QtCore>
+
+// An Aho-Corasick automaton over all the literals of a link. States keep ...
+// ... their edges sorted in a shared array, and the root a full table.
+using LiteralEdge=struct {
+    uchar ucByte;
+    int   iTarget;
+};
+
+using LiteralState=struct {
+    int iFail,
+        iFirstEdge,
+        iEdges,
+        iFirstMatch,
+        iMatches;
+};
+
+using LiteralAutomaton=struct {
+    QVector<int>          viRoot,
+                          viMatches;
+    QVector<LiteralState> vlsStates;
+    QVector<LiteralEdge>  vleEdges;
+    QByteArray            bytFirst;
+};
+
+using LinkAssertions=struct {
+    uint               uiStatus;
+    quint64            uiMaxSize;
+    QList<QByteArray>  lbContains,
+                       lbNotContains;
+    QRegularExpression rxMatch;
+    LiteralAutomaton   lauLiterals;
+};
+
+using LinkAssertionsPtr=QSharedPointer<const LinkAssertions>;
+
+class AssertionParser {
+public:
+    static bool    getAssertionsFromText(QString,LinkAssertionsPtr &,QString &);
+    static QString getTextFromAssertions(LinkAssertionsPtr);
+};
+
+#endif // ASSERTIONPARSER_H
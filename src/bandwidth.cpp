@@ -0,0 +1,204 @@
+#include "bandwidth.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Smallest grant a throttled transfer waits for, so a slow limit ends up ...
+// ... in fewer, bigger reads rather than a trickle of tiny ones.
+#define MIN_GRANT 4096
+
+#define BYTE_UNITS { \
+    "bytes", \
+    "KB", \
+    "MB", \
+    "GB", \
+    "TB" \
+}
+
+// One bucket per proxy, plus one (never limited) for the direct hits. ...
+// ... Limits cover both directions, as metered proxies count them all. ...
+// ... Each bucket holds up to one second of its rate, and may go into ...
+// ... debt: what was already moved is always charged.
+
+using ProxyBucket=struct {
+    quint64              uiRate;
+    double               dTokens;
+    qint64               iRefilled;
+    std::atomic<quint64> uiSent,
+                         uiReceived;
+    QMutex               mtxTokens;
+};
+
+static QElapsedTimer                             etmClock;
+static QReadWriteLock                            rwlBuckets;
+static std::vector<std::unique_ptr<ProxyBucket>> vpbBuckets;
+
+static ProxyBucket *getBucket(int iProxy) {
+    // Callers hold the read lock. Direct hits go to the first slot.
+    return iProxy+1>=0&&iProxy+1<int(vpbBuckets.size())?vpbBuckets.at(iProxy+1).get():nullptr;
+}
+
+static void refill(ProxyBucket *pbBucket) {
+    qint64 iNow=etmClock.nsecsElapsed();
+    pbBucket->dTokens=qMin(
+        double(pbBucket->uiRate),
+        pbBucket->dTokens+double(iNow-pbBucket->iRefilled)*pbBucket->uiRate/1e9
+    );
+    pbBucket->iRefilled=iNow;
+}
+
+static void charge(int iProxy,qint64 iBytes,bool bSent) {
+    QReadLocker rlkBuckets(&rwlBuckets);
+    ProxyBucket *pbBucket=getBucket(iProxy);
+    if(nullptr==pbBucket||iBytes<=0)
+        return;
+    (bSent?pbBucket->uiSent:pbBucket->uiReceived).fetch_add(quint64(iBytes),std::memory_order_relaxed);
+    if(pbBucket->uiRate) {
+        QMutexLocker mlkTokens(&pbBucket->mtxTokens);
+        refill(pbBucket);
+        pbBucket->dTokens-=iBytes;
+    }
+}
+
+QDataStream &operator<<(QDataStream &dstStream,const TrafficCounts &tcCounts) {
+    return dstStream << tcCounts.uiSent << tcCounts.uiReceived;
+}
+
+QDataStream &operator>>(QDataStream &dstStream,TrafficCounts &tcCounts) {
+    return dstStream >> tcCounts.uiSent >> tcCounts.uiReceived;
+}
+
+qint64 Bandwidth::acquire(int iProxy,qint64 iWanted) {
+    QReadLocker rlkBuckets(&rwlBuckets);
+    ProxyBucket *pbBucket=getBucket(iProxy);
+    if(nullptr==pbBucket||!pbBucket->uiRate)
+        return iWanted;
+    QMutexLocker mlkTokens(&pbBucket->mtxTokens);
+    refill(pbBucket);
+    // Only a grant: the bytes are charged once actually read.
+    if(pbBucket->dTokens<std::min({double(MIN_GRANT),double(pbBucket->uiRate),double(iWanted)}))
+        return 0;
+    return qMin(iWanted,qint64(pbBucket->dTokens));
+}
+
+void Bandwidth::beginRun(const QVector<quint64> &vuiRates) {
+    QWriteLocker wlkBuckets(&rwlBuckets);
+    vpbBuckets.clear();
+    etmClock.start();
+    for(int iK=-1;iK<vuiRates.count();iK++) {
+        std::unique_ptr<ProxyBucket> pbBucket(new ProxyBucket());
+        pbBucket->uiRate=iK>=0?vuiRates.at(iK):0;
+        // Starts full, so the first second goes at full speed.
+        pbBucket->dTokens=double(pbBucket->uiRate);
+        pbBucket->iRefilled=0;
+        pbBucket->uiSent=0;
+        pbBucket->uiReceived=0;
+        vpbBuckets.push_back(std::move(pbBucket));
+    }
+}
+
+bool Bandwidth::getRateFromText(QString sText,quint64 &uiRate) {
+    static const QRegularExpression rxRate(QStringLiteral("^(\\d+)([kKmMgG]?)$"));
+    QRegularExpressionMatch         rxmRate=rxRate.match(sText.trimmed());
+    QString                         sUnit;
+    bool                            bOK;
+    if(!rxmRate.hasMatch())
+        return false;
+    uiRate=rxmRate.captured(1).toULongLong(&bOK);
+    sUnit=rxmRate.captured(2).toLower();
+    // In bytes per second, with binary multiples.
+    if(QStringLiteral("k")==sUnit)
+        uiRate<<=10;
+    else if(QStringLiteral("m")==sUnit)
+        uiRate<<=20;
+    else if(QStringLiteral("g")==sUnit)
+        uiRate<<=30;
+    return bOK;
+}
+
+QString Bandwidth::getTextFromBytes(quint64 uiBytes) {
+    static const char *const szUnits[]=BYTE_UNITS;
+    double dValue=double(uiBytes);
+    uint   uiUnit=0;
+    while(dValue>=1024.0&&uiUnit<sizeof(szUnits)/sizeof(szUnits[0])-1) {
+        dValue/=1024.0;
+        uiUnit++;
+    }
+    return uiUnit?QStringLiteral("%1 %2").arg(dValue,0,'f',1).arg(QLatin1String(szUnits[uiUnit])):
+                  QStringLiteral("%1 %2").arg(uiBytes).arg(QLatin1String(szUnits[0]));
+}
+
+QString Bandwidth::getTextFromRate(quint64 uiRate) {
+    // The shortest exact form, so a limit reads back the same.
+    if(uiRate&&!(uiRate&((quint64(1)<<30)-1)))
+        return QStringLiteral("%1g").arg(uiRate>>30);
+    if(uiRate&&!(uiRate&((quint64(1)<<20)-1)))
+        return QStringLiteral("%1m").arg(uiRate>>20);
+    if(uiRate&&!(uiRate&((quint64(1)<<10)-1)))
+        return QStringLiteral("%1k").arg(uiRate>>10);
+    return QString::number(uiRate);
+}
+
+TrafficCounts Bandwidth::getTraffic(int iProxy) {
+    QReadLocker rlkBuckets(&rwlBuckets);
+    ProxyBucket *pbBucket=getBucket(iProxy);
+    if(nullptr==pbBucket)
+        return {0,0};
+    return {
+        pbBucket->uiSent.load(std::memory_order_relaxed),
+        pbBucket->uiReceived.load(std::memory_order_relaxed)
+    };
+}
+
+int Bandwidth::getWait(int iProxy) {
+    QReadLocker rlkBuckets(&rwlBuckets);
+    ProxyBucket *pbBucket=getBucket(iProxy);
+    double      dWanted;
+    if(nullptr==pbBucket||!pbBucket->uiRate)
+        return 0;
+    QMutexLocker mlkTokens(&pbBucket->mtxTokens);
+    refill(pbBucket);
+    dWanted=qMin<double>(MIN_GRANT,pbBucket->uiRate);
+    if(pbBucket->dTokens>=dWanted)
+        return 0;
+    return qMax(1,int(qCeil((dWanted-pbBucket->dTokens)*1000.0/pbBucket->uiRate)));
+}
+
+bool Bandwidth::isLimited(int iProxy) {
+    QReadLocker rlkBuckets(&rwlBuckets);
+    ProxyBucket *pbBucket=getBucket(iProxy);
+    return nullptr!=pbBucket&&pbBucket->uiRate;
+}
+
+void Bandwidth::received(int iProxy,qint64 iBytes) {
+    charge(iProxy,iBytes,false);
+}
+
+void Bandwidth::sent(int iProxy,qint64 iBytes) {
+    charge(iProxy,iBytes,true);
+}
+
+void Bandwidth::setRates(const QVector<quint64> &vuiRates) {
+    QWriteLocker wlkBuckets(&rwlBuckets);
+    // Mid-run: the counters carry on, only the limits change. Proxies ...
+    // ... added since the run began get a bucket of their own.
+    for(int iK=0;iK<vuiRates.count();iK++) {
+        ProxyBucket *pbBucket=getBucket(iK);
+        if(nullptr==pbBucket) {
+            std::unique_ptr<ProxyBucket> pbNewBucket(new ProxyBucket());
+            pbNewBucket->dTokens=double(vuiRates.at(iK));
+            pbNewBucket->iRefilled=etmClock.nsecsElapsed();
+            pbNewBucket->uiSent=0;
+            pbNewBucket->uiReceived=0;
+            pbBucket=pbNewBucket.get();
+            vpbBuckets.push_back(std::move(pbNewBucket));
+        }
+        else if(pbBucket->uiRate!=vuiRates.at(iK)) {
+            refill(pbBucket);
+            pbBucket->dTokens=qMin(pbBucket->dTokens,double(vuiRates.at(iK)));
+        }
+        pbBucket->uiRate=vuiRates.at(iK);
+    }
+}
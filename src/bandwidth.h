@@ -0,0 +1,29 @@
+#ifndef BANDWIDTH_H
+#define BANDWIDTH_H
+
+#include <QtCore>
+
+using TrafficCounts=struct {
+    quint64 uiSent,
+            uiReceived;
+};
+
+QDataStream &operator<<(QDataStream &,const TrafficCounts &);
+QDataStream &operator>>(QDataStream &,TrafficCounts &);
+
+class Bandwidth {
+public:
+    static qint64        acquire(int,qint64);
+    static void          beginRun(const QVector<quint64> &);
+    static bool          getRateFromText(QString,quint64 &);
+    static QString       getTextFromBytes(quint64);
+    static QString       getTextFromRate(quint64);
+    static TrafficCounts getTraffic(int);
+    static int           getWait(int);
+    static bool          isLimited(int);
+    static void          received(int,qint64);
+    static void          sent(int,qint64);
+    static void          setRates(const QVector<quint64> &);
+};
+
+#endif // BANDWIDTH_H
@@ -0,0 +1,394 @@
+#include "baseline.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define BASELINE_FORMAT  "multibrowser-baseline"
+#define BASELINE_VERSION 1
+
+// Two-sided 95% intervals around every percentile.
+#define CONFIDENCE_LEVEL 0.95
+#define CONFIDENCE_Z     1.959964
+
+// Fewer samples than this on either side can't tell anything apart.
+#define MIN_SAMPLES 30
+
+#define COMPARED_PERCENTILES {50.0,95.0,99.0}
+
+using ComparisonStatus=enum {
+    CS_UNCHANGED,
+    CS_REGRESSED,
+    CS_IMPROVED,
+    CS_INSUFFICIENT,
+    CS_TOTAL
+};
+
+#define STATUS_NAMES { \
+    "unchanged", \
+    "regressed", \
+    "improved", \
+    "insufficient" \
+}
+
+static const char *const szStatusNames[ComparisonStatus::CS_TOTAL]=STATUS_NAMES;
+
+using LatencyTest=struct {
+    bool   bSufficient,
+           bSlower,
+           bFaster;
+    double dScore,
+           dSlowerP,
+           dFasterP,
+           dSlowerAdjustedP,
+           dFasterAdjustedP;
+};
+
+static void getInterval(const LatencyHistogram &lhLatency,double dPercentile,quint32 &uiLow,quint32 &uiHigh) {
+    // The rank of a sample percentile is binomial, so its interval is ...
+    // ... given by two ranks around it, whatever the shape of the latencies.
+    double dCount=lhLatency.getCount(),
+           dQuantile=dPercentile/100.0,
+           dCenter=dCount*dQuantile,
+           dSpread=CONFIDENCE_Z*qSqrt(dCount*dQuantile*(1.0-dQuantile));
+    uiLow=lhLatency.getValueAtRank(quint64(qBound(1.0,std::floor(dCenter-dSpread),dCount)));
+    uiHigh=lhLatency.getValueAtRank(quint64(qBound(1.0,std::ceil(dCenter+dSpread)+1.0,dCount)));
+}
+
+static double getShiftScore(const LatencyHistogram &lhBaseline,const LatencyHistogram &lhCurrent) {
+    // Mann-Whitney U over the buckets, each bucket being a group of ties. ...
+    // ... The score is positive when the current latencies tend to be higher.
+    double dBaseline=lhBaseline.getCount(),
+           dCurrent=lhCurrent.getCount(),
+           dTotal=dBaseline+dCurrent,
+           dBelow=0.0,
+           dU=0.0,
+           dTies=0.0,
+           dVariance;
+    for(int iK=0;iK<LatencyHistogram::getTotalBuckets();iK++) {
+        double dInBaseline=lhBaseline.getBucketCount(iK),
+               dInCurrent=lhCurrent.getBucketCount(iK),
+               dTied=dInBaseline+dInCurrent;
+        dU+=dInCurrent*(dBelow+0.5*dInBaseline);
+        dTies+=dTied*dTied*dTied-dTied;
+        dBelow+=dInBaseline;
+    }
+    dVariance=dBaseline*dCurrent/12.0*((dTotal+1.0)-dTies/(dTotal*(dTotal-1.0)));
+    return dVariance>0.0?(dU-dBaseline*dCurrent/2.0)/qSqrt(dVariance):0.0;
+}
+
+static QJsonObject getSummary(const LatencyHistogram &lhLatency) {
+    return {
+        {QStringLiteral("count"),double(lhLatency.getCount())},
+        {QStringLiteral("mean"),lhLatency.getMean()},
+        {QStringLiteral("min"),double(lhLatency.getMin())},
+        {QStringLiteral("max"),double(lhLatency.getMax())}
+    };
+}
+
+static LatencyTest testLatencies(const LatencyHistogram &lhBaseline,
+                                 const LatencyHistogram &lhCurrent,
+                                 double                 dThreshold,
+                                 QJsonArray             *jsaPercentiles=nullptr) {
+    LatencyTest ltsResult={false,false,false,0.0,1.0,1.0,1.0,1.0};
+    ltsResult.bSufficient=lhBaseline.getCount()>=MIN_SAMPLES&&lhCurrent.getCount()>=MIN_SAMPLES;
+    if(ltsResult.bSufficient) {
+        ltsResult.dScore=getShiftScore(lhBaseline,lhCurrent);
+        ltsResult.dSlowerP=0.5*std::erfc(ltsResult.dScore/qSqrt(2.0));
+        ltsResult.dFasterP=0.5*std::erfc(-ltsResult.dScore/qSqrt(2.0));
+    }
+    // Until adjusted along with the rest of its group, a test stands alone.
+    ltsResult.dSlowerAdjustedP=ltsResult.dSlowerP;
+    ltsResult.dFasterAdjustedP=ltsResult.dFasterP;
+    for(double p:COMPARED_PERCENTILES) {
+        quint32 uiBaseline=lhBaseline.getPercentile(p),
+                uiCurrent=lhCurrent.getPercentile(p),
+                uiBaselineLow,
+                uiBaselineHigh,
+                uiCurrentLow,
+                uiCurrentHigh;
+        double  dDelta=double(uiCurrent)-uiBaseline,
+                dRelative=uiBaseline?dDelta/uiBaseline:0.0,
+                dDeltaLow,
+                dDeltaHigh;
+        getInterval(lhBaseline,p,uiBaselineLow,uiBaselineHigh);
+        getInterval(lhCurrent,p,uiCurrentLow,uiCurrentHigh);
+        // Conservative: the difference is only sure when the intervals don't overlap.
+        dDeltaLow=double(uiCurrentLow)-uiBaselineHigh;
+        dDeltaHigh=double(uiCurrentHigh)-uiBaselineLow;
+        ltsResult.bSlower|=dDeltaLow>0.0&&dRelative>dThreshold;
+        ltsResult.bFaster|=dDeltaHigh<0.0&&dRelative<-dThreshold;
+        if(nullptr!=jsaPercentiles)
+            jsaPercentiles->append(QJsonObject({
+                {QStringLiteral("percentile"),p},
+                {QStringLiteral("baseline"),double(uiBaseline)},
+                {QStringLiteral("baselineInterval"),QJsonArray({double(uiBaselineLow),double(uiBaselineHigh)})},
+                {QStringLiteral("current"),double(uiCurrent)},
+                {QStringLiteral("currentInterval"),QJsonArray({double(uiCurrentLow),double(uiCurrentHigh)})},
+                {QStringLiteral("delta"),dDelta},
+                {QStringLiteral("deltaInterval"),QJsonArray({dDeltaLow,dDeltaHigh})},
+                {QStringLiteral("relativeDelta"),dRelative}
+            }));
+    }
+    return ltsResult;
+}
+
+static ComparisonStatus getStatus(const LatencyTest &ltsTest,double dAlpha) {
+    // Both tests must agree: a shift of the whole distribution, and one ...
+    // ... big enough, on some percentile, to be worth the attention.
+    if(!ltsTest.bSufficient)
+        return ComparisonStatus::CS_INSUFFICIENT;
+    if(ltsTest.dSlowerAdjustedP<dAlpha&&ltsTest.bSlower)
+        return ComparisonStatus::CS_REGRESSED;
+    if(ltsTest.dFasterAdjustedP<dAlpha&&ltsTest.bFaster)
+        return ComparisonStatus::CS_IMPROVED;
+    return ComparisonStatus::CS_UNCHANGED;
+}
+
+static void adjustHolm(QVector<double *> &vdpPValues) {
+    double dRunningMax=0.0;
+    // Holm's step-down: the k-th smallest of m p-values is scaled by ...
+    // ... m-k+1, and never allowed below the ones before it. It bounds the ...
+    // ... chance of any false alarm in the group, whatever its size.
+    std::sort(
+        vdpPValues.begin(),
+        vdpPValues.end(),
+        [](const double *dpA,const double *dpB) {
+            return *dpA<*dpB;
+        }
+    );
+    for(int iK=0;iK<vdpPValues.count();iK++) {
+        dRunningMax=qMax(dRunningMax,qMin(1.0,*vdpPValues.at(iK)*(vdpPValues.count()-iK)));
+        *vdpPValues[iK]=dRunningMax;
+    }
+}
+
+static QJsonObject compareLatencies(QString                 sKey,
+                                    const LatencyHistogram &lhBaseline,
+                                    const LatencyHistogram &lhCurrent,
+                                    const LatencyTest      &ltsTest,
+                                    double                 dAlpha,
+                                    double                 dThreshold) {
+    QJsonArray  jsaPercentiles;
+    QJsonObject jsoResult;
+    // Only run again for the percentiles: the p-values are the group's.
+    testLatencies(lhBaseline,lhCurrent,dThreshold,&jsaPercentiles);
+    jsoResult.insert(QStringLiteral("key"),sKey);
+    jsoResult.insert(QStringLiteral("status"),QLatin1String(szStatusNames[getStatus(ltsTest,dAlpha)]));
+    jsoResult.insert(QStringLiteral("baseline"),getSummary(lhBaseline));
+    jsoResult.insert(QStringLiteral("current"),getSummary(lhCurrent));
+    jsoResult.insert(QStringLiteral("shiftScore"),ltsTest.dScore);
+    jsoResult.insert(QStringLiteral("pSlower"),ltsTest.dSlowerP);
+    jsoResult.insert(QStringLiteral("pFaster"),ltsTest.dFasterP);
+    jsoResult.insert(QStringLiteral("pSlowerAdjusted"),ltsTest.dSlowerAdjustedP);
+    jsoResult.insert(QStringLiteral("pFasterAdjusted"),ltsTest.dFasterAdjustedP);
+    jsoResult.insert(QStringLiteral("percentiles"),jsaPercentiles);
+    return jsoResult;
+}
+
+static QJsonObject compareGroup(const QMap<QString,LatencyHistogram> &mapBaseline,
+                                const QMap<QString,LatencyHistogram> &mapCurrent,
+                                double                               dAlpha,
+                                double                               dThreshold,
+                                BaselineReport                       &brpReport) {
+    uint                 uiCounts[ComparisonStatus::CS_TOTAL]={},
+                         uiNew=0,
+                         uiMissing=0;
+    QVector<QString>     vsKeys;
+    QVector<LatencyTest> vltTests;
+    QVector<double *>    vdpSlower,
+                         vdpFaster;
+    QJsonArray           jsaChanged;
+    QJsonObject          jsoCounts;
+    for(auto itCurrent=mapCurrent.constBegin();itCurrent!=mapCurrent.constEnd();itCurrent++) {
+        auto itBaseline=mapBaseline.constFind(itCurrent.key());
+        if(mapBaseline.constEnd()==itBaseline) {
+            uiNew++;
+            continue;
+        }
+        vsKeys.append(itCurrent.key());
+        vltTests.append(testLatencies(itBaseline.value(),itCurrent.value(),dThreshold));
+    }
+    // Thousands of links tested one by one at alpha would flag some by ...
+    // ... chance alone, so each direction is adjusted over the group.
+    for(auto &t:vltTests)
+        if(t.bSufficient) {
+            vdpSlower.append(&t.dSlowerAdjustedP);
+            vdpFaster.append(&t.dFasterAdjustedP);
+        }
+    adjustHolm(vdpSlower);
+    adjustHolm(vdpFaster);
+    for(int iK=0;iK<vltTests.count();iK++) {
+        ComparisonStatus csStatus=getStatus(vltTests.at(iK),dAlpha);
+        uiCounts[csStatus]++;
+        // Only what changed is listed, or lists of millions would drown it.
+        if(ComparisonStatus::CS_REGRESSED==csStatus||ComparisonStatus::CS_IMPROVED==csStatus)
+            jsaChanged.append(compareLatencies(
+                vsKeys.at(iK),
+                mapBaseline.value(vsKeys.at(iK)),
+                mapCurrent.value(vsKeys.at(iK)),
+                vltTests.at(iK),
+                dAlpha,
+                dThreshold
+            ));
+    }
+    for(auto itBaseline=mapBaseline.constBegin();itBaseline!=mapBaseline.constEnd();itBaseline++)
+        if(!mapCurrent.contains(itBaseline.key()))
+            uiMissing++;
+    brpReport.uiRegressions+=uiCounts[ComparisonStatus::CS_REGRESSED];
+    brpReport.uiImprovements+=uiCounts[ComparisonStatus::CS_IMPROVED];
+    for(int iK=0;iK<ComparisonStatus::CS_TOTAL;iK++)
+        jsoCounts.insert(QLatin1String(szStatusNames[iK]),double(uiCounts[iK]));
+    jsoCounts.insert(QStringLiteral("new"),double(uiNew));
+    jsoCounts.insert(QStringLiteral("missing"),double(uiMissing));
+    return {
+        {QStringLiteral("counts"),jsoCounts},
+        {QStringLiteral("changed"),jsaChanged}
+    };
+}
+
+static QJsonObject getJsonFromHistograms(const QMap<QString,LatencyHistogram> &mapHistograms) {
+    QJsonObject jsoResult;
+    for(auto itHistogram=mapHistograms.constBegin();itHistogram!=mapHistograms.constEnd();itHistogram++)
+        jsoResult.insert(itHistogram.key(),itHistogram.value().toJson());
+    return jsoResult;
+}
+
+static QMap<QString,LatencyHistogram> getHistogramsFromJson(QJsonObject jsoHistograms) {
+    QMap<QString,LatencyHistogram> mapResult;
+    for(auto itHistogram=jsoHistograms.constBegin();itHistogram!=jsoHistograms.constEnd();itHistogram++)
+        mapResult.insert(itHistogram.key(),LatencyHistogram::fromJson(itHistogram.value().toArray()));
+    return mapResult;
+}
+
+BaselineData Baseline::capture(const LinkStore &llLinks,const ProxyList &plProxies) {
+    BaselineData bldResult;
+    bldResult.dtmCaptured=QDateTime::currentDateTimeUtc();
+    // Keyed by URL (or template), not by position, so reordered or edited ...
+    // ... lists still match. Repeated links are merged, just as they'd be ...
+    // ... in a new run.
+    for(int iK=0;iK<llLinks.count();iK++) {
+        LatencyHistogram lhLatency=llLinks.getLatency(iK);
+        if(lhLatency.getCount())
+            bldResult.mapLinks[llLinks.getLabel(iK)].merge(lhLatency);
+    }
+    for(const auto &p:plProxies)
+        if(p.lhLatency.getCount()) {
+            QNetworkProxy npxProxy=p.npxProxy;
+            // Passwords have no place in a file meant to be shared.
+            npxProxy.setPassword(QString());
+            bldResult.mapProxies[ProxyParser::getTextFromProxy(npxProxy)].merge(p.lhLatency);
+        }
+    return bldResult;
+}
+
+BaselineReport Baseline::compare(const BaselineData &bldBaseline,
+                                 const BaselineData &bldCurrent,
+                                 double             dAlpha,
+                                 double             dThreshold) {
+    BaselineReport   brpResult={0,0,QJsonObject()};
+    LatencyHistogram lhBaseline,
+                     lhCurrent;
+    LatencyTest      ltsOverall;
+    ComparisonStatus csOverall;
+    QJsonObject      jsoOverall;
+    // The whole run is compared too, since every link alone may lack samples.
+    for(const auto &l:bldBaseline.mapLinks)
+        lhBaseline.merge(l);
+    for(const auto &l:bldCurrent.mapLinks)
+        lhCurrent.merge(l);
+    ltsOverall=testLatencies(lhBaseline,lhCurrent,dThreshold);
+    csOverall=getStatus(ltsOverall,dAlpha);
+    jsoOverall=compareLatencies(QStringLiteral("*"),lhBaseline,lhCurrent,ltsOverall,dAlpha,dThreshold);
+    if(ComparisonStatus::CS_REGRESSED==csOverall)
+        brpResult.uiRegressions++;
+    else if(ComparisonStatus::CS_IMPROVED==csOverall)
+        brpResult.uiImprovements++;
+    brpResult.jsoReport.insert(QStringLiteral("format"),QStringLiteral(BASELINE_FORMAT "-report"));
+    brpResult.jsoReport.insert(QStringLiteral("baselineCaptured"),bldBaseline.dtmCaptured.toString(Qt::DateFormat::ISODate));
+    brpResult.jsoReport.insert(QStringLiteral("currentCaptured"),bldCurrent.dtmCaptured.toString(Qt::DateFormat::ISODate));
+    brpResult.jsoReport.insert(QStringLiteral("confidence"),CONFIDENCE_LEVEL);
+    brpResult.jsoReport.insert(QStringLiteral("alpha"),dAlpha);
+    brpResult.jsoReport.insert(QStringLiteral("adjustment"),QStringLiteral("holm"));
+    brpResult.jsoReport.insert(QStringLiteral("threshold"),dThreshold);
+    brpResult.jsoReport.insert(QStringLiteral("minSamples"),MIN_SAMPLES);
+    brpResult.jsoReport.insert(QStringLiteral("overall"),jsoOverall);
+    brpResult.jsoReport.insert(
+        QStringLiteral("links"),
+        compareGroup(bldBaseline.mapLinks,bldCurrent.mapLinks,dAlpha,dThreshold,brpResult)
+    );
+    brpResult.jsoReport.insert(
+        QStringLiteral("proxies"),
+        compareGroup(bldBaseline.mapProxies,bldCurrent.mapProxies,dAlpha,dThreshold,brpResult)
+    );
+    brpResult.jsoReport.insert(QStringLiteral("regressions"),double(brpResult.uiRegressions));
+    brpResult.jsoReport.insert(QStringLiteral("improvements"),double(brpResult.uiImprovements));
+    brpResult.jsoReport.insert(
+        QStringLiteral("verdict"),
+        brpResult.uiRegressions?QStringLiteral("fail"):QStringLiteral("pass")
+    );
+    return brpResult;
+}
+
+bool Baseline::readFromFile(QString sPath,BaselineData &bldData,QString &sError) {
+    QFile           fFile(sPath);
+    QJsonParseError jpeError;
+    QJsonDocument   jsnDoc;
+    QJsonObject     jsoBaseline;
+    sError.clear();
+    if(!fFile.open(QFile::OpenModeFlag::ReadOnly)) {
+        sError=fFile.errorString();
+        return false;
+    }
+    jsnDoc=QJsonDocument::fromJson(fFile.readAll(),&jpeError);
+    jsoBaseline=jsnDoc.object();
+    if(QJsonParseError::ParseError::NoError!=jpeError.error||
+       QStringLiteral(BASELINE_FORMAT)!=jsoBaseline.value(QStringLiteral("format")).toString()||
+       jsoBaseline.value(QStringLiteral("version")).toInt()>BASELINE_VERSION) {
+        sError=QStringLiteral("Not a valid baseline file");
+        return false;
+    }
+    bldData.dtmCaptured=QDateTime::fromString(
+        jsoBaseline.value(QStringLiteral("captured")).toString(),
+        Qt::DateFormat::ISODate
+    );
+    bldData.mapLinks=getHistogramsFromJson(jsoBaseline.value(QStringLiteral("links")).toObject());
+    bldData.mapProxies=getHistogramsFromJson(jsoBaseline.value(QStringLiteral("proxies")).toObject());
+    return true;
+}
+
+bool Baseline::writeReportToFile(QString sPath,const BaselineReport &brpReport,QString &sError) {
+    QSaveFile sflFile(sPath);
+    sError.clear();
+    if(!sflFile.open(QFile::OpenModeFlag::WriteOnly)) {
+        sError=sflFile.errorString();
+        return false;
+    }
+    sflFile.write(QJsonDocument(brpReport.jsoReport).toJson(QJsonDocument::JsonFormat::Indented));
+    if(!sflFile.commit()) {
+        sError=sflFile.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool Baseline::writeToFile(QString sPath,const BaselineData &bldData,QString &sError) {
+    QSaveFile sflFile(sPath);
+    sError.clear();
+    if(!sflFile.open(QFile::OpenModeFlag::WriteOnly)) {
+        sError=sflFile.errorString();
+        return false;
+    }
+    // The histograms are kept whole, so any percentile can be compared later.
+    sflFile.write(QJsonDocument(QJsonObject({
+        {QStringLiteral("format"),QStringLiteral(BASELINE_FORMAT)},
+        {QStringLiteral("version"),BASELINE_VERSION},
+        {QStringLiteral("captured"),bldData.dtmCaptured.toString(Qt::DateFormat::ISODate)},
+        {QStringLiteral("links"),getJsonFromHistograms(bldData.mapLinks)},
+        {QStringLiteral("proxies"),getJsonFromHistograms(bldData.mapProxies)}
+    })).toJson(QJsonDocument::JsonFormat::Compact));
+    if(!sflFile.commit()) {
+        sError=sflFile.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef BASELINE_H
+#define BASELINE_H
+
+#include <QtCore>
+#include "hitengine.h"
+#include "latencyhistogram.h"
+
+using BaselineData=struct {
+    QDateTime                      dtmCaptured;
+    QMap<QString,LatencyHistogram> mapLinks,
+                                   mapProxies;
+};
+
+using BaselineReport=struct {
+    uint        uiRegressions,
+                uiImprovements;
+    QJsonObject jsoReport;
+};
+
+class Baseline {
+public:
+    static BaselineData   capture(const LinkStore &,const ProxyList &);
+    static BaselineReport compare(const BaselineData &,const BaselineData &,double=0.01,double=0.05);
+    static bool           readFromFile(QString,BaselineData &,QString &);
+    static bool           writeReportToFile(QString,const BaselineReport &,QString &);
+    static bool           writeToFile(QString,const BaselineData &,QString &);
+};
+
+#endif // BASELINE_H
@@ -2,40 +2,430 @@
 #include <QtWebEngineCore>
 #include <QApplication>
 #include <QCommandLineParser>
+#include <memory>
 #include "../proxyparser.h"
 
+// Warm profiles are kept in numbered slots, one per running helper at most.
+#define MAX_PROFILE_SLOTS 64
+
+// How often (in ms) the page is checked against the completion criteria.
+#define COMPLETION_POLL_INTERVAL 50
+
+// Time (in ms) the network and the selector still get after the load event.
+#define COMPLETION_GRACE 10000
+
+// Resource timings kept by the page. Chromium only keeps 250 by default.
+#define RESOURCE_TIMING_BUFFER 4096
+
+#define HAR_VERSION         "1.2"
+#define HAR_CREATOR         "MultiBrowser"
+#define HAR_CREATOR_VERSION "0.1"
+#define HAR_PAGE_ID         "page_1"
+
+using CompletionMode=enum {
+    CM_LOAD,
+    CM_DOM,
+    CM_IDLE,
+    CM_SELECTOR,
+    CM_TIME
+};
+
+using Completion=struct {
+    CompletionMode cmMode;
+    int            iMillis;
+    QString        sSelector,
+                   sText;
+};
+
+QString getResourceType(QWebEngineUrlRequestInfo::ResourceType rtType) {
+    // Named as the HAR files saved by Chromium's own tools name them.
+    switch(rtType) {
+        case QWebEngineUrlRequestInfo::ResourceType::ResourceTypeMainFrame:
+        case QWebEngineUrlRequestInfo::ResourceType::ResourceTypeSubFrame:
+            return QStringLiteral("document");
+        case QWebEngineUrlRequestInfo::ResourceType::ResourceTypeStylesheet:
+            return QStringLiteral("stylesheet");
+        case QWebEngineUrlRequestInfo::ResourceType::ResourceTypeScript:
+            return QStringLiteral("script");
+        case QWebEngineUrlRequestInfo::ResourceType::ResourceTypeImage:
+        case QWebEngineUrlRequestInfo::ResourceType::ResourceTypeFavicon:
+            return QStringLiteral("image");
+        case QWebEngineUrlRequestInfo::ResourceType::ResourceTypeFontResource:
+            return QStringLiteral("font");
+        case QWebEngineUrlRequestInfo::ResourceType::ResourceTypeMedia:
+            return QStringLiteral("media");
+        case QWebEngineUrlRequestInfo::ResourceType::ResourceTypeXhr:
+            return QStringLiteral("xhr");
+        case QWebEngineUrlRequestInfo::ResourceType::ResourceTypePing:
+            return QStringLiteral("ping");
+        default:
+            return QStringLiteral("other");
+    }
+}
+
+QJsonArray getHarHeaders(const QHash<QByteArray,QByteArray> &hshHeaders) {
+    QJsonArray jsaHeaders;
+    for(auto itHeader=hshHeaders.constBegin();itHeader!=hshHeaders.constEnd();itHeader++)
+        jsaHeaders.append(QJsonObject({
+            {QStringLiteral("name"),QString(itHeader.key())},
+            {QStringLiteral("value"),QString(itHeader.value())}
+        }));
+    return jsaHeaders;
+}
+
+class UrlRequestInterceptor:public QWebEngineUrlRequestInterceptor {
+public:
+    UrlRequestInterceptor() {
+        bRecording=false;
+        etmActivity.start();
+    }
+    qint64 getIdleTime() {
+        return etmActivity.elapsed();
+    }
+    QJsonObject getRequest(QString sUrl) {
+        return hshRequests.value(sUrl);
+    }
+    void interceptRequest(QWebEngineUrlRequestInfo &webUrlRIInfo) override {
+        // Called on the UI thread, for every request the page sends.
+        this->touch();
+        // Only the first request to each URL is kept, as with the timings.
+        if(bRecording&&!hshRequests.contains(webUrlRIInfo.requestUrl().toString()))
+            hshRequests.insert(
+                webUrlRIInfo.requestUrl().toString(),
+                {
+                    {QStringLiteral("method"),QString(webUrlRIInfo.requestMethod())},
+                    {QStringLiteral("type"),getResourceType(webUrlRIInfo.resourceType())},
+                    {QStringLiteral("initiator"),webUrlRIInfo.initiator().toString()}
+                }
+            );
+    }
+    void setRecording(bool bNewRecording) {
+        bRecording=bNewRecording;
+    }
+    void touch() {
+        etmActivity.restart();
+    }
+private:
+    bool                       bRecording;
+    QElapsedTimer              etmActivity;
+    QHash<QString,QJsonObject> hshRequests;
+};
+
 class UrlResponseInterceptor:public QWebEngineUrlResponseInterceptor {
 public:
+    UrlResponseInterceptor() {
+        bRecording=false;
+        uiSent=0;
+    }
+    QJsonObject getExchange(QString sUrl) {
+        return hshExchanges.value(sUrl);
+    }
     QJsonObject getHeaders() {
         return jsnObj;
     }
+    quint64 getSent() {
+        return uiSent;
+    }
     void interceptResponseHeaders(QWebEngineUrlResponseInfo &webUrlRIInfo) override {
+        // Chromium doesn't tell what it wrote, so every request is estimated ...
+        // ... from its line and its headers.
+        uiSent+=quint64(webUrlRIInfo.requestUrl().toEncoded().size())+15;
+        for(auto itHeader=webUrlRIInfo.requestHeaders().cbegin();
+            itHeader!=webUrlRIInfo.requestHeaders().cend();
+            itHeader++)
+            uiSent+=quint64(itHeader.key().size()+itHeader.value().size())+4;
         // Processes the response only if it's the top-level request.
         if(jsnObj.isEmpty())
             // Creates a JSON object including all headers as name:value pairs.
             for(const auto &k:webUrlRIInfo.responseHeaders().keys())
                 jsnObj[k]=QString(webUrlRIInfo.responseHeaders().value(k));
+        // The rest, only for the HAR files, and in their own format.
+        if(bRecording&&!hshExchanges.contains(webUrlRIInfo.requestUrl().toString()))
+            hshExchanges.insert(
+                webUrlRIInfo.requestUrl().toString(),
+                {
+                    {QStringLiteral("request"),getHarHeaders(webUrlRIInfo.requestHeaders())},
+                    {QStringLiteral("response"),getHarHeaders(webUrlRIInfo.responseHeaders())},
+                    {
+                        QStringLiteral("mimeType"),
+                        QString(webUrlRIInfo.responseHeaders().value(QByteArrayLiteral("content-type")))
+                    }
+                }
+            );
+    }
+    void setRecording(bool bNewRecording) {
+        bRecording=bNewRecording;
     }
 private:
-    QJsonObject jsnObj;
+    bool                       bRecording;
+    quint64                    uiSent;
+    QJsonObject                jsnObj;
+    QHash<QString,QJsonObject> hshExchanges;
 };
 
-bool browse(QUrl          urlURL,
-            QNetworkProxy npxProxy,
-            QString       sAgent,
-            QString       &sJSON) {
-    bool                   bResult;
-    QString                sContents;
-    QWebEnginePage         webPage;
+QJsonObject getHar(QUrl                   urlURL,
+                   QJsonObject            jsoTimings,
+                   UrlRequestInterceptor  &urqInterceptor,
+                   UrlResponseInterceptor &uriInterceptor,
+                   QJsonArray             &jsaResources) {
+    double      dOrigin=jsoTimings.value(QStringLiteral("origin")).toDouble();
+    QJsonArray  jsaEntries;
+    QJsonObject jsoPageTimings={
+        {QStringLiteral("onContentLoad"),-1},
+        {QStringLiteral("onLoad"),-1}
+    };
+    // Phases the browser won't disclose (cross-origin resources with no ...
+    // ... Timing-Allow-Origin header, or reused connections) are zeros.
+    auto fnSpan=[](double dFrom,double dTo) {
+        return dFrom>0.0&&dTo>=dFrom?dTo-dFrom:-1.0;
+    };
+    auto fnDateTime=[dOrigin](double dOffset) {
+        return QDateTime::fromMSecsSinceEpoch(qint64(dOrigin+dOffset),Qt::TimeSpec::UTC).toString(
+            Qt::DateFormat::ISODateWithMs
+        );
+    };
+    jsaResources=QJsonArray();
+    for(const auto &v:jsoTimings.value(QStringLiteral("entries")).toArray()) {
+        QJsonObject jsoEntry=v.toObject(),
+                    jsoRequest=urqInterceptor.getRequest(jsoEntry.value(QStringLiteral("name")).toString()),
+                    jsoExchange=uriInterceptor.getExchange(jsoEntry.value(QStringLiteral("name")).toString()),
+                    jsoQuery;
+        QJsonArray  jsaQuery;
+        QString     sUrl=jsoEntry.value(QStringLiteral("name")).toString(),
+                    sInitiatorType=jsoEntry.value(QStringLiteral("type")).toString(),
+                    sProtocol=jsoEntry.value(QStringLiteral("protocol")).toString(),
+                    sMimeType=jsoExchange.value(QStringLiteral("mimeType")).toString();
+        double      dStart=jsoEntry.value(QStringLiteral("start")).toDouble(),
+                    dDuration=jsoEntry.value(QStringLiteral("duration")).toDouble(),
+                    dFirstPhase=-1.0,
+                    dWait=fnSpan(
+                        jsoEntry.value(QStringLiteral("requestStart")).toDouble(),
+                        jsoEntry.value(QStringLiteral("responseStart")).toDouble()
+                    ),
+                    dReceive=fnSpan(
+                        jsoEntry.value(QStringLiteral("responseStart")).toDouble(),
+                        jsoEntry.value(QStringLiteral("responseEnd")).toDouble()
+                    );
+        if(QStringLiteral("navigation")==sInitiatorType) {
+            double dContentLoaded=jsoEntry.value(QStringLiteral("contentLoaded")).toDouble(),
+                   dLoaded=jsoEntry.value(QStringLiteral("loaded")).toDouble();
+            if(dContentLoaded>0.0)
+                jsoPageTimings[QStringLiteral("onContentLoad")]=dContentLoaded;
+            if(dLoaded>0.0)
+                jsoPageTimings[QStringLiteral("onLoad")]=dLoaded;
+        }
+        for(const auto &s:{QStringLiteral("dnsStart"),QStringLiteral("connectStart"),QStringLiteral("requestStart")})
+            if(dFirstPhase<0.0&&jsoEntry.value(s).toDouble()>0.0)
+                dFirstPhase=jsoEntry.value(s).toDouble();
+        // Undisclosed, the whole time goes to the transfer.
+        if(dWait<0.0||dReceive<0.0) {
+            dWait=0.0;
+            dReceive=dDuration;
+        }
+        for(const auto &q:QUrlQuery(QUrl(sUrl)).queryItems(QUrl::ComponentFormattingOption::FullyDecoded))
+            jsaQuery.append(QJsonObject({
+                {QStringLiteral("name"),q.first},
+                {QStringLiteral("value"),q.second}
+            }));
+        if(QStringLiteral("h2")==sProtocol)
+            sProtocol=QStringLiteral("HTTP/2");
+        else if(QStringLiteral("h3")==sProtocol)
+            sProtocol=QStringLiteral("HTTP/3");
+        else
+            sProtocol=sProtocol.toUpper();
+        jsaEntries.append(QJsonObject({
+            {QStringLiteral("pageref"),QStringLiteral(HAR_PAGE_ID)},
+            {QStringLiteral("startedDateTime"),fnDateTime(dStart)},
+            {QStringLiteral("time"),dDuration},
+            {
+                QStringLiteral("request"),
+                QJsonObject({
+                    {QStringLiteral("method"),jsoRequest.value(QStringLiteral("method")).toString(QStringLiteral("GET"))},
+                    {QStringLiteral("url"),sUrl},
+                    {QStringLiteral("httpVersion"),sProtocol},
+                    {QStringLiteral("cookies"),QJsonArray()},
+                    {QStringLiteral("headers"),jsoExchange.value(QStringLiteral("request")).toArray()},
+                    {QStringLiteral("queryString"),jsaQuery},
+                    {QStringLiteral("headersSize"),-1},
+                    {QStringLiteral("bodySize"),-1}
+                })
+            },
+            {
+                QStringLiteral("response"),
+                QJsonObject({
+                    {QStringLiteral("status"),jsoEntry.value(QStringLiteral("status")).toInt()},
+                    {QStringLiteral("statusText"),QString()},
+                    {QStringLiteral("httpVersion"),sProtocol},
+                    {QStringLiteral("cookies"),QJsonArray()},
+                    {QStringLiteral("headers"),jsoExchange.value(QStringLiteral("response")).toArray()},
+                    {
+                        QStringLiteral("content"),
+                        QJsonObject({
+                            {QStringLiteral("size"),jsoEntry.value(QStringLiteral("decoded")).toDouble()},
+                            {QStringLiteral("mimeType"),sMimeType.isEmpty()?QStringLiteral("x-unknown"):sMimeType}
+                        })
+                    },
+                    {QStringLiteral("redirectURL"),QString()},
+                    {QStringLiteral("headersSize"),-1},
+                    {QStringLiteral("bodySize"),jsoEntry.value(QStringLiteral("encoded")).toDouble()},
+                    {QStringLiteral("_transferSize"),jsoEntry.value(QStringLiteral("transfer")).toDouble()}
+                })
+            },
+            {QStringLiteral("cache"),QJsonObject()},
+            {
+                QStringLiteral("timings"),
+                QJsonObject({
+                    {QStringLiteral("blocked"),dFirstPhase>=dStart?dFirstPhase-dStart:-1.0},
+                    {
+                        QStringLiteral("dns"),
+                        fnSpan(
+                            jsoEntry.value(QStringLiteral("dnsStart")).toDouble(),
+                            jsoEntry.value(QStringLiteral("dnsEnd")).toDouble()
+                        )
+                    },
+                    {
+                        QStringLiteral("connect"),
+                        fnSpan(
+                            jsoEntry.value(QStringLiteral("connectStart")).toDouble(),
+                            jsoEntry.value(QStringLiteral("connectEnd")).toDouble()
+                        )
+                    },
+                    {
+                        QStringLiteral("ssl"),
+                        fnSpan(
+                            jsoEntry.value(QStringLiteral("sslStart")).toDouble(),
+                            jsoEntry.value(QStringLiteral("connectEnd")).toDouble()
+                        )
+                    },
+                    {QStringLiteral("send"),0},
+                    {QStringLiteral("wait"),dWait},
+                    {QStringLiteral("receive"),dReceive}
+                })
+            },
+            {
+                QStringLiteral("_initiator"),
+                QJsonObject({
+                    {QStringLiteral("type"),sInitiatorType},
+                    {QStringLiteral("url"),jsoRequest.value(QStringLiteral("initiator")).toString()}
+                })
+            },
+            {
+                QStringLiteral("_resourceType"),
+                jsoRequest.value(QStringLiteral("type")).toString(QStringLiteral("other"))
+            }
+        }));
+        // The summary the main program aggregates: what, why, how long, how big.
+        jsaResources.append(QJsonArray({
+            sUrl,
+            sInitiatorType,
+            dDuration,
+            jsoEntry.value(QStringLiteral("transfer")).toDouble()
+        }));
+    }
+    return {
+        {
+            QStringLiteral("log"),
+            QJsonObject({
+                {QStringLiteral("version"),QStringLiteral(HAR_VERSION)},
+                {
+                    QStringLiteral("creator"),
+                    QJsonObject({
+                        {QStringLiteral("name"),QStringLiteral(HAR_CREATOR)},
+                        {QStringLiteral("version"),QStringLiteral(HAR_CREATOR_VERSION)}
+                    })
+                },
+                {
+                    QStringLiteral("browser"),
+                    QJsonObject({
+                        {QStringLiteral("name"),QStringLiteral("Chromium")},
+                        {QStringLiteral("version"),QString(qWebEngineChromiumVersion())}
+                    })
+                },
+                {
+                    QStringLiteral("pages"),
+                    QJsonArray({
+                        QJsonObject({
+                            {QStringLiteral("startedDateTime"),fnDateTime(0.0)},
+                            {QStringLiteral("id"),QStringLiteral(HAR_PAGE_ID)},
+                            {QStringLiteral("title"),urlURL.toString()},
+                            {QStringLiteral("pageTimings"),jsoPageTimings}
+                        })
+                    })
+                },
+                {QStringLiteral("entries"),jsaEntries}
+            })
+        }
+    };
+}
+
+QWebEngineProfile *openProfile(QString                    sFolder,
+                               std::unique_ptr<QLockFile> &lkfSlot,
+                               QObject                    *objParent) {
+    QWebEngineProfile *webProfile;
+    lkfSlot.reset();
+    // No folder means a cold load: nothing is read from nor left on disk.
+    if(sFolder.isEmpty()) {
+        webProfile=new QWebEngineProfile(objParent);
+        webProfile->setHttpCacheType(QWebEngineProfile::HttpCacheType::MemoryHttpCache);
+        return webProfile;
+    }
+    // Chromium does not share a profile between processes, so each helper ...
+    // ... takes the first free slot and keeps it until it exits.
+    for(int iK=0;iK<MAX_PROFILE_SLOTS;iK++) {
+        QString sSlot=QStringLiteral("%1/slot-%2").arg(sFolder).arg(iK);
+        QDir().mkpath(sSlot);
+        lkfSlot.reset(new QLockFile(QStringLiteral("%1.lock").arg(sSlot)));
+        if(lkfSlot->tryLock(0)) {
+            webProfile=new QWebEngineProfile(QStringLiteral("warm-%1").arg(iK),objParent);
+            webProfile->setPersistentStoragePath(sSlot);
+            webProfile->setCachePath(QStringLiteral("%1/cache").arg(sSlot));
+            webProfile->setHttpCacheType(QWebEngineProfile::HttpCacheType::DiskHttpCache);
+            return webProfile;
+        }
+    }
+    lkfSlot.reset();
+    return nullptr;
+}
+
+bool browse(QUrl              urlURL,
+            QNetworkProxy     npxProxy,
+            QString           sAgent,
+            QWebEngineProfile *webProfile,
+            Completion        cmpUntil,
+            bool              bContent,
+            bool              bTimings,
+            QString           sHarPath,
+            QString           &sJSON) {
+    bool                   bResult,
+                           bDone=false,
+                           bLoaded=false,
+                           bPolling=false,
+                           bRecording=bTimings||!sHarPath.isEmpty();
+    int                    iResources=-1;
+    quint64                uiReceived=0;
+    QString                sContents,
+                           sError;
     QEventLoop             evlBrowse;
+    QTimer                 tmrPoll,
+                           tmrBudget;
+    QElapsedTimer          etmLoaded;
     QJsonObject            jsnParams,
-                           jsnResponse;
+                           jsnResponse,
+                           jsoTimings;
+    QJsonArray             jsaResources;
+    QWebEngineScript       wscBuffer;
+    UrlRequestInterceptor  urqInterceptor;
     UrlResponseInterceptor uriInterceptor;
+    // Last, so it goes first: pending script callbacks still find the rest.
+    QWebEnginePage         webPage(webProfile);
     sJSON.clear();
     // Includes the passed parameters in the response as well.
     jsnParams[QStringLiteral("url")]=urlURL.toString();
     jsnParams[QStringLiteral("proxy")]=ProxyParser::getTextFromProxy(npxProxy);
     jsnParams[QStringLiteral("agent")]=sAgent;
+    jsnParams[QStringLiteral("profile")]=webProfile->isOffTheRecord()?QStringLiteral("cold"):
+                                                                     QStringLiteral("warm");
+    jsnParams[QStringLiteral("until")]=cmpUntil.sText;
     jsnResponse[QStringLiteral("params")]=jsnParams;
     // Adds a fake password when the proxy only requires the user name.
     // QtNetwork seems to misbehave in this particularly specific case.
@@ -44,6 +434,50 @@ bool browse(QUrl          urlURL,
     QNetworkProxy::setApplicationProxy(npxProxy);
     if(!sAgent.isEmpty())
         webPage.profile()->setHttpUserAgent(sAgent);
+    // Ends the wait once. The page may well keep loading in the meantime.
+    auto fnComplete=[&](QString sFailure) {
+        if(bDone)
+            return;
+        bDone=true;
+        sError=sFailure;
+        tmrPoll.stop();
+        tmrBudget.stop();
+        if(sError.isEmpty()&&bContent) {
+            QEventLoop evlContent;
+            webPage.toHtml(
+                [&](const QString &sHTML) {
+                    sContents=sHTML;
+                    evlContent.exit();
+                }
+            );
+            // Waits until the page HTML contents are fully available.
+            evlContent.exec();
+        }
+        // Reads back the timings of the page itself and of every resource. ...
+        // ... Always, as they also tell the bytes received.
+        if(sError.isEmpty()) {
+            QEventLoop evlTimings;
+            webPage.runJavaScript(
+                QStringLiteral(
+                    "JSON.stringify({origin:performance.timeOrigin,entries:performance.getEntriesByType('navigation')"
+                    ".concat(performance.getEntriesByType('resource')).map(e=>({name:e.name,type:e.initiatorType,"
+                    "start:e.startTime,duration:e.duration,dnsStart:e.domainLookupStart,dnsEnd:e.domainLookupEnd,"
+                    "connectStart:e.connectStart,connectEnd:e.connectEnd,sslStart:e.secureConnectionStart,"
+                    "requestStart:e.requestStart,responseStart:e.responseStart,responseEnd:e.responseEnd,"
+                    "transfer:e.transferSize,encoded:e.encodedBodySize,decoded:e.decodedBodySize,"
+                    "protocol:e.nextHopProtocol,status:e.responseStatus||0,"
+                    "contentLoaded:e.domContentLoadedEventEnd||0,loaded:e.loadEventEnd||0}))})"
+                ),
+                [&](const QVariant &varResult) {
+                    jsoTimings=QJsonDocument::fromJson(varResult.toString().toUtf8()).object();
+                    evlTimings.exit();
+                }
+            );
+            evlTimings.exec();
+        }
+        webPage.triggerAction(QWebEnginePage::WebAction::Stop);
+        evlBrowse.exit(sError.isEmpty());
+    };
     QObject::connect(
         &webPage,
         &QWebEnginePage::certificateError,
@@ -57,36 +491,150 @@ bool browse(QUrl          urlURL,
         &webPage,
         &QWebEnginePage::loadFinished,
         [&](bool bOK) {
-            if(bOK) {
-                QEventLoop evlContent;
-                webPage.toHtml(
-                    [&](const QString &sHTML) {
-                        sContents=sHTML;
-                        evlContent.exit();
-                    }
+            bLoaded=true;
+            etmLoaded.start();
+            if(!bOK)
+                fnComplete(QStringLiteral("Unable to load the URL"));
+            // Whatever comes before the load event is done by now.
+            else if(CompletionMode::CM_IDLE!=cmpUntil.cmMode&&CompletionMode::CM_SELECTOR!=cmpUntil.cmMode)
+                fnComplete(QString());
+        }
+    );
+    QObject::connect(
+        &tmrPoll,
+        &QTimer::timeout,
+        [&]() {
+            QString sScript;
+            if(bPolling)
+                return;
+            if(bLoaded&&etmLoaded.elapsed()>=COMPLETION_GRACE) {
+                fnComplete(
+                    CompletionMode::CM_IDLE==cmpUntil.cmMode?QStringLiteral("The network never went idle"):
+                                                             QStringLiteral("The selector never matched")
                 );
-                // Waits until the page HTML contents are fully available.
-                evlContent.exec();
+                return;
             }
-            evlBrowse.exit(bOK);
+            // The blank page is there until the first response commits.
+            if(CompletionMode::CM_DOM==cmpUntil.cmMode)
+                sScript=QStringLiteral("document.URL!=='about:blank'&&document.readyState!=='loading'");
+            else if(CompletionMode::CM_SELECTOR==cmpUntil.cmMode)
+                sScript=QStringLiteral("document.URL!=='about:blank'&&document.querySelector(%1[0])!==null").arg(
+                    QString(QJsonDocument(QJsonArray({cmpUntil.sSelector})).toJson(QJsonDocument::JsonFormat::Compact))
+                );
+            else
+                sScript=QStringLiteral(
+                    "document.URL!=='about:blank'&&document.readyState!=='loading'?"
+                    "performance.getEntriesByType('resource').length:-1"
+                );
+            bPolling=true;
+            webPage.runJavaScript(
+                sScript,
+                [&](const QVariant &varResult) {
+                    bPolling=false;
+                    if(bDone)
+                        return;
+                    if(CompletionMode::CM_IDLE!=cmpUntil.cmMode) {
+                        if(varResult.toBool())
+                            fnComplete(QString());
+                    }
+                    // Idle: no request sent and no resource finished for a while.
+                    else if(varResult.toInt()!=iResources) {
+                        iResources=varResult.toInt();
+                        urqInterceptor.touch();
+                    }
+                    else if(iResources>=0&&urqInterceptor.getIdleTime()>=cmpUntil.iMillis)
+                        fnComplete(QString());
+                }
+            );
+        }
+    );
+    tmrBudget.setSingleShot(true);
+    QObject::connect(
+        &tmrBudget,
+        &QTimer::timeout,
+        [&]() {
+            // Measures whatever got done within the budget.
+            fnComplete(QString());
         }
     );
+    // Raises the resource timing buffer before the page can fill it.
+    wscBuffer.setSourceCode(
+        QStringLiteral("performance.setResourceTimingBufferSize(%1);").arg(RESOURCE_TIMING_BUFFER)
+    );
+    wscBuffer.setInjectionPoint(QWebEngineScript::InjectionPoint::DocumentCreation);
+    wscBuffer.setWorldId(QWebEngineScript::ScriptWorldId::MainWorld);
+    wscBuffer.setRunsOnSubFrames(false);
+    webPage.scripts().insert(wscBuffer);
+    urqInterceptor.setRecording(bRecording);
+    uriInterceptor.setRecording(bRecording);
+    webPage.setUrlRequestInterceptor(&urqInterceptor);
     webPage.setUrlResponseInterceptor(&uriInterceptor);
     webPage.load(urlURL);
-    // Waits until the web page is fully loaded (or some error occurs).
+    if(CompletionMode::CM_TIME==cmpUntil.cmMode)
+        tmrBudget.start(cmpUntil.iMillis);
+    else if(CompletionMode::CM_LOAD!=cmpUntil.cmMode)
+        tmrPoll.start(COMPLETION_POLL_INTERVAL);
+    // Waits until the page is complete, as requested (or some error occurs).
     if(bResult=evlBrowse.exec()) {
         jsnResponse[QStringLiteral("headers")]=uriInterceptor.getHeaders();
-        jsnResponse[QStringLiteral("content")]=sContents;
+        if(bContent)
+            jsnResponse[QStringLiteral("content")]=sContents;
+        if(bRecording) {
+            QJsonObject jsoHar=getHar(urlURL,jsoTimings,urqInterceptor,uriInterceptor,jsaResources);
+            if(bTimings)
+                jsnResponse[QStringLiteral("resources")]=jsaResources;
+            // A HAR file that can't be written doesn't fail the hit.
+            if(!sHarPath.isEmpty()) {
+                QSaveFile sfHar(sHarPath);
+                if(!sfHar.open(QIODevice::OpenModeFlag::WriteOnly)||
+                   -1==sfHar.write(QJsonDocument(jsoHar).toJson(QJsonDocument::JsonFormat::Compact))||
+                   !sfHar.commit())
+                    jsnResponse[QStringLiteral("harError")]=sfHar.errorString();
+            }
+        }
     }
     else
-        jsnResponse[QStringLiteral("error")]=QStringLiteral("Unable to load the URL");
+        jsnResponse[QStringLiteral("error")]=sError;
+    // Only what the page could time is received: cross-origin resources ...
+    // ... without Timing-Allow-Origin report no size.
+    for(const auto &v:jsoTimings.value(QStringLiteral("entries")).toArray())
+        uiReceived+=quint64(qMax(0.0,v.toObject().value(QStringLiteral("transfer")).toDouble()));
+    jsnResponse[QStringLiteral("traffic")]=QJsonArray({double(uriInterceptor.getSent()),double(uiReceived)});
     sJSON=QJsonDocument(jsnResponse).toJson();
     return bResult;
 }
 
+bool parseCompletion(QString sText,Completion &cmpUntil) {
+    bool    bOK=true;
+    QString sMode=sText.section(QLatin1Char(':'),0,0),
+            sValue=sText.section(QLatin1Char(':'),1);
+    cmpUntil={CompletionMode::CM_LOAD,0,QString(),sText};
+    if(sText.isEmpty()||QStringLiteral("load")==sText)
+        cmpUntil.sText=QStringLiteral("load");
+    else if(QStringLiteral("dom")==sText)
+        cmpUntil.cmMode=CompletionMode::CM_DOM;
+    else if(QStringLiteral("selector")==sMode&&!sValue.isEmpty()) {
+        cmpUntil.cmMode=CompletionMode::CM_SELECTOR;
+        cmpUntil.sSelector=sValue;
+    }
+    else if(QStringLiteral("idle")==sMode||QStringLiteral("time")==sMode) {
+        cmpUntil.cmMode=QStringLiteral("idle")==sMode?CompletionMode::CM_IDLE:CompletionMode::CM_TIME;
+        cmpUntil.iMillis=sValue.toInt(&bOK);
+        bOK=bOK&&cmpUntil.iMillis>0;
+    }
+    else
+        bOK=false;
+    return bOK;
+}
+
 bool parseParams(QUrl          &urlURL,
                  QNetworkProxy &npxProxy,
                  QString       &sAgent,
+                 QString       &sWarmFolder,
+                 Completion    &cmpUntil,
+                 bool          &bContent,
+                 bool          &bTimings,
+                 QString       &sHarPath,
                  QString       &sError) {
     QString            sURL,
                        sProxy;
@@ -94,6 +642,11 @@ bool parseParams(QUrl          &urlURL,
     urlURL.clear();
     npxProxy=QNetworkProxy();
     sAgent.clear();
+    sWarmFolder.clear();
+    cmpUntil={CompletionMode::CM_LOAD,0,QString(),QStringLiteral("load")};
+    bContent=true;
+    bTimings=false;
+    sHarPath.clear();
     sError.clear();
     clpParser.setApplicationDescription(
         QStringLiteral("Browses to the given URL and returns a JSON-encoded response")
@@ -123,6 +676,55 @@ bool parseParams(QUrl          &urlURL,
             QStringLiteral("agent")
         }
     );
+    clpParser.addOption(
+        {
+            {
+                QStringLiteral("w"),
+                QStringLiteral("warm")
+            },
+            QStringLiteral("Keep a warm profile (HTTP cache included) in Folder"),
+            QStringLiteral("folder")
+        }
+    );
+    clpParser.addOption(
+        {
+            {
+                QStringLiteral("u"),
+                QStringLiteral("until")
+            },
+            QStringLiteral("Consider the page complete on: load (default), dom, "
+                           "idle:<ms>, selector:<css> or time:<ms>"),
+            QStringLiteral("criterion")
+        }
+    );
+    clpParser.addOption(
+        {
+            {
+                QStringLiteral("n"),
+                QStringLiteral("no-content")
+            },
+            QStringLiteral("Do not return the page HTML")
+        }
+    );
+    clpParser.addOption(
+        {
+            {
+                QStringLiteral("t"),
+                QStringLiteral("timings")
+            },
+            QStringLiteral("Return the timing and size of every resource")
+        }
+    );
+    clpParser.addOption(
+        {
+            {
+                QStringLiteral("r"),
+                QStringLiteral("har")
+            },
+            QStringLiteral("Save every request and its timings to a HAR File"),
+            QStringLiteral("file")
+        }
+    );
     // Encapsulates the making of an error message, immediately followed ...
     // ... by the application's description and usage, handly when a lot ...
     // ... of parameter validations are necessary (when it's called with ...
@@ -154,10 +756,20 @@ bool parseParams(QUrl          &urlURL,
         return false;
     }
     sAgent=clpParser.value(QStringLiteral("agent"));
+    sWarmFolder=clpParser.value(QStringLiteral("warm"));
+    if(!parseCompletion(clpParser.value(QStringLiteral("until")),cmpUntil)) {
+        sError=fnMakeErrMsg(QStringLiteral("Invalid completion criterion"));
+        return false;
+    }
+    bContent=!clpParser.isSet(QStringLiteral("no-content"));
+    bTimings=clpParser.isSet(QStringLiteral("timings"));
+    sHarPath=clpParser.value(QStringLiteral("har"));
     return true;
 }
 
 int main(int argc,char *argv[]) {
+    // The warm slot stays locked until the profile (owned by the app) is gone.
+    std::unique_ptr<QLockFile> lkfSlot;
     // Creates a widgets app, since QtWebEngine does not work in console.
     QApplication appMain(argc,argv);
     // Encapsulates the 'console' code inside a lambda, so it's called ...
@@ -168,21 +780,35 @@ int main(int argc,char *argv[]) {
     // ... otherwise, the application would never reach an exit point.
     QTimer::singleShot(
         0,
-        [&appMain]() {
+        [&appMain,&lkfSlot]() {
+            bool              bContent,
+                              bTimings;
             QString           sAgent,
+                              sWarmFolder,
+                              sHarPath,
                               sError,
                               sJSON;
             QUrl              urlURL;
+            Completion        cmpUntil;
             QNetworkProxy     npxProxy;
             QTextStream       tstOutput(stdout);
+            QWebEngineProfile *webProfile=nullptr;
             // Shows the results (either an error or a JSON response, and exits.
             // The use of QTextStream is an alternative to 'std::cout', with ...
             // ... the plus of not having to do 'toStdString()' conversionss.
-            if(!parseParams(urlURL,npxProxy,sAgent,sError)) {
+            if(!parseParams(urlURL,npxProxy,sAgent,sWarmFolder,cmpUntil,bContent,bTimings,sHarPath,sError)) {
                 tstOutput << sError;
                 appMain.exit(EXIT_FAILURE);
             }
-            else if(!browse(urlURL,npxProxy,sAgent,sJSON)) {
+            else if(nullptr==(webProfile=openProfile(sWarmFolder,lkfSlot,&appMain))) {
+                tstOutput << QJsonDocument(
+                    QJsonObject({
+                        {QStringLiteral("error"),QStringLiteral("No free warm profile slot")}
+                    })
+                ).toJson();
+                appMain.exit(EXIT_FAILURE);
+            }
+            else if(!browse(urlURL,npxProxy,sAgent,webProfile,cmpUntil,bContent,bTimings,sHarPath,sJSON)) {
                 tstOutput << sJSON;
                 appMain.exit(EXIT_FAILURE);
             }
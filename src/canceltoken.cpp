@@ -0,0 +1,26 @@
+#include "canceltoken.h"
+
+CancelToken::CancelToken() {
+    bCancelled=false;
+}
+
+void CancelToken::cancel() {
+    QMutexLocker mlkWait(&mtxWait);
+    bCancelled=true;
+    // Wakes up every worker still sleeping through its cooldown.
+    wcnWait.wakeAll();
+}
+
+bool CancelToken::isCancelled() {
+    return bCancelled;
+}
+
+bool CancelToken::sleep(uint uiMilliseconds) {
+    QMutexLocker   mlkWait(&mtxWait);
+    QDeadlineTimer dtmWait(uiMilliseconds);
+    // Returns false when the wait was interrupted by a cancellation.
+    while(!bCancelled)
+        if(!wcnWait.wait(&mtxWait,dtmWait))
+            break;
+    return !bCancelled;
+}
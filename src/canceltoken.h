@@ -0,0 +1,21 @@
+#ifndef CANCELTOKEN_H
+#define CANCELTOKEN_H
+
+#include <QtCore>
+#include <atomic>
+
+class CancelToken {
+public:
+    CancelToken();
+    void cancel();
+    bool isCancelled();
+    bool sleep(uint);
+private:
+    std::atomic<bool> bCancelled;
+    QMutex            mtxWait;
+    QWaitCondition    wcnWait;
+};
+
+using CancelTokenPtr=QSharedPointer<CancelToken>;
+
+#endif // CANCELTOKEN_H
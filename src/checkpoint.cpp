@@ -0,0 +1,165 @@
+#include "checkpoint.h"
+
+#define CHECKPOINT_MAGIC   0x4D42434B
+#define CHECKPOINT_VERSION 6
+
+QDataStream &operator<<(QDataStream &dstStream,const CheckpointCounters &ccCounters) {
+    return dstStream << ccCounters.uiHits << ccCounters.uiErrors << ccCounters.uiCancels;
+}
+
+QDataStream &operator>>(QDataStream &dstStream,CheckpointCounters &ccCounters) {
+    return dstStream >> ccCounters.uiHits >> ccCounters.uiErrors >> ccCounters.uiCancels;
+}
+
+QByteArray Checkpoint::getFingerprint(QStringList slInputs) {
+    QCryptographicHash chsHash(QCryptographicHash::Algorithm::Sha1);
+    // Every list is hashed along with its length, so they can't be confused.
+    for(const auto &s:slInputs) {
+        QByteArray bytInput=s.toUtf8();
+        chsHash.addData(QByteArray::number(bytInput.size()));
+        chsHash.addData(bytInput);
+    }
+    return chsHash.result();
+}
+
+bool Checkpoint::readFromFile(QString sPath,CheckpointData &cdData,QString &sError) {
+    quint16               uiVersion;
+    quint32               uiMagic;
+    QFile                 fFile;
+    QDataStream           dstStream;
+    QMap<quint32,QString> mapLinkErrors;
+    sError.clear();
+    fFile.setFileName(sPath);
+    if(!fFile.open(QFile::OpenModeFlag::ReadOnly)) {
+        sError=fFile.errorString();
+        return false;
+    }
+    dstStream.setDevice(&fFile);
+    dstStream.setVersion(QDataStream::Version::Qt_5_15);
+    dstStream >> uiMagic >> uiVersion;
+    if(CHECKPOINT_MAGIC!=uiMagic||!uiVersion||CHECKPOINT_VERSION<uiVersion) {
+        sError=QStringLiteral("Not a valid checkpoint file");
+        return false;
+    }
+    dstStream >> cdData.bytFingerprint
+              >> cdData.bytRandomState
+              >> cdData.uiScheduled
+              >> cdData.uiElapsed
+              >> cdData.ccvLinks
+              >> cdData.ccvProxies;
+    // Up to version 4, this slot held the last error message of each link, ...
+    // ... which tells nothing about the counts by kind, so it's skipped.
+    cdData.mapLinkErrorKinds.clear();
+    if(uiVersion>=5)
+        dstStream >> cdData.mapLinkErrorKinds;
+    else
+        dstStream >> mapLinkErrors;
+    // Version 1 files predate the assertions, so they have no failures.
+    cdData.mapLinkFailures.clear();
+    if(uiVersion>=2)
+        dstStream >> cdData.mapLinkFailures;
+    // Nor did version 2 ones have any retries.
+    cdData.mapLinkRetries.clear();
+    if(uiVersion>=3)
+        dstStream >> cdData.mapLinkRetries;
+    // And the revalidations came with version 4.
+    cdData.mapLinkRevalidations.clear();
+    if(uiVersion>=4)
+        dstStream >> cdData.mapLinkRevalidations;
+    // Proxies got their errors by kind with version 5 as well.
+    cdData.mapProxyErrorKinds.clear();
+    if(uiVersion>=5)
+        dstStream >> cdData.mapProxyErrorKinds;
+    // Bytes sent and received, by link and by proxy, since version 6.
+    cdData.mapLinkTraffic.clear();
+    cdData.mapProxyTraffic.clear();
+    if(uiVersion>=6)
+        dstStream >> cdData.mapLinkTraffic >> cdData.mapProxyTraffic;
+    if(QDataStream::Status::Ok!=dstStream.status()) {
+        sError=QStringLiteral("Truncated or corrupt checkpoint file");
+        return false;
+    }
+    return true;
+}
+
+bool Checkpoint::writeToFile(QString sPath,const CheckpointData &cdData,QString &sError) {
+    QSaveFile   sflFile;
+    QDataStream dstStream;
+    sError.clear();
+    // QSaveFile only replaces the previous snapshot after a complete write, ...
+    // ... so a crash in the middle of it never leaves a corrupt checkpoint.
+    sflFile.setFileName(sPath);
+    if(!sflFile.open(QFile::OpenModeFlag::WriteOnly)) {
+        sError=sflFile.errorString();
+        return false;
+    }
+    dstStream.setDevice(&sflFile);
+    dstStream.setVersion(QDataStream::Version::Qt_5_15);
+    dstStream << quint32(CHECKPOINT_MAGIC)
+              << quint16(CHECKPOINT_VERSION)
+              << cdData.bytFingerprint
+              << cdData.bytRandomState
+              << cdData.uiScheduled
+              << cdData.uiElapsed
+              << cdData.ccvLinks
+              << cdData.ccvProxies
+              << cdData.mapLinkErrorKinds
+              << cdData.mapLinkFailures
+              << cdData.mapLinkRetries
+              << cdData.mapLinkRevalidations
+              << cdData.mapProxyErrorKinds
+              << cdData.mapLinkTraffic
+              << cdData.mapProxyTraffic;
+    if(!sflFile.commit()) {
+        sError=sflFile.errorString();
+        return false;
+    }
+    return true;
+}
+
+CheckpointWriter::CheckpointWriter(QObject *objParent,QString sNewPath):
+QThread(objParent) {
+    bFinishing=false;
+    bPending=false;
+    sPath=sNewPath;
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    this->finish();
+}
+
+void CheckpointWriter::finish() {
+    {
+        QMutexLocker mlkPending(&mtxPending);
+        bFinishing=true;
+        wcnPending.wakeAll();
+    }
+    // The last submitted snapshot is always flushed before leaving.
+    this->wait();
+}
+
+void CheckpointWriter::run() {
+    forever {
+        CheckpointData cdCurrent;
+        QString        sError;
+        {
+            QMutexLocker mlkPending(&mtxPending);
+            while(!bPending&&!bFinishing)
+                wcnPending.wait(&mtxPending);
+            if(!bPending)
+                break;
+            cdCurrent=std::move(cdPending);
+            bPending=false;
+        }
+        Checkpoint::writeToFile(sPath,cdCurrent,sError);
+        emit written(sError);
+    }
+}
+
+void CheckpointWriter::submit(const CheckpointData &cdData) {
+    QMutexLocker mlkPending(&mtxPending);
+    // A snapshot that was not written yet is simply superseded.
+    cdPending=cdData;
+    bPending=true;
+    wcnPending.wakeAll();
+}
@@ -0,0 +1,56 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <QtCore>
+#include "bandwidth.h"
+#include "errortaxonomy.h"
+
+using CheckpointCounters=struct {
+    quint32 uiHits,
+            uiErrors,
+            uiCancels;
+};
+
+using CheckpointData=struct {
+    QByteArray                  bytFingerprint,
+                                bytRandomState;
+    quint64                     uiScheduled,
+                                uiElapsed;
+    QVector<CheckpointCounters> ccvLinks,
+                                ccvProxies;
+    QMap<quint32,ErrorCounts>   mapLinkErrorKinds;
+    QMap<quint32,quint32>       mapLinkFailures,
+                                mapLinkRetries,
+                                mapLinkRevalidations;
+    QMap<quint32,ErrorCounts>   mapProxyErrorKinds;
+    QMap<quint32,TrafficCounts> mapLinkTraffic,
+                                mapProxyTraffic;
+};
+
+class Checkpoint {
+public:
+    static QByteArray getFingerprint(QStringList);
+    static bool       readFromFile(QString,CheckpointData &,QString &);
+    static bool       writeToFile(QString,const CheckpointData &,QString &);
+};
+
+class CheckpointWriter:public QThread {
+    Q_OBJECT
+public:
+    CheckpointWriter(QObject * =nullptr,QString=QString());
+    ~CheckpointWriter();
+    void finish();
+    void run() override;
+    void submit(const CheckpointData &);
+signals:
+    void written(QString);
+private:
+    bool           bFinishing,
+                   bPending;
+    QString        sPath;
+    CheckpointData cdPending;
+    QMutex         mtxPending;
+    QWaitCondition wcnPending;
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,372 @@
+#include "coordinator.h"
+
+#define CONNECT_TIMEOUT 5000
+#define STOP_TIMEOUT    30000
+
+Coordinator::Coordinator(QObject *objParent,HitEngine *engNewEngine):
+QObject(objParent) {
+    bRunning=false;
+    engEngine=engNewEngine;
+    vraAgents.clear();
+}
+
+Coordinator::~Coordinator() {
+    this->release();
+}
+
+int Coordinator::getAgent(QObject *objSocket) {
+    for(int iK=0;iK<vraAgents.count();iK++)
+        if(vraAgents.at(iK).tcpSocket==objSocket)
+            return iK;
+    return -1;
+}
+
+QStringList Coordinator::getAddressesFromText(QString sText) {
+    QStringList slResult;
+    for(const auto &a:sText.split(QRegularExpression(QStringLiteral("[,;\\s]+")))) {
+        QString sAddress=a.trimmed();
+        if(!sAddress.isEmpty())
+            slResult.append(sAddress);
+    }
+    return slResult;
+}
+
+QJsonArray Coordinator::getLinkShare(int iAgent,int iAgents) {
+    const LinkStore &llLinks=engEngine->getLinks();
+    QJsonArray      jsaResult;
+    int             iActive=0;
+    // Links are dealt round-robin. Retired ones (after a reload) aren't dealt.
+    for(const auto &l:llLinks)
+        if(!l.bRetired)
+            if(iAgent==iActive++%iAgents)
+                jsaResult.append(
+                    QJsonArray({
+                        int(l.uiIndex),
+                        llLinks.getText(l.uiIndex)
+                    })
+                );
+    return jsaResult;
+}
+
+QJsonArray Coordinator::getProxyShare(int iAgent,int iAgents) {
+    const ProxyList &plProxies=engEngine->getProxies();
+    QJsonArray      jsaResult;
+    int             iActive=0,
+                    iTotal=0;
+    for(const auto &p:plProxies)
+        if(!p.bRetired)
+            iTotal++;
+    // Proxies are dealt too, unless there are not enough of them. A ...
+    // ... shared proxy has its limit split, so the agents keep it together.
+    for(const auto &p:plProxies)
+        if(!p.bRetired)
+            if(iTotal<iAgents||iAgent==iActive++%iAgents) {
+                ProxyRecord prShare=p;
+                if(iTotal<iAgents&&prShare.uiRateLimit)
+                    prShare.uiRateLimit=qMax<quint64>(1,prShare.uiRateLimit/iAgents);
+                jsaResult.append(
+                    QJsonArray({
+                        int(prShare.uiIndex),
+                        HitEngine::getTextFromProxy(prShare)
+                    })
+                );
+            }
+    return jsaResult;
+}
+
+void Coordinator::handleMessage(int iAgent,QJsonObject jsoMessage) {
+    RemoteAgent &raAgent=vraAgents[iAgent];
+    QString     sEvent=jsoMessage.value(QStringLiteral("evt")).toString();
+    if(QStringLiteral("stats")==sEvent) {
+        for(const auto &v:jsoMessage.value(QStringLiteral("links")).toArray()) {
+            QJsonArray      jsaLink=v.toArray();
+            uint            uiIndex=jsaLink.at(0).toInt();
+            RemoteLinkStats rlsStats;
+            rlsStats.uiHits=jsaLink.at(1).toDouble();
+            rlsStats.uiErrors=jsaLink.at(2).toDouble();
+            rlsStats.uiFailures=jsaLink.at(3).toDouble();
+            rlsStats.uiCancels=jsaLink.at(4).toDouble();
+            rlsStats.uiRetries=jsaLink.at(5).toDouble();
+            rlsStats.uiRevalidations=jsaLink.at(6).toDouble();
+            rlsStats.ecsErrors=ErrorTaxonomy::getCountsFromJson(jsaLink.at(7).toObject());
+            rlsStats.lhLatency=LatencyHistogram::fromJson(jsaLink.at(8).toArray());
+            rlsStats.tcTraffic={
+                quint64(jsaLink.at(9).toArray().at(0).toDouble()),
+                quint64(jsaLink.at(9).toArray().at(1).toDouble())
+            };
+            raAgent.hshLinks.insert(uiIndex,rlsStats);
+            this->mergeLink(uiIndex);
+        }
+        for(const auto &v:jsoMessage.value(QStringLiteral("proxies")).toArray()) {
+            QJsonArray jsaProxy=v.toArray();
+            uint       uiIndex=jsaProxy.at(0).toInt();
+            raAgent.hshProxies.insert(
+                uiIndex,
+                {
+                    uint(jsaProxy.at(1).toDouble()),
+                    uint(jsaProxy.at(2).toDouble()),
+                    uint(jsaProxy.at(3).toDouble()),
+                    ErrorTaxonomy::getCountsFromJson(jsaProxy.at(4).toObject()),
+                    LatencyHistogram::fromJson(jsaProxy.at(5).toArray()),
+                    {
+                        quint64(jsaProxy.at(6).toArray().at(0).toDouble()),
+                        quint64(jsaProxy.at(6).toArray().at(1).toDouble())
+                    }
+                }
+            );
+            this->mergeProxy(uiIndex);
+        }
+    }
+    else if(QStringLiteral("stopped")==sEvent)
+        raAgent.bStopped=true;
+    else if(QStringLiteral("error")==sEvent) {
+        raAgent.bStopped=true;
+        emit agentFailed(
+            QStringLiteral("%1: %2").arg(
+                raAgent.sAddress,
+                jsoMessage.value(QStringLiteral("message")).toString()
+            )
+        );
+    }
+}
+
+bool Coordinator::isRunning() {
+    return bRunning;
+}
+
+void Coordinator::mergeLink(uint uiIndex) {
+    LinkStore &llLinks=engEngine->getLinks();
+    if(uiIndex<uint(llLinks.count())) {
+        LinkRecord       &lrLink=llLinks[uiIndex];
+        LatencyHistogram lhLatency;
+        ErrorCounts      ecsErrors=ErrorCounts();
+        TrafficCounts    tcTraffic={0,0};
+        // Every agent reports its own totals, so the sum is rebuilt each time.
+        lrLink.uiHits=0;
+        lrLink.uiErrors=0;
+        lrLink.uiFailures=0;
+        lrLink.uiCancels=0;
+        lrLink.uiRetries=0;
+        lrLink.uiRevalidations=0;
+        for(const auto &a:vraAgents) {
+            auto itStats=a.hshLinks.constFind(uiIndex);
+            if(a.hshLinks.constEnd()!=itStats) {
+                lrLink.uiHits+=itStats->uiHits;
+                lrLink.uiErrors+=itStats->uiErrors;
+                lrLink.uiFailures+=itStats->uiFailures;
+                lrLink.uiCancels+=itStats->uiCancels;
+                lrLink.uiRetries+=itStats->uiRetries;
+                lrLink.uiRevalidations+=itStats->uiRevalidations;
+                for(int iK=0;iK<ErrorCode::EC_TOTAL;iK++)
+                    ecsErrors.uiCounts[iK]+=itStats->ecsErrors.uiCounts[iK];
+                lhLatency.merge(itStats->lhLatency);
+                tcTraffic.uiSent+=itStats->tcTraffic.uiSent;
+                tcTraffic.uiReceived+=itStats->tcTraffic.uiReceived;
+            }
+        }
+        llLinks.setErrors(uiIndex,ecsErrors);
+        llLinks.setLatency(uiIndex,lhLatency);
+        llLinks.setTraffic(uiIndex,tcTraffic);
+        emit linkUpdated(&lrLink);
+    }
+}
+
+void Coordinator::mergeProxy(uint uiIndex) {
+    ProxyList &plProxies=engEngine->getProxies();
+    if(uiIndex<uint(plProxies.count())) {
+        ProxyRecord &prProxy=plProxies[uiIndex];
+        prProxy.uiHits=0;
+        prProxy.uiErrors=0;
+        prProxy.uiCancels=0;
+        prProxy.ecsErrors=ErrorCounts();
+        prProxy.lhLatency=LatencyHistogram();
+        prProxy.tcTraffic={0,0};
+        for(const auto &a:vraAgents) {
+            auto itStats=a.hshProxies.constFind(uiIndex);
+            if(a.hshProxies.constEnd()!=itStats) {
+                prProxy.uiHits+=itStats->uiHits;
+                prProxy.uiErrors+=itStats->uiErrors;
+                prProxy.uiCancels+=itStats->uiCancels;
+                for(int iK=0;iK<ErrorCode::EC_TOTAL;iK++)
+                    prProxy.ecsErrors.uiCounts[iK]+=itStats->ecsErrors.uiCounts[iK];
+                prProxy.lhLatency.merge(itStats->lhLatency);
+                prProxy.tcTraffic.uiSent+=itStats->tcTraffic.uiSent;
+                prProxy.tcTraffic.uiReceived+=itStats->tcTraffic.uiReceived;
+            }
+        }
+        emit proxyUpdated(&prProxy);
+    }
+}
+
+bool Coordinator::reload(QStringList slAgents,QString &sError) {
+    QVector<int> viRunning;
+    QJsonArray   jsaAgents;
+    sError.clear();
+    for(int iK=0;iK<vraAgents.count();iK++)
+        if(!vraAgents.at(iK).bStopped)
+            viRunning.append(iK);
+    if(!bRunning||viRunning.isEmpty()) {
+        sError=QStringLiteral("No agent is running");
+        return false;
+    }
+    for(const auto &a:slAgents)
+        jsaAgents.append(a);
+    // The lists are dealt anew between the agents still running. A link ...
+    // ... that changes hands keeps the totals of both, as they are summed.
+    for(int iK=0;iK<viRunning.count();iK++)
+        RemoteProtocol::writeMessage(
+            vraAgents.at(viRunning.at(iK)).tcpSocket,
+            {
+                {QStringLiteral("cmd"),QStringLiteral("reload")},
+                {QStringLiteral("links"),this->getLinkShare(iK,viRunning.count())},
+                {QStringLiteral("proxies"),this->getProxyShare(iK,viRunning.count())},
+                {QStringLiteral("agents"),jsaAgents}
+            }
+        );
+    return true;
+}
+
+void Coordinator::release() {
+    for(auto &a:vraAgents) {
+        a.tcpSocket->disconnect(this);
+        a.tcpSocket->disconnectFromHost();
+        a.tcpSocket->deleteLater();
+    }
+    vraAgents.clear();
+}
+
+void Coordinator::setRate(uint uiWorkers,uint uiCooldown,uint uiMemory) {
+    if(bRunning)
+        for(const auto &a:vraAgents)
+            if(!a.bStopped)
+                RemoteProtocol::writeMessage(
+                    a.tcpSocket,
+                    {
+                        {QStringLiteral("cmd"),QStringLiteral("rate")},
+                        {QStringLiteral("workers"),int(uiWorkers)},
+                        {QStringLiteral("cooldown"),int(uiCooldown)},
+                        {QStringLiteral("memory"),int(uiMemory)}
+                    }
+                );
+}
+
+bool Coordinator::start(QStringList slAddresses,QString sToken,QJsonObject jsoSettings,QString &sError) {
+    bool bScenario=!jsoSettings.value(QStringLiteral("scenario")).toString().isEmpty();
+    this->release();
+    if(slAddresses.isEmpty()) {
+        sError=QStringLiteral("At least one agent is required");
+        return false;
+    }
+    if(sToken.isEmpty()) {
+        sError=QStringLiteral("The agents' token is required");
+        return false;
+    }
+    for(const auto &a:slAddresses) {
+        RemoteAgent raAgent;
+        int         iColon=a.lastIndexOf(QLatin1Char(':'));
+        quint16     uiPort=0;
+        if(iColon>0)
+            uiPort=a.mid(iColon+1).toUShort();
+        if(!uiPort) {
+            sError=QStringLiteral("Invalid agent address: %1 (host:port expected)").arg(a);
+            this->release();
+            return false;
+        }
+        raAgent.sAddress=a;
+        raAgent.bStopped=false;
+        raAgent.tcpSocket=new QTcpSocket(this);
+        vraAgents.append(raAgent);
+        raAgent.tcpSocket->connectToHost(a.left(iColon),uiPort);
+        if(!raAgent.tcpSocket->waitForConnected(CONNECT_TIMEOUT)) {
+            sError=QStringLiteral("Unable to reach agent %1: %2").arg(
+                a,
+                raAgent.tcpSocket->errorString()
+            );
+            this->release();
+            return false;
+        }
+        // Agents drop whoever doesn't open with the right token.
+        RemoteProtocol::writeMessage(
+            raAgent.tcpSocket,
+            {
+                {QStringLiteral("cmd"),QStringLiteral("hello")},
+                {QStringLiteral("token"),sToken}
+            }
+        );
+    }
+    for(int iK=0;iK<vraAgents.count();iK++) {
+        QJsonObject jsoStart=jsoSettings;
+        QJsonArray  jsaLinks;
+        // Scenario steps go to every agent.
+        if(!bScenario)
+            jsaLinks=this->getLinkShare(iK,vraAgents.count());
+        if(!bScenario&&jsaLinks.isEmpty()) {
+            // More agents than links: this one has nothing to do.
+            vraAgents[iK].bStopped=true;
+            continue;
+        }
+        jsoStart.insert(QStringLiteral("cmd"),QStringLiteral("start"));
+        jsoStart.insert(QStringLiteral("links"),jsaLinks);
+        jsoStart.insert(QStringLiteral("proxies"),this->getProxyShare(iK,vraAgents.count()));
+        connect(
+            vraAgents.at(iK).tcpSocket,
+            &QTcpSocket::readyRead,
+            this,
+            &Coordinator::agentReadyRead
+        );
+        connect(
+            vraAgents.at(iK).tcpSocket,
+            &QTcpSocket::disconnected,
+            this,
+            &Coordinator::agentDisconnected
+        );
+        RemoteProtocol::writeMessage(vraAgents.at(iK).tcpSocket,jsoStart);
+    }
+    bRunning=true;
+    return true;
+}
+
+void Coordinator::stop() {
+    QDeadlineTimer dtmStop(STOP_TIMEOUT);
+    bRunning=false;
+    for(const auto &a:vraAgents)
+        if(!a.bStopped)
+            RemoteProtocol::writeMessage(
+                a.tcpSocket,
+                {{QStringLiteral("cmd"),QStringLiteral("stop")}}
+            );
+    // Waits for the agents' final stats, but never for an unresponsive one.
+    while(!dtmStop.hasExpired()) {
+        bool bPending=false;
+        for(const auto &a:vraAgents)
+            if(!a.bStopped) {
+                bPending=true;
+                break;
+            }
+        if(!bPending)
+            break;
+        QCoreApplication::processEvents(
+            QEventLoop::ProcessEventsFlag::ExcludeUserInputEvents
+        );
+    }
+    this->release();
+}
+
+void Coordinator::agentDisconnected() {
+    int iAgent=this->getAgent(QObject::sender());
+    if(iAgent>=0)
+        if(!vraAgents.at(iAgent).bStopped) {
+            vraAgents[iAgent].bStopped=true;
+            if(bRunning)
+                emit agentFailed(
+                    QStringLiteral("Agent %1 disconnected").arg(vraAgents.at(iAgent).sAddress)
+                );
+        }
+}
+
+void Coordinator::agentReadyRead() {
+    int iAgent=this->getAgent(QObject::sender());
+    if(iAgent>=0)
+        for(const auto &m:RemoteProtocol::readMessages(vraAgents.at(iAgent).tcpSocket))
+            this->handleMessage(iAgent,m);
+}
@@ -0,0 +1,70 @@
+#ifndef COORDINATOR_H
+#define COORDINATOR_H
+
+#include <QtCore>
+#include <QtNetwork>
+#include "hitengine.h"
+#include "latencyhistogram.h"
+#include "remoteprotocol.h"
+
+using RemoteLinkStats=struct {
+    uint             uiHits,
+                     uiErrors,
+                     uiFailures,
+                     uiCancels,
+                     uiRetries,
+                     uiRevalidations;
+    ErrorCounts      ecsErrors;
+    LatencyHistogram lhLatency;
+    TrafficCounts    tcTraffic;
+};
+
+using RemoteProxyStats=struct {
+    uint             uiHits,
+                     uiErrors,
+                     uiCancels;
+    ErrorCounts      ecsErrors;
+    LatencyHistogram lhLatency;
+    TrafficCounts    tcTraffic;
+};
+
+using RemoteAgent=struct {
+    QString                      sAddress;
+    bool                         bStopped;
+    QTcpSocket                   *tcpSocket;
+    QHash<uint,RemoteLinkStats>  hshLinks;
+    QHash<uint,RemoteProxyStats> hshProxies;
+};
+
+class Coordinator:public QObject {
+    Q_OBJECT
+public:
+    Coordinator(QObject * =nullptr,HitEngine * =nullptr);
+    ~Coordinator();
+    bool isRunning();
+    bool reload(QStringList,QString &);
+    void setRate(uint,uint,uint);
+    bool start(QStringList,QString,QJsonObject,QString &);
+    void stop();
+    static QStringList getAddressesFromText(QString);
+signals:
+    void agentFailed(QString);
+    void linkUpdated(LinkRecord *);
+    void proxyUpdated(ProxyRecord *);
+private slots:
+    void agentDisconnected();
+    void agentReadyRead();
+private:
+    bool                 bRunning;
+    HitEngine            *engEngine;
+    QVector<RemoteAgent> vraAgents;
+    int        getAgent(QObject *);
+    QJsonArray getLinkShare(int,int);
+    QJsonArray getProxyShare(int,int);
+    void       handleMessage(int,QJsonObject);
+    void       mergeLink(uint);
+    void       mergeProxy(uint);
+    void       release();
+};
+
+#endif // COORDINATOR_H
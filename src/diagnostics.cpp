@@ -0,0 +1,251 @@
+#include "diagnostics.h"
+#include "memorygovernor.h"
+#include "tlssessioncache.h"
+
+#include <atomic>
+#include <chrono>
+
+// How often (in ms) the event loop is expected to fire the probe.
+#define LAG_PROBE_INTERVAL 100
+
+// The cost of the tool itself, as opposed to the target's: the same ...
+// ... lock-free counters as the metrics, just pointed the other way.
+
+using TimerCounters=struct {
+    std::atomic<quint64> uiCount,
+                         uiTotal,
+                         uiMax;
+};
+
+static TimerCounters        tcrScheduler,
+                            tcrSpawns,
+                            tcrUpdates,
+                            tcrLag;
+static std::atomic<quint64> uiScheduledHits{0},
+                            uiPicks{0},
+                            uiProbes{0},
+                            uiMaxProbes{0},
+                            uiLastLag{0};
+static std::atomic<qint64>  iQueueDepth{0},
+                            iMaxQueueDepth{0},
+                            iRunStart{0};
+
+static qint64 getNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+template<typename T> static void raiseMax(std::atomic<T> &atmMax,T tValue) {
+    T tCurrent=atmMax.load(std::memory_order_relaxed);
+    while(tCurrent<tValue&&!atmMax.compare_exchange_weak(tCurrent,tValue,std::memory_order_relaxed));
+}
+
+static void recordTimer(TimerCounters &tcrTimer,quint64 uiValue) {
+    tcrTimer.uiCount.fetch_add(1,std::memory_order_relaxed);
+    tcrTimer.uiTotal.fetch_add(uiValue,std::memory_order_relaxed);
+    raiseMax(tcrTimer.uiMax,uiValue);
+}
+
+static void resetTimer(TimerCounters &tcrTimer) {
+    tcrTimer.uiCount=0;
+    tcrTimer.uiTotal=0;
+    tcrTimer.uiMax=0;
+}
+
+static double getAverage(const TimerCounters &tcrTimer) {
+    quint64 uiCount=tcrTimer.uiCount.load(std::memory_order_relaxed);
+    return uiCount?double(tcrTimer.uiTotal.load(std::memory_order_relaxed))/uiCount:0.0;
+}
+
+static double getShare(const TimerCounters &tcrTimer) {
+    qint64 iWall=getNow()-iRunStart.load(std::memory_order_relaxed);
+    return iWall>0?100.0*tcrTimer.uiTotal.load(std::memory_order_relaxed)/iWall:0.0;
+}
+
+void Diagnostics::beginRun() {
+    for(auto t:{&tcrScheduler,&tcrSpawns,&tcrUpdates,&tcrLag})
+        resetTimer(*t);
+    uiScheduledHits=0;
+    uiPicks=0;
+    uiProbes=0;
+    uiMaxProbes=0;
+    uiLastLag=0;
+    iQueueDepth=0;
+    iMaxQueueDepth=0;
+    iRunStart=getNow();
+}
+
+void Diagnostics::eventHandled() {
+    iQueueDepth.fetch_sub(1,std::memory_order_relaxed);
+}
+
+void Diagnostics::eventQueued() {
+    raiseMax(iMaxQueueDepth,iQueueDepth.fetch_add(1,std::memory_order_relaxed)+1);
+}
+
+qint64 Diagnostics::getQueueDepth() {
+    return qMax<qint64>(0,iQueueDepth.load(std::memory_order_relaxed));
+}
+
+DiagnosticsReadings Diagnostics::getReadings() {
+    quint64 uiPasses=tcrScheduler.uiCount.load(std::memory_order_relaxed),
+            uiTotalPicks=uiPicks.load(std::memory_order_relaxed),
+            uiFullHandshakes=TlsSessionCache::getCount(TlsSessionCache::Handshake::HS_FULL),
+            uiOfferedHandshakes=TlsSessionCache::getCount(TlsSessionCache::Handshake::HS_TICKET_OFFERED);
+    // Timers are kept in ns (the lag in ms), but shown in ms all along.
+    return {
+        {
+            QStringLiteral("Scheduler passes"),
+            QStringLiteral("%1, avg. %2 ms, max. %3 ms, %4% of the wall time").arg(
+                uiPasses
+            ).arg(
+                getAverage(tcrScheduler)/1e6,0,'f',3
+            ).arg(
+                tcrScheduler.uiMax.load(std::memory_order_relaxed)/1e6,0,'f',3
+            ).arg(
+                getShare(tcrScheduler),0,'f',2
+            )
+        },
+        {
+            QStringLiteral("Hits per scheduler pass"),
+            QStringLiteral("avg. %1").arg(
+                uiPasses?double(uiScheduledHits.load(std::memory_order_relaxed))/uiPasses:0.0,0,'f',2
+            )
+        },
+        {
+            QStringLiteral("Links probed per pick"),
+            QStringLiteral("avg. %1, max. %2").arg(
+                uiTotalPicks?double(uiProbes.load(std::memory_order_relaxed))/uiTotalPicks:0.0,0,'f',2
+            ).arg(
+                uiMaxProbes.load(std::memory_order_relaxed)
+            )
+        },
+        {
+            QStringLiteral("Browser thread spawns"),
+            QStringLiteral("%1, avg. %2 ms, max. %3 ms").arg(
+                tcrSpawns.uiCount.load(std::memory_order_relaxed)
+            ).arg(
+                getAverage(tcrSpawns)/1e6,0,'f',3
+            ).arg(
+                tcrSpawns.uiMax.load(std::memory_order_relaxed)/1e6,0,'f',3
+            )
+        },
+        {
+            QStringLiteral("Engine event queue"),
+            QStringLiteral("%1 pending, max. %2").arg(
+                qMax<qint64>(0,iQueueDepth.load(std::memory_order_relaxed))
+            ).arg(
+                iMaxQueueDepth.load(std::memory_order_relaxed)
+            )
+        },
+        {
+            QStringLiteral("Event loop lag"),
+            QStringLiteral("last %1 ms, avg. %2 ms, max. %3 ms").arg(
+                uiLastLag.load(std::memory_order_relaxed)
+            ).arg(
+                getAverage(tcrLag),0,'f',1
+            ).arg(
+                tcrLag.uiMax.load(std::memory_order_relaxed)
+            )
+        },
+        {
+            QStringLiteral("TLS handshakes"),
+            QStringLiteral("%1 full, %2 offering a ticket (%3%)%4").arg(
+                uiFullHandshakes
+            ).arg(
+                uiOfferedHandshakes
+            ).arg(
+                uiFullHandshakes+uiOfferedHandshakes?
+                    100.0*uiOfferedHandshakes/(uiFullHandshakes+uiOfferedHandshakes):0.0,0,'f',1
+            ).arg(
+                TlsSessionCache::isEnabled()?QString():QStringLiteral(", resumption disabled")
+            )
+        },
+        {
+            QStringLiteral("Stats updates"),
+            QStringLiteral("%1, avg. %2 ms, max. %3 ms, %4% of the wall time").arg(
+                tcrUpdates.uiCount.load(std::memory_order_relaxed)
+            ).arg(
+                getAverage(tcrUpdates)/1e6,0,'f',3
+            ).arg(
+                tcrUpdates.uiMax.load(std::memory_order_relaxed)/1e6,0,'f',3
+            ).arg(
+                getShare(tcrUpdates),0,'f',2
+            )
+        },
+        {
+            QStringLiteral("Memory"),
+            MemoryGovernor::getUsageText()
+        },
+        {
+            QStringLiteral("Memory backpressure"),
+            MemoryGovernor::getThrottleText()
+        }
+    };
+}
+
+QString Diagnostics::getSummary() {
+    // A single line, for the headless output.
+    return QStringLiteral("Scheduler: %1% of the wall time, queue: %2 (max. %3), lag: %4 ms (max. %5 ms)").arg(
+        getShare(tcrScheduler),0,'f',2
+    ).arg(
+        qMax<qint64>(0,iQueueDepth.load(std::memory_order_relaxed))
+    ).arg(
+        iMaxQueueDepth.load(std::memory_order_relaxed)
+    ).arg(
+        uiLastLag.load(std::memory_order_relaxed)
+    ).arg(
+        tcrLag.uiMax.load(std::memory_order_relaxed)
+    );
+}
+
+void Diagnostics::linksProbed(uint uiCount) {
+    uiPicks.fetch_add(1,std::memory_order_relaxed);
+    uiProbes.fetch_add(uiCount,std::memory_order_relaxed);
+    raiseMax(uiMaxProbes,quint64(uiCount));
+}
+
+void Diagnostics::loopLagged(qint64 iLag) {
+    uiLastLag=quint64(iLag);
+    recordTimer(tcrLag,quint64(iLag));
+}
+
+void Diagnostics::schedulerPassed(qint64 iElapsed,uint uiHits) {
+    recordTimer(tcrScheduler,quint64(iElapsed));
+    uiScheduledHits.fetch_add(uiHits,std::memory_order_relaxed);
+}
+
+void Diagnostics::threadSpawned(qint64 iElapsed) {
+    recordTimer(tcrSpawns,quint64(iElapsed));
+}
+
+void Diagnostics::uiUpdated(qint64 iElapsed) {
+    recordTimer(tcrUpdates,quint64(iElapsed));
+}
+
+LagProbe::LagProbe(QObject *objParent):
+QObject(objParent) {
+    // Precise, so the lag measured is the loop's and not the timer's slack.
+    tmrProbe.setTimerType(Qt::TimerType::PreciseTimer);
+    connect(
+        &tmrProbe,
+        &QTimer::timeout,
+        this,
+        &LagProbe::probeTimeout
+    );
+}
+
+void LagProbe::start() {
+    etmProbe.start();
+    tmrProbe.start(LAG_PROBE_INTERVAL);
+}
+
+void LagProbe::stop() {
+    tmrProbe.stop();
+}
+
+void LagProbe::probeTimeout() {
+    // Whatever kept the loop busy past the interval delayed everything else too.
+    Diagnostics::loopLagged(qMax<qint64>(0,etmProbe.restart()-LAG_PROBE_INTERVAL));
+}
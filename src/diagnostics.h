@@ -0,0 +1,41 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <QtCore>
+
+using DiagnosticsReading=struct {
+    QString sName,
+            sValue;
+};
+
+using DiagnosticsReadings=QVector<DiagnosticsReading>;
+
+class Diagnostics {
+public:
+    static void                beginRun();
+    static void                eventHandled();
+    static void                eventQueued();
+    static qint64              getQueueDepth();
+    static DiagnosticsReadings getReadings();
+    static QString             getSummary();
+    static void                linksProbed(uint);
+    static void                loopLagged(qint64);
+    static void                schedulerPassed(qint64,uint);
+    static void                threadSpawned(qint64);
+    static void                uiUpdated(qint64);
+};
+
+class LagProbe:public QObject {
+    Q_OBJECT
+public:
+    LagProbe(QObject * =nullptr);
+    void start();
+    void stop();
+private slots:
+    void probeTimeout();
+private:
+    QTimer        tmrProbe;
+    QElapsedTimer etmProbe;
+};
+
+#endif // DIAGNOSTICS_H
@@ -0,0 +1,209 @@
+#include "errortaxonomy.h"
+
+#include <algorithm>
+#include <atomic>
+
+// Full messages kept per error kind. The rest are only counted.
+#define ERROR_SAMPLES 8
+
+#define ERROR_NAMES { \
+    "dns", \
+    "refused", \
+    "connection", \
+    "proxy", \
+    "proxy-auth", \
+    "tls", \
+    "timeout", \
+    "http-3xx", \
+    "http-4xx", \
+    "http-5xx", \
+    "assertion", \
+    "browser", \
+    "browser-crash", \
+    "other" \
+}
+
+static const char *const   szNames[ErrorCode::EC_TOTAL]=ERROR_NAMES;
+static std::atomic<quint64> uiCounts[ErrorCode::EC_TOTAL];
+static quint32              uiSampled[ErrorCode::EC_TOTAL];
+static QStringList          slSamples[ErrorCode::EC_TOTAL];
+static QMutex               mtxSamples;
+
+QDataStream &operator<<(QDataStream &dstStream,const ErrorCounts &ecsCounts) {
+    // Sized, so a build with more (or fewer) kinds can still read it.
+    dstStream << quint8(ErrorCode::EC_TOTAL);
+    for(auto c:ecsCounts.uiCounts)
+        dstStream << c;
+    return dstStream;
+}
+
+QDataStream &operator>>(QDataStream &dstStream,ErrorCounts &ecsCounts) {
+    quint8 uiTotal;
+    ecsCounts=ErrorCounts();
+    dstStream >> uiTotal;
+    for(int iK=0;iK<uiTotal;iK++) {
+        quint32 uiCount;
+        dstStream >> uiCount;
+        // Unknown kinds are folded into the catch-all one.
+        ecsCounts.uiCounts[iK<ErrorCode::EC_TOTAL?iK:ErrorCode::EC_OTHER]+=uiCount;
+    }
+    return dstStream;
+}
+
+void ErrorTaxonomy::beginRun() {
+    QMutexLocker mlkSamples(&mtxSamples);
+    // Counters are totals, like the metrics. Only the samples are per run.
+    for(int iK=0;iK<ErrorCode::EC_TOTAL;iK++) {
+        uiSampled[iK]=0;
+        slSamples[iK].clear();
+    }
+}
+
+ErrorCode ErrorTaxonomy::fromNetworkError(QNetworkReply::NetworkError nerError) {
+    switch(nerError) {
+        case QNetworkReply::NetworkError::HostNotFoundError:
+            return ErrorCode::EC_DNS;
+        case QNetworkReply::NetworkError::ConnectionRefusedError:
+            return ErrorCode::EC_REFUSED;
+        case QNetworkReply::NetworkError::RemoteHostClosedError:
+        case QNetworkReply::NetworkError::TemporaryNetworkFailureError:
+        case QNetworkReply::NetworkError::NetworkSessionFailedError:
+        case QNetworkReply::NetworkError::UnknownNetworkError:
+            return ErrorCode::EC_CONNECTION;
+        case QNetworkReply::NetworkError::ProxyConnectionRefusedError:
+        case QNetworkReply::NetworkError::ProxyConnectionClosedError:
+        case QNetworkReply::NetworkError::ProxyNotFoundError:
+        case QNetworkReply::NetworkError::ProxyTimeoutError:
+        case QNetworkReply::NetworkError::UnknownProxyError:
+            return ErrorCode::EC_PROXY;
+        case QNetworkReply::NetworkError::ProxyAuthenticationRequiredError:
+            return ErrorCode::EC_PROXY_AUTH;
+        case QNetworkReply::NetworkError::SslHandshakeFailedError:
+            return ErrorCode::EC_TLS;
+        // The transfer timeout of the manager ends as a cancellation.
+        case QNetworkReply::NetworkError::TimeoutError:
+        case QNetworkReply::NetworkError::OperationCanceledError:
+            return ErrorCode::EC_TIMEOUT;
+        default:
+            return ErrorCode::EC_OTHER;
+    }
+}
+
+ErrorCode ErrorTaxonomy::fromSocketError(QAbstractSocket::SocketError sckError) {
+    switch(sckError) {
+        case QAbstractSocket::SocketError::HostNotFoundError:
+            return ErrorCode::EC_DNS;
+        case QAbstractSocket::SocketError::ConnectionRefusedError:
+            return ErrorCode::EC_REFUSED;
+        case QAbstractSocket::SocketError::RemoteHostClosedError:
+        case QAbstractSocket::SocketError::NetworkError:
+            return ErrorCode::EC_CONNECTION;
+        case QAbstractSocket::SocketError::ProxyConnectionRefusedError:
+        case QAbstractSocket::SocketError::ProxyConnectionClosedError:
+        case QAbstractSocket::SocketError::ProxyConnectionTimeoutError:
+        case QAbstractSocket::SocketError::ProxyNotFoundError:
+        case QAbstractSocket::SocketError::ProxyProtocolError:
+            return ErrorCode::EC_PROXY;
+        case QAbstractSocket::SocketError::ProxyAuthenticationRequiredError:
+            return ErrorCode::EC_PROXY_AUTH;
+        case QAbstractSocket::SocketError::SslHandshakeFailedError:
+        case QAbstractSocket::SocketError::SslInternalError:
+        case QAbstractSocket::SocketError::SslInvalidUserDataError:
+            return ErrorCode::EC_TLS;
+        case QAbstractSocket::SocketError::SocketTimeoutError:
+            return ErrorCode::EC_TIMEOUT;
+        default:
+            return ErrorCode::EC_OTHER;
+    }
+}
+
+ErrorCode ErrorTaxonomy::fromStatus(uint uiStatus) {
+    if(407==uiStatus)
+        return ErrorCode::EC_PROXY_AUTH;
+    else if(uiStatus>=300&&uiStatus<400)
+        return ErrorCode::EC_HTTP_3XX;
+    else if(uiStatus>=400&&uiStatus<500)
+        return ErrorCode::EC_HTTP_4XX;
+    else if(uiStatus>=500&&uiStatus<600)
+        return ErrorCode::EC_HTTP_5XX;
+    return ErrorCode::EC_OTHER;
+}
+
+ErrorCounts ErrorTaxonomy::getCountsFromJson(QJsonObject jsoCounts) {
+    ErrorCounts ecsResult=ErrorCounts();
+    for(auto itCount=jsoCounts.constBegin();itCount!=jsoCounts.constEnd();itCount++) {
+        int iCode=ErrorCode::EC_OTHER;
+        for(int iK=0;iK<ErrorCode::EC_TOTAL;iK++)
+            if(QLatin1String(szNames[iK])==itCount.key()) {
+                iCode=iK;
+                break;
+            }
+        ecsResult.uiCounts[iCode]+=quint32(itCount.value().toDouble());
+    }
+    return ecsResult;
+}
+
+quint64 ErrorTaxonomy::getCount(ErrorCode ecCode) {
+    return uiCounts[ecCode].load(std::memory_order_relaxed);
+}
+
+QJsonObject ErrorTaxonomy::getJsonFromCounts(const ErrorCounts &ecsCounts) {
+    QJsonObject jsoResult;
+    // Keyed by name, so agents and coordinators need not share the numbering.
+    for(int iK=0;iK<ErrorCode::EC_TOTAL;iK++)
+        if(ecsCounts.uiCounts[iK])
+            jsoResult.insert(QLatin1String(szNames[iK]),double(ecsCounts.uiCounts[iK]));
+    return jsoResult;
+}
+
+QString ErrorTaxonomy::getName(ErrorCode ecCode) {
+    return QLatin1String(szNames[ecCode]);
+}
+
+QStringList ErrorTaxonomy::getSamples(ErrorCode ecCode) {
+    QMutexLocker mlkSamples(&mtxSamples);
+    return slSamples[ecCode];
+}
+
+QString ErrorTaxonomy::getTextFromCounts(const ErrorCounts &ecsCounts) {
+    QVector<int> viCodes;
+    QStringList  slResult;
+    for(int iK=0;iK<ErrorCode::EC_TOTAL;iK++)
+        if(ecsCounts.uiCounts[iK])
+            viCodes.append(iK);
+    // The most frequent kinds go first.
+    std::stable_sort(
+        viCodes.begin(),
+        viCodes.end(),
+        [&ecsCounts](int iLeft,int iRight) {
+            return ecsCounts.uiCounts[iLeft]>ecsCounts.uiCounts[iRight];
+        }
+    );
+    for(int c:viCodes)
+        slResult.append(QStringLiteral("%1: %2").arg(QLatin1String(szNames[c])).arg(ecsCounts.uiCounts[c]));
+    return slResult.join(QStringLiteral(", "));
+}
+
+bool ErrorTaxonomy::isEmpty(const ErrorCounts &ecsCounts) {
+    for(auto c:ecsCounts.uiCounts)
+        if(c)
+            return false;
+    return true;
+}
+
+void ErrorTaxonomy::record(ErrorCode ecCode,QString sMessage) {
+    uiCounts[ecCode].fetch_add(1,std::memory_order_relaxed);
+    QMutexLocker mlkSamples(&mtxSamples);
+    // Reservoir sampling over the distinct messages: every one seen so far ...
+    // ... has the same chance to be kept, whatever the length of the run.
+    if(slSamples[ecCode].contains(sMessage))
+        return;
+    uiSampled[ecCode]++;
+    if(slSamples[ecCode].count()<ERROR_SAMPLES)
+        slSamples[ecCode].append(sMessage);
+    else {
+        quint32 uiSlot=QRandomGenerator::global()->bounded(uiSampled[ecCode]);
+        if(uiSlot<ERROR_SAMPLES)
+            slSamples[ecCode][int(uiSlot)]=sMessage;
+    }
+}
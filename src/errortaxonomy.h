@@ -0,0 +1,48 @@
+#ifndef ERRORTAXONOMY_H
+#define ERRORTAXONOMY_H
+
+#include <QtCore>
+#include <QtNetwork>
+
+using ErrorCode=enum {
+    EC_DNS,
+    EC_REFUSED,
+    EC_CONNECTION,
+    EC_PROXY,
+    EC_PROXY_AUTH,
+    EC_TLS,
+    EC_TIMEOUT,
+    EC_HTTP_3XX,
+    EC_HTTP_4XX,
+    EC_HTTP_5XX,
+    EC_ASSERTION,
+    EC_BROWSER,
+    EC_BROWSER_CRASH,
+    EC_OTHER,
+    EC_TOTAL
+};
+
+using ErrorCounts=struct {
+    quint32 uiCounts[ErrorCode::EC_TOTAL];
+};
+
+QDataStream &operator<<(QDataStream &,const ErrorCounts &);
+QDataStream &operator>>(QDataStream &,ErrorCounts &);
+
+class ErrorTaxonomy {
+public:
+    static void        beginRun();
+    static ErrorCode   fromNetworkError(QNetworkReply::NetworkError);
+    static ErrorCode   fromSocketError(QAbstractSocket::SocketError);
+    static ErrorCode   fromStatus(uint);
+    static ErrorCounts getCountsFromJson(QJsonObject);
+    static quint64     getCount(ErrorCode);
+    static QJsonObject getJsonFromCounts(const ErrorCounts &);
+    static QString     getName(ErrorCode);
+    static QStringList getSamples(ErrorCode);
+    static QString     getTextFromCounts(const ErrorCounts &);
+    static bool        isEmpty(const ErrorCounts &);
+    static void        record(ErrorCode,QString);
+};
+
+#endif // ERRORTAXONOMY_H
@@ -0,0 +1,1635 @@
+#include "hitengine.h"
+#include "networkengine.h"
+
+#include <sstream>
+
+#define APP_BROWSER_EXE "Browser.exe"
+
+#define CANCEL_POLL_INTERVAL 50
+
+// Room kept in the lists for reloads, so new records can be appended ...
+// ... without moving those that hits in flight point to.
+#define RELOAD_SPARE_RECORDS 256
+#define RELOAD_SPARE_SHARE   16
+
+// How often (in ms) the sampled consumers are refreshed for the memory ...
+// ... governor, and the scheduler given a chance to follow the pressure.
+#define MEMORY_SAMPLE_INTERVAL 500
+
+// Polls between two samples of a browser helper's memory.
+#define HELPER_SAMPLE_POLLS 10
+
+// Rough cost of an engine event waiting in a queue: the hit it carries, ...
+// ... plus Qt's own wrapping.
+#define QUEUED_EVENT_SIZE 512
+
+// Budgets are given in MB.
+#define MEMORY_BUDGET_UNIT 1048576
+
+static int getSpareCapacity(int iCount) {
+    return iCount+iCount/RELOAD_SPARE_SHARE+RELOAD_SPARE_RECORDS;
+}
+
+static QString getProxyLabel(QNetworkProxy npxProxy) {
+    // Proxy credentials are kept out of the exported labels.
+    npxProxy.setUser(QString());
+    npxProxy.setPassword(QString());
+    return ProxyParser::getTextFromProxy(npxProxy);
+}
+
+HitEngine::HitEngine(QObject *objParent):
+QObject(objParent) {
+    bRunning=false;
+    bFetchContent=true;
+    bResources=false;
+    uiTotalWorkers=0;
+    uiMaxWorkers=1;
+    uiMaxCooldown=0;
+    uiCheckpointInterval=0;
+    uiHarSampling=0;
+    uiScheduledHits=0;
+    uiElapsedBefore=0;
+    uiResourceHits=0;
+    sCheckpointPath.clear();
+    sCachePath.clear();
+    sProfilePath.clear();
+    sCompletion.clear();
+    sHarFolder.clear();
+    rplCurrentPlan=RunPlan();
+    llCurrentLinks.clear();
+    llPendingLinks.clear();
+    plCurrentProxies.clear();
+    plPendingProxies.clear();
+    slCurrentAgents.clear();
+    sslCurrentSteps.clear();
+    rmMode=BrowserWorker::RunMode::RM_NETWORK;
+    npcPolicy=NetworkPolicy();
+    cwrCheckpoint=nullptr;
+    nenNetwork=nullptr;
+    connect(
+        &tmrCheckpoint,
+        &QTimer::timeout,
+        this,
+        &HitEngine::checkpointTimeout
+    );
+    connect(
+        &tmrMemory,
+        &QTimer::timeout,
+        this,
+        &HitEngine::memoryTimeout
+    );
+}
+
+HitEngine::~HitEngine() {
+    // Aborts whatever is still in flight, so no worker outlives the engine.
+    if(!ctpCurrentRun.isNull())
+        ctpCurrentRun->cancel();
+    if(nullptr!=nenNetwork)
+        nenNetwork->cancel();
+    for(auto &w:this->findChildren<BrowserWorker *>())
+        w->wait();
+}
+
+void HitEngine::browse() {
+    LinkRecord    *lrSelectedLink;
+    ProxyRecord   *prSelectedProxy;
+    QString       sSelectedAgent;
+    uint          uiSelectedCooldown,
+                  uiPassHits=0,
+                  uiLimit;
+    QElapsedTimer etmPass;
+    // Reloaded records that didn't fit wait for the hits in flight to ...
+    // ... drain, since growing the lists moves what they point to.
+    if(!llPendingLinks.isEmpty()||!plPendingProxies.isEmpty()) {
+        if(uiTotalWorkers)
+            return;
+        this->applyPending();
+        emit listsChanged();
+    }
+    // Timed as a whole: it is what runs between any two finished hits.
+    etmPass.start();
+    while(true) {
+        // Rechecked for every hit, since each helper scheduled in this pass ...
+        // ... is charged right away.
+        uiLimit=MemoryGovernor::getLimit(uiMaxWorkers);
+        if(uiTotalWorkers>=uiLimit)
+            break;
+        if(!this->getNextHit(lrSelectedLink,prSelectedProxy,sSelectedAgent,uiSelectedCooldown))
+            break; // Nothing to do if all links are busy (or the plan is over).
+        uiTotalWorkers++;
+        uiPassHits++;
+        uiScheduledHits++;
+        Metrics::hitScheduled();
+        if(!sslCurrentSteps.isEmpty()) {
+            // Every session runs all the steps, so links are never 'busy' here.
+            ScenarioSession *ssnSession=new ScenarioSession(
+                this,
+                &llCurrentLinks,
+                &sslCurrentSteps,
+                prSelectedProxy,
+                sSelectedAgent
+            );
+            if(nullptr!=prSelectedProxy)
+                prSelectedProxy->bBusy=true;
+            connect(
+                ssnSession,
+                &ScenarioSession::finished,
+                this,
+                &HitEngine::sessionFinished
+            );
+            connect(
+                ssnSession,
+                &ScenarioSession::stepFinished,
+                this,
+                &HitEngine::sessionStepFinished
+            );
+            ssnSession->start(uiSelectedCooldown);
+        }
+        else if(nullptr!=nenNetwork) {
+            quint64 uiTraceId=Tracer::sample();
+            Tracer::record(
+                uiTraceId,
+                Tracer::TraceEvent::TE_SCHEDULED,
+                lrSelectedLink->uiIndex,
+                nullptr!=prSelectedProxy?qint32(prSelectedProxy->uiIndex):-1
+            );
+            // Marked busy right away, since hits are queued, not started.
+            lrSelectedLink->bBusy=true;
+            if(nullptr!=prSelectedProxy)
+                prSelectedProxy->bBusy=true;
+            // The loops get copies of the URL and the proxy, and only hand ...
+            // ... the records back: they never touch the store or the records. ...
+            // ... Their random draws come from the seed, so they follow the run's.
+            nenNetwork->submit({
+                lrSelectedLink,
+                prSelectedProxy,
+                nullptr!=prSelectedProxy?int(prSelectedProxy->uiIndex):-1,
+                nullptr!=prSelectedProxy?prSelectedProxy->npxProxy:QNetworkProxy(),
+                llCurrentLinks.getUrl(lrSelectedLink->uiIndex),
+                !llCurrentLinks.getTemplate(lrSelectedLink->uiIndex).isNull(),
+                llCurrentLinks.getAssertions(lrSelectedLink->uiIndex),
+                sSelectedAgent,
+                uiSelectedCooldown,
+                uiTraceId,
+                quint32(rngScheduler())
+            });
+        }
+        else {
+            quint64       uiTraceId=Tracer::sample();
+            BrowserWorker *bwWorker=new BrowserWorker(
+                this,
+                lrSelectedLink,
+                prSelectedProxy,
+                sSelectedAgent,
+                ctpCurrentRun
+            );
+            Tracer::record(
+                uiTraceId,
+                Tracer::TraceEvent::TE_SCHEDULED,
+                lrSelectedLink->uiIndex,
+                nullptr!=prSelectedProxy?qint32(prSelectedProxy->uiIndex):-1
+            );
+            bwWorker->setCooldown(uiSelectedCooldown);
+            bwWorker->setTraceId(uiTraceId);
+            bwWorker->setMode(rmMode);
+            bwWorker->setProfile(sProfilePath);
+            bwWorker->setCompletion(sCompletion,bFetchContent);
+            if(bResources) {
+                QString sHarPath;
+                // The first hit of the run is always sampled, then one in N.
+                if(uiHarSampling&&!(uiResourceHits%uiHarSampling))
+                    sHarPath=QStringLiteral("%1/%2-link-%3.har").arg(
+                        sHarFolder,
+                        QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-hhmmss-zzz"))
+                    ).arg(lrSelectedLink->uiIndex+1);
+                uiResourceHits++;
+                bwWorker->setResources(true,sHarPath);
+            }
+            bwWorker->setTarget(
+                llCurrentLinks.getUrl(lrSelectedLink->uiIndex),
+                llCurrentLinks.getAssertions(lrSelectedLink->uiIndex)
+            );
+            connect(
+                bwWorker,
+                &BrowserWorker::started,
+                this,
+                &HitEngine::workerStarted
+            );
+            connect(
+                bwWorker,
+                &BrowserWorker::finished,
+                this,
+                &HitEngine::workerFinished
+            );
+            connect(
+                bwWorker,
+                &BrowserWorker::statusChanged,
+                this,
+                &HitEngine::workerStatusChanged
+            );
+            bwWorker->start();
+        }
+    }
+    Diagnostics::schedulerPassed(etmPass.nsecsElapsed(),uiPassHits);
+    // Slots left empty for the memory's sake, not for lack of work.
+    if(uiLimit<uiMaxWorkers&&uiTotalWorkers>=uiLimit)
+        MemoryGovernor::throttled(MemoryGovernor::Throttle::TH_HITS);
+    // A plan ends on its own, once its last hit is done.
+    if(!rplCurrentPlan.vphHits.isEmpty()&&!uiTotalWorkers&&this->isPlanOver()) {
+        bRunning=false;
+        emit runFinished();
+    }
+}
+
+void HitEngine::applyPending() {
+    // Grown with room to spare, so the next reloads are likely to fit.
+    if(llCurrentLinks.capacity()<llCurrentLinks.count()+llPendingLinks.count())
+        llCurrentLinks.reserve(getSpareCapacity(llCurrentLinks.count()+llPendingLinks.count()));
+    if(plCurrentProxies.capacity()<plCurrentProxies.count()+plPendingProxies.count())
+        plCurrentProxies.reserve(getSpareCapacity(plCurrentProxies.count()+plPendingProxies.count()));
+    for(int iK=0;iK<llPendingLinks.count();iK++)
+        llCurrentLinks.append(
+            llPendingLinks.getUrl(iK),
+            llPendingLinks.getAssertions(iK),
+            llPendingLinks.getTemplate(iK)
+        );
+    plCurrentProxies.append(plPendingProxies);
+    llPendingLinks.clear();
+    plPendingProxies.clear();
+    this->updateActive();
+    if(bRunning)
+        this->updateRates();
+}
+
+bool HitEngine::applyCheckpoint(const CheckpointData &cdData,QString &sError) {
+    std::istringstream issRandom(cdData.bytRandomState.toStdString());
+    sError.clear();
+    // Reloaded lists match no text they could be given in again.
+    if(cdData.bytFingerprint.isEmpty()) {
+        sError=QStringLiteral("The checkpoint was taken after the lists were reloaded");
+        return false;
+    }
+    if(bytCurrentFingerprint!=cdData.bytFingerprint||
+       llCurrentLinks.count()!=cdData.ccvLinks.count()||
+       plCurrentProxies.count()!=cdData.ccvProxies.count()) {
+        sError=QStringLiteral("The checkpoint does not belong to the current lists");
+        return false;
+    }
+    issRandom >> rngScheduler;
+    if(issRandom.fail()) {
+        sError=QStringLiteral("The checkpoint has a corrupt scheduler state");
+        return false;
+    }
+    for(auto &l:llCurrentLinks) {
+        l.uiHits=cdData.ccvLinks.at(l.uiIndex).uiHits;
+        l.uiErrors=cdData.ccvLinks.at(l.uiIndex).uiErrors;
+        l.uiFailures=cdData.mapLinkFailures.value(l.uiIndex);
+        l.uiCancels=cdData.ccvLinks.at(l.uiIndex).uiCancels;
+        l.uiRetries=cdData.mapLinkRetries.value(l.uiIndex);
+        l.uiRevalidations=cdData.mapLinkRevalidations.value(l.uiIndex);
+    }
+    for(auto itErrors=cdData.mapLinkErrorKinds.constBegin();itErrors!=cdData.mapLinkErrorKinds.constEnd();itErrors++)
+        llCurrentLinks.setErrors(itErrors.key(),itErrors.value());
+    for(auto itTraffic=cdData.mapLinkTraffic.constBegin();itTraffic!=cdData.mapLinkTraffic.constEnd();itTraffic++)
+        llCurrentLinks.setTraffic(itTraffic.key(),itTraffic.value());
+    for(auto &p:plCurrentProxies) {
+        p.uiHits=cdData.ccvProxies.at(p.uiIndex).uiHits;
+        p.uiErrors=cdData.ccvProxies.at(p.uiIndex).uiErrors;
+        p.uiCancels=cdData.ccvProxies.at(p.uiIndex).uiCancels;
+        p.ecsErrors=cdData.mapProxyErrorKinds.value(p.uiIndex,ErrorCounts());
+        p.tcTraffic=cdData.mapProxyTraffic.value(p.uiIndex,{0,0});
+    }
+    uiScheduledHits=cdData.uiScheduled;
+    uiElapsedBefore=cdData.uiElapsed;
+    return true;
+}
+
+CheckpointData HitEngine::getCheckpoint() {
+    CheckpointData     cdResult;
+    std::ostringstream ossRandom;
+    // Only plain counters are copied here. Serializing and flushing them ...
+    // ... to disk is left to the writer thread.
+    ossRandom << rngScheduler;
+    cdResult.bytFingerprint=bytCurrentFingerprint;
+    cdResult.bytRandomState=QByteArray::fromStdString(ossRandom.str());
+    cdResult.uiScheduled=uiScheduledHits;
+    cdResult.uiElapsed=uiElapsedBefore+etmCurrentRun.elapsed();
+    cdResult.ccvLinks.reserve(llCurrentLinks.count());
+    for(const auto &l:llCurrentLinks) {
+        cdResult.ccvLinks.append({l.uiHits,l.uiErrors,l.uiCancels});
+        if(l.uiFailures)
+            cdResult.mapLinkFailures.insert(l.uiIndex,l.uiFailures);
+        if(l.uiRetries)
+            cdResult.mapLinkRetries.insert(l.uiIndex,l.uiRetries);
+        if(l.uiRevalidations)
+            cdResult.mapLinkRevalidations.insert(l.uiIndex,l.uiRevalidations);
+        if(l.uiErrors||l.uiFailures)
+            cdResult.mapLinkErrorKinds.insert(l.uiIndex,llCurrentLinks.getErrors(l.uiIndex));
+        // Links never hit have moved no bytes, so they aren't even looked up.
+        if(l.uiHits||l.uiErrors||l.uiFailures||l.uiCancels) {
+            TrafficCounts tcTraffic=llCurrentLinks.getTraffic(l.uiIndex);
+            if(tcTraffic.uiSent||tcTraffic.uiReceived)
+                cdResult.mapLinkTraffic.insert(l.uiIndex,tcTraffic);
+        }
+    }
+    cdResult.ccvProxies.reserve(plCurrentProxies.count());
+    for(const auto &p:plCurrentProxies) {
+        cdResult.ccvProxies.append({p.uiHits,p.uiErrors,p.uiCancels});
+        if(p.uiErrors)
+            cdResult.mapProxyErrorKinds.insert(p.uiIndex,p.ecsErrors);
+        if(p.tcTraffic.uiSent||p.tcTraffic.uiReceived)
+            cdResult.mapProxyTraffic.insert(p.uiIndex,p.tcTraffic);
+    }
+    return cdResult;
+}
+
+bool HitEngine::getNextHit(LinkRecord  *&lrLink,
+                           ProxyRecord *&prProxy,
+                           QString     &sAgent,
+                           uint        &uiCooldown) {
+    lrLink=nullptr;
+    if(!rplCurrentPlan.vphHits.isEmpty()) {
+        if(this->isPlanOver())
+            return false;
+        const RunPlanHit &rphHit=rplCurrentPlan.vphHits.at(int(uiScheduledHits));
+        if(sslCurrentSteps.isEmpty()) {
+            // Hits go strictly in order: a busy link holds back the ones behind it.
+            lrLink=&llCurrentLinks[rphHit.uiLink];
+            if(lrLink->bBusy)
+                return false;
+        }
+        prProxy=rphHit.iProxy<0?nullptr:&plCurrentProxies[rphHit.iProxy];
+        sAgent=rphHit.iAgent<0?QString():slCurrentAgents.at(rphHit.iAgent);
+        uiCooldown=rphHit.uiCooldown;
+        return true;
+    }
+    if(sslCurrentSteps.isEmpty()) {
+        bool bFreeLinks=false;
+        int  iRandomLink;
+        uint uiProbes=0;
+        // Verifies that there are non-busy links. Only active ones are ...
+        // ... looked at, so retired links don't slow down the picks.
+        for(const auto &i:viActiveLinks) {
+            uiProbes++;
+            if(!llCurrentLinks.at(i).bBusy) {
+                bFreeLinks=true;
+                break;
+            }
+        }
+        if(!bFreeLinks) {
+            Diagnostics::linksProbed(uiProbes);
+            return false;
+        }
+        // Picks one non-busy link at random.
+        while(true) {
+            uiProbes++;
+            iRandomLink=viActiveLinks.at(this->getRandom(viActiveLinks.count()));
+            if(!llCurrentLinks.at(iRandomLink).bBusy)
+                break;
+        }
+        // Both loops grow with the busy share of the list, hence counted.
+        Diagnostics::linksProbed(uiProbes);
+        lrLink=&llCurrentLinks[iRandomLink];
+    }
+    prProxy=this->getRandomProxy();
+    sAgent=this->getRandomAgent();
+    uiCooldown=this->getRandom(uiMaxCooldown+1);
+    return true;
+}
+
+int HitEngine::getRandom(int iBound) {
+    // Every scheduling decision comes from this generator, so its state ...
+    // ... can be saved in checkpoints and the run resumed where it was.
+    return std::uniform_int_distribution<int>(0,iBound-1)(rngScheduler);
+}
+
+QString HitEngine::getRandomAgent() {
+    QString sResult=QString();
+    if(!slCurrentAgents.isEmpty())
+        // Picks any user agent. Frequent picks are not important.
+        sResult=slCurrentAgents.at(this->getRandom(slCurrentAgents.count()));
+    return sResult;
+}
+
+ProxyRecord *HitEngine::getRandomProxy() {
+    bool        bFreeProxies=false;
+    int         iRandomProxy;
+    ProxyRecord *prResult=nullptr;
+    // Verifies that there are non-busy proxies among the active ones.
+    for(const auto &i:viActiveProxies)
+        if(!plCurrentProxies.at(i).bBusy) {
+            bFreeProxies=true;
+            break;
+        }
+    if(!viActiveProxies.isEmpty()) {
+        // Picks one non-busy proxy at random, or any if all are busy.
+        while(true) {
+            iRandomProxy=viActiveProxies.at(this->getRandom(viActiveProxies.count()));
+            if(!bFreeProxies||!plCurrentProxies.at(iRandomProxy).bBusy)
+                break;
+        }
+        prResult=&plCurrentProxies[iRandomProxy];
+    }
+    return prResult;
+}
+
+LinkStore HitEngine::getLinksFromSteps(ScenarioStepList sslSteps) {
+    LinkStore llResult;
+    // Each step gets a record of its own, so it has separate stats.
+    llResult.reserve(sslSteps.count());
+    for(const auto &s:sslSteps)
+        llResult.append(s.urlLink); // Scenarios are far too short to fill it.
+    return llResult;
+}
+
+LinkStore HitEngine::getLinksFromText(QString sText,QString &sError) {
+    int                iStart=0;
+    LinkStore          llResult;
+    QRegularExpression rxSpace(QStringLiteral("\\s"));
+    sError.clear();
+    // Lines are taken one at a time, so a huge list is never copied whole.
+    llResult.reserve(sText.count(QLatin1Char('\n'))+1);
+    while(iStart<sText.size()) {
+        QUrl            urlTestLink;
+        int             iEnd=sText.indexOf(QLatin1Char('\n'),iStart),
+                        iSpace;
+        QString         sLine,
+                        sOptions,
+                        sTemplateError;
+        LinkTemplatePtr ltpTemplate;
+        if(iEnd<0)
+            iEnd=sText.size();
+        sLine=sText.mid(iStart,iEnd-iStart).trimmed();
+        iStart=iEnd+1;
+        if(sLine.isEmpty())
+            continue;
+        iSpace=sLine.indexOf(rxSpace);
+        // Whatever follows the link, after a space, is its assertions.
+        if(iSpace>0) {
+            sOptions=sLine.mid(iSpace+1);
+            sLine.truncate(iSpace);
+        }
+        if(!UrlTemplate::getTemplateFromText(sLine,ltpTemplate,sTemplateError)) {
+            if(sError.isEmpty())
+                sError=QStringLiteral("%1: %2").arg(sLine,sTemplateError);
+            continue;
+        }
+        // Templates are checked through one of their URLs, as the braces ...
+        // ... may stand where QUrl takes no such thing (a port, say).
+        if(ltpTemplate.isNull())
+            urlTestLink.setUrl(sLine);
+        else
+            urlTestLink=UrlTemplate::expand(ltpTemplate);
+        if(urlTestLink.isValid()) {
+            QString sScheme=urlTestLink.scheme().toLower();
+            if(sScheme==QStringLiteral("http")||sScheme==QStringLiteral("https")) {
+                LinkAssertionsPtr lapAssertions;
+                QString           sOptionsError;
+                if(!AssertionParser::getAssertionsFromText(sOptions,lapAssertions,sOptionsError)) {
+                    // Reported, but the rest of the list is still usable.
+                    if(sError.isEmpty())
+                        sError=QStringLiteral("%1: %2").arg(sLine,sOptionsError);
+                    continue;
+                }
+                // Unlike bad lines, this fails the whole list: the rest wouldn't fit either.
+                if(!llResult.append(urlTestLink,lapAssertions,ltpTemplate)) {
+                    sError=QStringLiteral("The links are too long to be loaded together");
+                    return LinkStore();
+                }
+            }
+        }
+    }
+    llResult.squeeze();
+    return llResult;
+}
+
+ProxyList HitEngine::getProxiesFromText(QString sText) {
+    uint               uiIndex=0;
+    ProxyList          plResult={};
+    QStringList        slProxies=sText.split(
+        QStringLiteral("\n"),
+        Qt::SplitBehaviorFlags::SkipEmptyParts
+    );
+    QRegularExpression rxSpace(QStringLiteral("\\s"));
+    for(const auto &s:slProxies) {
+        QString       sLine=s.trimmed(),
+                      sOption;
+        int           iSpace=sLine.indexOf(rxSpace);
+        quint64       uiRateLimit=0;
+        QNetworkProxy npxProxy;
+        // A proxy may be followed, after a space, by its bandwidth limit.
+        if(iSpace>0) {
+            sOption=sLine.mid(iSpace+1).trimmed();
+            sLine.truncate(iSpace);
+            if(!sOption.startsWith(QStringLiteral("limit="))||
+               !Bandwidth::getRateFromText(sOption.mid(6),uiRateLimit))
+                continue;
+        }
+        npxProxy=ProxyParser::getProxyFromText(sLine);
+        if(QNetworkProxy::ProxyType::NoProxy!=npxProxy.type()) {
+            ProxyRecord prProxy;
+            prProxy.npxProxy=npxProxy;
+            prProxy.bBusy=false;
+            prProxy.bRetired=false;
+            prProxy.uiIndex=uiIndex++;
+            prProxy.uiHits=0;
+            prProxy.uiErrors=0;
+            prProxy.uiCancels=0;
+            prProxy.ecsErrors=ErrorCounts();
+            prProxy.lhLatency=LatencyHistogram();
+            prProxy.uiRateLimit=uiRateLimit;
+            prProxy.tcTraffic={0,0};
+            plResult.append(prProxy);
+        }
+    }
+    return plResult;
+}
+
+QStringList HitEngine::getUserAgentsFromText(QString sText) {
+    QStringList slResult={},
+                slAgents=sText.split(
+                    QStringLiteral("\n"),
+                    Qt::SplitBehaviorFlags::SkipEmptyParts
+                );
+    for(const auto &a:slAgents)
+        if(AgentParser::isUserAgent(a.trimmed()))
+            slResult.append(a.trimmed());
+    return slResult;
+}
+
+QString HitEngine::getTextFromLinks(const LinkStore &llLinks) {
+    QString sResult=QString();
+    for(int iK=0;iK<llLinks.count();iK++) {
+        if(!sResult.isEmpty())
+            sResult.append(QStringLiteral("\n"));
+        sResult.append(llLinks.getText(iK));
+    }
+    return sResult;
+}
+
+QString HitEngine::getTextFromProxies(ProxyList plProxies) {
+    QString sResult=QString();
+    for(const auto &p:plProxies) {
+        QString sProxy=HitEngine::getTextFromProxy(p);
+        if(!sProxy.isEmpty()) {
+            if(!sResult.isEmpty())
+                sResult.append(QStringLiteral("\n"));
+            sResult.append(sProxy);
+        }
+    }
+    return sResult;
+}
+
+QString HitEngine::getTextFromProxy(const ProxyRecord &prProxy) {
+    QString sResult=ProxyParser::getTextFromProxy(prProxy.npxProxy);
+    if(!sResult.isEmpty()&&prProxy.uiRateLimit)
+        sResult.append(QStringLiteral(" limit=%1").arg(Bandwidth::getTextFromRate(prProxy.uiRateLimit)));
+    return sResult;
+}
+
+QString HitEngine::getTextFromUserAgents(QStringList slUserAgents) {
+    QString sResult=QString();
+    for(const auto &a:slUserAgents) {
+        if(!sResult.isEmpty())
+            sResult.append(QStringLiteral("\n"));
+        sResult.append(a);
+    }
+    return sResult;
+}
+
+void HitEngine::checkpointTimeout() {
+    if(nullptr!=cwrCheckpoint)
+        cwrCheckpoint->submit(this->getCheckpoint());
+}
+
+LinkStore &HitEngine::getLinks() {
+    return llCurrentLinks;
+}
+
+ProxyList &HitEngine::getProxies() {
+    return plCurrentProxies;
+}
+
+ScenarioStepList HitEngine::getSteps() {
+    return sslCurrentSteps;
+}
+
+bool HitEngine::isPlanOver() {
+    if(uiScheduledHits>=quint64(rplCurrentPlan.vphHits.count()))
+        return true;
+    // The time budget covers the whole run, resumed parts included.
+    return rplCurrentPlan.uiMaxDuration&&
+           uiElapsedBefore+etmCurrentRun.elapsed()>=rplCurrentPlan.uiMaxDuration*1000ull;
+}
+
+bool HitEngine::isRunning() {
+    return bRunning;
+}
+
+/**
+ * @brief Swaps the lists of a run, live, keeping what they have in common.
+ *
+ * Entries are matched by their text (links with their template, proxies
+ * with their credentials), so they keep their records and stats, and take
+ * the new assertions or limit. Those no longer listed are retired: never
+ * picked again, while their hits in flight finish as usual. Those listed
+ * again are brought back, and the rest is appended. Records that hits in
+ * flight point to are never changed: one that would need to be is retired,
+ * and a new one takes its place.
+ *
+ * The slots give, for every entry of the new lists, the index of the
+ * record it ended up in.
+ */
+bool HitEngine::reload(const LinkStore &llNewLinks,
+                       const ProxyList &plNewProxies,
+                       QStringList     slNewAgents,
+                       QVector<int>    &viLinkSlots,
+                       QVector<int>    &viProxySlots,
+                       QString         &sError) {
+    QHash<QString,QVector<int>> hshLinks,
+                                hshProxies;
+    sError.clear();
+    viLinkSlots.clear();
+    viProxySlots.clear();
+    if(!sslCurrentSteps.isEmpty()) {
+        sError=QStringLiteral("Scenarios can't be reloaded");
+        return false;
+    }
+    // A plan refers to the lists by position, as they were.
+    if(bRunning&&!rplCurrentPlan.vphHits.isEmpty()) {
+        sError=QStringLiteral("Run plans can't be reloaded");
+        return false;
+    }
+    if(!llPendingLinks.isEmpty()||!plPendingProxies.isEmpty()) {
+        sError=QStringLiteral("The last reload is still waiting for the hits in flight");
+        return false;
+    }
+    // Active records go first, so duplicates revive retired ones last.
+    for(bool bRetired:{false,true}) {
+        for(const auto &l:llCurrentLinks)
+            if(bRetired==l.bRetired)
+                hshLinks[llCurrentLinks.getLabel(l.uiIndex)].append(l.uiIndex);
+        for(const auto &p:plCurrentProxies)
+            if(bRetired==p.bRetired)
+                hshProxies[ProxyParser::getTextFromProxy(p.npxProxy)].append(p.uiIndex);
+    }
+    viLinkSlots.reserve(llNewLinks.count());
+    for(int iK=0;iK<llNewLinks.count();iK++) {
+        auto itMatch=hshLinks.find(llNewLinks.getLabel(iK));
+        int  iSlot=-1;
+        if(hshLinks.end()!=itMatch)
+            for(int iL=0;iL<itMatch->count();iL++) {
+                const LinkRecord &lrSlot=llCurrentLinks.at(itMatch->at(iL));
+                // A record a hit still points to is only taken as it is, ...
+                // ... otherwise it's retired and a new one is appended.
+                if(!lrSlot.bBusy||!lrSlot.bRetired) {
+                    iSlot=itMatch->takeAt(iL);
+                    break;
+                }
+            }
+        if(iSlot>=0)
+            viLinkSlots.append(iSlot);
+        else {
+            viLinkSlots.append(llCurrentLinks.count()+llPendingLinks.count());
+            llPendingLinks.append(
+                llNewLinks.getUrl(iK),
+                llNewLinks.getAssertions(iK),
+                llNewLinks.getTemplate(iK)
+            );
+        }
+    }
+    // Checked before any record changes, so a refused reload leaves no trace.
+    if(!llCurrentLinks.canAppend(llPendingLinks)) {
+        llPendingLinks.clear();
+        viLinkSlots.clear();
+        sError=QStringLiteral("The links are too long to be loaded together");
+        return false;
+    }
+    for(int iK=0;iK<viLinkSlots.count();iK++)
+        if(viLinkSlots.at(iK)<llCurrentLinks.count()) {
+            if(!llCurrentLinks.at(viLinkSlots.at(iK)).bBusy)
+                llCurrentLinks[viLinkSlots.at(iK)].bRetired=false;
+            // Hits carry their own copy of the assertions.
+            llCurrentLinks.setAssertions(viLinkSlots.at(iK),llNewLinks.getAssertions(iK));
+        }
+    viProxySlots.reserve(plNewProxies.count());
+    for(const auto &p:plNewProxies) {
+        auto itMatch=hshProxies.find(ProxyParser::getTextFromProxy(p.npxProxy));
+        int  iSlot=-1;
+        if(hshProxies.end()!=itMatch)
+            for(int iL=0;iL<itMatch->count();iL++) {
+                const ProxyRecord &prSlot=plCurrentProxies.at(itMatch->at(iL));
+                if(!prSlot.bBusy||(!prSlot.bRetired&&prSlot.uiRateLimit==p.uiRateLimit)) {
+                    iSlot=itMatch->takeAt(iL);
+                    break;
+                }
+            }
+        if(iSlot>=0) {
+            if(!plCurrentProxies.at(iSlot).bBusy) {
+                plCurrentProxies[iSlot].bRetired=false;
+                plCurrentProxies[iSlot].uiRateLimit=p.uiRateLimit;
+            }
+            viProxySlots.append(iSlot);
+        }
+        else {
+            ProxyRecord prProxy=p;
+            prProxy.bBusy=false;
+            prProxy.bRetired=false;
+            prProxy.uiIndex=plCurrentProxies.count()+plPendingProxies.count();
+            viProxySlots.append(prProxy.uiIndex);
+            plPendingProxies.append(prProxy);
+        }
+    }
+    if(bRunning&&!plPendingProxies.isEmpty()) {
+        QStringList slProxyLabels;
+        for(const auto &p:plPendingProxies)
+            slProxyLabels.append(getProxyLabel(p.npxProxy));
+        Metrics::addProxies(slProxyLabels);
+    }
+    // Whatever was left unmatched is no longer listed, busy records ...
+    // ... included: retiring one only keeps the scheduler away from it.
+    for(const auto &m:hshLinks)
+        for(const auto &i:m)
+            llCurrentLinks[i].bRetired=true;
+    for(const auto &m:hshProxies)
+        for(const auto &i:m)
+            plCurrentProxies[i].bRetired=true;
+    this->updateActive();
+    slCurrentAgents=slNewAgents;
+    // Checkpoints from here on can't be told apart from those of other ...
+    // ... lists, so they are marked as unresumable.
+    bytCurrentFingerprint.clear();
+    if(!bRunning||!uiTotalWorkers||
+       (llCurrentLinks.capacity()-llCurrentLinks.count()>=llPendingLinks.count()&&
+        plCurrentProxies.capacity()-plCurrentProxies.count()>=plPendingProxies.count()))
+        this->applyPending();
+    else
+        this->updateRates();
+    emit listsChanged();
+    // New records may be free when all the others were busy.
+    if(bRunning)
+        this->browse();
+    return true;
+}
+
+void HitEngine::reset() {
+    // Starts the scheduler from scratch (a checkpoint may restore it later).
+    uiScheduledHits=0;
+    uiElapsedBefore=0;
+    rngScheduler.seed(QRandomGenerator::global()->generate());
+}
+
+void HitEngine::setAgents(QStringList slNewAgents) {
+    slCurrentAgents=slNewAgents;
+}
+
+void HitEngine::setCachePath(QString sNewPath) {
+    // Validators survive the runs anyway. This keeps them across sessions.
+    sCachePath=sNewPath;
+}
+
+void HitEngine::setCheckpoint(QString sNewPath,uint uiNewInterval) {
+    sCheckpointPath=sNewPath;
+    uiCheckpointInterval=uiNewInterval;
+}
+
+void HitEngine::setCompletion(QString sNewCompletion,bool bNewFetchContent) {
+    // Passed as is to the browser helpers, which validate it.
+    sCompletion=sNewCompletion;
+    bFetchContent=bNewFetchContent;
+}
+
+void HitEngine::setFingerprint(QByteArray bytNewFingerprint) {
+    bytCurrentFingerprint=bytNewFingerprint;
+}
+
+void HitEngine::setLinks(LinkStore llNewLinks) {
+    llCurrentLinks=std::move(llNewLinks);
+    this->updateActive();
+}
+
+void HitEngine::setMaxCooldown(uint uiNewMaxCooldown) {
+    uiMaxCooldown=uiNewMaxCooldown;
+}
+
+void HitEngine::setMaxWorkers(uint uiNewMaxWorkers) {
+    uiMaxWorkers=uiNewMaxWorkers;
+    if(nullptr!=nenNetwork)
+        nenNetwork->setMaxInFlight(uiMaxWorkers);
+    // A raise takes effect right away. A cut, as the workers finish.
+    if(bRunning)
+        this->browse();
+}
+
+void HitEngine::setMemoryBudget(uint uiNewBudget) {
+    MemoryGovernor::setBudget(quint64(uiNewBudget)*MEMORY_BUDGET_UNIT);
+    // Lifting the budget lets the scheduler fill the slots it held back.
+    if(bRunning)
+        this->browse();
+}
+
+void HitEngine::setMode(BrowserWorker::RunMode rmNewMode) {
+    rmMode=rmNewMode;
+}
+
+void HitEngine::setNetworkPolicy(NetworkPolicy npcNewPolicy) {
+    // Only applies to plain hits, and only from the next run on.
+    npcPolicy=npcNewPolicy;
+}
+
+bool HitEngine::setPlan(const RunPlan &rplNewPlan,QString &sError) {
+    sError.clear();
+    // An empty plan brings back the random scheduler.
+    if(!rplNewPlan.vphHits.isEmpty())
+        if(rplNewPlan.uiLinks!=uint(llCurrentLinks.count())||
+           rplNewPlan.uiProxies!=uint(plCurrentProxies.count())||
+           rplNewPlan.uiAgents!=uint(slCurrentAgents.count())) {
+            sError=QStringLiteral("The run plan does not belong to the current lists");
+            return false;
+        }
+    rplCurrentPlan=rplNewPlan;
+    return true;
+}
+
+void HitEngine::setProfilePath(QString sNewPath) {
+    // Empty for cold page loads, a folder to keep the helpers' profiles warm.
+    sProfilePath=sNewPath;
+}
+
+void HitEngine::setProxies(ProxyList plNewProxies) {
+    plCurrentProxies=plNewProxies;
+    this->updateActive();
+}
+
+void HitEngine::setResources(bool bNewResources,uint uiNewHarSampling,QString sNewHarFolder) {
+    // Only applies to browser hits. No sampling (0) means no HAR files.
+    bResources=bNewResources;
+    uiHarSampling=uiNewHarSampling;
+    sHarFolder=sNewHarFolder;
+}
+
+void HitEngine::setSteps(ScenarioStepList sslNewSteps) {
+    // Non-empty steps turn the engine into a scenario runner.
+    sslCurrentSteps=sslNewSteps;
+}
+
+void HitEngine::start() {
+    QStringList      slProxyLabels;
+    QVector<quint64> vuiRateLimits;
+    bRunning=true;
+    ctpCurrentRun=CancelTokenPtr(new CancelToken());
+    // Also detaches the lists from any copy, before pointers are handed out.
+    llPendingLinks.clear();
+    plPendingProxies.clear();
+    llCurrentLinks.reserve(getSpareCapacity(llCurrentLinks.count()));
+    plCurrentProxies.reserve(getSpareCapacity(plCurrentProxies.count()));
+    for(const auto &p:plCurrentProxies) {
+        slProxyLabels.append(getProxyLabel(p.npxProxy));
+        vuiRateLimits.append(p.uiRateLimit);
+    }
+    Metrics::beginRun(slProxyLabels);
+    Diagnostics::beginRun();
+    ErrorTaxonomy::beginRun();
+    TlsSessionCache::beginRun(npcPolicy.bResumeTls);
+    ResourceStats::beginRun();
+    Bandwidth::beginRun(vuiRateLimits);
+    MemoryGovernor::beginRun();
+    uiResourceHits=0;
+    lprProbe.start();
+    tmrMemory.start(MEMORY_SAMPLE_INTERVAL);
+    if(BrowserWorker::RunMode::RM_NETWORK==rmMode&&sslCurrentSteps.isEmpty()) {
+        // Plain hits go to the multi-loop engine instead of a thread each.
+        nenNetwork=new NetworkEngine(this);
+        nenNetwork->setMaxInFlight(uiMaxWorkers);
+        nenNetwork->setPolicy(npcPolicy);
+        nenNetwork->setValidators(&vchValidators);
+        if(npcPolicy.bRevalidate&&!sCachePath.isEmpty()&&QFile::exists(sCachePath)) {
+            QString sError;
+            // An unreadable cache is no reason not to run: it just starts cold.
+            if(!vchValidators.readFromFile(sCachePath,sError))
+                vchValidators.clear();
+        }
+        connect(
+            nenNetwork,
+            &NetworkEngine::hitFinished,
+            this,
+            &HitEngine::networkHitFinished
+        );
+        connect(
+            nenNetwork,
+            &NetworkEngine::hitStarted,
+            this,
+            &HitEngine::networkHitStarted
+        );
+    }
+    if(uiCheckpointInterval&&!sCheckpointPath.isEmpty()) {
+        cwrCheckpoint=new CheckpointWriter(this,sCheckpointPath);
+        connect(
+            cwrCheckpoint,
+            &CheckpointWriter::written,
+            this,
+            &HitEngine::checkpointWritten
+        );
+        cwrCheckpoint->start(QThread::Priority::LowPriority);
+        tmrCheckpoint.start(uiCheckpointInterval*1000);
+    }
+    etmCurrentRun.start();
+    this->browse();
+}
+
+void HitEngine::stop() {
+    bRunning=false;
+    // Aborts pending replies, kills helpers and interrupts cooldowns.
+    if(!ctpCurrentRun.isNull())
+        ctpCurrentRun->cancel();
+    for(auto &s:this->findChildren<ScenarioSession *>())
+        s->cancel();
+    if(nullptr!=nenNetwork)
+        nenNetwork->cancel();
+    tmrCheckpoint.stop();
+    tmrMemory.stop();
+    lprProbe.stop();
+    while(uiTotalWorkers)
+        QCoreApplication::processEvents(
+            QEventLoop::ProcessEventsFlag::ExcludeUserInputEvents
+        );
+    if(nullptr!=nenNetwork) {
+        delete nenNetwork;
+        nenNetwork=nullptr;
+        if(npcPolicy.bRevalidate&&!sCachePath.isEmpty()) {
+            QString sError;
+            vchValidators.writeToFile(sCachePath,sError);
+        }
+    }
+    if(nullptr!=cwrCheckpoint) {
+        // Flushes the final counters before releasing the writer.
+        cwrCheckpoint->submit(this->getCheckpoint());
+        cwrCheckpoint->finish();
+        cwrCheckpoint->deleteLater();
+        cwrCheckpoint=nullptr;
+    }
+}
+
+void HitEngine::updateActive() {
+    // Slots are sampled from these, never from the whole lists: after ...
+    // ... reloads, retired records could otherwise make up most of them. ...
+    // ... With nothing retired, they map every slot to itself, so the ...
+    // ... same seed still schedules the same hits.
+    viActiveLinks.clear();
+    viActiveProxies.clear();
+    for(int iK=0;iK<llCurrentLinks.count();iK++)
+        if(!llCurrentLinks.at(iK).bRetired)
+            viActiveLinks.append(iK);
+    for(int iK=0;iK<plCurrentProxies.count();iK++)
+        if(!plCurrentProxies.at(iK).bRetired)
+            viActiveProxies.append(iK);
+}
+
+void HitEngine::updateRates() {
+    QVector<quint64> vuiRateLimits;
+    vuiRateLimits.reserve(plCurrentProxies.count());
+    for(const auto &p:plCurrentProxies)
+        vuiRateLimits.append(p.uiRateLimit);
+    Bandwidth::setRates(vuiRateLimits);
+}
+
+void HitEngine::memoryTimeout() {
+    quint64 uiProxies=quint64(plCurrentProxies.capacity())*sizeof(ProxyRecord);
+    // The stats are estimated from the stores, the queued events from ...
+    // ... the depth the diagnostics already keep.
+    MemoryGovernor::setUsage(
+        MemoryGovernor::Consumer::CS_STATS,
+        llCurrentLinks.getMemoryUsage()+uiProxies
+    );
+    MemoryGovernor::setUsage(
+        MemoryGovernor::Consumer::CS_EVENTS,
+        quint64(Diagnostics::getQueueDepth())*QUEUED_EVENT_SIZE
+    );
+    // Held back slots come back as the memory drains, even with no hit ...
+    // ... finishing to trigger a pass.
+    if(bRunning)
+        this->browse();
+}
+
+void HitEngine::networkHitFinished(NetworkResult nrsResult) {
+    LinkRecord  *lrCurrentLink=nrsResult.nhtHit.lrLink;
+    ProxyRecord *prCurrentProxy=nrsResult.nhtHit.prProxy;
+    Diagnostics::eventHandled();
+    // Counted here, in the engine's thread: the loops only carry the records ...
+    // ... back, and work from the copies made when the hit was submitted.
+    lrCurrentLink->uiRetries+=nrsResult.nhtHit.uiRetries;
+    if(nrsResult.bCancelled)
+        lrCurrentLink->uiCancels++;
+    else if(nrsResult.bFailed) {
+        lrCurrentLink->uiFailures++;
+        llCurrentLinks.recordError(lrCurrentLink->uiIndex,nrsResult.ecError);
+        ErrorTaxonomy::record(nrsResult.ecError,nrsResult.sError);
+    }
+    else if(nrsResult.sError.isEmpty()) {
+        lrCurrentLink->uiHits++;
+        if(nrsResult.bNotModified)
+            lrCurrentLink->uiRevalidations++;
+    }
+    else {
+        lrCurrentLink->uiErrors++;
+        llCurrentLinks.recordError(lrCurrentLink->uiIndex,nrsResult.ecError);
+        ErrorTaxonomy::record(nrsResult.ecError,nrsResult.sError);
+    }
+    // A 304 says little about the cost of the page, so it stays out of it.
+    if(nrsResult.iLatency>=0&&!nrsResult.bNotModified) {
+        llCurrentLinks.recordLatency(lrCurrentLink->uiIndex,nrsResult.iLatency);
+        if(nullptr!=prCurrentProxy)
+            prCurrentProxy->lhLatency.record(nrsResult.iLatency);
+    }
+    // Every attempt's bytes, retries and cancelled transfers included.
+    llCurrentLinks.recordTraffic(lrCurrentLink->uiIndex,nrsResult.nhtHit.tcTraffic);
+    lrCurrentLink->bBusy=false;
+    if(nullptr!=prCurrentProxy) {
+        prCurrentProxy->tcTraffic.uiSent+=nrsResult.nhtHit.tcTraffic.uiSent;
+        prCurrentProxy->tcTraffic.uiReceived+=nrsResult.nhtHit.tcTraffic.uiReceived;
+        // A response that fails its assertions was still delivered by the proxy.
+        if(nrsResult.bCancelled)
+            prCurrentProxy->uiCancels++;
+        else if(nrsResult.bFailed||nrsResult.sError.isEmpty())
+            prCurrentProxy->uiHits++;
+        else {
+            prCurrentProxy->uiErrors++;
+            prCurrentProxy->ecsErrors.uiCounts[nrsResult.ecError]++;
+        }
+        prCurrentProxy->bBusy=false;
+    }
+    // The window is connected directly, so this times its redraws too.
+    Tracer::record(nrsResult.nhtHit.uiTraceId,Tracer::TraceEvent::TE_UI_BEGIN);
+    emit statusChanged(
+        lrCurrentLink,
+        prCurrentProxy,
+        nrsResult.bCancelled?QStringLiteral("Cancelled"):QStringLiteral("Idle")
+    );
+    emit hitFinished(lrCurrentLink,prCurrentProxy);
+    Tracer::record(nrsResult.nhtHit.uiTraceId,Tracer::TraceEvent::TE_UI_END);
+    uiTotalWorkers--;
+    if(bRunning)
+        this->browse();
+}
+
+void HitEngine::networkHitStarted(NetworkHit nhtHit) {
+    Diagnostics::eventHandled();
+    emit hitStarted(nhtHit.lrLink,nhtHit.prProxy);
+    emit statusChanged(
+        nhtHit.lrLink,
+        nhtHit.prProxy,
+        nhtHit.uiCooldown?QStringLiteral("Starting in %1s").arg(nhtHit.uiCooldown):
+                          QStringLiteral("Browsing...")
+    );
+}
+
+void HitEngine::sessionFinished() {
+    ScenarioSession *ssnSession=qobject_cast<ScenarioSession *>(QObject::sender());
+    ProxyRecord     *prCurrentProxy=ssnSession->getProxyRecord();
+    if(nullptr!=prCurrentProxy)
+        prCurrentProxy->bBusy=false;
+    emit hitFinished(nullptr,prCurrentProxy);
+    ssnSession->disconnect();
+    ssnSession->deleteLater();
+    uiTotalWorkers--;
+    if(bRunning)
+        this->browse();
+}
+
+void HitEngine::sessionStepFinished(LinkRecord *lrStep,QString sStatus) {
+    ScenarioSession *ssnSession=qobject_cast<ScenarioSession *>(QObject::sender());
+    emit statusChanged(lrStep,ssnSession->getProxyRecord(),sStatus);
+}
+
+void HitEngine::workerFinished() {
+    BrowserWorker *bwWorker=qobject_cast<BrowserWorker *>(QObject::sender());
+    LinkRecord    *lrCurrentLink=bwWorker->getLinkRecord();
+    ProxyRecord   *prCurrentProxy=bwWorker->getProxyRecord();
+    lrCurrentLink->bBusy=false;
+    // Latencies and errors go to the store here, in the engine's thread, ...
+    // ... never from the workers.
+    if(bwWorker->getLatency()>=0) {
+        llCurrentLinks.recordLatency(lrCurrentLink->uiIndex,bwWorker->getLatency());
+        if(nullptr!=prCurrentProxy)
+            prCurrentProxy->lhLatency.record(bwWorker->getLatency());
+    }
+    if(!bwWorker->getError().isEmpty()) {
+        llCurrentLinks.recordError(lrCurrentLink->uiIndex,bwWorker->getErrorCode());
+        ErrorTaxonomy::record(bwWorker->getErrorCode(),bwWorker->getError());
+        // Failed assertions were still delivered by the proxy.
+        if(nullptr!=prCurrentProxy&&ErrorCode::EC_ASSERTION!=bwWorker->getErrorCode())
+            prCurrentProxy->ecsErrors.uiCounts[bwWorker->getErrorCode()]++;
+    }
+    llCurrentLinks.recordTraffic(lrCurrentLink->uiIndex,bwWorker->getTraffic());
+    if(nullptr!=prCurrentProxy) {
+        prCurrentProxy->tcTraffic.uiSent+=bwWorker->getTraffic().uiSent;
+        prCurrentProxy->tcTraffic.uiReceived+=bwWorker->getTraffic().uiReceived;
+        prCurrentProxy->bBusy=false;
+    }
+    Tracer::record(bwWorker->getTraceId(),Tracer::TraceEvent::TE_UI_BEGIN);
+    emit hitFinished(lrCurrentLink,prCurrentProxy);
+    Tracer::record(bwWorker->getTraceId(),Tracer::TraceEvent::TE_UI_END);
+    bwWorker->disconnect();
+    bwWorker->deleteLater();
+    uiTotalWorkers--;
+    if(bRunning)
+        this->browse();
+}
+
+void HitEngine::workerStarted() {
+    BrowserWorker *bwWorker=qobject_cast<BrowserWorker *>(QObject::sender());
+    LinkRecord    *lrCurrentLink=bwWorker->getLinkRecord();
+    ProxyRecord   *prCurrentProxy=bwWorker->getProxyRecord();
+    lrCurrentLink->bBusy=true;
+    if(nullptr!=prCurrentProxy)
+        prCurrentProxy->bBusy=true;
+    emit hitStarted(lrCurrentLink,prCurrentProxy);
+}
+
+void HitEngine::workerStatusChanged(QString sStatus) {
+    BrowserWorker *bwWorker=qobject_cast<BrowserWorker *>(QObject::sender());
+    emit statusChanged(bwWorker->getLinkRecord(),bwWorker->getProxyRecord(),sStatus);
+}
+
+BrowserWorker::BrowserWorker(QObject        *objParent,
+                             LinkRecord     *lrNewLink,
+                             ProxyRecord    *prNewProxy,
+                             QString        sNewAgent,
+                             CancelTokenPtr ctpNewCancel):
+QThread(objParent) {
+    bCancelled=false;
+    bFailed=false;
+    bContent=true;
+    bResources=false;
+    uiCooldown=0;
+    iLatency=-1;
+    uiBytes=0;
+    uiTraceId=0;
+    tcTraffic={0,0};
+    sError.clear();
+    sProfile.clear();
+    sCompletion.clear();
+    sHarPath.clear();
+    ecError=ErrorCode::EC_OTHER;
+    lrLink=lrNewLink;
+    prProxy=prNewProxy;
+    sAgent=sNewAgent;
+    rmMode=BrowserWorker::RunMode::RM_WEB_ENGINE;
+    // The helper is charged from the moment it is scheduled, well before ...
+    // ... it can be measured, so a single pass can't start too many.
+    mchHelper=MemoryCharge(MemoryGovernor::Consumer::CS_HELPERS);
+    mchHelper.set(MemoryGovernor::getHelperEstimate());
+    // A worker created without a token simply never gets cancelled.
+    ctpCancel=ctpNewCancel.isNull()?CancelTokenPtr(new CancelToken()):ctpNewCancel;
+    etmSpawn.start();
+}
+
+QString BrowserWorker::getError() {
+    return sError;
+}
+
+ErrorCode BrowserWorker::getErrorCode() {
+    return ecError;
+}
+
+qint64 BrowserWorker::getLatency() {
+    return iLatency;
+}
+
+LinkRecord *BrowserWorker::getLinkRecord() {
+    return lrLink;
+}
+
+ProxyRecord *BrowserWorker::getProxyRecord() {
+    return prProxy;
+}
+
+quint64 BrowserWorker::getTraceId() {
+    return uiTraceId;
+}
+
+TrafficCounts BrowserWorker::getTraffic() {
+    return tcTraffic;
+}
+
+void BrowserWorker::run() {
+    // From the worker's creation to its first instruction in the new thread.
+    Diagnostics::threadSpawned(etmSpawn.nsecsElapsed());
+    emit statusChanged(QString());
+    if(nullptr!=lrLink) {
+        if(uiCooldown)
+            Tracer::record(uiTraceId,Tracer::TraceEvent::TE_WAIT_BEGIN);
+        for(int iK=uiCooldown;iK;iK--) {
+            // A countdown is the first thing to go under memory pressure.
+            if(MemoryGovernor::isCoalescing())
+                MemoryGovernor::throttled(MemoryGovernor::Throttle::TH_EVENTS);
+            else
+                emit statusChanged(QStringLiteral("Starting in %1s").arg(iK));
+            if(!ctpCancel->sleep(1000)) {
+                bCancelled=true;
+                break;
+            }
+        }
+        if(uiCooldown)
+            Tracer::record(uiTraceId,Tracer::TraceEvent::TE_WAIT_END);
+        Metrics::hitStarted();
+        if(!bCancelled) {
+            QElapsedTimer etmHit;
+            emit statusChanged(QStringLiteral("Browsing..."));
+            Tracer::record(uiTraceId,Tracer::TraceEvent::TE_STARTED);
+            etmHit.start();
+            // Plain HTTP hits are run by the network engine instead.
+            if(BrowserWorker::RunMode::RM_WEB_ENGINE==rmMode)
+                this->runWithWebEngine();
+            // Only successful hits are meaningful for the latency stats.
+            if(!bCancelled&&!bFailed&&sError.isEmpty()) {
+                iLatency=etmHit.elapsed();
+                if(BrowserWorker::RunMode::RM_WEB_ENGINE==rmMode)
+                    Metrics::pageLoaded(!sProfile.isEmpty(),iLatency);
+            }
+            Tracer::record(uiTraceId,Tracer::TraceEvent::TE_FINISHED);
+        }
+    }
+    // Also drops what was reserved for a helper that never started, before ...
+    // ... the engine schedules the next hits.
+    mchHelper.set(0);
+    // Interrupted hits are neither successes nor failures.
+    if(nullptr!=lrLink)
+        Metrics::hitFinished(
+            bCancelled?Metrics::HitResult::HR_CANCEL:
+            bFailed?Metrics::HitResult::HR_FAILURE:
+            sError.isEmpty()?Metrics::HitResult::HR_HIT:
+                             Metrics::HitResult::HR_ERROR,
+            nullptr!=prProxy?int(prProxy->uiIndex):-1,
+            uiBytes,
+            iLatency
+        );
+    if(nullptr!=lrLink) {
+        if(bCancelled)
+            lrLink->uiCancels++;
+        else if(bFailed)
+            lrLink->uiFailures++;
+        else if(sError.isEmpty())
+            lrLink->uiHits++;
+        else
+            lrLink->uiErrors++;
+        lrLink->bBusy=false;
+    }
+    if(nullptr!=prProxy) {
+        if(bCancelled)
+            prProxy->uiCancels++;
+        else if(bFailed||sError.isEmpty())
+            prProxy->uiHits++;
+        else
+            prProxy->uiErrors++;
+        prProxy->bBusy=false;
+    }
+    emit statusChanged(
+        bCancelled?QStringLiteral("Cancelled"):QStringLiteral("Idle")
+    );
+}
+
+void BrowserWorker::runWithWebEngine() {
+    sError.clear();
+    if(nullptr!=lrLink) {
+        bool         bKeepContent=bContent;
+        uint         uiPolls=0;
+        QString      sBrowserPath;
+        QStringList  slBrowserParams;
+        QProcess     proBrowserApp;
+        sBrowserPath=QStringLiteral("%1/%2").arg(
+            QCoreApplication::applicationDirPath(),
+            QStringLiteral(APP_BROWSER_EXE)
+        );
+        slBrowserParams={urlLink.toString()};
+        if(nullptr!=prProxy)
+            slBrowserParams.append({
+                QStringLiteral("-p"),
+                ProxyParser::getTextFromProxy(prProxy->npxProxy)
+            });
+        if(!sAgent.isEmpty())
+            slBrowserParams.append({
+                QStringLiteral("-a"),
+                sAgent
+            });
+        if(!sProfile.isEmpty())
+            slBrowserParams.append({
+                QStringLiteral("-w"),
+                sProfile
+            });
+        if(!sCompletion.isEmpty())
+            slBrowserParams.append({
+                QStringLiteral("-u"),
+                sCompletion
+            });
+        // Content assertions need the HTML, whatever was asked for. Under ...
+        // ... memory pressure, nothing else does.
+        if(bKeepContent&&lapAssertions.isNull()&&MemoryGovernor::isDroppingBodies()) {
+            bKeepContent=false;
+            MemoryGovernor::throttled(MemoryGovernor::Throttle::TH_BODIES);
+        }
+        if(!bKeepContent&&lapAssertions.isNull())
+            slBrowserParams.append(QStringLiteral("-n"));
+        if(bResources)
+            slBrowserParams.append(QStringLiteral("-t"));
+        if(!sHarPath.isEmpty())
+            slBrowserParams.append({
+                QStringLiteral("-r"),
+                sHarPath
+            });
+        proBrowserApp.start(sBrowserPath,slBrowserParams);
+        // Right after the start, Chromium has yet to fork its renderers, so ...
+        // ... the estimate stands until the first periodic sample replaces it.
+        mchHelper.set(qMax(
+            MemoryGovernor::getHelperEstimate(),
+            MemoryGovernor::getProcessMemory(proBrowserApp.processId())
+        ));
+        // Polls the helper, so a cancellation can kill it right away. Its ...
+        // ... memory is only sampled now and then: walking a process tree ...
+        // ... isn't free. The charge goes with the helper, on any way out.
+        while(!proBrowserApp.waitForFinished(CANCEL_POLL_INTERVAL))
+            if(QProcess::ProcessState::NotRunning==proBrowserApp.state())
+                break;
+            else if(ctpCancel->isCancelled()) {
+                bCancelled=true;
+                proBrowserApp.kill();
+                proBrowserApp.waitForFinished(-1);
+                return;
+            }
+            else if(!(++uiPolls%HELPER_SAMPLE_POLLS))
+                mchHelper.set(MemoryGovernor::getProcessMemory(proBrowserApp.processId()));
+        mchHelper.set(0);
+        if(QProcess::ExitStatus::NormalExit==proBrowserApp.exitStatus()) {
+            QString       sJSON=proBrowserApp.readAll();
+            QJsonDocument jsnDoc=QJsonDocument::fromJson(sJSON.toUtf8());
+            QJsonObject   jsnObj=jsnDoc.isObject()?jsnDoc.object():QJsonObject();
+            // Reported as they were: Chromium moves the bytes on its own, ...
+            // ... so there's no throttling them from here.
+            if(jsnObj.contains(QStringLiteral("traffic"))) {
+                int iProxy=nullptr!=prProxy?int(prProxy->uiIndex):-1;
+                tcTraffic={
+                    quint64(jsnObj.value(QStringLiteral("traffic")).toArray().at(0).toDouble()),
+                    quint64(jsnObj.value(QStringLiteral("traffic")).toArray().at(1).toDouble())
+                };
+                Bandwidth::sent(iProxy,tcTraffic.uiSent);
+                Bandwidth::received(iProxy,tcTraffic.uiReceived);
+            }
+            if(!proBrowserApp.exitCode()) {
+                if(jsnObj.contains(QStringLiteral("resources")))
+                    ResourceStats::record(jsnObj.value(QStringLiteral("resources")).toArray());
+                if(jsnObj.contains(QStringLiteral("content"))) {
+                    QByteArray       bytContent=jsnObj.value(QStringLiteral("content")).toString().toUtf8();
+                    AssertionMatcher amtMatcher(lapAssertions);
+                    // The helper reports no status code, so only the content is checked.
+                    uiBytes=bytContent.size();
+                    amtMatcher.feed(bytContent.constData(),bytContent.size());
+                    sError=amtMatcher.finish();
+                    bFailed=!sError.isEmpty();
+                    ecError=ErrorCode::EC_ASSERTION;
+                }
+                // Without the HTML, a clean exit is all there is to check.
+                else if(bKeepContent||!lapAssertions.isNull()) {
+                    sError=QStringLiteral("Wrong browser response"); // Impossible.
+                    ecError=ErrorCode::EC_BROWSER;
+                }
+            }
+            else {
+                // The helper only reports text, so its errors make a kind of their own.
+                if(jsnObj.contains(QStringLiteral("error")))
+                    sError=jsnObj.value(QStringLiteral("error")).toString();
+                else
+                    sError=QStringLiteral("Wrong browser call"); // Impossible.
+                ecError=ErrorCode::EC_BROWSER;
+            }
+        }
+        else {
+            sError=QStringLiteral("Browser crashed"); // Improbable.
+            ecError=ErrorCode::EC_BROWSER_CRASH;
+        }
+    }
+}
+
+void BrowserWorker::setCompletion(QString sNewCompletion,bool bNewContent) {
+    sCompletion=sNewCompletion;
+    bContent=bNewContent;
+}
+
+void BrowserWorker::setCooldown(uint uiNewCooldown) {
+    uiCooldown=uiNewCooldown;
+}
+
+void BrowserWorker::setMode(RunMode rmNewMode) {
+    rmMode=rmNewMode;
+    // Only web engine hits start a helper.
+    mchHelper.set(BrowserWorker::RunMode::RM_WEB_ENGINE==rmMode?MemoryGovernor::getHelperEstimate():0);
+}
+
+void BrowserWorker::setProfile(QString sNewProfile) {
+    sProfile=sNewProfile;
+}
+
+void BrowserWorker::setResources(bool bNewResources,QString sNewHarPath) {
+    bResources=bNewResources;
+    sHarPath=sNewHarPath;
+}
+
+void BrowserWorker::setTarget(QUrl urlNewLink,LinkAssertionsPtr lapNewAssertions) {
+    urlLink=urlNewLink;
+    lapAssertions=lapNewAssertions;
+}
+
+void BrowserWorker::setTraceId(quint64 uiNewTraceId) {
+    uiTraceId=uiNewTraceId;
+}
+
+ScenarioSession::ScenarioSession(QObject                *objParent,
+                                 LinkStore              *llNewSteps,
+                                 const ScenarioStepList *sslNewSteps,
+                                 ProxyRecord            *prNewProxy,
+                                 QString                sNewAgent):
+QObject(objParent) {
+    bCancelled=false;
+    bFinished=false;
+    bTicketOffered=false;
+    bEncrypted=false;
+    iStep=0;
+    sAgent=sNewAgent;
+    llSteps=llNewSteps;
+    prProxy=prNewProxy;
+    sslSteps=sslNewSteps;
+    nrpReply=nullptr;
+    // All the steps share the cookies and the kept-alive connections ...
+    // ... of this manager, just like the tabs of a real browser would.
+    namManager.setCookieJar(new QNetworkCookieJar(&namManager));
+    connect(
+        &namManager,
+        &QNetworkAccessManager::sslErrors,
+        [](QNetworkReply *nrpError,const QList<QSslError> &) {
+            nrpError->ignoreSslErrors();
+        }
+    );
+    if(nullptr!=prProxy)
+        namManager.setProxy(prProxy->npxProxy);
+    namManager.setTransferTimeout();
+    tmrWait.setSingleShot(true);
+    connect(
+        &tmrWait,
+        &QTimer::timeout,
+        this,
+        &ScenarioSession::sendStep
+    );
+}
+
+ProxyRecord *ScenarioSession::getProxyRecord() {
+    return prProxy;
+}
+
+void ScenarioSession::cancel() {
+    if(!bFinished&&!bCancelled) {
+        bCancelled=true;
+        if(nullptr!=nrpReply)
+            // The reply finishes right away, and so does the session.
+            nrpReply->abort();
+        else {
+            // Still waiting: the pending step is the one being cancelled.
+            tmrWait.stop();
+            Metrics::hitStarted();
+            Metrics::hitFinished(
+                Metrics::HitResult::HR_CANCEL,
+                nullptr!=prProxy?int(prProxy->uiIndex):-1,
+                0,
+                -1
+            );
+            (*llSteps)[iStep].uiCancels++;
+            if(nullptr!=prProxy)
+                prProxy->uiCancels++;
+            emit stepFinished(&(*llSteps)[iStep],QStringLiteral("Cancelled"));
+            this->finish();
+        }
+    }
+}
+
+void ScenarioSession::finish() {
+    bFinished=true;
+    emit finished();
+}
+
+void ScenarioSession::replyEncrypted() {
+    bEncrypted=true;
+}
+
+void ScenarioSession::replyFinished() {
+    uint       uiStatus;
+    qint64     iLatency=etmStep.elapsed();
+    quint64    uiBytes=nrpReply->bytesAvailable();
+    QString    sError=QString();
+    ErrorCode  ecError=ErrorCode::EC_OTHER;
+    LinkRecord *lrStep=&(*llSteps)[iStep];
+    uiStatus=nrpReply->attribute(
+        QNetworkRequest::Attribute::HttpStatusCodeAttribute
+    ).toUInt();
+    if(QNetworkReply::NetworkError::NoError!=nrpReply->error())
+        if(uiStatus) {
+            sError=QStringLiteral("Unexpected response code: %1").arg(uiStatus);
+            ecError=ErrorTaxonomy::fromStatus(uiStatus);
+        }
+        else {
+            sError=nrpReply->errorString();
+            ecError=ErrorTaxonomy::fromNetworkError(nrpReply->error());
+        }
+    else if(!uiStatus) {
+        sError=QStringLiteral("Response timeout expired");
+        ecError=ErrorCode::EC_TIMEOUT;
+    }
+    TlsSessionCache::finish(
+        nrpReply,
+        nullptr!=prProxy?int(prProxy->uiIndex):-1,
+        bTicketOffered,
+        bEncrypted
+    );
+    nrpReply->deleteLater();
+    nrpReply=nullptr;
+    Metrics::hitFinished(
+        bCancelled?Metrics::HitResult::HR_CANCEL:
+        sError.isEmpty()?Metrics::HitResult::HR_HIT:
+                         Metrics::HitResult::HR_ERROR,
+        nullptr!=prProxy?int(prProxy->uiIndex):-1,
+        uiBytes,
+        iLatency
+    );
+    if(bCancelled) {
+        lrStep->uiCancels++;
+        if(nullptr!=prProxy)
+            prProxy->uiCancels++;
+        emit stepFinished(lrStep,QStringLiteral("Cancelled"));
+        this->finish();
+    }
+    else if(!sError.isEmpty()) {
+        lrStep->uiErrors++;
+        llSteps->recordError(iStep,ecError);
+        ErrorTaxonomy::record(ecError,sError);
+        if(nullptr!=prProxy) {
+            prProxy->uiErrors++;
+            prProxy->ecsErrors.uiCounts[ecError]++;
+        }
+        emit stepFinished(lrStep,QStringLiteral("Error"));
+        // The following steps most likely depend on this one, so a ...
+        // ... failure ends the whole session.
+        this->finish();
+    }
+    else {
+        lrStep->uiHits++;
+        llSteps->recordLatency(iStep,iLatency);
+        if(nullptr!=prProxy) {
+            prProxy->uiHits++;
+            prProxy->lhLatency.record(iLatency);
+        }
+        emit stepFinished(lrStep,QStringLiteral("OK"));
+        if(++iStep<sslSteps->count()) {
+            Metrics::hitScheduled();
+            tmrWait.start(sslSteps->at(iStep).uiThinkTime);
+        }
+        else
+            this->finish();
+    }
+}
+
+void ScenarioSession::sendStep() {
+    const ScenarioStep &ssStep=sslSteps->at(iStep);
+    QNetworkRequest    nrqRequest;
+    nrqRequest.setUrl(ssStep.urlLink);
+    for(const auto &h:ssStep.lpHeaders)
+        nrqRequest.setRawHeader(h.first,h.second);
+    if(!sAgent.isEmpty())
+        nrqRequest.setHeader(
+            QNetworkRequest::KnownHeaders::UserAgentHeader,
+            sAgent
+        );
+    // Sessions start with a manager of their own, but not with a cold TLS cache.
+    bTicketOffered=TlsSessionCache::prepare(nrqRequest,nullptr!=prProxy?int(prProxy->uiIndex):-1);
+    bEncrypted=false;
+    Metrics::hitStarted();
+    etmStep.start();
+    nrpReply=namManager.sendCustomRequest(
+        nrqRequest,
+        ssStep.bytMethod,
+        ssStep.bytBody
+    );
+    connect(
+        nrpReply,
+        &QNetworkReply::encrypted,
+        this,
+        &ScenarioSession::replyEncrypted
+    );
+    connect(
+        nrpReply,
+        &QNetworkReply::finished,
+        this,
+        &ScenarioSession::replyFinished
+    );
+}
+
+void ScenarioSession::start(uint uiCooldown) {
+    // The first step's think-time is added to the random cooldown.
+    tmrWait.start(uiCooldown*1000+sslSteps->at(iStep).uiThinkTime);
+}
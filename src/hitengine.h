@@ -0,0 +1,280 @@
+#ifndef HITENGINE_H
+#define HITENGINE_H
+
+#include <QtCore>
+#include <QtNetwork>
+#include <random>
+#include "agentparser.h"
+#include "assertionmatcher.h"
+#include "bandwidth.h"
+#include "canceltoken.h"
+#include "checkpoint.h"
+#include "diagnostics.h"
+#include "errortaxonomy.h"
+#include "latencyhistogram.h"
+#include "linkstore.h"
+#include "memorygovernor.h"
+#include "metrics.h"
+#include "proxyparser.h"
+#include "resourcestats.h"
+#include "runplan.h"
+#include "scenarioparser.h"
+#include "tlssessioncache.h"
+#include "tracer.h"
+#include "validatorcache.h"
+
+using ProxyRecord=struct {
+    QNetworkProxy    npxProxy;
+    bool             bBusy,
+                     bRetired;
+    uint             uiIndex,
+                     uiHits,
+                     uiErrors,
+                     uiCancels;
+    ErrorCounts      ecsErrors;
+    LatencyHistogram lhLatency;
+    quint64          uiRateLimit;
+    TrafficCounts    tcTraffic;
+};
+
+using ProxyList=QVector<ProxyRecord>;
+
+using NetworkHit=struct {
+    LinkRecord        *lrLink;
+    ProxyRecord       *prProxy;
+    int               iProxy;
+    QNetworkProxy     npxProxy;
+    QUrl              urlLink;
+    bool              bTemplated;
+    LinkAssertionsPtr lapAssertions;
+    QString           sAgent;
+    uint              uiCooldown;
+    quint64           uiTraceId;
+    quint32           uiSeed;
+    uint              uiRetries;
+    QElapsedTimer     etmStarted;
+    TrafficCounts     tcTraffic;
+};
+
+using NetworkPolicy=struct {
+    uint uiConnectTimeout,
+         uiFirstByteTimeout,
+         uiTotalTimeout,
+         uiMaxRetries,
+         uiRetryBudget;
+    bool bRevalidate;
+    uint uiColdHits;
+    bool bResumeTls,
+         bRawEngine;
+    uint uiPipelineDepth;
+};
+
+using NetworkResult=struct {
+    NetworkHit                 nhtHit;
+    bool                       bCancelled,
+                               bFailed;
+    qint64                     iLatency;
+    quint64                    uiBytes;
+    QString                    sError;
+    ErrorCode                  ecError;
+    bool                       bNotModified;
+    quint64                    uiSavedBytes;
+    TlsSessionCache::Handshake hsHandshake;
+};
+
+Q_DECLARE_METATYPE(NetworkHit)
+Q_DECLARE_METATYPE(NetworkResult)
+
+class NetworkEngine;
+
+class BrowserWorker:public QThread {
+    Q_OBJECT
+public:
+    using RunMode=enum {
+        RM_WEB_ENGINE,
+        RM_NETWORK
+    };
+    BrowserWorker(QObject * =nullptr,LinkRecord * =nullptr,ProxyRecord * =nullptr,QString=QString(),CancelTokenPtr=CancelTokenPtr());
+    QString       getError();
+    ErrorCode     getErrorCode();
+    qint64        getLatency();
+    LinkRecord    *getLinkRecord();
+    ProxyRecord   *getProxyRecord();
+    quint64       getTraceId();
+    TrafficCounts getTraffic();
+    void          run() override;
+    void          setCompletion(QString,bool);
+    void          setCooldown(uint);
+    void          setMode(RunMode);
+    void          setProfile(QString);
+    void          setResources(bool,QString);
+    void          setTarget(QUrl,LinkAssertionsPtr);
+    void          setTraceId(quint64);
+signals:
+    void statusChanged(QString);
+private:
+    bool              bCancelled,
+                      bFailed,
+                      bContent,
+                      bResources;
+    uint              uiCooldown;
+    qint64            iLatency;
+    quint64           uiBytes,
+                      uiTraceId;
+    QString           sError,
+                      sAgent,
+                      sProfile,
+                      sCompletion,
+                      sHarPath;
+    QUrl              urlLink;
+    QElapsedTimer     etmSpawn;
+    LinkRecord        *lrLink;
+    ProxyRecord       *prProxy;
+    RunMode           rmMode;
+    CancelTokenPtr    ctpCancel;
+    LinkAssertionsPtr lapAssertions;
+    ErrorCode         ecError;
+    TrafficCounts     tcTraffic;
+    MemoryCharge      mchHelper;
+    void runWithWebEngine();
+};
+
+class ScenarioSession:public QObject {
+    Q_OBJECT
+public:
+    ScenarioSession(QObject * =nullptr,LinkStore * =nullptr,const ScenarioStepList * =nullptr,ProxyRecord * =nullptr,QString=QString());
+    ProxyRecord *getProxyRecord();
+    void        cancel();
+    void        start(uint);
+signals:
+    void finished();
+    void stepFinished(LinkRecord *,QString);
+private slots:
+    void replyEncrypted();
+    void replyFinished();
+    void sendStep();
+private:
+    bool                   bCancelled,
+                           bFinished,
+                           bTicketOffered,
+                           bEncrypted;
+    int                    iStep;
+    QString                sAgent;
+    LinkStore              *llSteps;
+    ProxyRecord            *prProxy;
+    const ScenarioStepList *sslSteps;
+    QElapsedTimer          etmStep;
+    QTimer                 tmrWait;
+    QNetworkAccessManager  namManager;
+    QNetworkReply          *nrpReply;
+    void finish();
+};
+
+class HitEngine:public QObject {
+    Q_OBJECT
+public:
+    HitEngine(QObject * =nullptr);
+    ~HitEngine();
+    bool             applyCheckpoint(const CheckpointData &,QString &);
+    CheckpointData   getCheckpoint();
+    LinkStore        &getLinks();
+    ProxyList        &getProxies();
+    ScenarioStepList getSteps();
+    bool             isRunning();
+    bool             reload(const LinkStore &,const ProxyList &,QStringList,QVector<int> &,QVector<int> &,QString &);
+    void             reset();
+    void             setAgents(QStringList);
+    void             setCachePath(QString);
+    void             setCheckpoint(QString,uint);
+    void             setCompletion(QString,bool);
+    void             setFingerprint(QByteArray);
+    void             setLinks(LinkStore);
+    void             setMaxCooldown(uint);
+    void             setMaxWorkers(uint);
+    void             setMemoryBudget(uint);
+    void             setMode(BrowserWorker::RunMode);
+    void             setNetworkPolicy(NetworkPolicy);
+    bool             setPlan(const RunPlan &,QString &);
+    void             setProfilePath(QString);
+    void             setProxies(ProxyList);
+    void             setResources(bool,uint,QString);
+    void             setSteps(ScenarioStepList);
+    void             start();
+    void             stop();
+    static LinkStore   getLinksFromSteps(ScenarioStepList);
+    static LinkStore   getLinksFromText(QString,QString &);
+    static ProxyList   getProxiesFromText(QString);
+    static QString     getTextFromLinks(const LinkStore &);
+    static QString     getTextFromProxies(ProxyList);
+    static QString     getTextFromProxy(const ProxyRecord &);
+    static QString     getTextFromUserAgents(QStringList);
+    static QStringList getUserAgentsFromText(QString);
+signals:
+    void checkpointWritten(QString);
+    void hitFinished(LinkRecord *,ProxyRecord *);
+    void hitStarted(LinkRecord *,ProxyRecord *);
+    void listsChanged();
+    void runFinished();
+    void statusChanged(LinkRecord *,ProxyRecord *,QString);
+protected:
+    // Picks a hit without scheduling it, so the selection loop can be timed alone.
+    bool getNextHit(LinkRecord *&,ProxyRecord *&,QString &,uint &);
+private slots:
+    void checkpointTimeout();
+    void memoryTimeout();
+    void networkHitFinished(NetworkResult);
+    void networkHitStarted(NetworkHit);
+    void sessionFinished();
+    void sessionStepFinished(LinkRecord *,QString);
+    void workerFinished();
+    void workerStarted();
+    void workerStatusChanged(QString);
+private:
+    bool                   bRunning,
+                           bFetchContent,
+                           bResources;
+    uint                   uiTotalWorkers,
+                           uiMaxWorkers,
+                           uiMaxCooldown,
+                           uiCheckpointInterval,
+                           uiHarSampling;
+    quint64                uiScheduledHits,
+                           uiElapsedBefore,
+                           uiResourceHits;
+    QString                sCheckpointPath,
+                           sCachePath,
+                           sProfilePath,
+                           sCompletion,
+                           sHarFolder;
+    QByteArray             bytCurrentFingerprint;
+    QElapsedTimer          etmCurrentRun;
+    QTimer                 tmrCheckpoint,
+                           tmrMemory;
+    std::mt19937           rngScheduler;
+    CancelTokenPtr         ctpCurrentRun;
+    RunPlan                rplCurrentPlan;
+    LinkStore              llCurrentLinks,
+                           llPendingLinks;
+    ProxyList              plCurrentProxies,
+                           plPendingProxies;
+    QStringList            slCurrentAgents;
+    ScenarioStepList       sslCurrentSteps;
+    QVector<int>           viActiveLinks,
+                           viActiveProxies;
+    BrowserWorker::RunMode rmMode;
+    NetworkPolicy          npcPolicy;
+    ValidatorCache         vchValidators;
+    LagProbe               lprProbe;
+    CheckpointWriter       *cwrCheckpoint;
+    NetworkEngine          *nenNetwork;
+    void        applyPending();
+    void        browse();
+    int         getRandom(int);
+    QString     getRandomAgent();
+    ProxyRecord *getRandomProxy();
+    bool        isPlanOver();
+    void        updateActive();
+    void        updateRates();
+};
+
+#endif // HITENGINE_H
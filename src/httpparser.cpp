@@ -0,0 +1,272 @@
+#include "httpparser.h"
+
+#include <cstring>
+
+// Longest status, header or chunk size line accepted, in bytes.
+#define MAX_LINE_SIZE 65536
+
+// Room kept for the lines, so most responses parse without allocating.
+#define LINE_RESERVE 1024
+
+// Incremental: bytes go in as they arrive, in slices of any size, and the ...
+// ... body comes back as spans of the caller's own buffer, never copied. ...
+// ... Only the status and the few headers the engine needs are kept.
+
+static bool isToken(const char *szData,int iSize,const char *szToken) {
+    int iToken=int(qstrlen(szToken));
+    return iSize==iToken&&!qstrnicmp(szData,szToken,uint(iToken));
+}
+
+static bool containsToken(const char *szData,int iSize,const char *szToken) {
+    int iToken=int(qstrlen(szToken));
+    for(int iK=0;iK+iToken<=iSize;iK++)
+        if(!qstrnicmp(szData+iK,szToken,uint(iToken)))
+            return true;
+    return false;
+}
+
+HttpParser::HttpParser() {
+    bytLine.reserve(LINE_RESERVE);
+    this->reset();
+}
+
+int HttpParser::feed(const char *szData,int iSize,const char *&szBody,int &iBody) {
+    int iUsed=0;
+    szBody=nullptr;
+    iBody=0;
+    while(iUsed<iSize&&ParserState::PS_DONE!=psState&&ParserState::PS_FAILED!=psState) {
+        const char *szCurrent=szData+iUsed;
+        int        iLeft=iSize-iUsed;
+        bStarted=true;
+        if(ParserState::PS_BODY==psState||ParserState::PS_CHUNK_DATA==psState) {
+            // One span per call, so the caller can stop the transfer in between.
+            iBody=iRemaining<0?iLeft:int(qMin<qint64>(iRemaining,iLeft));
+            szBody=szCurrent;
+            iUsed+=iBody;
+            if(iRemaining>=0) {
+                iRemaining-=iBody;
+                if(!iRemaining)
+                    psState=ParserState::PS_BODY==psState?ParserState::PS_DONE:ParserState::PS_CHUNK_END;
+            }
+            return iUsed;
+        }
+        else {
+            bool bComplete;
+            iUsed+=this->readLine(szCurrent,iLeft,bComplete);
+            if(!bComplete)
+                continue;
+            switch(psState) {
+                case ParserState::PS_STATUS:
+                    // A stray empty line between responses is tolerated.
+                    if(!bytLine.isEmpty())
+                        this->parseStatus();
+                    break;
+                case ParserState::PS_HEADERS:
+                    if(bytLine.isEmpty())
+                        this->beginBody();
+                    else
+                        this->parseHeader();
+                    break;
+                case ParserState::PS_CHUNK_SIZE:
+                    this->parseChunkSize();
+                    break;
+                case ParserState::PS_CHUNK_END:
+                    psState=bytLine.isEmpty()?ParserState::PS_CHUNK_SIZE:ParserState::PS_FAILED;
+                    break;
+                case ParserState::PS_TRAILERS:
+                    if(bytLine.isEmpty())
+                        psState=ParserState::PS_DONE;
+                    break;
+                default:
+                    break;
+            }
+            bytLine.resize(0);
+        }
+    }
+    return iUsed;
+}
+
+void HttpParser::finishOnClose() {
+    // Bodies with no length nor chunks end with the connection.
+    if(ParserState::PS_BODY==psState&&iRemaining<0)
+        psState=ParserState::PS_DONE;
+}
+
+QByteArray HttpParser::getETag() const {
+    return bytETag;
+}
+
+QByteArray HttpParser::getLastModified() const {
+    return bytLastModified;
+}
+
+uint HttpParser::getStatus() const {
+    return uiStatus;
+}
+
+bool HttpParser::hasFailed() const {
+    return ParserState::PS_FAILED==psState;
+}
+
+bool HttpParser::isComplete() const {
+    return ParserState::PS_DONE==psState;
+}
+
+bool HttpParser::isHeadComplete() const {
+    return bHeadComplete;
+}
+
+bool HttpParser::isKeepAlive() const {
+    return bKeepAlive;
+}
+
+bool HttpParser::isStarted() const {
+    return bStarted;
+}
+
+void HttpParser::reset() {
+    psState=ParserState::PS_STATUS;
+    bStarted=false;
+    bHeadComplete=false;
+    bKeepAlive=true;
+    bChunked=false;
+    uiStatus=0;
+    iContentLength=-1;
+    iRemaining=-1;
+    // Resized rather than cleared, so the room reserved is kept.
+    bytLine.resize(0);
+    bytETag.clear();
+    bytLastModified.clear();
+}
+
+void HttpParser::beginBody() {
+    // Interim responses (100 Continue and the like) are skipped whole.
+    if(uiStatus>=100&&uiStatus<200&&101!=uiStatus) {
+        bool bKeepAliveBefore=bKeepAlive;
+        this->reset();
+        bStarted=true;
+        bKeepAlive=bKeepAliveBefore;
+        return;
+    }
+    bHeadComplete=true;
+    if(101==uiStatus)
+        psState=ParserState::PS_FAILED;
+    else if(204==uiStatus||304==uiStatus)
+        psState=ParserState::PS_DONE;
+    else if(bChunked)
+        psState=ParserState::PS_CHUNK_SIZE;
+    else if(iContentLength>=0) {
+        iRemaining=iContentLength;
+        psState=iRemaining?ParserState::PS_BODY:ParserState::PS_DONE;
+    }
+    else {
+        // Delimited by the end of the connection, which can't be kept then.
+        bKeepAlive=false;
+        iRemaining=-1;
+        psState=ParserState::PS_BODY;
+    }
+}
+
+void HttpParser::parseChunkSize() {
+    const char *szLine=bytLine.constData();
+    qint64     iSize=0;
+    int        iDigits=0;
+    for(int iK=0;iK<bytLine.size();iK++) {
+        char chrDigit=szLine[iK];
+        int  iValue;
+        if(chrDigit>='0'&&chrDigit<='9')
+            iValue=chrDigit-'0';
+        else if(chrDigit>='a'&&chrDigit<='f')
+            iValue=chrDigit-'a'+10;
+        else if(chrDigit>='A'&&chrDigit<='F')
+            iValue=chrDigit-'A'+10;
+        // Extensions after the size are allowed, and ignored.
+        else
+            break;
+        // Sizes that big are a broken (or hostile) response, not a body.
+        if(++iDigits>15) {
+            psState=ParserState::PS_FAILED;
+            return;
+        }
+        iSize=iSize*16+iValue;
+    }
+    if(!iDigits)
+        psState=ParserState::PS_FAILED;
+    else if(iSize) {
+        iRemaining=iSize;
+        psState=ParserState::PS_CHUNK_DATA;
+    }
+    else
+        psState=ParserState::PS_TRAILERS;
+}
+
+void HttpParser::parseHeader() {
+    const char *szLine=bytLine.constData(),
+               *szColon=static_cast<const char *>(memchr(szLine,':',size_t(bytLine.size())));
+    const char *szValue,
+               *szEnd=szLine+bytLine.size();
+    int        iName,
+               iValue;
+    if(nullptr==szColon) {
+        psState=ParserState::PS_FAILED;
+        return;
+    }
+    iName=int(szColon-szLine);
+    szValue=szColon+1;
+    while(szValue<szEnd&&(' '==*szValue||'\t'==*szValue))
+        szValue++;
+    while(szEnd>szValue&&(' '==szEnd[-1]||'\t'==szEnd[-1]))
+        szEnd--;
+    iValue=int(szEnd-szValue);
+    // Only a handful of headers matter, so the rest cost a length check.
+    if(isToken(szLine,iName,"content-length")) {
+        bool bOk;
+        iContentLength=QByteArray::fromRawData(szValue,iValue).toLongLong(&bOk);
+        if(!bOk||iContentLength<0)
+            psState=ParserState::PS_FAILED;
+    }
+    else if(isToken(szLine,iName,"transfer-encoding"))
+        bChunked=containsToken(szValue,iValue,"chunked");
+    else if(isToken(szLine,iName,"connection")) {
+        if(containsToken(szValue,iValue,"close"))
+            bKeepAlive=false;
+        else if(containsToken(szValue,iValue,"keep-alive"))
+            bKeepAlive=true;
+    }
+    else if(isToken(szLine,iName,"etag"))
+        bytETag=QByteArray(szValue,iValue);
+    else if(isToken(szLine,iName,"last-modified"))
+        bytLastModified=QByteArray(szValue,iValue);
+}
+
+void HttpParser::parseStatus() {
+    const char *szLine=bytLine.constData();
+    // E.g. "HTTP/1.1 200 OK". The reason phrase is never looked at.
+    if(bytLine.size()<12||qstrncmp(szLine,"HTTP/1.",7)||' '!=szLine[8]||
+       szLine[9]<'1'||szLine[9]>'5'||szLine[10]<'0'||szLine[10]>'9'||szLine[11]<'0'||szLine[11]>'9') {
+        psState=ParserState::PS_FAILED;
+        return;
+    }
+    // HTTP/1.0 closes by default, unless told otherwise.
+    bKeepAlive='0'!=szLine[7];
+    uiStatus=uint((szLine[9]-'0')*100+(szLine[10]-'0')*10+szLine[11]-'0');
+    psState=ParserState::PS_HEADERS;
+}
+
+int HttpParser::readLine(const char *szData,int iSize,bool &bComplete) {
+    const char *szNewLine=static_cast<const char *>(memchr(szData,'\n',size_t(iSize)));
+    int        iTaken=nullptr!=szNewLine?int(szNewLine-szData)+1:iSize;
+    bComplete=false;
+    if(bytLine.size()+iTaken>MAX_LINE_SIZE) {
+        psState=ParserState::PS_FAILED;
+        return iTaken;
+    }
+    bytLine.append(szData,iTaken);
+    if(nullptr!=szNewLine) {
+        bComplete=true;
+        bytLine.chop(1);
+        if(bytLine.endsWith('\r'))
+            bytLine.chop(1);
+    }
+    return iTaken;
+}
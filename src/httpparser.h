@@ -0,0 +1,50 @@
+#ifndef HTTPPARSER_H
+#define HTTPPARSER_H
+
+#include <QtCore>
+
+class HttpParser {
+public:
+    HttpParser();
+    int        feed(const char *,int,const char *&,int &);
+    void       finishOnClose();
+    QByteArray getETag() const;
+    QByteArray getLastModified() const;
+    uint       getStatus() const;
+    bool       hasFailed() const;
+    bool       isComplete() const;
+    bool       isHeadComplete() const;
+    bool       isKeepAlive() const;
+    bool       isStarted() const;
+    void       reset();
+private:
+    using ParserState=enum {
+        PS_STATUS,
+        PS_HEADERS,
+        PS_BODY,
+        PS_CHUNK_SIZE,
+        PS_CHUNK_DATA,
+        PS_CHUNK_END,
+        PS_TRAILERS,
+        PS_DONE,
+        PS_FAILED
+    };
+    ParserState psState;
+    bool        bStarted,
+                bHeadComplete,
+                bKeepAlive,
+                bChunked;
+    uint        uiStatus;
+    qint64      iContentLength,
+                iRemaining;
+    QByteArray  bytLine,
+                bytETag,
+                bytLastModified;
+    void beginBody();
+    void parseChunkSize();
+    void parseHeader();
+    void parseStatus();
+    int  readLine(const char *,int,bool &);
+};
+
+#endif // HTTPPARSER_H
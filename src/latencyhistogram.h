@@ -0,0 +1,31 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QtCore>
+
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+    quint32 getBucketCount(int) const;
+    quint64 getCount() const;
+    quint32 getMax() const;
+    double  getMean() const;
+    quint32 getMin() const;
+    quint32 getPercentile(double) const;
+    quint32 getValueAtRank(quint64) const;
+    void    merge(const LatencyHistogram &);
+    void    record(quint32);
+    QJsonArray     toJson() const;
+    static LatencyHistogram fromJson(QJsonArray);
+    static int     getBucket(quint32);
+    static quint32 getBucketValue(int);
+    static int     getTotalBuckets();
+private:
+    quint64          uiCount,
+                     uiSum;
+    quint32          uiMin,
+                     uiMax;
+    QVector<quint32> vBuckets;
+};
+
+#endif // LATENCYHISTOGRAM_H
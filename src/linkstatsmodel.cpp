@@ -0,0 +1,158 @@
+#include "linkstatsmodel.h"
+
+#define COLOR_ACTIVE_LINK 0x99FFFF
+
+#define STATUS_RETIRED "Retired"
+
+#define LABELS_LINK_STATS { \
+    QStringLiteral("Link"), \
+    QStringLiteral("Status"), \
+    QStringLiteral("Hits"), \
+    QStringLiteral("Errors"), \
+    QStringLiteral("Failures"), \
+    QStringLiteral("Cancels"), \
+    QStringLiteral("Retries"), \
+    QStringLiteral("304s"), \
+    QStringLiteral("Avg. ms"), \
+    QStringLiteral("P95 ms"), \
+    QStringLiteral("Sent"), \
+    QStringLiteral("Received"), \
+    QStringLiteral("Errors by kind") \
+}
+
+// Rows are never materialized: every cell is read from the store when ...
+// ... the view paints it, so only the visible rows cost anything, however ...
+// ... many links there are. Statuses and highlights are kept only for the ...
+// ... links that have any.
+
+LinkStatsModel::LinkStatsModel(QObject *objParent,const LinkStore *llNewLinks):
+QAbstractTableModel(objParent) {
+    iRows=0;
+    llLinks=llNewLinks;
+    sslSteps.clear();
+    hshStatuses.clear();
+    setActiveRows.clear();
+}
+
+void LinkStatsModel::addRows() {
+    // Rows are only ever appended: a reload retires links, never drops them.
+    if(nullptr!=llLinks&&llLinks->count()>iRows) {
+        this->beginInsertRows(QModelIndex(),iRows,llLinks->count()-1);
+        iRows=llLinks->count();
+        this->endInsertRows();
+    }
+}
+
+int LinkStatsModel::columnCount(const QModelIndex &mdiParent) const {
+    return mdiParent.isValid()?0:LSTC_TOTAL;
+}
+
+QVariant LinkStatsModel::data(const QModelIndex &mdiIndex,int iRole) const {
+    int iIndex=mdiIndex.row();
+    // The store may be swapped for a new run before the rows are reset.
+    if(!mdiIndex.isValid()||nullptr==llLinks||iIndex>=llLinks->count())
+        return QVariant();
+    if(Qt::ItemDataRole::BackgroundRole==iRole)
+        return setActiveRows.contains(iIndex)?QVariant(QBrush(QColor(COLOR_ACTIVE_LINK))):QVariant();
+    if(Qt::ItemDataRole::TextAlignmentRole==iRole) {
+        if(LSTC_LINK==mdiIndex.column()||LSTC_STATUS==mdiIndex.column()||LSTC_ERROR_KINDS==mdiIndex.column())
+            return QVariant();
+        return int(Qt::AlignmentFlag::AlignRight|Qt::AlignmentFlag::AlignVCenter);
+    }
+    if(Qt::ItemDataRole::DisplayRole!=iRole)
+        return QVariant();
+    const LinkRecord &l=llLinks->at(iIndex);
+    switch(mdiIndex.column()) {
+        case LSTC_LINK:
+            return this->getLabel(iIndex);
+        case LSTC_STATUS:
+            // Retired links still report their last hits, but stay marked as such.
+            return l.bRetired?QStringLiteral(STATUS_RETIRED):hshStatuses.value(iIndex);
+        case LSTC_HITS:
+            return QString::number(l.uiHits);
+        case LSTC_ERRORS:
+            return QString::number(l.uiErrors);
+        case LSTC_FAILURES:
+            return QString::number(l.uiFailures);
+        case LSTC_CANCELS:
+            return QString::number(l.uiCancels);
+        case LSTC_RETRIES:
+            return QString::number(l.uiRetries);
+        case LSTC_REVALIDATIONS:
+            return QString::number(l.uiRevalidations);
+        case LSTC_AVG_TIME:
+        case LSTC_P95_TIME: {
+            LatencyHistogram lhLatency=llLinks->getLatency(iIndex);
+            if(!lhLatency.getCount())
+                return QString();
+            if(LSTC_AVG_TIME==mdiIndex.column())
+                return QString::number(lhLatency.getMean(),'f',0);
+            return QString::number(lhLatency.getPercentile(95.0));
+        }
+        case LSTC_SENT:
+            return Bandwidth::getTextFromBytes(llLinks->getTraffic(iIndex).uiSent);
+        case LSTC_RECEIVED:
+            return Bandwidth::getTextFromBytes(llLinks->getTraffic(iIndex).uiReceived);
+        case LSTC_ERROR_KINDS:
+            return ErrorTaxonomy::getTextFromCounts(llLinks->getErrors(iIndex));
+        default:
+            return QVariant();
+    }
+}
+
+QVariant LinkStatsModel::headerData(int iSection,Qt::Orientation ortOrientation,int iRole) const {
+    static const QStringList slLabels=LABELS_LINK_STATS;
+    if(Qt::Orientation::Horizontal==ortOrientation&&Qt::ItemDataRole::DisplayRole==iRole&&iSection<slLabels.count())
+        return slLabels.at(iSection);
+    return QAbstractTableModel::headerData(iSection,ortOrientation,iRole);
+}
+
+void LinkStatsModel::refresh() {
+    if(iRows)
+        emit dataChanged(this->index(0,0),this->index(iRows-1,LSTC_TOTAL-1));
+}
+
+void LinkStatsModel::reset(ScenarioStepList sslNewSteps) {
+    this->beginResetModel();
+    iRows=nullptr!=llLinks?llLinks->count():0;
+    sslSteps=sslNewSteps;
+    hshStatuses.clear();
+    setActiveRows.clear();
+    this->endResetModel();
+}
+
+int LinkStatsModel::rowCount(const QModelIndex &mdiParent) const {
+    return mdiParent.isValid()?0:iRows;
+}
+
+void LinkStatsModel::setActive(int iIndex,bool bActive) {
+    if(bActive)
+        setActiveRows.insert(iIndex);
+    else
+        setActiveRows.remove(iIndex);
+    this->updateRow(iIndex);
+}
+
+void LinkStatsModel::setStatus(int iIndex,QString sStatus) {
+    if(sStatus.isEmpty())
+        hshStatuses.remove(iIndex);
+    else
+        hshStatuses.insert(iIndex,sStatus);
+    if(iIndex<iRows)
+        emit dataChanged(this->index(iIndex,LSTC_STATUS),this->index(iIndex,LSTC_STATUS));
+}
+
+void LinkStatsModel::updateRow(int iIndex) {
+    if(iIndex<iRows)
+        emit dataChanged(this->index(iIndex,0),this->index(iIndex,LSTC_TOTAL-1));
+}
+
+QString LinkStatsModel::getLabel(int iIndex) const {
+    if(sslSteps.isEmpty())
+        return llLinks->getLabel(iIndex);
+    return QStringLiteral("%1: %2 %3").arg(
+        sslSteps.at(iIndex).sName,
+        QString(sslSteps.at(iIndex).bytMethod),
+        llLinks->getUrl(iIndex).url()
+    );
+}
@@ -0,0 +1,49 @@
+#ifndef LINKSTATSMODEL_H
+#define LINKSTATSMODEL_H
+
+#include <QtCore>
+#include <QtGui>
+#include "linkstore.h"
+#include "scenarioparser.h"
+
+enum LinkStatsTableColumns {
+    LSTC_LINK,
+    LSTC_STATUS,
+    LSTC_HITS,
+    LSTC_ERRORS,
+    LSTC_FAILURES,
+    LSTC_CANCELS,
+    LSTC_RETRIES,
+    LSTC_REVALIDATIONS,
+    LSTC_AVG_TIME,
+    LSTC_P95_TIME,
+    LSTC_SENT,
+    LSTC_RECEIVED,
+    LSTC_ERROR_KINDS,
+    LSTC_TOTAL
+};
+
+class LinkStatsModel:public QAbstractTableModel {
+    Q_OBJECT
+public:
+    LinkStatsModel(QObject * =nullptr,const LinkStore * =nullptr);
+    void     addRows();
+    int      columnCount(const QModelIndex & =QModelIndex()) const override;
+    QVariant data(const QModelIndex &,int=Qt::ItemDataRole::DisplayRole) const override;
+    QVariant headerData(int,Qt::Orientation,int=Qt::ItemDataRole::DisplayRole) const override;
+    void     refresh();
+    void     reset(ScenarioStepList);
+    int      rowCount(const QModelIndex & =QModelIndex()) const override;
+    void     setActive(int,bool);
+    void     setStatus(int,QString);
+    void     updateRow(int);
+private:
+    int                 iRows;
+    const LinkStore     *llLinks;
+    ScenarioStepList    sslSteps;
+    QHash<int,QString>  hshStatuses;
+    QSet<int>           setActiveRows;
+    QString getLabel(int) const;
+};
+
+#endif // LINKSTATSMODEL_H
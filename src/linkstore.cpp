@@ -0,0 +1,281 @@
+#include "linkstore.h"
+
+// Rough cost of a hash node (key, value pointer, bucket share), on top of ...
+// ... the value itself.
+#define HASH_ENTRY_OVERHEAD 32
+
+// Path offsets are 32 bits wide, which caps the arena.
+#define MAX_PATHS_SIZE Q_UINT64_C(0xFFFFFFFF)
+
+// Links are kept column by column. The counters the scheduler and the stats ...
+// ... scan all the time sit in one dense array, while the URLs are split in ...
+// ... interned schemes and hosts plus the rest, packed back to back in a ...
+// ... single arena. Errors are only counted by kind, never kept as text, and ...
+// ... like assertions and latencies, only for the links that have any. ...
+// ... Templates keep their placeholders, and only become URLs when picked.
+
+LinkStore::LinkStore() {
+    this->clear();
+}
+
+LinkRecord &LinkStore::operator[](int iIndex) {
+    return vlrRecords[iIndex];
+}
+
+bool LinkStore::append(const QUrl &urlLink,LinkAssertionsPtr lapAssertions,LinkTemplatePtr ltpTemplate) {
+    QByteArray bytLink=urlLink.toEncoded();
+    int        iScheme=bytLink.indexOf("://"),
+               iPath=-1;
+    LinkRecord lrLink;
+    if(iScheme>0) {
+        // The authority ends where the path, the query or the fragment begins.
+        for(int iK=iScheme+3;iK<bytLink.size()&&iPath<0;iK++)
+            if('/'==bytLink.at(iK)||'?'==bytLink.at(iK)||'#'==bytLink.at(iK))
+                iPath=iK;
+        if(iPath<0)
+            iPath=bytLink.size();
+    }
+    else
+        iPath=0; // Not expected from the parsers, but kept whole just in case.
+    // Checked before anything is added, so a full store is left as it was.
+    if(quint64(bytPaths.size())+quint64(bytLink.size()-iPath)>MAX_PATHS_SIZE)
+        return false;
+    lrLink.bBusy=false;
+    lrLink.bRetired=false;
+    lrLink.uiIndex=vlrRecords.count();
+    lrLink.uiHits=0;
+    lrLink.uiErrors=0;
+    lrLink.uiFailures=0;
+    lrLink.uiCancels=0;
+    lrLink.uiRetries=0;
+    lrLink.uiRevalidations=0;
+    if(iScheme>0) {
+        vuiSchemes.append(quint8(LinkStore::intern(hshSchemes,vbytSchemes,bytLink.left(iScheme))));
+        vuiHosts.append(LinkStore::intern(hshHosts,vbytHosts,bytLink.mid(iScheme+3,iPath-iScheme-3)));
+    }
+    else {
+        vuiSchemes.append(quint8(LinkStore::intern(hshSchemes,vbytSchemes,QByteArray())));
+        vuiHosts.append(LinkStore::intern(hshHosts,vbytHosts,QByteArray()));
+    }
+    bytPaths.append(bytLink.constData()+iPath,bytLink.size()-iPath);
+    vuiPaths.append(quint32(bytPaths.size()));
+    if(!lapAssertions.isNull())
+        hshAssertions.insert(lrLink.uiIndex,lapAssertions);
+    if(!ltpTemplate.isNull())
+        hshTemplates.insert(lrLink.uiIndex,ltpTemplate);
+    vlrRecords.append(lrLink);
+    return true;
+}
+
+const LinkRecord &LinkStore::at(int iIndex) const {
+    return vlrRecords.at(iIndex);
+}
+
+LinkRecord *LinkStore::begin() {
+    return vlrRecords.data();
+}
+
+const LinkRecord *LinkStore::begin() const {
+    return vlrRecords.constData();
+}
+
+bool LinkStore::canAppend(const LinkStore &llOther) const {
+    return quint64(bytPaths.size())+quint64(llOther.bytPaths.size())<=MAX_PATHS_SIZE;
+}
+
+int LinkStore::capacity() const {
+    // Records are appended in place up to here, without moving.
+    return vlrRecords.capacity();
+}
+
+void LinkStore::clear() {
+    vlrRecords.clear();
+    vuiSchemes.clear();
+    vuiHosts.clear();
+    // Offsets are kept as boundaries, so every link has a start and an end.
+    vuiPaths={0};
+    bytPaths.clear();
+    vbytSchemes.clear();
+    vbytHosts.clear();
+    hshSchemes.clear();
+    hshHosts.clear();
+    hshAssertions.clear();
+    hshErrors.clear();
+    hshLatencies.clear();
+    hshTraffic.clear();
+    hshTemplates.clear();
+}
+
+int LinkStore::count() const {
+    return vlrRecords.count();
+}
+
+LinkRecord *LinkStore::end() {
+    return vlrRecords.data()+vlrRecords.count();
+}
+
+const LinkRecord *LinkStore::end() const {
+    return vlrRecords.constData()+vlrRecords.count();
+}
+
+LinkAssertionsPtr LinkStore::getAssertions(int iIndex) const {
+    return hshAssertions.value(iIndex);
+}
+
+ErrorCounts LinkStore::getErrorTotals() const {
+    ErrorCounts ecsResult=ErrorCounts();
+    // Only the links with errors are visited, whatever the size of the list.
+    for(const auto &e:hshErrors)
+        for(int iK=0;iK<ErrorCode::EC_TOTAL;iK++)
+            ecsResult.uiCounts[iK]+=e.uiCounts[iK];
+    return ecsResult;
+}
+
+ErrorCounts LinkStore::getErrors(int iIndex) const {
+    return hshErrors.value(iIndex,ErrorCounts());
+}
+
+QString LinkStore::getLabel(int iIndex) const {
+    LinkTemplatePtr ltpTemplate=hshTemplates.value(iIndex);
+    // Templates go by their text, as all their URLs share the same stats.
+    if(!ltpTemplate.isNull())
+        return ltpTemplate->sText;
+    return this->getUrl(iIndex).toString();
+}
+
+LatencyHistogram LinkStore::getLatency(int iIndex) const {
+    return hshLatencies.value(iIndex);
+}
+
+quint64 LinkStore::getMemoryUsage() const {
+    quint64 uiResult=quint64(vlrRecords.capacity())*sizeof(LinkRecord)+
+                     quint64(vuiSchemes.capacity())*sizeof(quint8)+
+                     quint64(vuiHosts.capacity()+vuiPaths.capacity())*sizeof(quint32)+
+                     quint64(bytPaths.capacity());
+    // An estimate: the columns are counted as allocated, the sparse hashes ...
+    // ... by entry, the histograms with all their buckets.
+    for(const auto &b:vbytHosts)
+        uiResult+=quint64(b.capacity())+2*HASH_ENTRY_OVERHEAD;
+    uiResult+=quint64(hshAssertions.count()+hshTemplates.count())*HASH_ENTRY_OVERHEAD+
+              quint64(hshErrors.count())*(HASH_ENTRY_OVERHEAD+sizeof(ErrorCounts))+
+              quint64(hshTraffic.count())*(HASH_ENTRY_OVERHEAD+sizeof(TrafficCounts))+
+              quint64(hshLatencies.count())*(
+                  HASH_ENTRY_OVERHEAD+sizeof(LatencyHistogram)+LatencyHistogram::getTotalBuckets()*sizeof(quint32)
+              );
+    return uiResult;
+}
+
+LinkTemplatePtr LinkStore::getTemplate(int iIndex) const {
+    return hshTemplates.value(iIndex);
+}
+
+QString LinkStore::getText(int iIndex) const {
+    QString           sResult=this->getLabel(iIndex);
+    LinkAssertionsPtr lapAssertions=this->getAssertions(iIndex);
+    if(!lapAssertions.isNull())
+        sResult.append(QStringLiteral(" %1").arg(
+            AssertionParser::getTextFromAssertions(lapAssertions)
+        ));
+    return sResult;
+}
+
+TrafficCounts LinkStore::getTraffic(int iIndex) const {
+    return hshTraffic.value(iIndex,{0,0});
+}
+
+QUrl LinkStore::getUrl(int iIndex) const {
+    QByteArray       bytLink;
+    quint32          uiStart=vuiPaths.at(iIndex),
+                     uiEnd=vuiPaths.at(iIndex+1);
+    const QByteArray &bytScheme=vbytSchemes.at(vuiSchemes.at(iIndex));
+    // Templates are expanded anew every time, so each hit gets its own URL.
+    if(!hshTemplates.isEmpty()) {
+        LinkTemplatePtr ltpTemplate=hshTemplates.value(iIndex);
+        if(!ltpTemplate.isNull())
+            return UrlTemplate::expand(ltpTemplate);
+    }
+    // Only rebuilt when a hit is about to be sent, never stored this way.
+    if(!bytScheme.isEmpty()) {
+        bytLink.append(bytScheme);
+        bytLink.append("://");
+        bytLink.append(vbytHosts.at(vuiHosts.at(iIndex)));
+    }
+    bytLink.append(bytPaths.constData()+uiStart,uiEnd-uiStart);
+    return QUrl::fromEncoded(bytLink);
+}
+
+bool LinkStore::isEmpty() const {
+    return vlrRecords.isEmpty();
+}
+
+void LinkStore::recordError(int iIndex,ErrorCode ecCode) {
+    auto itErrors=hshErrors.find(iIndex);
+    if(hshErrors.end()==itErrors)
+        itErrors=hshErrors.insert(iIndex,ErrorCounts());
+    itErrors.value().uiCounts[ecCode]++;
+}
+
+void LinkStore::recordLatency(int iIndex,quint32 uiLatency) {
+    hshLatencies[iIndex].record(uiLatency);
+}
+
+void LinkStore::recordTraffic(int iIndex,const TrafficCounts &tcTraffic) {
+    TrafficCounts &tcTotal=hshTraffic[iIndex];
+    tcTotal.uiSent+=tcTraffic.uiSent;
+    tcTotal.uiReceived+=tcTraffic.uiReceived;
+}
+
+void LinkStore::reserve(int iTotal) {
+    vlrRecords.reserve(iTotal);
+    vuiSchemes.reserve(iTotal);
+    vuiHosts.reserve(iTotal);
+    vuiPaths.reserve(iTotal+1);
+}
+
+void LinkStore::setAssertions(int iIndex,LinkAssertionsPtr lapAssertions) {
+    if(lapAssertions.isNull())
+        hshAssertions.remove(iIndex);
+    else
+        hshAssertions.insert(iIndex,lapAssertions);
+}
+
+void LinkStore::setErrors(int iIndex,const ErrorCounts &ecsErrors) {
+    if(ErrorTaxonomy::isEmpty(ecsErrors))
+        hshErrors.remove(iIndex);
+    else
+        hshErrors.insert(iIndex,ecsErrors);
+}
+
+void LinkStore::setLatency(int iIndex,const LatencyHistogram &lhLatency) {
+    if(lhLatency.getCount())
+        hshLatencies.insert(iIndex,lhLatency);
+    else
+        hshLatencies.remove(iIndex);
+}
+
+void LinkStore::setTraffic(int iIndex,const TrafficCounts &tcTraffic) {
+    if(tcTraffic.uiSent||tcTraffic.uiReceived)
+        hshTraffic.insert(iIndex,tcTraffic);
+    else
+        hshTraffic.remove(iIndex);
+}
+
+void LinkStore::squeeze() {
+    // Drops the slack left by the growth of the columns while loading.
+    vlrRecords.squeeze();
+    vuiSchemes.squeeze();
+    vuiHosts.squeeze();
+    vuiPaths.squeeze();
+    bytPaths.squeeze();
+}
+
+quint32 LinkStore::intern(QHash<QByteArray,quint32> &hshIds,
+                          QVector<QByteArray>       &vbytValues,
+                          const QByteArray          &bytValue) {
+    auto itValue=hshIds.constFind(bytValue);
+    if(hshIds.constEnd()==itValue) {
+        itValue=hshIds.insert(bytValue,vbytValues.count());
+        vbytValues.append(bytValue);
+    }
+    return itValue.value();
+}
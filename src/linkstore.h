@@ -0,0 +1,80 @@
+#ifndef LINKSTORE_H
+#define LINKSTORE_H
+
+#include <QtCore>
+#include "assertionparser.h"
+#include "bandwidth.h"
+#include "errortaxonomy.h"
+#include "latencyhistogram.h"
+#include "urltemplate.h"
+
+using LinkRecord=struct {
+    bool bBusy,
+         bRetired;
+    uint uiIndex,
+         uiHits,
+         uiErrors,
+         uiFailures,
+         uiCancels,
+         uiRetries,
+         uiRevalidations;
+};
+
+class LinkStore {
+public:
+    LinkStore();
+    LinkStore(LinkStore &&)=default;
+    LinkStore         &operator=(LinkStore &&)=default;
+    LinkRecord        &operator[](int);
+    bool              append(const QUrl &,LinkAssertionsPtr=LinkAssertionsPtr(),LinkTemplatePtr=LinkTemplatePtr());
+    const LinkRecord  &at(int) const;
+    LinkRecord        *begin();
+    const LinkRecord  *begin() const;
+    bool              canAppend(const LinkStore &) const;
+    int               capacity() const;
+    void              clear();
+    int               count() const;
+    LinkRecord        *end();
+    const LinkRecord  *end() const;
+    LinkAssertionsPtr getAssertions(int) const;
+    ErrorCounts       getErrorTotals() const;
+    ErrorCounts       getErrors(int) const;
+    QString           getLabel(int) const;
+    LatencyHistogram  getLatency(int) const;
+    quint64           getMemoryUsage() const;
+    LinkTemplatePtr   getTemplate(int) const;
+    QString           getText(int) const;
+    TrafficCounts     getTraffic(int) const;
+    QUrl              getUrl(int) const;
+    bool              isEmpty() const;
+    void              recordError(int,ErrorCode);
+    void              recordLatency(int,quint32);
+    void              recordTraffic(int,const TrafficCounts &);
+    void              reserve(int);
+    void              setAssertions(int,LinkAssertionsPtr);
+    void              setErrors(int,const ErrorCounts &);
+    void              setLatency(int,const LatencyHistogram &);
+    void              setTraffic(int,const TrafficCounts &);
+    void              squeeze();
+private:
+    // A copy would share the records until written to, then detach, leaving ...
+    // ... the pointers handed out to hits on the old ones. Stores are moved.
+    Q_DISABLE_COPY(LinkStore)
+    QVector<LinkRecord>          vlrRecords;
+    QVector<quint8>              vuiSchemes;
+    QVector<quint32>             vuiHosts,
+                                 vuiPaths;
+    QByteArray                   bytPaths;
+    QVector<QByteArray>          vbytSchemes,
+                                 vbytHosts;
+    QHash<QByteArray,quint32>    hshSchemes,
+                                 hshHosts;
+    QHash<int,LinkAssertionsPtr> hshAssertions;
+    QHash<int,ErrorCounts>       hshErrors;
+    QHash<int,LatencyHistogram>  hshLatencies;
+    QHash<int,TrafficCounts>     hshTraffic;
+    QHash<int,LinkTemplatePtr>   hshTemplates;
+    static quint32 intern(QHash<QByteArray,quint32> &,QVector<QByteArray> &,const QByteArray &);
+};
+
+#endif // LINKSTORE_H
@@ -1,8 +1,160 @@
 #include "multibrowser.h"
+#include "agentserver.h"
+#include "baseline.h"
 
 #include <QApplication>
 
+int runAgent(int argc,char *argv[]) {
+    QCoreApplication   appAgent(argc,argv);
+    QCommandLineParser clpParser;
+    QString            sError;
+    quint16            uiPort;
+    QHostAddress       hadBind(QHostAddress::SpecialAddress::LocalHost);
+    AgentServer        agsServer;
+    MetricsServer      *msvMetrics=nullptr;
+    clpParser.setApplicationDescription(
+        QStringLiteral("Headless agent, driven by a coordinator over TCP.")
+    );
+    clpParser.addHelpOption();
+    clpParser.addOptions({
+        {
+            QStringLiteral("agent"),
+            QStringLiteral("Listens for a coordinator on <port>."),
+            QStringLiteral("port")
+        },
+        {
+            QStringLiteral("bind"),
+            QStringLiteral("Listens on <addr> only (localhost by default, 0.0.0.0 for any)."),
+            QStringLiteral("addr")
+        },
+        {
+            QStringLiteral("token"),
+            QStringLiteral("Only obeys coordinators that know <token> (or $%1).").arg(
+                QStringLiteral(AGENT_TOKEN_VARIABLE)
+            ),
+            QStringLiteral("token")
+        },
+        {
+            QStringLiteral("metrics"),
+            QStringLiteral("Serves Prometheus metrics on localhost:<port>."),
+            QStringLiteral("port")
+        }
+    });
+    clpParser.process(appAgent);
+    uiPort=clpParser.value(QStringLiteral("agent")).toUShort();
+    if(!uiPort) {
+        QTextStream(stderr) << QStringLiteral("A valid port is required") << Qt::endl;
+        return 1;
+    }
+    // Localhost unless asked otherwise: whoever reaches the port with the ...
+    // ... token can send traffic anywhere.
+    if(clpParser.isSet(QStringLiteral("bind"))&&!hadBind.setAddress(clpParser.value(QStringLiteral("bind")))) {
+        QTextStream(stderr) << QStringLiteral("A valid address is required") << Qt::endl;
+        return 1;
+    }
+    // The environment keeps the token out of the process list.
+    agsServer.setToken(
+        clpParser.isSet(QStringLiteral("token"))?clpParser.value(QStringLiteral("token")):
+                                                 qEnvironmentVariable(AGENT_TOKEN_VARIABLE)
+    );
+    if(!agsServer.listen(hadBind,uiPort,sError)) {
+        QTextStream(stderr) << QStringLiteral("Unable to listen: %1").arg(sError) << Qt::endl;
+        return 1;
+    }
+    if(clpParser.isSet(QStringLiteral("metrics"))) {
+        msvMetrics=new MetricsServer(&appAgent,clpParser.value(QStringLiteral("metrics")).toUShort());
+        msvMetrics->start(QThread::Priority::LowPriority);
+    }
+    QTextStream(stdout) << QStringLiteral("Agent listening on %1, port %2").arg(
+        hadBind.toString()
+    ).arg(
+        uiPort
+    ) << Qt::endl;
+    return appAgent.exec();
+}
+
+int runCompare(int argc,char *argv[]) {
+    QCoreApplication   appCompare(argc,argv);
+    QCommandLineParser clpParser;
+    QString            sError;
+    QStringList        slArguments;
+    BaselineData       bldBaseline,
+                       bldCurrent;
+    BaselineReport     brpReport;
+    bool               bAlpha=true,
+                       bThreshold=true;
+    double             dAlpha=0.01,
+                       dThreshold=5.0;
+    clpParser.setApplicationDescription(
+        QStringLiteral("Compares a run with a baseline. Exits with 2 on regressions.")
+    );
+    clpParser.addHelpOption();
+    clpParser.addPositionalArgument(
+        QStringLiteral("current"),
+        QStringLiteral("Baseline file saved at the end of the run to check.")
+    );
+    clpParser.addOptions({
+        {
+            QStringLiteral("compare"),
+            QStringLiteral("Baseline file to compare with."),
+            QStringLiteral("baseline")
+        },
+        {
+            QStringLiteral("report"),
+            QStringLiteral("Writes the report to <file> instead of the standard output."),
+            QStringLiteral("file")
+        },
+        {
+            QStringLiteral("alpha"),
+            QStringLiteral("Significance level of the shift test (default: 0.01)."),
+            QStringLiteral("alpha")
+        },
+        {
+            QStringLiteral("threshold"),
+            QStringLiteral("Smallest relative change reported, in percent (default: 5)."),
+            QStringLiteral("percent")
+        }
+    });
+    clpParser.process(appCompare);
+    slArguments=clpParser.positionalArguments();
+    if(clpParser.isSet(QStringLiteral("alpha")))
+        dAlpha=clpParser.value(QStringLiteral("alpha")).toDouble(&bAlpha);
+    if(clpParser.isSet(QStringLiteral("threshold")))
+        dThreshold=clpParser.value(QStringLiteral("threshold")).toDouble(&bThreshold);
+    if(1!=slArguments.count()||!bAlpha||dAlpha<=0.0||dAlpha>=1.0||!bThreshold||dThreshold<0.0) {
+        QTextStream(stderr) << QStringLiteral("A baseline, a current run and valid options are required") << Qt::endl;
+        return 1;
+    }
+    if(!Baseline::readFromFile(clpParser.value(QStringLiteral("compare")),bldBaseline,sError)||
+       !Baseline::readFromFile(slArguments.at(0),bldCurrent,sError)) {
+        QTextStream(stderr) << QStringLiteral("Unable to read: %1").arg(sError) << Qt::endl;
+        return 1;
+    }
+    brpReport=Baseline::compare(bldBaseline,bldCurrent,dAlpha,dThreshold/100.0);
+    if(clpParser.isSet(QStringLiteral("report"))) {
+        if(!Baseline::writeReportToFile(clpParser.value(QStringLiteral("report")),brpReport,sError)) {
+            QTextStream(stderr) << QStringLiteral("Unable to write: %1").arg(sError) << Qt::endl;
+            return 1;
+        }
+    }
+    else
+        QTextStream(stdout) << QJsonDocument(brpReport.jsoReport).toJson(QJsonDocument::JsonFormat::Indented);
+    QTextStream(stderr) << QStringLiteral("%1 regression(s), %2 improvement(s)").arg(
+        brpReport.uiRegressions
+    ).arg(
+        brpReport.uiImprovements
+    ) << Qt::endl;
+    // Meant for pipelines: anything but 0 fails the build.
+    return brpReport.uiRegressions?2:0;
+}
+
 int main(int argc,char *argv[]) {
+    // Agents and comparisons run headless, so they don't even need a GUI application.
+    for(int iK=1;iK<argc;iK++)
+        if(QByteArray(argv[iK]).startsWith("--agent"))
+            return runAgent(argc,argv);
+        else if(QByteArray(argv[iK]).startsWith("--compare"))
+            return runCompare(argc,argv);
     QApplication appMain(argc,argv);
     MultiBrowser mbMain;
     mbMain.show();
@@ -0,0 +1,208 @@
+#include "memorygovernor.h"
+
+#include <atomic>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+// Share of the budget (in %) past which each kind of backpressure kicks in: ...
+// ... cosmetic events go first, then bodies nobody asked for, then hits.
+#define PRESSURE_EVENTS 70
+#define PRESSURE_BODIES 80
+#define PRESSURE_HITS   90
+
+// What a browser helper is assumed to take before it can be measured, ...
+// ... and wherever its tree can't be measured at all.
+#define HELPER_MEMORY_ESTIMATE 157286400
+
+// The big consumers of the tool itself, kept as lock-free counters so the ...
+// ... workers, the network loops and the scheduler can all check them.
+
+static std::atomic<qint64>  iUsages[MemoryGovernor::Consumer::CS_TOTAL];
+static std::atomic<quint64> uiThrottles[MemoryGovernor::Throttle::TH_TOTAL],
+                            uiBudget{0};
+static std::atomic<uint>    uiLimit{0},
+                            uiMaxLimit{0};
+
+static quint64 getTotal() {
+    qint64 iResult=0;
+    for(const auto &i:iUsages)
+        iResult+=qMax<qint64>(0,i.load(std::memory_order_relaxed));
+    return quint64(iResult);
+}
+
+static uint getPressure() {
+    quint64 uiCurrentBudget=uiBudget.load(std::memory_order_relaxed);
+    return uiCurrentBudget?uint(qMin<quint64>(getTotal()*100/uiCurrentBudget,1000)):0;
+}
+
+static QString getTextFromSize(quint64 uiSize) {
+    return QLocale::c().formattedDataSize(qint64(uiSize));
+}
+
+void MemoryGovernor::adjust(Consumer csConsumer,qint64 iDelta) {
+    iUsages[csConsumer].fetch_add(iDelta,std::memory_order_relaxed);
+}
+
+void MemoryGovernor::beginRun() {
+    // Helpers and buffers are released by whoever charged them, so only ...
+    // ... the sampled consumers start over.
+    iUsages[Consumer::CS_STATS]=0;
+    iUsages[Consumer::CS_EVENTS]=0;
+    for(auto &u:uiThrottles)
+        u=0;
+    uiLimit=0;
+    uiMaxLimit=0;
+}
+
+quint64 MemoryGovernor::getBudget() {
+    return uiBudget.load(std::memory_order_relaxed);
+}
+
+quint64 MemoryGovernor::getHelperEstimate() {
+    return HELPER_MEMORY_ESTIMATE;
+}
+
+uint MemoryGovernor::getLimit(uint uiMaxWorkers) {
+    uint uiPressure=getPressure(),
+         uiResult=uiMaxWorkers;
+    // Past the threshold, concurrency shrinks along with the headroom left, ...
+    // ... down to a single hit at a time once the budget is all used. ...
+    // ... Helpers are charged as soon as they are scheduled, so those about ...
+    // ... to start already count here.
+    if(uiPressure>=100)
+        uiResult=qMin<uint>(1,uiMaxWorkers);
+    else if(uiPressure>PRESSURE_HITS)
+        uiResult=qMax<uint>(1,uiMaxWorkers*(100-uiPressure)/(100-PRESSURE_HITS));
+    uiLimit=uiResult;
+    uiMaxLimit=uiMaxWorkers;
+    return uiResult;
+}
+
+/**
+ * @brief Measures the resident memory of a process and all of its children.
+ *
+ * Chromium renders in child processes of its own, so the helper's tree is
+ * walked through /proc. Shared pages are counted once per process, which
+ * overestimates a little: the safe side for a budget. Elsewhere, a fixed
+ * estimate stands for every helper.
+ */
+quint64 MemoryGovernor::getProcessMemory(qint64 iPid) {
+#ifdef Q_OS_LINUX
+    quint64 uiResult=0;
+    QFile   fStatm(QStringLiteral("/proc/%1/statm").arg(iPid));
+    if(iPid<=0)
+        return 0;
+    // Resident pages are the second field.
+    if(fStatm.open(QFile::OpenModeFlag::ReadOnly)) {
+        QList<QByteArray> lbytFields=fStatm.readAll().split(' ');
+        if(lbytFields.count()>1)
+            uiResult=lbytFields.at(1).toULongLong()*quint64(sysconf(_SC_PAGESIZE));
+        fStatm.close();
+    }
+    for(const auto &t:QDir(QStringLiteral("/proc/%1/task").arg(iPid)).entryList(
+        QDir::Filter::Dirs|QDir::Filter::NoDotAndDotDot
+    )) {
+        QFile fChildren(QStringLiteral("/proc/%1/task/%2/children").arg(iPid).arg(t));
+        if(fChildren.open(QFile::OpenModeFlag::ReadOnly)) {
+            for(const auto &c:fChildren.readAll().simplified().split(' '))
+                uiResult+=MemoryGovernor::getProcessMemory(c.toLongLong());
+            fChildren.close();
+        }
+    }
+    return uiResult;
+#else
+    return iPid>0?HELPER_MEMORY_ESTIMATE:0;
+#endif
+}
+
+QString MemoryGovernor::getSummary() {
+    // A single line, for the headless output.
+    return QStringLiteral("Memory: %1, throttled: %2").arg(
+        MemoryGovernor::getUsageText(),
+        MemoryGovernor::getThrottleText()
+    );
+}
+
+QString MemoryGovernor::getThrottleText() {
+    QString sResult=QStringLiteral("%1 scheduler passes held back, %2 bodies dropped, %3 events coalesced").arg(
+        uiThrottles[Throttle::TH_HITS].load(std::memory_order_relaxed)
+    ).arg(
+        uiThrottles[Throttle::TH_BODIES].load(std::memory_order_relaxed)
+    ).arg(
+        uiThrottles[Throttle::TH_EVENTS].load(std::memory_order_relaxed)
+    );
+    uint uiCurrentLimit=uiLimit.load(std::memory_order_relaxed),
+         uiCurrentMaxLimit=uiMaxLimit.load(std::memory_order_relaxed);
+    if(uiCurrentLimit<uiCurrentMaxLimit)
+        sResult.append(QStringLiteral(", concurrency %1 of %2").arg(uiCurrentLimit).arg(uiCurrentMaxLimit));
+    return sResult;
+}
+
+quint64 MemoryGovernor::getUsage(Consumer csConsumer) {
+    return quint64(qMax<qint64>(0,iUsages[csConsumer].load(std::memory_order_relaxed)));
+}
+
+QString MemoryGovernor::getUsageText() {
+    quint64 uiCurrentBudget=uiBudget.load(std::memory_order_relaxed);
+    return QStringLiteral("%1 of %2 (helpers %3, buffers %4, stats %5, events %6)").arg(
+        getTextFromSize(getTotal()),
+        uiCurrentBudget?getTextFromSize(uiCurrentBudget):QStringLiteral("no budget"),
+        getTextFromSize(MemoryGovernor::getUsage(Consumer::CS_HELPERS)),
+        getTextFromSize(MemoryGovernor::getUsage(Consumer::CS_BUFFERS)),
+        getTextFromSize(MemoryGovernor::getUsage(Consumer::CS_STATS)),
+        getTextFromSize(MemoryGovernor::getUsage(Consumer::CS_EVENTS))
+    );
+}
+
+bool MemoryGovernor::isCoalescing() {
+    return getPressure()>=PRESSURE_EVENTS;
+}
+
+bool MemoryGovernor::isDroppingBodies() {
+    return getPressure()>=PRESSURE_BODIES;
+}
+
+void MemoryGovernor::setBudget(quint64 uiBytes) {
+    uiBudget=uiBytes;
+}
+
+void MemoryGovernor::setUsage(Consumer csConsumer,quint64 uiBytes) {
+    iUsages[csConsumer]=qint64(uiBytes);
+}
+
+void MemoryGovernor::throttled(Throttle thThrottle) {
+    uiThrottles[thThrottle].fetch_add(1,std::memory_order_relaxed);
+}
+
+MemoryCharge::MemoryCharge(MemoryGovernor::Consumer csConsumer) {
+    this->csConsumer=csConsumer;
+    uiBytes=0;
+}
+
+MemoryCharge::MemoryCharge(const MemoryCharge &mchOther) {
+    csConsumer=mchOther.csConsumer;
+    uiBytes=0;
+    this->set(mchOther.uiBytes);
+}
+
+MemoryCharge::~MemoryCharge() {
+    this->set(0);
+}
+
+MemoryCharge &MemoryCharge::operator=(const MemoryCharge &mchOther) {
+    if(this!=&mchOther) {
+        this->set(0);
+        csConsumer=mchOther.csConsumer;
+        this->set(mchOther.uiBytes);
+    }
+    return *this;
+}
+
+void MemoryCharge::set(quint64 uiBytes) {
+    // Only the difference goes to the governor, so a charge can follow a ...
+    // ... growing buffer or a sampled process without piling up.
+    MemoryGovernor::adjust(csConsumer,qint64(uiBytes)-qint64(this->uiBytes));
+    this->uiBytes=uiBytes;
+}
@@ -0,0 +1,50 @@
+#ifndef MEMORYGOVERNOR_H
+#define MEMORYGOVERNOR_H
+
+#include <QtCore>
+
+class MemoryGovernor {
+public:
+    using Consumer=enum {
+        CS_HELPERS,
+        CS_BUFFERS,
+        CS_STATS,
+        CS_EVENTS,
+        CS_TOTAL
+    };
+    using Throttle=enum {
+        TH_HITS,
+        TH_BODIES,
+        TH_EVENTS,
+        TH_TOTAL
+    };
+    static void    adjust(Consumer,qint64);
+    static void    beginRun();
+    static quint64 getBudget();
+    static quint64 getHelperEstimate();
+    static uint    getLimit(uint);
+    static quint64 getProcessMemory(qint64);
+    static QString getSummary();
+    static QString getThrottleText();
+    static quint64 getUsage(Consumer);
+    static QString getUsageText();
+    static bool    isCoalescing();
+    static bool    isDroppingBodies();
+    static void    setBudget(quint64);
+    static void    setUsage(Consumer,quint64);
+    static void    throttled(Throttle);
+};
+
+class MemoryCharge {
+public:
+    MemoryCharge(MemoryGovernor::Consumer=MemoryGovernor::Consumer::CS_BUFFERS);
+    MemoryCharge(const MemoryCharge &);
+    ~MemoryCharge();
+    MemoryCharge &operator=(const MemoryCharge &);
+    void set(quint64);
+private:
+    MemoryGovernor::Consumer csConsumer;
+    quint64                  uiBytes;
+};
+
+#endif // MEMORYGOVERNOR_H
@@ -0,0 +1,264 @@
+#include "metrics.h"
+#include "errortaxonomy.h"
+#include "tlssessioncache.h"
+
+#include <atomic>
+#include <memory>
+
+#define METRICS_PREFIX "multibrowser_"
+
+// Upper bounds (in ms) of the exported hit duration histogram buckets.
+#define DURATION_BOUNDS {5,10,25,50,100,250,500,1000,2500,5000,10000,30000,60000}
+
+using ProxyCounters=struct {
+    std::atomic<quint64> uiHits,
+                         uiErrors,
+                         uiCancels;
+};
+
+// Everything that only makes sense for the current run lives here. A new ...
+// ... run swaps the whole thing atomically, so readers never need a lock. ...
+// ... Counters are shared one by one, so a run grown by a reload keeps ...
+// ... counting into the same ones.
+using RunMetrics=struct {
+    QStringList                             slProxies;
+    QVector<std::shared_ptr<ProxyCounters>> vpcProxies;
+};
+
+static const quint32 uiDurationBounds[]=DURATION_BOUNDS;
+static const int     iTotalDurationBounds=sizeof(uiDurationBounds)/sizeof(quint32);
+
+static std::atomic<quint64>        uiHits{0},
+                                   uiErrors{0},
+                                   uiFailures{0},
+                                   uiCancels{0},
+                                   uiRetries{0},
+                                   uiRevalidations{0},
+                                   uiReceivedBytes{0},
+                                   uiSavedBytes{0},
+                                   uiDurationSum{0},
+                                   uiDurationBuckets[iTotalDurationBounds+1],
+                                   uiRevalidationSum{0},
+                                   uiRevalidationBuckets[iTotalDurationBounds+1],
+                                   uiWarmLoadSum{0},
+                                   uiWarmLoadBuckets[iTotalDurationBounds+1],
+                                   uiColdLoadSum{0},
+                                   uiColdLoadBuckets[iTotalDurationBounds+1];
+static std::atomic<qint64>         iInFlight{0},
+                                   iQueued{0};
+static std::shared_ptr<RunMetrics> rmCurrentRun;
+
+static QByteArray escapeLabel(QString sLabel) {
+    return sLabel.replace(QStringLiteral("\\"),QStringLiteral("\\\\"))
+                 .replace(QStringLiteral("\""),QStringLiteral("\\\""))
+                 .replace(QStringLiteral("\n"),QStringLiteral("\\n"))
+                 .toUtf8();
+}
+
+static void writeHeader(QByteArray &bytOutput,const char *szName,const char *szType,const char *szHelp) {
+    bytOutput.append("# HELP " METRICS_PREFIX).append(szName).append(' ').append(szHelp).append('\n');
+    bytOutput.append("# TYPE " METRICS_PREFIX).append(szName).append(' ').append(szType).append('\n');
+}
+
+static void writeValue(QByteArray &bytOutput,const char *szName,QByteArray bytLabels,quint64 uiValue) {
+    bytOutput.append(METRICS_PREFIX).append(szName);
+    if(!bytLabels.isEmpty())
+        bytOutput.append('{').append(bytLabels).append('}');
+    bytOutput.append(' ').append(QByteArray::number(uiValue)).append('\n');
+}
+
+static void recordDuration(std::atomic<quint64> *uiBuckets,std::atomic<quint64> &uiSum,qint64 iLatency) {
+    int iBucket=0;
+    while(iBucket<iTotalDurationBounds&&uiDurationBounds[iBucket]<iLatency)
+        iBucket++;
+    uiBuckets[iBucket].fetch_add(1,std::memory_order_relaxed);
+    uiSum.fetch_add(iLatency,std::memory_order_relaxed);
+}
+
+static void writeHistogram(QByteArray           &bytOutput,
+                           const char           *szName,
+                           QByteArray           bytLabels,
+                           std::atomic<quint64> *uiBuckets,
+                           std::atomic<quint64> &uiSum) {
+    QByteArray bytName(szName),
+               bytPrefix=bytLabels.isEmpty()?QByteArray():bytLabels+',';
+    quint64    uiCumulative=0;
+    // The header is left to the caller, since a labelled family has many series.
+    for(int iK=0;iK<=iTotalDurationBounds;iK++) {
+        uiCumulative+=uiBuckets[iK].load(std::memory_order_relaxed);
+        writeValue(
+            bytOutput,
+            QByteArray(bytName+"_bucket").constData(),
+            iK<iTotalDurationBounds?
+                bytPrefix+"le=\""+QByteArray::number(uiDurationBounds[iK]/1000.0)+'"':
+                bytPrefix+"le=\"+Inf\"",
+            uiCumulative
+        );
+    }
+    bytOutput.append(METRICS_PREFIX).append(bytName).append("_sum");
+    if(!bytLabels.isEmpty())
+        bytOutput.append('{').append(bytLabels).append('}');
+    bytOutput.append(' ').append(QByteArray::number(uiSum.load(std::memory_order_relaxed)/1000.0)).append('\n');
+    writeValue(bytOutput,QByteArray(bytName+"_count").constData(),bytLabels,uiCumulative);
+}
+
+void Metrics::addProxies(QStringList slProxies) {
+    std::shared_ptr<RunMetrics> rmRun=std::atomic_load(&rmCurrentRun),
+                                rmNewRun=std::make_shared<RunMetrics>();
+    // Proxies reloaded into a live run take the next indexes, so they go ...
+    // ... after the others. Only the engine's thread ever swaps the run.
+    if(nullptr!=rmRun)
+        *rmNewRun=*rmRun;
+    rmNewRun->slProxies.append(slProxies);
+    for(int iK=0;iK<slProxies.count();iK++)
+        rmNewRun->vpcProxies.append(std::make_shared<ProxyCounters>());
+    std::atomic_store(&rmCurrentRun,rmNewRun);
+}
+
+void Metrics::beginRun(QStringList slProxies) {
+    std::shared_ptr<RunMetrics> rmNewRun=std::make_shared<RunMetrics>();
+    rmNewRun->slProxies=slProxies;
+    for(int iK=0;iK<slProxies.count();iK++)
+        rmNewRun->vpcProxies.append(std::make_shared<ProxyCounters>());
+    std::atomic_store(&rmCurrentRun,rmNewRun);
+    iInFlight=0;
+    iQueued=0;
+}
+
+void Metrics::bytesSaved(quint64 uiBytes) {
+    uiSavedBytes.fetch_add(uiBytes,std::memory_order_relaxed);
+}
+
+QByteArray Metrics::getExposition() {
+    QByteArray                  bytResult;
+    std::shared_ptr<RunMetrics> rmRun=std::atomic_load(&rmCurrentRun);
+    // Only relaxed atomic reads from here on: scraping never blocks a hit.
+    writeHeader(bytResult,"hits_total","counter","Successful hits.");
+    writeValue(bytResult,"hits_total",QByteArray(),uiHits.load(std::memory_order_relaxed));
+    writeHeader(bytResult,"errors_total","counter","Failed hits.");
+    writeValue(bytResult,"errors_total",QByteArray(),uiErrors.load(std::memory_order_relaxed));
+    writeHeader(bytResult,"errors_by_kind_total","counter","Failed hits and assertion failures, by kind.");
+    for(int iK=0;iK<ErrorCode::EC_TOTAL;iK++)
+        writeValue(
+            bytResult,
+            "errors_by_kind_total",
+            QByteArrayLiteral("kind=\"")+ErrorTaxonomy::getName(ErrorCode(iK)).toUtf8()+'"',
+            ErrorTaxonomy::getCount(ErrorCode(iK))
+        );
+    writeHeader(bytResult,"assertion_failures_total","counter","Hits whose response failed its assertions.");
+    writeValue(bytResult,"assertion_failures_total",QByteArray(),uiFailures.load(std::memory_order_relaxed));
+    writeHeader(bytResult,"cancels_total","counter","Hits interrupted by a stop.");
+    writeValue(bytResult,"cancels_total",QByteArray(),uiCancels.load(std::memory_order_relaxed));
+    writeHeader(bytResult,"retries_total","counter","Failed attempts sent again, on top of the hits themselves.");
+    writeValue(bytResult,"retries_total",QByteArray(),uiRetries.load(std::memory_order_relaxed));
+    writeHeader(bytResult,"revalidations_total","counter","Successful hits answered with a 304, counted in the hits too.");
+    writeValue(bytResult,"revalidations_total",QByteArray(),uiRevalidations.load(std::memory_order_relaxed));
+    writeHeader(bytResult,"received_bytes_total","counter","Response bytes received.");
+    writeValue(bytResult,"received_bytes_total",QByteArray(),uiReceivedBytes.load(std::memory_order_relaxed));
+    writeHeader(bytResult,"saved_bytes_total","counter","Response bytes spared by the revalidations.");
+    writeValue(bytResult,"saved_bytes_total",QByteArray(),uiSavedBytes.load(std::memory_order_relaxed));
+    writeHeader(bytResult,"tls_handshakes_total","counter","TLS handshakes of new connections, full or offering a ticket from the shared cache.");
+    for(auto h:{TlsSessionCache::Handshake::HS_FULL,TlsSessionCache::Handshake::HS_TICKET_OFFERED})
+        writeValue(
+            bytResult,
+            "tls_handshakes_total",
+            QByteArrayLiteral("kind=\"")+TlsSessionCache::getName(h).toUtf8()+'"',
+            TlsSessionCache::getCount(h)
+        );
+    writeHeader(bytResult,"inflight_hits","gauge","Hits currently waiting for a response.");
+    writeValue(bytResult,"inflight_hits",QByteArray(),qMax<qint64>(0,iInFlight.load(std::memory_order_relaxed)));
+    writeHeader(bytResult,"queued_hits","gauge","Scheduled hits still in their cooldown.");
+    writeValue(bytResult,"queued_hits",QByteArray(),qMax<qint64>(0,iQueued.load(std::memory_order_relaxed)));
+    writeHeader(bytResult,"hit_duration_seconds","histogram","Duration of the successful hits that got a full response.");
+    writeHistogram(bytResult,"hit_duration_seconds",QByteArray(),uiDurationBuckets,uiDurationSum);
+    writeHeader(bytResult,"revalidation_duration_seconds","histogram","Duration of the successful hits answered with a 304.");
+    writeHistogram(bytResult,"revalidation_duration_seconds",QByteArray(),uiRevalidationBuckets,uiRevalidationSum);
+    writeHeader(bytResult,"page_load_duration_seconds","histogram","Duration of the successful browser hits, by profile.");
+    writeHistogram(bytResult,"page_load_duration_seconds",QByteArrayLiteral("profile=\"warm\""),uiWarmLoadBuckets,uiWarmLoadSum);
+    writeHistogram(bytResult,"page_load_duration_seconds",QByteArrayLiteral("profile=\"cold\""),uiColdLoadBuckets,uiColdLoadSum);
+    if(nullptr!=rmRun) {
+        writeHeader(bytResult,"proxy_hits_total","counter","Successful hits per proxy.");
+        for(int iK=0;iK<rmRun->slProxies.count();iK++)
+            writeValue(
+                bytResult,
+                "proxy_hits_total",
+                QByteArrayLiteral("proxy=\"")+escapeLabel(rmRun->slProxies.at(iK))+'"',
+                rmRun->vpcProxies.at(iK)->uiHits.load(std::memory_order_relaxed)
+            );
+        writeHeader(bytResult,"proxy_errors_total","counter","Failed hits per proxy.");
+        for(int iK=0;iK<rmRun->slProxies.count();iK++)
+            writeValue(
+                bytResult,
+                "proxy_errors_total",
+                QByteArrayLiteral("proxy=\"")+escapeLabel(rmRun->slProxies.at(iK))+'"',
+                rmRun->vpcProxies.at(iK)->uiErrors.load(std::memory_order_relaxed)
+            );
+        writeHeader(bytResult,"proxy_cancels_total","counter","Cancelled hits per proxy.");
+        for(int iK=0;iK<rmRun->slProxies.count();iK++)
+            writeValue(
+                bytResult,
+                "proxy_cancels_total",
+                QByteArrayLiteral("proxy=\"")+escapeLabel(rmRun->slProxies.at(iK))+'"',
+                rmRun->vpcProxies.at(iK)->uiCancels.load(std::memory_order_relaxed)
+            );
+    }
+    return bytResult;
+}
+
+void Metrics::hitFinished(HitResult hrResult,int iProxy,quint64 uiBytes,qint64 iLatency) {
+    std::shared_ptr<RunMetrics> rmRun=std::atomic_load(&rmCurrentRun);
+    ProxyCounters               *pcProxy=nullptr;
+    iInFlight.fetch_sub(1,std::memory_order_relaxed);
+    uiReceivedBytes.fetch_add(uiBytes,std::memory_order_relaxed);
+    if(nullptr!=rmRun&&iProxy>=0&&iProxy<rmRun->slProxies.count())
+        pcProxy=rmRun->vpcProxies.at(iProxy).get();
+    if(HitResult::HR_HIT==hrResult||HitResult::HR_REVALIDATED==hrResult) {
+        uiHits.fetch_add(1,std::memory_order_relaxed);
+        if(nullptr!=pcProxy)
+            pcProxy->uiHits.fetch_add(1,std::memory_order_relaxed);
+        // A 304 is way cheaper than a full response, so they're kept apart.
+        if(HitResult::HR_REVALIDATED==hrResult) {
+            uiRevalidations.fetch_add(1,std::memory_order_relaxed);
+            if(iLatency>=0)
+                recordDuration(uiRevalidationBuckets,uiRevalidationSum,iLatency);
+        }
+        else if(iLatency>=0)
+            recordDuration(uiDurationBuckets,uiDurationSum,iLatency);
+    }
+    else if(HitResult::HR_FAILURE==hrResult) {
+        // The proxy did deliver the response, so it's a hit as far as it goes.
+        uiFailures.fetch_add(1,std::memory_order_relaxed);
+        if(nullptr!=pcProxy)
+            pcProxy->uiHits.fetch_add(1,std::memory_order_relaxed);
+    }
+    else if(HitResult::HR_ERROR==hrResult) {
+        uiErrors.fetch_add(1,std::memory_order_relaxed);
+        if(nullptr!=pcProxy)
+            pcProxy->uiErrors.fetch_add(1,std::memory_order_relaxed);
+    }
+    else if(HitResult::HR_RETRY==hrResult)
+        // Only the final attempt decides what the hit counts as.
+        uiRetries.fetch_add(1,std::memory_order_relaxed);
+    else {
+        uiCancels.fetch_add(1,std::memory_order_relaxed);
+        if(nullptr!=pcProxy)
+            pcProxy->uiCancels.fetch_add(1,std::memory_order_relaxed);
+    }
+}
+
+void Metrics::pageLoaded(bool bWarm,qint64 iLatency) {
+    // Same hits as in the duration histogram, just split by browser profile.
+    if(bWarm)
+        recordDuration(uiWarmLoadBuckets,uiWarmLoadSum,iLatency);
+    else
+        recordDuration(uiColdLoadBuckets,uiColdLoadSum,iLatency);
+}
+
+void Metrics::hitScheduled() {
+    iQueued.fetch_add(1,std::memory_order_relaxed);
+}
+
+void Metrics::hitStarted() {
+    iQueued.fetch_sub(1,std::memory_order_relaxed);
+    iInFlight.fetch_add(1,std::memory_order_relaxed);
+}
@@ -0,0 +1,26 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QtCore>
+
+class Metrics {
+public:
+    using HitResult=enum {
+        HR_HIT,
+        HR_ERROR,
+        HR_FAILURE,
+        HR_CANCEL,
+        HR_RETRY,
+        HR_REVALIDATED
+    };
+    static void       addProxies(QStringList);
+    static void       beginRun(QStringList);
+    static void       bytesSaved(quint64);
+    static QByteArray getExposition();
+    static void       hitFinished(HitResult,int,quint64,qint64);
+    static void       hitScheduled();
+    static void       hitStarted();
+    static void       pageLoaded(bool,qint64);
+};
+
+#endif // METRICS_H
@@ -0,0 +1,72 @@
+#include "metricsserver.h"
+#include "metrics.h"
+
+#define MAX_REQUEST_SIZE 8192
+
+MetricsServer::MetricsServer(QObject *objParent,quint16 uiNewPort):
+QThread(objParent) {
+    uiPort=uiNewPort;
+}
+
+MetricsServer::~MetricsServer() {
+    this->quit();
+    this->wait();
+}
+
+void MetricsServer::run() {
+    QTcpServer tcsServer;
+    // Serves from a thread (and an event loop) of its own, so a slow ...
+    // ... scraper never competes with the GUI or the workers.
+    if(!tcsServer.listen(QHostAddress::SpecialAddress::LocalHost,uiPort)) {
+        emit listenFailed(tcsServer.errorString());
+        return;
+    }
+    connect(
+        &tcsServer,
+        &QTcpServer::newConnection,
+        [&tcsServer]() {
+            while(tcsServer.hasPendingConnections()) {
+                QTcpSocket *tcpClient=tcsServer.nextPendingConnection();
+                connect(
+                    tcpClient,
+                    &QTcpSocket::disconnected,
+                    tcpClient,
+                    &QTcpSocket::deleteLater
+                );
+                connect(
+                    tcpClient,
+                    &QTcpSocket::readyRead,
+                    [tcpClient]() {
+                        QByteArray bytRequest,
+                                   bytBody,
+                                   bytResponse;
+                        // Waits for the whole request head (only GETs are expected).
+                        if(!tcpClient->peek(MAX_REQUEST_SIZE).contains("\r\n\r\n")) {
+                            if(tcpClient->bytesAvailable()>=MAX_REQUEST_SIZE)
+                                tcpClient->abort();
+                            return;
+                        }
+                        bytRequest=tcpClient->readAll();
+                        if(bytRequest.startsWith("GET /metrics ")||bytRequest.startsWith("GET / ")) {
+                            bytBody=Metrics::getExposition();
+                            bytResponse="HTTP/1.1 200 OK\r\n"
+                                        "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
+                        }
+                        else {
+                            bytBody="Not found\n";
+                            bytResponse="HTTP/1.1 404 Not Found\r\n"
+                                        "Content-Type: text/plain\r\n";
+                        }
+                        bytResponse.append("Content-Length: ");
+                        bytResponse.append(QByteArray::number(bytBody.size()));
+                        bytResponse.append("\r\nConnection: close\r\n\r\n");
+                        bytResponse.append(bytBody);
+                        tcpClient->write(bytResponse);
+                        tcpClient->disconnectFromHost();
+                    }
+                );
+            }
+        }
+    );
+    this->exec();
+}
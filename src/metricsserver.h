@@ -0,0 +1,19 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QtCore>
+#include <QtNetwork>
+
+class MetricsServer:public QThread {
+    Q_OBJECT
+public:
+    MetricsServer(QObject * =nullptr,quint16=0);
+    ~MetricsServer();
+    void run() override;
+signals:
+    void listenFailed(QString);
+private:
+    quint16 uiPort;
+};
+
+#endif // METRICSSERVER_H
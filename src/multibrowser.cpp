@@ -1,77 +1,170 @@
 #include "multibrowser.h"
 
-#define APP_BROWSER_EXE  "Browser.exe"
+#define FILTER_TXT_FILES        "Text files (*.txt)"
+#define FILTER_JSON_FILES       "Scenario files (*.json)"
+#define FILTER_CHECKPOINT_FILES "Checkpoints (*.mbc)"
+#define FILTER_PLAN_FILES       "Run plans (*.mbp)"
+#define FILTER_TRACE_FILES      "Chrome traces (*.json)"
+#define FILTER_BASELINE_FILES   "Baselines (*.mbb)"
+#define FILTER_REPORT_FILES     "Reports (*.json)"
 
-#define FILTER_TXT_FILES "Text files (*.txt)"
+#define MAX_THREADS   16
+#define MAX_IN_FLIGHT 1000
+#define MAX_COOLDOWN  60
 
-#define MAX_THREADS  16
-#define MAX_COOLDOWN 60
+// In MB.
+#define MAX_MEMORY_BUDGET  262144
+#define MEMORY_BUDGET_STEP 256
 
-#define LABELS_LINK_STATS { \
-    QStringLiteral("Link"), \
-    QStringLiteral("Status"), \
-    QStringLiteral("Hits"), \
-    QStringLiteral("Errors"), \
-    QStringLiteral("Last error") \
-}
+#define DEFAULT_METRICS_PORT 9464
+
+#define MAX_TRACE_SAMPLING     10000
+#define DEFAULT_TRACE_SAMPLING 100
+
+#define MIN_CHECKPOINT_INTERVAL     5
+#define MAX_CHECKPOINT_INTERVAL     3600
+#define DEFAULT_CHECKPOINT_INTERVAL 60
+
+#define MAX_TIMEOUT          600000
+#define MAX_RETRIES          10
+#define DEFAULT_RETRY_BUDGET 10
+#define DEFAULT_COLD_HITS    20
+
+#define MAX_PIPELINE_DEPTH     16
+#define DEFAULT_PIPELINE_DEPTH 1
+
+#define MAX_COMPLETION_TIME     60000
+#define DEFAULT_COMPLETION_TIME 500
+
+#define MAX_HAR_SAMPLING     10000
+#define DEFAULT_HAR_SAMPLING 100
+
+#define TOP_RESOURCES 20
+
+#define MAX_PLAN_HITS     1000000
+#define DEFAULT_PLAN_HITS 1000
+#define MAX_PLAN_DURATION 86400
+#define DEFAULT_PLAN_SEED 1
+
+#define DIAGNOSTICS_INTERVAL 1000
+
+#define STATUS_RETIRED "Retired"
+
+// Link files past this size (in characters) are read from disk when ...
+// ... needed, instead of being kept (and laid out) in the box.
+#define MAX_EDITABLE_LINKS_TEXT 4194304
 
 #define LABELS_PROXY_STATS { \
     QStringLiteral("Proxy"), \
     QStringLiteral("Hits"), \
-    QStringLiteral("Errors") \
+    QStringLiteral("Errors"), \
+    QStringLiteral("Cancels"), \
+    QStringLiteral("Sent"), \
+    QStringLiteral("Received"), \
+    QStringLiteral("Throughput"), \
+    QStringLiteral("Errors by kind") \
 }
 
-#define COLOR_ACTIVE_LINK  0x99FFFF
-#define COLOR_ACTIVE_PROXY 0xFF99FF
+#define LABELS_ERRORS { \
+    QStringLiteral("Kind"), \
+    QStringLiteral("Count"), \
+    QStringLiteral("Sample messages") \
+}
 
-enum LinkStatsTableColumns {
-    LSTC_LINK,
-    LSTC_STATUS,
-    LSTC_HITS,
-    LSTC_ERRORS,
-    LSTC_LAST_ERROR,
-    LSTC_TOTAL
-};
+#define LABELS_RESOURCES { \
+    QStringLiteral("Ranking"), \
+    QStringLiteral("Resource"), \
+    QStringLiteral("Type"), \
+    QStringLiteral("Loads"), \
+    QStringLiteral("Avg. ms"), \
+    QStringLiteral("Max ms"), \
+    QStringLiteral("Avg. bytes"), \
+    QStringLiteral("Max bytes") \
+}
+
+#define LABELS_DIAGNOSTICS { \
+    QStringLiteral("Measure"), \
+    QStringLiteral("Value") \
+}
+
+#define COLOR_ACTIVE_PROXY 0xFF99FF
 
 enum ProxyStatsTableColumns {
     PSTC_PROXY,
     PSTC_HITS,
     PSTC_ERRORS,
+    PSTC_CANCELS,
+    PSTC_SENT,
+    PSTC_RECEIVED,
+    PSTC_THROUGHPUT,
+    PSTC_ERROR_KINDS,
     PSTC_TOTAL
 };
 
+enum ErrorsTableColumns {
+    ERTC_KIND,
+    ERTC_COUNT,
+    ERTC_SAMPLES,
+    ERTC_TOTAL
+};
+
+enum ResourcesTableColumns {
+    RSTC_RANKING,
+    RSTC_RESOURCE,
+    RSTC_TYPE,
+    RSTC_LOADS,
+    RSTC_AVG_TIME,
+    RSTC_MAX_TIME,
+    RSTC_AVG_BYTES,
+    RSTC_MAX_BYTES,
+    RSTC_TOTAL
+};
+
+enum DiagnosticsTableColumns {
+    DGTC_MEASURE,
+    DGTC_VALUE,
+    DGTC_TOTAL
+};
+
 MultiBrowser::MultiBrowser(QWidget *wgtParent):
-QMainWindow(wgtParent) {
+QMainWindow(wgtParent),
+crdAgents(nullptr,&engEngine),
+lsmLinkStats(nullptr,&engEngine.getLinks()) {
     bRunning=false;
-    uiTotalWorkers=0;
-    llCurrentLinks.clear();
-    plCurrentProxies.clear();
-    slCurrentAgents.clear();
+    sCheckpointPath.clear();
+    sLinksFile.clear();
+    msvMetrics=nullptr;
+    ocdResume.reset();
+    orpReplay.reset();
     // UI setup goes here:
     [=]() {
-        std::function<void(QTableWidget *,uint,QStringList)> fnConfigTable=[](
-            QTableWidget *twgTable,
-            uint         uiTotalColumns,
-            QStringList  slColumnLabels) {
-                twgTable->setColumnCount(uiTotalColumns);
-                twgTable->setHorizontalHeaderLabels(slColumnLabels);
-                twgTable->horizontalHeader()->setSectionResizeMode(
+        std::function<void(QTableView *,uint,QStringList)> fnConfigTable=[](
+            QTableView  *tvwTable,
+            uint        uiTotalColumns,
+            QStringList slColumnLabels) {
+                QTableWidget *twgWidget=qobject_cast<QTableWidget *>(tvwTable);
+                // Views get their columns and labels from the model.
+                if(nullptr!=twgWidget) {
+                    twgWidget->setColumnCount(uiTotalColumns);
+                    twgWidget->setHorizontalHeaderLabels(slColumnLabels);
+                }
+                tvwTable->horizontalHeader()->setSectionResizeMode(
                     QHeaderView::ResizeMode::ResizeToContents
                 );
-                twgTable->horizontalHeader()->setSectionResizeMode(
+                tvwTable->horizontalHeader()->setSectionResizeMode(
                     0,
                     QHeaderView::ResizeMode::Stretch
                 );
-                twgTable->verticalHeader()->setSectionResizeMode(
+                tvwTable->verticalHeader()->setSectionResizeMode(
                     QHeaderView::ResizeMode::Fixed
                 );
-                twgTable->setEditTriggers(
+                tvwTable->setEditTriggers(
                     QAbstractItemView::EditTrigger::NoEditTriggers
                 );
-                twgTable->setSelectionBehavior(
+                tvwTable->setSelectionBehavior(
                     QAbstractItemView::SelectionBehavior::SelectRows
                 );
-                twgTable->setSelectionMode(
+                tvwTable->setSelectionMode(
                     QAbstractItemView::SelectionMode::SingleSelection
                 );
             };
@@ -118,13 +211,25 @@ QMainWindow(wgtParent) {
         hblAgents.addWidget(&btnLoadAgents);
         vblAgents.addWidget(&txtAgents);
 
+        vblSettings.addLayout(&vblScenario);
+        vblScenario.addLayout(&hblScenario);
+        lblScenario.setSizePolicy(
+            QSizePolicy::Policy::Expanding,
+            QSizePolicy::Policy::Preferred
+        );
+        lblScenario.setText(QStringLiteral("Scenario (JSON steps, replaces the links):"));
+        hblScenario.addWidget(&lblScenario);
+        btnLoadScenario.setText(QStringLiteral("Load"));
+        hblScenario.addWidget(&btnLoadScenario);
+        vblScenario.addWidget(&txtScenario);
+
         vblSettings.addLayout(&hblOptions);
         hblOptions.addStretch();
         hblOptions.addLayout(&hblOptionThreads);
-        lblThreads.setText(QStringLiteral("Max. threads:"));
+        lblThreads.setText(QStringLiteral("Max. in flight:"));
         hblOptionThreads.addWidget(&lblThreads);
         spbThreads.setMinimum(1);
-        spbThreads.setMaximum(MAX_THREADS);
+        spbThreads.setMaximum(MAX_IN_FLIGHT);
         hblOptionThreads.addWidget(&spbThreads);
         hblOptions.addStretch();
         hblOptions.addLayout(&hblOptionCooldown);
@@ -134,13 +239,205 @@ QMainWindow(wgtParent) {
         spbCooldown.setMaximum(MAX_COOLDOWN);
         spbCooldown.setSuffix(QStringLiteral(" s"));
         hblOptionCooldown.addWidget(&spbCooldown);
+        hblOptions.addLayout(&hblOptionMemory);
+        lblMemoryBudget.setText(QStringLiteral("Memory budget:"));
+        hblOptionMemory.addWidget(&lblMemoryBudget);
+        spbMemoryBudget.setMinimum(0);
+        spbMemoryBudget.setMaximum(MAX_MEMORY_BUDGET);
+        spbMemoryBudget.setSingleStep(MEMORY_BUDGET_STEP);
+        spbMemoryBudget.setSuffix(QStringLiteral(" MB"));
+        spbMemoryBudget.setSpecialValueText(QStringLiteral("None"));
+        spbMemoryBudget.setToolTip(QStringLiteral(
+            "Memory the helpers, buffers, stats and queued events may take together.\n"
+            "Past it, events are coalesced, unneeded bodies dropped, then fewer hits run at once."
+        ));
+        hblOptionMemory.addWidget(&spbMemoryBudget);
         hblOptions.addStretch();
         hblOptions.addLayout(&hblOptionUse);
         optUseBrowser.setText(QStringLiteral("Use browser"));
         hblOptionUse.addWidget(&optUseBrowser);
+        chkWarmProfile.setText(QStringLiteral("Warm profile"));
+        chkWarmProfile.setEnabled(false);
+        hblOptionUse.addWidget(&chkWarmProfile);
         optUseHTTP.setText(QStringLiteral("Use HTTP"));
         optUseHTTP.setChecked(true);
         hblOptionUse.addWidget(&optUseHTTP);
+        optUseScenario.setText(QStringLiteral("Use scenario"));
+        hblOptionUse.addWidget(&optUseScenario);
+        hblOptions.addStretch();
+
+        vblSettings.addLayout(&hblMonitoring);
+        hblMonitoring.addStretch();
+        hblMonitoring.addLayout(&hblOptionCheckpoint);
+        chkCheckpoint.setText(QStringLiteral("Checkpoint every:"));
+        hblOptionCheckpoint.addWidget(&chkCheckpoint);
+        spbCheckpoint.setMinimum(MIN_CHECKPOINT_INTERVAL);
+        spbCheckpoint.setMaximum(MAX_CHECKPOINT_INTERVAL);
+        spbCheckpoint.setValue(DEFAULT_CHECKPOINT_INTERVAL);
+        spbCheckpoint.setSuffix(QStringLiteral(" s"));
+        hblOptionCheckpoint.addWidget(&spbCheckpoint);
+        hblMonitoring.addStretch();
+        hblMonitoring.addLayout(&hblOptionMetrics);
+        chkMetrics.setText(QStringLiteral("Serve metrics on port:"));
+        hblOptionMetrics.addWidget(&chkMetrics);
+        spbMetrics.setMinimum(1);
+        spbMetrics.setMaximum(65535);
+        spbMetrics.setValue(DEFAULT_METRICS_PORT);
+        hblOptionMetrics.addWidget(&spbMetrics);
+        hblMonitoring.addStretch();
+        hblMonitoring.addLayout(&hblOptionTrace);
+        chkTrace.setText(QStringLiteral("Trace one hit in:"));
+        hblOptionTrace.addWidget(&chkTrace);
+        spbTrace.setMinimum(1);
+        spbTrace.setMaximum(MAX_TRACE_SAMPLING);
+        spbTrace.setValue(DEFAULT_TRACE_SAMPLING);
+        hblOptionTrace.addWidget(&spbTrace);
+        btnSaveTrace.setText(QStringLiteral("Save..."));
+        hblOptionTrace.addWidget(&btnSaveTrace);
+        hblMonitoring.addStretch();
+
+        vblSettings.addLayout(&hblNetwork);
+        hblNetwork.addStretch();
+        hblNetwork.addLayout(&hblOptionTimeouts);
+        lblConnectTimeout.setText(QStringLiteral("Connect timeout:"));
+        hblOptionTimeouts.addWidget(&lblConnectTimeout);
+        hblOptionTimeouts.addWidget(&spbConnectTimeout);
+        lblFirstByteTimeout.setText(QStringLiteral("First byte:"));
+        hblOptionTimeouts.addWidget(&lblFirstByteTimeout);
+        hblOptionTimeouts.addWidget(&spbFirstByteTimeout);
+        lblTotalTimeout.setText(QStringLiteral("Total:"));
+        hblOptionTimeouts.addWidget(&lblTotalTimeout);
+        hblOptionTimeouts.addWidget(&spbTotalTimeout);
+        for(const auto &s:{&spbConnectTimeout,&spbFirstByteTimeout,&spbTotalTimeout}) {
+            s->setMinimum(0);
+            s->setMaximum(MAX_TIMEOUT);
+            s->setSingleStep(100);
+            s->setSuffix(QStringLiteral(" ms"));
+            s->setSpecialValueText(QStringLiteral("None"));
+        }
+        hblNetwork.addStretch();
+        hblNetwork.addLayout(&hblOptionRetries);
+        lblRetries.setText(QStringLiteral("Retries:"));
+        hblOptionRetries.addWidget(&lblRetries);
+        spbRetries.setMinimum(0);
+        spbRetries.setMaximum(MAX_RETRIES);
+        spbRetries.setSpecialValueText(QStringLiteral("None"));
+        hblOptionRetries.addWidget(&spbRetries);
+        lblRetryBudget.setText(QStringLiteral("Budget:"));
+        hblOptionRetries.addWidget(&lblRetryBudget);
+        spbRetryBudget.setMinimum(1);
+        spbRetryBudget.setMaximum(100);
+        spbRetryBudget.setValue(DEFAULT_RETRY_BUDGET);
+        spbRetryBudget.setSuffix(QStringLiteral(" %"));
+        hblOptionRetries.addWidget(&spbRetryBudget);
+        hblNetwork.addStretch();
+        chkResumeTls.setText(QStringLiteral("Resume TLS sessions"));
+        chkResumeTls.setChecked(true);
+        hblNetwork.addWidget(&chkResumeTls);
+        hblNetwork.addStretch();
+
+        vblSettings.addLayout(&hblPage);
+        lblCompletion.setText(QStringLiteral("Page complete on:"));
+        lblCompletion.setEnabled(false);
+        hblPage.addWidget(&lblCompletion);
+        cmbCompletion.addItem(QStringLiteral("Load event"),QStringLiteral("load"));
+        cmbCompletion.addItem(QStringLiteral("DOMContentLoaded"),QStringLiteral("dom"));
+        cmbCompletion.addItem(QStringLiteral("Network idle for"),QStringLiteral("idle"));
+        cmbCompletion.addItem(QStringLiteral("Selector match"),QStringLiteral("selector"));
+        cmbCompletion.addItem(QStringLiteral("Time budget of"),QStringLiteral("time"));
+        cmbCompletion.setEnabled(false);
+        hblPage.addWidget(&cmbCompletion);
+        spbCompletion.setMinimum(1);
+        spbCompletion.setMaximum(MAX_COMPLETION_TIME);
+        spbCompletion.setValue(DEFAULT_COMPLETION_TIME);
+        spbCompletion.setSingleStep(100);
+        spbCompletion.setSuffix(QStringLiteral(" ms"));
+        spbCompletion.setEnabled(false);
+        hblPage.addWidget(&spbCompletion);
+        txtSelector.setPlaceholderText(QStringLiteral("CSS selector, e.g. #checkout"));
+        txtSelector.setEnabled(false);
+        hblPage.addWidget(&txtSelector);
+        hblPage.addStretch();
+        chkFetchContent.setText(QStringLiteral("Fetch HTML"));
+        chkFetchContent.setChecked(true);
+        chkFetchContent.setEnabled(false);
+        hblPage.addWidget(&chkFetchContent);
+        chkResources.setText(QStringLiteral("Record resources, HAR of one hit in:"));
+        chkResources.setEnabled(false);
+        hblPage.addWidget(&chkResources);
+        spbHarSampling.setMinimum(0);
+        spbHarSampling.setMaximum(MAX_HAR_SAMPLING);
+        spbHarSampling.setValue(DEFAULT_HAR_SAMPLING);
+        spbHarSampling.setSpecialValueText(QStringLiteral("None"));
+        spbHarSampling.setEnabled(false);
+        hblPage.addWidget(&spbHarSampling);
+
+        vblSettings.addLayout(&hblCache);
+        chkRevalidate.setText(QStringLiteral("Revalidate repeat hits (ETag/Last-Modified), cold hits:"));
+        hblCache.addWidget(&chkRevalidate);
+        spbColdHits.setMinimum(0);
+        spbColdHits.setMaximum(100);
+        spbColdHits.setValue(DEFAULT_COLD_HITS);
+        spbColdHits.setSuffix(QStringLiteral(" %"));
+        spbColdHits.setEnabled(false);
+        hblCache.addWidget(&spbColdHits);
+        hblCache.addStretch();
+        chkKeepCache.setText(QStringLiteral("Keep validators on disk"));
+        chkKeepCache.setEnabled(false);
+        hblCache.addWidget(&chkKeepCache);
+
+        vblSettings.addLayout(&hblEngine);
+        chkRawEngine.setText(QStringLiteral("Raw HTTP/1.1 engine, pipeline depth:"));
+        hblEngine.addWidget(&chkRawEngine);
+        spbPipeline.setMinimum(1);
+        spbPipeline.setMaximum(MAX_PIPELINE_DEPTH);
+        spbPipeline.setValue(DEFAULT_PIPELINE_DEPTH);
+        spbPipeline.setSpecialValueText(QStringLiteral("No pipelining"));
+        spbPipeline.setEnabled(false);
+        hblEngine.addWidget(&spbPipeline);
+        hblEngine.addStretch();
+
+        vblSettings.addLayout(&hblPlan);
+        chkPlan.setText(QStringLiteral("Seeded plan, seed:"));
+        hblPlan.addWidget(&chkPlan);
+        spbSeed.setMinimum(0);
+        spbSeed.setMaximum(std::numeric_limits<int>::max());
+        spbSeed.setValue(DEFAULT_PLAN_SEED);
+        spbSeed.setEnabled(false);
+        hblPlan.addWidget(&spbSeed);
+        hblPlan.addStretch();
+        lblPlanHits.setText(QStringLiteral("Hits:"));
+        hblPlan.addWidget(&lblPlanHits);
+        spbPlanHits.setMinimum(1);
+        spbPlanHits.setMaximum(MAX_PLAN_HITS);
+        spbPlanHits.setValue(DEFAULT_PLAN_HITS);
+        spbPlanHits.setEnabled(false);
+        hblPlan.addWidget(&spbPlanHits);
+        hblPlan.addStretch();
+        lblPlanDuration.setText(QStringLiteral("Max. duration:"));
+        hblPlan.addWidget(&lblPlanDuration);
+        spbPlanDuration.setMinimum(0);
+        spbPlanDuration.setMaximum(MAX_PLAN_DURATION);
+        spbPlanDuration.setSuffix(QStringLiteral(" s"));
+        spbPlanDuration.setSpecialValueText(QStringLiteral("None"));
+        spbPlanDuration.setEnabled(false);
+        hblPlan.addWidget(&spbPlanDuration);
+        hblPlan.addStretch();
+        btnExportPlan.setText(QStringLiteral("Export..."));
+        btnExportPlan.setEnabled(false);
+        hblPlan.addWidget(&btnExportPlan);
+
+        vblSettings.addLayout(&hblDistribute);
+        chkDistribute.setText(QStringLiteral("Distribute to agents:"));
+        hblDistribute.addWidget(&chkDistribute);
+        txtRemoteAgents.setPlaceholderText(QStringLiteral("host:port, host:port, ..."));
+        txtRemoteAgents.setEnabled(false);
+        hblDistribute.addWidget(&txtRemoteAgents);
+        txtAgentToken.setPlaceholderText(QStringLiteral("Token"));
+        txtAgentToken.setEchoMode(QLineEdit::EchoMode::Password);
+        txtAgentToken.setText(qEnvironmentVariable(AGENT_TOKEN_VARIABLE));
+        txtAgentToken.setEnabled(false);
+        hblDistribute.addWidget(&txtAgentToken);
 
         tbwMain.addTab(&wgtProgress,QStringLiteral("Progress"));
         wgtProgress.setLayout(&vblProgress);
@@ -148,8 +445,9 @@ QMainWindow(wgtParent) {
         lblLinkStats.setText(QStringLiteral("Link stats:"));
         lblLinkStats.setAlignment(Qt::AlignmentFlag::AlignCenter);
         vblLinkStats.addWidget(&lblLinkStats);
-        fnConfigTable(&twgLinkStats,LSTC_TOTAL,LABELS_LINK_STATS);
-        vblLinkStats.addWidget(&twgLinkStats);
+        tvwLinkStats.setModel(&lsmLinkStats);
+        fnConfigTable(&tvwLinkStats,LSTC_TOTAL,{});
+        vblLinkStats.addWidget(&tvwLinkStats);
         vblProgress.addLayout(&vblProxyStats);
         lblProxyStats.setText(QStringLiteral("Proxy stats:"));
         lblProxyStats.setAlignment(Qt::AlignmentFlag::AlignCenter);
@@ -157,8 +455,54 @@ QMainWindow(wgtParent) {
         fnConfigTable(&twgProxyStats,PSTC_TOTAL,LABELS_PROXY_STATS);
         vblProxyStats.addWidget(&twgProxyStats);
 
+        tbwMain.addTab(&wgtErrors,QStringLiteral("Errors"));
+        wgtErrors.setLayout(&vblErrors);
+        fnConfigTable(&twgErrors,ERTC_TOTAL,LABELS_ERRORS);
+        twgErrors.verticalHeader()->setVisible(false);
+        twgErrors.setRowCount(ErrorCode::EC_TOTAL);
+        for(int iK=0;iK<ErrorCode::EC_TOTAL;iK++) {
+            QTableWidgetItem *twiItem;
+            twgErrors.setItem(iK,ERTC_KIND,new QTableWidgetItem(ErrorTaxonomy::getName(ErrorCode(iK))));
+            twiItem=new QTableWidgetItem(QStringLiteral("0"));
+            twiItem->setTextAlignment(
+                Qt::AlignmentFlag::AlignRight|Qt::AlignmentFlag::AlignVCenter
+            );
+            twgErrors.setItem(iK,ERTC_COUNT,twiItem);
+            twgErrors.setItem(iK,ERTC_SAMPLES,new QTableWidgetItem());
+        }
+        vblErrors.addWidget(&twgErrors);
+
+        tbwMain.addTab(&wgtResources,QStringLiteral("Resources"));
+        wgtResources.setLayout(&vblResources);
+        fnConfigTable(&twgResources,RSTC_TOTAL,LABELS_RESOURCES);
+        twgResources.verticalHeader()->setVisible(false);
+        vblResources.addWidget(&twgResources);
+
+        tbwMain.addTab(&wgtDiagnostics,QStringLiteral("Diagnostics"));
+        wgtDiagnostics.setLayout(&vblDiagnostics);
+        fnConfigTable(&twgDiagnostics,DGTC_TOTAL,LABELS_DIAGNOSTICS);
+        twgDiagnostics.verticalHeader()->setVisible(false);
+        vblDiagnostics.addWidget(&twgDiagnostics);
+
         vblMain.addLayout(&hblRun);
+        btnSaveBaseline.setText(QStringLiteral("Save baseline..."));
+        hblRun.addWidget(&btnSaveBaseline);
+        btnCompareBaseline.setText(QStringLiteral("Compare with baseline..."));
+        hblRun.addWidget(&btnCompareBaseline);
         hblRun.addStretch();
+        chkFollowFiles.setText(QStringLiteral("Follow list files"));
+        chkFollowFiles.setToolTip(
+            QStringLiteral("Reloads the lists, mid-run, whenever a loaded file is saved")
+        );
+        hblRun.addWidget(&chkFollowFiles);
+        btnApply.setText(QStringLiteral("Apply lists"));
+        btnApply.setToolTip(QStringLiteral("Reloads the lists without stopping the run"));
+        btnApply.setEnabled(false);
+        hblRun.addWidget(&btnApply);
+        btnReplay.setText(QStringLiteral("Replay..."));
+        hblRun.addWidget(&btnReplay);
+        btnResume.setText(QStringLiteral("Resume..."));
+        hblRun.addWidget(&btnResume);
         btnRun.setText(QStringLiteral("Run"));
         hblRun.addWidget(&btnRun);
 
@@ -184,177 +528,277 @@ QMainWindow(wgtParent) {
             this,
             &MultiBrowser::loadUserAgentsClicked
         );
+        connect(
+            &btnLoadScenario,
+            &QPushButton::clicked,
+            this,
+            &MultiBrowser::loadScenarioClicked
+        );
+        for(const auto &o:{&optUseBrowser,&optUseHTTP,&optUseScenario})
+            connect(
+                o,
+                &QRadioButton::toggled,
+                this,
+                &MultiBrowser::useModeToggled
+            );
+        connect(
+            &chkMetrics,
+            &QCheckBox::toggled,
+            this,
+            &MultiBrowser::metricsToggled
+        );
+        connect(
+            &chkTrace,
+            &QCheckBox::toggled,
+            this,
+            &MultiBrowser::traceToggled
+        );
+        connect(
+            &spbTrace,
+            QOverload<int>::of(&QSpinBox::valueChanged),
+            this,
+            [this](int) {
+                this->traceToggled(chkTrace.isChecked());
+            }
+        );
+        connect(
+            &btnSaveTrace,
+            &QPushButton::clicked,
+            this,
+            &MultiBrowser::saveTraceClicked
+        );
+        connect(
+            &chkRevalidate,
+            &QCheckBox::toggled,
+            this,
+            &MultiBrowser::revalidateToggled
+        );
+        connect(
+            &chkRawEngine,
+            &QCheckBox::toggled,
+            this,
+            &MultiBrowser::rawEngineToggled
+        );
+        connect(
+            &cmbCompletion,
+            QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this,
+            &MultiBrowser::completionChanged
+        );
+        connect(
+            &chkPlan,
+            &QCheckBox::toggled,
+            this,
+            &MultiBrowser::planToggled
+        );
+        connect(
+            &btnExportPlan,
+            &QPushButton::clicked,
+            this,
+            &MultiBrowser::exportPlanClicked
+        );
+        connect(
+            &chkDistribute,
+            &QCheckBox::toggled,
+            this,
+            &MultiBrowser::distributeToggled
+        );
+        connect(
+            &spbThreads,
+            QOverload<int>::of(&QSpinBox::valueChanged),
+            this,
+            &MultiBrowser::threadsChanged
+        );
+        connect(
+            &spbCooldown,
+            QOverload<int>::of(&QSpinBox::valueChanged),
+            this,
+            &MultiBrowser::cooldownChanged
+        );
+        connect(
+            &spbMemoryBudget,
+            QOverload<int>::of(&QSpinBox::valueChanged),
+            this,
+            &MultiBrowser::memoryBudgetChanged
+        );
+        connect(
+            &btnSaveBaseline,
+            &QPushButton::clicked,
+            this,
+            &MultiBrowser::saveBaselineClicked
+        );
+        connect(
+            &btnCompareBaseline,
+            &QPushButton::clicked,
+            this,
+            &MultiBrowser::compareBaselineClicked
+        );
+        connect(
+            &btnApply,
+            &QPushButton::clicked,
+            this,
+            &MultiBrowser::applyClicked
+        );
+        connect(
+            &fswLists,
+            &QFileSystemWatcher::fileChanged,
+            this,
+            &MultiBrowser::listFileChanged
+        );
+        connect(
+            &btnReplay,
+            &QPushButton::clicked,
+            this,
+            &MultiBrowser::replayClicked
+        );
+        connect(
+            &btnResume,
+            &QPushButton::clicked,
+            this,
+            &MultiBrowser::resumeClicked
+        );
         connect(
             &btnRun,
             &QPushButton::clicked,
             this,
             &MultiBrowser::runClicked
         );
+        connect(
+            &engEngine,
+            &HitEngine::checkpointWritten,
+            this,
+            &MultiBrowser::checkpointWritten
+        );
+        connect(
+            &engEngine,
+            &HitEngine::hitFinished,
+            this,
+            &MultiBrowser::hitFinished
+        );
+        connect(
+            &engEngine,
+            &HitEngine::hitStarted,
+            this,
+            &MultiBrowser::hitStarted
+        );
+        connect(
+            &engEngine,
+            &HitEngine::listsChanged,
+            this,
+            &MultiBrowser::listsChanged
+        );
+        connect(
+            &engEngine,
+            &HitEngine::statusChanged,
+            this,
+            &MultiBrowser::statusChanged
+        );
+        // Queued, since the engine may be still inside start() when a plan ends.
+        connect(
+            &engEngine,
+            &HitEngine::runFinished,
+            this,
+            &MultiBrowser::runFinished,
+            Qt::ConnectionType::QueuedConnection
+        );
+        connect(
+            &crdAgents,
+            &Coordinator::agentFailed,
+            this,
+            &MultiBrowser::agentFailed
+        );
+        connect(
+            &crdAgents,
+            &Coordinator::linkUpdated,
+            this,
+            &MultiBrowser::updateLinkStats
+        );
+        connect(
+            &crdAgents,
+            &Coordinator::proxyUpdated,
+            this,
+            &MultiBrowser::updateProxyStats
+        );
+        connect(
+            &tmrDiagnostics,
+            &QTimer::timeout,
+            this,
+            &MultiBrowser::diagnosticsTimeout
+        );
+        tmrDiagnostics.start(DIAGNOSTICS_INTERVAL);
     }();
 }
 
 MultiBrowser::~MultiBrowser() {
-    // No cleanup required ATM.
-}
-
-void MultiBrowser::browse() {
-    while(uiTotalWorkers<(uint)spbThreads.value()) {
-        bool bFreeLinks=false,
-             bFreeProxies=false;
-        // Verifies that thee are non-busy links.
-        for(const auto &l:llCurrentLinks)
-            if(!l.bBusy) {
-                bFreeLinks=true;
-                break;
-            }
-        if(bFreeLinks) {
-            int           iRandomLink,
-                          iRandomProxy,
-                          iRandomAgent;
-            QString       sSelectedAgent=QString();
-            LinkRecord    *lrSelectedLink=nullptr;
-            ProxyRecord   *prSelectedProxy=nullptr;
-            BrowserWorker *bwWorker=nullptr;
-            uiTotalWorkers++;
-            // Picks one non-busy link at random.
-            while(true) {
-                iRandomLink=QRandomGenerator::global()->bounded(
-                    llCurrentLinks.count()
-                );
-                if(!llCurrentLinks.at(iRandomLink).bBusy)
-                    break;
-            }
-            lrSelectedLink=&llCurrentLinks[iRandomLink];
-            if(!plCurrentProxies.isEmpty()) {
-                // Verifies that there are non-busy proxies.
-                for(const auto &p:plCurrentProxies)
-                    if(!p.bBusy) {
-                        bFreeProxies=true;
-                        break;
-                    }
-                if(bFreeProxies)
-                    // Picks one non-busy proxy at random.
-                    while(true) {
-                        iRandomProxy=QRandomGenerator::global()->bounded(
-                            plCurrentProxies.count()
-                        );
-                        if(!plCurrentProxies.at(iRandomProxy).bBusy)
-                            break;
-                    }
-                else
-                    // Picks any if all proxies are busy.
-                    iRandomProxy=QRandomGenerator::global()->bounded(
-                        plCurrentProxies.count()
-                    );
-                prSelectedProxy=&plCurrentProxies[iRandomProxy];
-            }
-            if(!slCurrentAgents.isEmpty()) {
-                // Picks any user agent. Frequent picks are not important.
-                iRandomAgent=QRandomGenerator::global()->bounded(
-                    slCurrentAgents.count()
-                );
-                sSelectedAgent=slCurrentAgents.at(iRandomAgent);
-            }
-            bwWorker=new BrowserWorker(
-                this,
-                lrSelectedLink,
-                prSelectedProxy,
-                sSelectedAgent
-            );
-            bwWorker->setCooldown(
-                QRandomGenerator::global()->bounded(spbCooldown.value()+1)
-            );
-            if(optUseHTTP.isChecked())
-                bwWorker->setMode(BrowserWorker::RunMode::RM_NETWORK);
-            else if(optUseBrowser.isChecked())
-                bwWorker->setMode(BrowserWorker::RunMode::RM_WEB_ENGINE);
-            connect(
-                bwWorker,
-                &BrowserWorker::started,
-                this,
-                &MultiBrowser::workerStarted
-            );
-            connect(
-                bwWorker,
-                &BrowserWorker::finished,
-                this,
-                &MultiBrowser::workerFinished
-            );
-            connect(
-                bwWorker,
-                &BrowserWorker::statusChanged,
-                this,
-                &MultiBrowser::workerStatusChanged
-            );
-            bwWorker->start();
-        }
-        else
-            break; // Nothing to do if all links are busy.
-    }
+    // The widgets go away before the engine does, so it must stop reporting.
+    engEngine.disconnect(this);
+    crdAgents.disconnect(this);
 }
 
-LinkList MultiBrowser::getLinksFromText(QString sText) {
-    uint        uiIndex=0;
-    LinkList    llResult={};
-    QStringList slLinks=sText.split(
-        QStringLiteral("\n"),
-        Qt::SplitBehaviorFlags::SkipEmptyParts
-    );
-    for(const auto &s:slLinks) {
-        QUrl urlTestLink;
-        urlTestLink.setUrl(s.trimmed());
-        if(urlTestLink.isValid()) {
-            QString sScheme=urlTestLink.scheme().toLower();
-            if(sScheme==QStringLiteral("http")||sScheme==QStringLiteral("https")) {
-                LinkRecord lrLink;
-                lrLink.urlLink=urlTestLink;
-                lrLink.bBusy=false;
-                lrLink.uiIndex=uiIndex++;
-                lrLink.uiHits=0;
-                lrLink.uiErrors=0;
-                lrLink.sLastError=QString();
-                llResult.append(lrLink);
-            }
-        }
+void MultiBrowser::addProxyRows(int iFirst) {
+    const ProxyList &plProxies=engEngine.getProxies();
+    twgProxyStats.setRowCount(plProxies.count());
+    for(int iK=iFirst;iK<plProxies.count();iK++) {
+        const ProxyRecord &p=plProxies.at(iK);
+        QTableWidgetItem  *twiItem;
+        twiItem=new QTableWidgetItem(ProxyParser::getTextFromProxy(p.npxProxy));
+        twgProxyStats.setItem(p.uiIndex,PSTC_PROXY,twiItem);
+        twiItem=new QTableWidgetItem(QString::number(p.uiHits));
+        twiItem->setTextAlignment(
+            Qt::AlignmentFlag::AlignRight|Qt::AlignmentFlag::AlignVCenter
+        );
+        twgProxyStats.setItem(p.uiIndex,PSTC_HITS,twiItem);
+        twiItem=new QTableWidgetItem(QString::number(p.uiErrors));
+        twiItem->setTextAlignment(
+            Qt::AlignmentFlag::AlignRight|Qt::AlignmentFlag::AlignVCenter
+        );
+        twgProxyStats.setItem(p.uiIndex,PSTC_ERRORS,twiItem);
+        twiItem=new QTableWidgetItem(QString::number(p.uiCancels));
+        twiItem->setTextAlignment(
+            Qt::AlignmentFlag::AlignRight|Qt::AlignmentFlag::AlignVCenter
+        );
+        twgProxyStats.setItem(p.uiIndex,PSTC_CANCELS,twiItem);
+        twiItem=new QTableWidgetItem(Bandwidth::getTextFromBytes(p.tcTraffic.uiSent));
+        twiItem->setTextAlignment(
+            Qt::AlignmentFlag::AlignRight|Qt::AlignmentFlag::AlignVCenter
+        );
+        twgProxyStats.setItem(p.uiIndex,PSTC_SENT,twiItem);
+        twiItem=new QTableWidgetItem(Bandwidth::getTextFromBytes(p.tcTraffic.uiReceived));
+        twiItem->setTextAlignment(
+            Qt::AlignmentFlag::AlignRight|Qt::AlignmentFlag::AlignVCenter
+        );
+        twgProxyStats.setItem(p.uiIndex,PSTC_RECEIVED,twiItem);
+        twiItem=new QTableWidgetItem(QString());
+        twiItem->setTextAlignment(
+            Qt::AlignmentFlag::AlignRight|Qt::AlignmentFlag::AlignVCenter
+        );
+        twgProxyStats.setItem(p.uiIndex,PSTC_THROUGHPUT,twiItem);
+        twiItem=new QTableWidgetItem(ErrorTaxonomy::getTextFromCounts(p.ecsErrors));
+        twgProxyStats.setItem(p.uiIndex,PSTC_ERROR_KINDS,twiItem);
     }
-    return llResult;
 }
 
-ProxyList MultiBrowser::getProxiesFromText(QString sText) {
-    uint        uiIndex=0;
-    ProxyList   plResult={};
-    QStringList slProxies=sText.split(
-        QStringLiteral("\n"),
-        Qt::SplitBehaviorFlags::SkipEmptyParts
-    );
-    for(const auto &s:slProxies) {
-        QNetworkProxy npxProxy=ProxyParser::getProxyFromText(s);
-        if(QNetworkProxy::ProxyType::NoProxy!=npxProxy.type()) {
-            ProxyRecord prProxy;
-            prProxy.npxProxy=npxProxy;
-            prProxy.bBusy=false;
-            prProxy.uiIndex=uiIndex++;
-            prProxy.uiHits=0;
-            prProxy.uiErrors=0;
-            plResult.append(prProxy);
-        }
-    }
-    return plResult;
+QString MultiBrowser::getCompletion() {
+    QString sResult=cmbCompletion.currentData().toString();
+    // Same syntax as the helper's --until option.
+    if(QStringLiteral("idle")==sResult||QStringLiteral("time")==sResult)
+        sResult.append(QStringLiteral(":%1").arg(spbCompletion.value()));
+    else if(QStringLiteral("selector")==sResult)
+        sResult.append(QStringLiteral(":%1").arg(txtSelector.text().trimmed()));
+    return sResult;
 }
 
-QStringList MultiBrowser::getUserAgentsFromText(QString sText) {
-    QStringList slResult={},
-                slAgents=sText.split(
-                    QStringLiteral("\n"),
-                    Qt::SplitBehaviorFlags::SkipEmptyParts
-                );
-    for(const auto &a:slAgents)
-        if(AgentParser::isUserAgent(a.trimmed()))
-            slResult.append(a.trimmed());
-    return slResult;
+QString MultiBrowser::getLinksText() {
+    QFile fFile(sLinksFile);
+    if(sLinksFile.isEmpty())
+        return txtLinks.toPlainText();
+    // Nothing is kept: the text only lives as long as it's being parsed.
+    if(!fFile.open(QFile::OpenModeFlag::ReadOnly))
+        return QString();
+    return QString::fromUtf8(fFile.readAll());
 }
 
-QString MultiBrowser::getTextFileContents(QString sPrompt) {
+QString MultiBrowser::getTextFileContents(QString sPrompt,QString sFilter,QPlainTextEdit *txtTarget) {
     QString sResult=QString(),
             sDefaultFolder,
             sTempPath;
@@ -365,7 +809,7 @@ QString MultiBrowser::getTextFileContents(QString sPrompt) {
         this,
         sPrompt,
         sDefaultFolder,
-        QStringLiteral(FILTER_TXT_FILES)
+        sFilter.isEmpty()?QStringLiteral(FILTER_TXT_FILES):sFilter
     );
     if(!sTempPath.isEmpty()) {
         QFile fFile;
@@ -373,6 +817,18 @@ QString MultiBrowser::getTextFileContents(QString sPrompt) {
         if(fFile.open(QFile::OpenModeFlag::ReadOnly)) {
             sResult=fFile.readAll();
             fFile.close();
+            // Watched, so the box can follow the file (one file per box).
+            if(nullptr!=txtTarget) {
+                for(auto itWatched=hshWatched.begin();itWatched!=hshWatched.end();)
+                    if(txtTarget==itWatched.value()) {
+                        fswLists.removePath(itWatched.key());
+                        itWatched=hshWatched.erase(itWatched);
+                    }
+                    else
+                        itWatched++;
+                hshWatched.insert(sTempPath,txtTarget);
+                fswLists.addPath(sTempPath);
+            }
         }
         else
             QMessageBox::critical(
@@ -384,49 +840,280 @@ QString MultiBrowser::getTextFileContents(QString sPrompt) {
     return sResult;
 }
 
-QString MultiBrowser::getTextFromLinks(LinkList llLinks) {
-    QString sResult=QString();
-    for(const auto &l:llLinks) {
-        if(!sResult.isEmpty())
-            sResult.append(QStringLiteral("\n"));
-        sResult.append(l.urlLink.toString());
+bool MultiBrowser::reloadLists(QString &sError) {
+    LinkStore    llLinks;
+    ProxyList    plProxies;
+    QStringList  slAgents;
+    QVector<int> viLinkSlots,
+                 viProxySlots;
+    if(!engEngine.getSteps().isEmpty()) {
+        sError=QStringLiteral("Scenarios can't be reloaded");
+        return false;
+    }
+    // Same checks as a new run, so the lists are never left without links.
+    llLinks=HitEngine::getLinksFromText(this->getLinksText(),sError);
+    if(!sError.isEmpty())
+        return false;
+    if(llLinks.isEmpty()) {
+        sError=QStringLiteral("At least one link is required");
+        return false;
+    }
+    plProxies=HitEngine::getProxiesFromText(txtProxies.toPlainText());
+    slAgents=HitEngine::getUserAgentsFromText(txtAgents.toPlainText());
+    if(!engEngine.reload(llLinks,plProxies,slAgents,viLinkSlots,viProxySlots,sError))
+        return false;
+    this->setLinksText(HitEngine::getTextFromLinks(llLinks));
+    txtProxies.setPlainText(HitEngine::getTextFromProxies(plProxies));
+    txtAgents.setPlainText(HitEngine::getTextFromUserAgents(slAgents));
+    // The engine only keeps the merged totals here: the agents get their ...
+    // ... new shares from it.
+    if(crdAgents.isRunning())
+        return crdAgents.reload(slAgents,sError);
+    return true;
+}
+
+void MultiBrowser::checkpointWritten(QString sError) {
+    if(bRunning) {
+        if(sError.isEmpty())
+            stbMain.showMessage(
+                QStringLiteral("Running... (checkpoint saved at %1)").arg(
+                    QTime::currentTime().toString()
+                )
+            );
+        else
+            stbMain.showMessage(
+                QStringLiteral("Running... (checkpoint failed: %1)").arg(sError)
+            );
     }
-    return sResult;
 }
 
-QString MultiBrowser::getTextFromProxies(ProxyList plProxies) {
-    QString sResult=QString();
-    for(const auto &p:plProxies) {
-        QString sProxy=ProxyParser::getTextFromProxy(p.npxProxy);
-        if(!sProxy.isEmpty()) {
-            if(!sResult.isEmpty())
-                sResult.append(QStringLiteral("\n"));
-            sResult.append(sProxy);
+void MultiBrowser::updateDiagnostics() {
+    DiagnosticsReadings drsReadings=Diagnostics::getReadings();
+    twgDiagnostics.setRowCount(drsReadings.count());
+    for(int iK=0;iK<drsReadings.count();iK++) {
+        if(nullptr==twgDiagnostics.item(iK,DGTC_MEASURE)) {
+            twgDiagnostics.setItem(iK,DGTC_MEASURE,new QTableWidgetItem(drsReadings.at(iK).sName));
+            twgDiagnostics.setItem(iK,DGTC_VALUE,new QTableWidgetItem());
         }
+        twgDiagnostics.item(iK,DGTC_VALUE)->setText(drsReadings.at(iK).sValue);
     }
-    return sResult;
 }
 
-QString MultiBrowser::getTextFromUserAgents(QStringList slUserAgents) {
-    QString sResult=QString();
-    for(const auto &a:slUserAgents) {
-        if(!sResult.isEmpty())
-            sResult.append(QStringLiteral("\n"));
-        sResult.append(a);
+void MultiBrowser::updateErrorStats() {
+    // Counted from the links, so the errors of the agents show up too. The ...
+    // ... samples are only kept where the errors happened, though.
+    ErrorCounts ecsTotals=engEngine.getLinks().getErrorTotals();
+    for(int iK=0;iK<ErrorCode::EC_TOTAL;iK++) {
+        twgErrors.item(iK,ERTC_COUNT)->setText(QString::number(ecsTotals.uiCounts[iK]));
+        twgErrors.item(iK,ERTC_SAMPLES)->setText(
+            ErrorTaxonomy::getSamples(ErrorCode(iK)).join(QStringLiteral(" | "))
+        );
+    }
+}
+
+void MultiBrowser::updateResourceStats() {
+    int iRow=0;
+    // Collected by the browser helpers of this process only, not the agents'.
+    twgResources.setRowCount(0);
+    for(auto rkRanking:{ResourceStats::Ranking::RK_SLOWEST,ResourceStats::Ranking::RK_HEAVIEST})
+        for(const auto &r:ResourceStats::getTop(rkRanking,TOP_RESOURCES)) {
+            QStringList slValues={
+                ResourceStats::Ranking::RK_SLOWEST==rkRanking?QStringLiteral("Slowest"):
+                                                              QStringLiteral("Heaviest"),
+                r.sResource,
+                r.sType,
+                QString::number(r.uiLoads),
+                QString::number(r.dTotalTime/r.uiLoads,'f',1),
+                QString::number(r.dMaxTime,'f',1),
+                QString::number(r.uiTotalBytes/r.uiLoads),
+                QString::number(r.uiMaxBytes)
+            };
+            twgResources.insertRow(iRow);
+            for(int iK=0;iK<RSTC_TOTAL;iK++) {
+                QTableWidgetItem *twiItem=new QTableWidgetItem(slValues.at(iK));
+                if(iK>=RSTC_LOADS)
+                    twiItem->setTextAlignment(
+                        Qt::AlignmentFlag::AlignRight|Qt::AlignmentFlag::AlignVCenter
+                    );
+                twgResources.setItem(iRow,iK,twiItem);
+            }
+            iRow++;
+        }
+}
+
+void MultiBrowser::updateLinkStats(LinkRecord *lrLink) {
+    // Only repaints the row (when visible): the model reads the store itself.
+    lsmLinkStats.updateRow(lrLink->uiIndex);
+}
+
+void MultiBrowser::updateProxyStats(ProxyRecord *prProxy) {
+    twgProxyStats.item(prProxy->uiIndex,PSTC_HITS)->setText(
+        QString::number(prProxy->uiHits)
+    );
+    twgProxyStats.item(prProxy->uiIndex,PSTC_ERRORS)->setText(
+        QString::number(prProxy->uiErrors)
+    );
+    twgProxyStats.item(prProxy->uiIndex,PSTC_CANCELS)->setText(
+        QString::number(prProxy->uiCancels)
+    );
+    twgProxyStats.item(prProxy->uiIndex,PSTC_SENT)->setText(
+        Bandwidth::getTextFromBytes(prProxy->tcTraffic.uiSent)
+    );
+    twgProxyStats.item(prProxy->uiIndex,PSTC_RECEIVED)->setText(
+        Bandwidth::getTextFromBytes(prProxy->tcTraffic.uiReceived)
+    );
+    twgProxyStats.item(prProxy->uiIndex,PSTC_ERROR_KINDS)->setText(
+        ErrorTaxonomy::getTextFromCounts(prProxy->ecsErrors)
+    );
+}
+
+void MultiBrowser::updateThroughput() {
+    double dElapsed=etmThroughput.restart()/1000.0;
+    if(dElapsed<=0.0)
+        return;
+    for(const auto &p:engEngine.getProxies()) {
+        // Local runs see the bytes as they move, distributed ones as the ...
+        // ... agents report them.
+        TrafficCounts tcNow=crdAgents.isRunning()?p.tcTraffic:Bandwidth::getTraffic(p.uiIndex);
+        quint64       uiNow=tcNow.uiSent+tcNow.uiReceived,
+                      uiBefore,
+                      uiRate;
+        QString       sRate;
+        if(p.uiIndex>=uint(vtcThroughput.count())||p.uiIndex>=uint(twgProxyStats.rowCount()))
+            continue;
+        uiBefore=vtcThroughput.at(p.uiIndex).uiSent+vtcThroughput.at(p.uiIndex).uiReceived;
+        uiRate=uiNow>uiBefore?quint64((uiNow-uiBefore)/dElapsed):0;
+        vtcThroughput[p.uiIndex]=tcNow;
+        sRate=QStringLiteral("%1/s").arg(Bandwidth::getTextFromBytes(uiRate));
+        if(p.uiRateLimit)
+            sRate.append(QStringLiteral(" of %1/s").arg(Bandwidth::getTextFromBytes(p.uiRateLimit)));
+        twgProxyStats.item(p.uiIndex,PSTC_THROUGHPUT)->setText(sRate);
     }
-    return sResult;
 }
 
 void MultiBrowser::loadLinksClicked(bool) {
-    txtLinks.setPlainText(this->getTextFileContents(lblLinks.text()));
+    QString sText=this->getTextFileContents(lblLinks.text(),QString(),&txtLinks);
+    sLinksFile.clear();
+    txtLinks.setReadOnly(false);
+    // Huge lists stay in their file: only a note of it goes in the box.
+    if(sText.size()>MAX_EDITABLE_LINKS_TEXT) {
+        sLinksFile=hshWatched.key(&txtLinks);
+        txtLinks.setReadOnly(true);
+        txtLinks.setPlainText(
+            QStringLiteral("%1 lines, read from %2 when needed (too many to edit here: load a smaller file to edit links again)").arg(
+                sText.count(QLatin1Char('\n'))+1
+            ).arg(
+                QDir::toNativeSeparators(sLinksFile)
+            )
+        );
+    }
+    else
+        txtLinks.setPlainText(sText);
 }
 
 void MultiBrowser::loadProxiesClicked(bool) {
-    txtProxies.setPlainText(this->getTextFileContents(lblProxies.text()));
+    txtProxies.setPlainText(this->getTextFileContents(lblProxies.text(),QString(),&txtProxies));
+}
+
+void MultiBrowser::loadScenarioClicked(bool) {
+    txtScenario.setPlainText(
+        this->getTextFileContents(
+            lblScenario.text(),
+            QStringLiteral(FILTER_JSON_FILES)
+        )
+    );
 }
 
 void MultiBrowser::loadUserAgentsClicked(bool) {
-    txtAgents.setPlainText(this->getTextFileContents(lblAgents.text()));
+    txtAgents.setPlainText(this->getTextFileContents(lblAgents.text(),QString(),&txtAgents));
+}
+
+void MultiBrowser::replayClicked(bool) {
+    QString sPath=QFileDialog::getOpenFileName(
+        this,
+        QStringLiteral("Replay run plan"),
+        QStandardPaths::standardLocations(
+            QStandardPaths::StandardLocation::DocumentsLocation
+        ).at(0),
+        QStringLiteral(FILTER_PLAN_FILES)
+    );
+    if(!sPath.isEmpty()) {
+        RunPlan rplPlan;
+        QString sError;
+        if(RunPlanner::readFromFile(sPath,rplPlan,sError)) {
+            orpReplay=rplPlan;
+            this->runClicked(false);
+            orpReplay.reset();
+        }
+        else
+            QMessageBox::critical(
+                this,
+                QStringLiteral("Error"),
+                sError
+            );
+    }
+}
+
+void MultiBrowser::resumeClicked(bool) {
+    QString sPath=QFileDialog::getOpenFileName(
+        this,
+        QStringLiteral("Resume from checkpoint"),
+        QStandardPaths::writableLocation(
+            QStandardPaths::StandardLocation::AppDataLocation
+        ),
+        QStringLiteral(FILTER_CHECKPOINT_FILES)
+    );
+    if(!sPath.isEmpty()) {
+        CheckpointData cdData;
+        QString        sError;
+        if(Checkpoint::readFromFile(sPath,cdData,sError)) {
+            // The run continues writing into the checkpoint it resumed from.
+            sCheckpointPath=sPath;
+            ocdResume=cdData;
+            this->runClicked(false);
+            ocdResume.reset();
+        }
+        else
+            QMessageBox::critical(
+                this,
+                QStringLiteral("Error"),
+                sError
+            );
+    }
+}
+
+void MultiBrowser::memoryBudgetChanged(int) {
+    // Like the limits, the budget applies to a running engine (or agents).
+    engEngine.setMemoryBudget(spbMemoryBudget.value());
+    crdAgents.setRate(spbThreads.value(),spbCooldown.value(),spbMemoryBudget.value());
+}
+
+void MultiBrowser::metricsListenFailed(QString sError) {
+    QMessageBox::critical(
+        this,
+        QStringLiteral("Error"),
+        QStringLiteral("Unable to serve metrics: %1").arg(sError)
+    );
+    chkMetrics.setChecked(false);
+}
+
+void MultiBrowser::metricsToggled(bool bChecked) {
+    if(nullptr!=msvMetrics) {
+        delete msvMetrics;
+        msvMetrics=nullptr;
+    }
+    if(bChecked) {
+        // Served on localhost only: it's meant for a local scraper.
+        msvMetrics=new MetricsServer(this,spbMetrics.value());
+        connect(
+            msvMetrics,
+            &MetricsServer::listenFailed,
+            this,
+            &MultiBrowser::metricsListenFailed
+        );
+        msvMetrics->start(QThread::Priority::LowPriority);
+    }
+    spbMetrics.setEnabled(!bChecked);
 }
 
 void MultiBrowser::runClicked(bool) {
@@ -434,31 +1121,66 @@ void MultiBrowser::runClicked(bool) {
         bRunning=false;
         btnRun.setEnabled(false);
         stbMain.showMessage(QStringLiteral("Stopping (wait)..."));
-        while(uiTotalWorkers)
-            QApplication::processEvents(
-                QEventLoop::ProcessEventsFlag::ExcludeUserInputEvents
-            );
+        if(crdAgents.isRunning())
+            crdAgents.stop();
+        else
+            engEngine.stop();
         stbMain.clearMessage();
+        btnApply.setEnabled(false);
+        btnReplay.setEnabled(!chkDistribute.isChecked());
+        btnResume.setEnabled(!chkDistribute.isChecked());
         btnRun.setEnabled(true);
         btnRun.setText(QStringLiteral("Run"));
     }
     else {
-        int iRun=QMessageBox::StandardButton::No;
-        llCurrentLinks=this->getLinksFromText(txtLinks.toPlainText());
-        plCurrentProxies=this->getProxiesFromText(txtProxies.toPlainText());
-        slCurrentAgents=this->getUserAgentsFromText(txtAgents.toPlainText());
-        txtLinks.setPlainText(this->getTextFromLinks(llCurrentLinks));
-        txtProxies.setPlainText(this->getTextFromProxies(plCurrentProxies));
-        txtAgents.setPlainText(this->getTextFromUserAgents(slCurrentAgents));
-        if(llCurrentLinks.isEmpty())
+        int              iRun=QMessageBox::StandardButton::No;
+        QString          sInputError=QString();
+        LinkStore        llLinks;
+        ProxyList        plProxies;
+        QStringList      slAgents;
+        ScenarioStepList sslSteps={};
+        if(optUseScenario.isChecked()) {
+            // The steps of the scenario take the place of the links.
+            ScenarioParser::getStepsFromText(
+                txtScenario.toPlainText(),
+                sslSteps,
+                sInputError
+            );
+            llLinks=HitEngine::getLinksFromSteps(sslSteps);
+        }
+        else {
+            llLinks=HitEngine::getLinksFromText(this->getLinksText(),sInputError);
+            // Lines with bad options are left alone, so that they can be fixed.
+            if(sInputError.isEmpty())
+                this->setLinksText(HitEngine::getTextFromLinks(llLinks));
+        }
+        plProxies=HitEngine::getProxiesFromText(txtProxies.toPlainText());
+        slAgents=HitEngine::getUserAgentsFromText(txtAgents.toPlainText());
+        txtProxies.setPlainText(HitEngine::getTextFromProxies(plProxies));
+        txtAgents.setPlainText(HitEngine::getTextFromUserAgents(slAgents));
+        if(!sInputError.isEmpty())
+            QMessageBox::critical(
+                this,
+                QStringLiteral("Error"),
+                sInputError
+            );
+        else if(llLinks.isEmpty())
             QMessageBox::critical(
                 this,
                 QStringLiteral("Error"),
                 QStringLiteral("At least one link is required")
             );
+        else if(optUseBrowser.isChecked()&&
+                QStringLiteral("selector")==cmbCompletion.currentData().toString()&&
+                txtSelector.text().trimmed().isEmpty())
+            QMessageBox::critical(
+                this,
+                QStringLiteral("Error"),
+                QStringLiteral("A selector is required to wait for")
+            );
         else {
             iRun=QMessageBox::StandardButton::Yes;
-            if(plCurrentProxies.isEmpty())
+            if(plProxies.isEmpty())
                 iRun=QMessageBox::warning(
                     this,
                     QStringLiteral("Warning"),
@@ -468,7 +1190,7 @@ void MultiBrowser::runClicked(bool) {
                     QMessageBox::StandardButton::No
                 );
             if(QMessageBox::StandardButton::Yes==iRun)
-                if(slCurrentAgents.isEmpty())
+                if(slAgents.isEmpty())
                     iRun=QMessageBox::warning(
                         this,
                         QStringLiteral("Warning"),
@@ -479,299 +1201,562 @@ void MultiBrowser::runClicked(bool) {
                     );
         }
         if(QMessageBox::StandardButton::Yes==iRun) {
-            bRunning=true;
-            twgLinkStats.clearContents();
-            twgLinkStats.setRowCount(llCurrentLinks.count());
-            for(const auto &l:llCurrentLinks) {
-                QTableWidgetItem *twiItem;
-                twiItem=new QTableWidgetItem(l.urlLink.url());
-                twgLinkStats.setItem(l.uiIndex,LSTC_LINK,twiItem);
-                twiItem=new QTableWidgetItem(QString());
-                twgLinkStats.setItem(l.uiIndex,LSTC_STATUS,twiItem);
-                twiItem=new QTableWidgetItem(QString::number(l.uiHits));
-                twiItem->setTextAlignment(
-                    Qt::AlignmentFlag::AlignRight|Qt::AlignmentFlag::AlignVCenter
-                );
-                twgLinkStats.setItem(l.uiIndex,LSTC_HITS,twiItem);
-                twiItem=new QTableWidgetItem(QString::number(l.uiErrors));
-                twiItem->setTextAlignment(
-                    Qt::AlignmentFlag::AlignRight|Qt::AlignmentFlag::AlignVCenter
+            QString sError;
+            engEngine.setLinks(std::move(llLinks));
+            engEngine.setProxies(plProxies);
+            engEngine.setAgents(slAgents);
+            engEngine.setSteps(sslSteps);
+            engEngine.setMode(
+                optUseBrowser.isChecked()?BrowserWorker::RunMode::RM_WEB_ENGINE:
+                                          BrowserWorker::RunMode::RM_NETWORK
+            );
+            engEngine.setMaxWorkers(spbThreads.value());
+            engEngine.setMaxCooldown(spbCooldown.value());
+            engEngine.setMemoryBudget(spbMemoryBudget.value());
+            engEngine.setCompletion(this->getCompletion(),chkFetchContent.isChecked());
+            engEngine.setNetworkPolicy({
+                uint(spbConnectTimeout.value()),
+                uint(spbFirstByteTimeout.value()),
+                uint(spbTotalTimeout.value()),
+                uint(spbRetries.value()),
+                uint(spbRetryBudget.value()),
+                chkRevalidate.isChecked(),
+                uint(spbColdHits.value()),
+                chkResumeTls.isChecked(),
+                chkRawEngine.isChecked(),
+                uint(spbPipeline.value())
+            });
+            if(chkKeepCache.isChecked()) {
+                QString sFolder=QStandardPaths::writableLocation(
+                    QStandardPaths::StandardLocation::AppDataLocation
                 );
-                twgLinkStats.setItem(l.uiIndex,LSTC_ERRORS,twiItem);
-                twiItem=new QTableWidgetItem(QString());
-                twgLinkStats.setItem(l.uiIndex,LSTC_LAST_ERROR,twiItem);
+                QDir().mkpath(sFolder);
+                engEngine.setCachePath(QStringLiteral("%1/validators.mbv").arg(sFolder));
             }
-            twgProxyStats.clearContents();
-            twgProxyStats.setRowCount(plCurrentProxies.count());
-            for(const auto &p:plCurrentProxies) {
-                QTableWidgetItem *twiItem;
-                twiItem=new QTableWidgetItem(ProxyParser::getTextFromProxy(p.npxProxy));
-                twgProxyStats.setItem(p.uiIndex,PSTC_PROXY,twiItem);
-                twiItem=new QTableWidgetItem(QString::number(p.uiHits));
-                twiItem->setTextAlignment(
-                    Qt::AlignmentFlag::AlignRight|Qt::AlignmentFlag::AlignVCenter
+            else
+                engEngine.setCachePath(QString());
+            // Cold loads use a throwaway profile. Warm ones share a disk cache.
+            if(chkWarmProfile.isChecked()) {
+                QString sFolder=QStringLiteral("%1/profiles").arg(
+                    QStandardPaths::writableLocation(
+                        QStandardPaths::StandardLocation::AppDataLocation
+                    )
                 );
-                twgProxyStats.setItem(p.uiIndex,PSTC_HITS,twiItem);
-                twiItem=new QTableWidgetItem(QString::number(p.uiErrors));
-                twiItem->setTextAlignment(
-                    Qt::AlignmentFlag::AlignRight|Qt::AlignmentFlag::AlignVCenter
+                QDir().mkpath(sFolder);
+                engEngine.setProfilePath(sFolder);
+            }
+            else
+                engEngine.setProfilePath(QString());
+            if(chkResources.isChecked()&&spbHarSampling.value()) {
+                QString sFolder=QStringLiteral("%1/har").arg(
+                    QStandardPaths::writableLocation(
+                        QStandardPaths::StandardLocation::AppDataLocation
+                    )
                 );
-                twgProxyStats.setItem(p.uiIndex,PSTC_ERRORS,twiItem);
+                QDir().mkpath(sFolder);
+                engEngine.setResources(true,spbHarSampling.value(),sFolder);
             }
+            else
+                engEngine.setResources(chkResources.isChecked(),0,QString());
+            // Plans are local: agents schedule their own share at random.
+            if(!chkDistribute.isChecked()) {
+                RunPlan rplPlan=RunPlan();
+                if(orpReplay.has_value())
+                    rplPlan=orpReplay.value();
+                else if(chkPlan.isChecked())
+                    rplPlan=RunPlanner::getPlan(
+                        spbSeed.value(),
+                        spbPlanHits.value(),
+                        spbPlanDuration.value(),
+                        engEngine.getLinks().count(),
+                        plProxies.count(),
+                        slAgents.count(),
+                        spbCooldown.value()
+                    );
+                if(!engEngine.setPlan(rplPlan,sError)) {
+                    QMessageBox::critical(
+                        this,
+                        QStringLiteral("Error"),
+                        sError
+                    );
+                    return;
+                }
+            }
+            engEngine.setFingerprint(
+                Checkpoint::getFingerprint({
+                    this->getLinksText(),
+                    txtProxies.toPlainText(),
+                    txtAgents.toPlainText(),
+                    optUseScenario.isChecked()?txtScenario.toPlainText():QString()
+                })
+            );
+            engEngine.reset();
+            if(ocdResume.has_value())
+                if(!engEngine.applyCheckpoint(ocdResume.value(),sError)) {
+                    QMessageBox::critical(
+                        this,
+                        QStringLiteral("Error"),
+                        sError
+                    );
+                    return;
+                }
+        }
+        if(QMessageBox::StandardButton::Yes==iRun) {
+            lsmLinkStats.reset(sslSteps);
+            twgProxyStats.setRowCount(0);
+            this->addProxyRows(0);
+            // Both the engine's counters and the agents' totals start over ...
+            // ... with the run.
+            vtcThroughput.fill({0,0},engEngine.getProxies().count());
+            etmThroughput.start();
+            if(chkDistribute.isChecked()) {
+                QString    sError;
+                QJsonArray jsaAgents;
+                for(const auto &a:slAgents)
+                    jsaAgents.append(a);
+                // Each agent runs its own share with the same limits.
+                if(!crdAgents.start(
+                    Coordinator::getAddressesFromText(txtRemoteAgents.text()),
+                    txtAgentToken.text(),
+                    {
+                        {
+                            QStringLiteral("mode"),
+                            optUseBrowser.isChecked()?QStringLiteral("browser"):
+                                                      QStringLiteral("network")
+                        },
+                        {QStringLiteral("warmProfile"),chkWarmProfile.isChecked()},
+                        {QStringLiteral("until"),this->getCompletion()},
+                        {QStringLiteral("content"),chkFetchContent.isChecked()},
+                        {QStringLiteral("resources"),chkResources.isChecked()},
+                        {QStringLiteral("har"),spbHarSampling.value()},
+                        {QStringLiteral("workers"),spbThreads.value()},
+                        {QStringLiteral("cooldown"),spbCooldown.value()},
+                        {QStringLiteral("memory"),spbMemoryBudget.value()},
+                        {QStringLiteral("connectTimeout"),spbConnectTimeout.value()},
+                        {QStringLiteral("firstByteTimeout"),spbFirstByteTimeout.value()},
+                        {QStringLiteral("totalTimeout"),spbTotalTimeout.value()},
+                        {QStringLiteral("retries"),spbRetries.value()},
+                        {QStringLiteral("retryBudget"),spbRetryBudget.value()},
+                        {QStringLiteral("revalidate"),chkRevalidate.isChecked()},
+                        {QStringLiteral("coldHits"),spbColdHits.value()},
+                        {QStringLiteral("resumeTls"),chkResumeTls.isChecked()},
+                        {QStringLiteral("rawEngine"),chkRawEngine.isChecked()},
+                        {QStringLiteral("pipeline"),spbPipeline.value()},
+                        {QStringLiteral("agents"),jsaAgents},
+                        {
+                            QStringLiteral("scenario"),
+                            optUseScenario.isChecked()?txtScenario.toPlainText():QString()
+                        }
+                    },
+                    sError)) {
+                    QMessageBox::critical(
+                        this,
+                        QStringLiteral("Error"),
+                        sError
+                    );
+                    return;
+                }
+            }
+            else if(chkCheckpoint.isChecked()) {
+                if(!ocdResume.has_value()) {
+                    QString sFolder=QStandardPaths::writableLocation(
+                        QStandardPaths::StandardLocation::AppDataLocation
+                    );
+                    QDir().mkpath(sFolder);
+                    sCheckpointPath=QStringLiteral("%1/%2.mbc").arg(
+                        sFolder,
+                        QDateTime::currentDateTime().toString(
+                            QStringLiteral("yyyyMMdd-hhmmss")
+                        )
+                    );
+                }
+                engEngine.setCheckpoint(sCheckpointPath,spbCheckpoint.value());
+            }
+            else
+                engEngine.setCheckpoint(QString(),0);
+            // The trace starts over with every run, so it only shows this one.
+            Tracer::beginRun(chkTrace.isChecked()?spbTrace.value():0);
+            bRunning=true;
+            // Plans and scenarios are tied to the lists they started with.
+            btnApply.setEnabled(
+                sslSteps.isEmpty()&&
+                (chkDistribute.isChecked()||(!orpReplay.has_value()&&!chkPlan.isChecked()))
+            );
+            btnReplay.setEnabled(false);
+            btnResume.setEnabled(false);
             btnRun.setText(QStringLiteral("Stop"));
             stbMain.showMessage(QStringLiteral("Running..."));
             tbwMain.setCurrentWidget(&wgtProgress);
-            this->browse();
+            if(!crdAgents.isRunning())
+                engEngine.start();
         }
     }
 }
 
-void MultiBrowser::workerFinished() {
-    BrowserWorker *bwWorker=qobject_cast<BrowserWorker *>(QObject::sender());
-    LinkRecord    *lrCurrentLink=bwWorker->getLinkRecord();
-    ProxyRecord   *prCurrentProxy=bwWorker->getProxyRecord();
-    lrCurrentLink->bBusy=false;
-    for(int iK=0;iK<twgLinkStats.columnCount();iK++)
-        twgLinkStats.item(
-            lrCurrentLink->uiIndex,
-            iK
-        )->setBackground(QBrush(Qt::GlobalColor::white));
-    twgLinkStats.scrollToItem(twgLinkStats.item(lrCurrentLink->uiIndex,0));
-    if(nullptr!=prCurrentProxy) {
-        prCurrentProxy->bBusy=false;
-        for(int iK=0;iK<twgProxyStats.columnCount();iK++)
-            twgProxyStats.item(
-                prCurrentProxy->uiIndex,
-                iK
-            )->setBackground(QBrush(Qt::GlobalColor::white));
-        twgProxyStats.scrollToItem(twgProxyStats.item(prCurrentProxy->uiIndex,0));
+void MultiBrowser::setActive(LinkRecord *lrLink,ProxyRecord *prProxy,bool bActive) {
+    if(nullptr!=lrLink) {
+        lsmLinkStats.setActive(lrLink->uiIndex,bActive);
+        tvwLinkStats.scrollTo(lsmLinkStats.index(lrLink->uiIndex,0));
     }
-    bwWorker->disconnect();
-    bwWorker->deleteLater();
-    uiTotalWorkers--;
-    if(bRunning)
-        this->browse();
-}
-
-void MultiBrowser::workerStarted() {
-    BrowserWorker *bwWorker=qobject_cast<BrowserWorker *>(QObject::sender());
-    LinkRecord    *lrCurrentLink=bwWorker->getLinkRecord();
-    ProxyRecord   *prCurrentProxy=bwWorker->getProxyRecord();
-    lrCurrentLink->bBusy=true;
-    for(int iK=0;iK<twgLinkStats.columnCount();iK++)
-        twgLinkStats.item(
-            lrCurrentLink->uiIndex,
-            iK
-        )->setBackground(QBrush(QColor(COLOR_ACTIVE_LINK)));
-    twgLinkStats.scrollToItem(twgLinkStats.item(lrCurrentLink->uiIndex,0));
-    if(nullptr!=prCurrentProxy) {
-        prCurrentProxy->bBusy=true;
+    if(nullptr!=prProxy) {
         for(int iK=0;iK<twgProxyStats.columnCount();iK++)
             twgProxyStats.item(
-                prCurrentProxy->uiIndex,
+                prProxy->uiIndex,
                 iK
-            )->setBackground(QBrush(QColor(COLOR_ACTIVE_PROXY)));
-        twgProxyStats.scrollToItem(twgProxyStats.item(prCurrentProxy->uiIndex,0));
+            )->setBackground(
+                bActive?QBrush(QColor(COLOR_ACTIVE_PROXY)):QBrush(Qt::GlobalColor::white)
+            );
+        twgProxyStats.scrollToItem(twgProxyStats.item(prProxy->uiIndex,0));
     }
 }
 
-void MultiBrowser::workerStatusChanged(QString sStatus) {
-    BrowserWorker *bwWorker=qobject_cast<BrowserWorker *>(QObject::sender());
-    LinkRecord    *lrCurrentLink=bwWorker->getLinkRecord();
-    ProxyRecord   *prCurrentProxy=bwWorker->getProxyRecord();
-    twgLinkStats.item(lrCurrentLink->uiIndex,LSTC_STATUS)->setText(
-        sStatus
-    );
-    twgLinkStats.item(lrCurrentLink->uiIndex,LSTC_HITS)->setText(
-        QString::number(lrCurrentLink->uiHits)
-    );
-    twgLinkStats.item(lrCurrentLink->uiIndex,LSTC_ERRORS)->setText(
-        QString::number(lrCurrentLink->uiErrors)
-    );
-    twgLinkStats.item(lrCurrentLink->uiIndex,LSTC_LAST_ERROR)->setText(
-        lrCurrentLink->sLastError
-    );
-    if(nullptr!=prCurrentProxy) {
-        twgProxyStats.item(prCurrentProxy->uiIndex,PSTC_HITS)->setText(
-            QString::number(prCurrentProxy->uiHits)
+void MultiBrowser::setLinksText(QString sText) {
+    // Huge lists are never rewritten: their file stays as it is.
+    if(sLinksFile.isEmpty())
+        txtLinks.setPlainText(sText);
+}
+
+void MultiBrowser::agentFailed(QString sError) {
+    // The remaining agents carry on, so this is no reason to stop the run.
+    if(bRunning)
+        stbMain.showMessage(QStringLiteral("Running... (%1)").arg(sError));
+}
+
+void MultiBrowser::applyClicked(bool) {
+    QString sError;
+    if(this->reloadLists(sError))
+        stbMain.showMessage(QStringLiteral("Running... (lists reloaded)"));
+    else
+        QMessageBox::critical(
+            this,
+            QStringLiteral("Error"),
+            sError
         );
-        twgProxyStats.item(prCurrentProxy->uiIndex,PSTC_ERRORS)->setText(
-            QString::number(prCurrentProxy->uiErrors)
+}
+
+void MultiBrowser::compareBaselineClicked(bool) {
+    BaselineData   bldBaseline;
+    BaselineReport brpReport;
+    QString        sError,
+                   sPath=QFileDialog::getOpenFileName(
+                       this,
+                       QStringLiteral("Compare with baseline"),
+                       QStandardPaths::standardLocations(
+                           QStandardPaths::StandardLocation::DocumentsLocation
+                       ).at(0),
+                       QStringLiteral(FILTER_BASELINE_FILES)
+                   );
+    if(sPath.isEmpty())
+        return;
+    if(!Baseline::readFromFile(sPath,bldBaseline,sError)) {
+        QMessageBox::critical(
+            this,
+            QStringLiteral("Error"),
+            sError
         );
+        return;
     }
+    brpReport=Baseline::compare(
+        bldBaseline,
+        Baseline::capture(engEngine.getLinks(),engEngine.getProxies())
+    );
+    // The details can be long, so they go to a file (if wanted) and only ...
+    // ... the verdict is shown here.
+    sPath=QFileDialog::getSaveFileName(
+        this,
+        QStringLiteral("Save comparison report"),
+        QStandardPaths::standardLocations(
+            QStandardPaths::StandardLocation::DocumentsLocation
+        ).at(0),
+        QStringLiteral(FILTER_REPORT_FILES)
+    );
+    if(!sPath.isEmpty())
+        if(!Baseline::writeReportToFile(sPath,brpReport,sError))
+            QMessageBox::critical(
+                this,
+                QStringLiteral("Error"),
+                sError
+            );
+    QMessageBox::information(
+        this,
+        QStringLiteral("Comparison"),
+        QStringLiteral("%1 regression(s), %2 improvement(s).").arg(
+            brpReport.uiRegressions
+        ).arg(
+            brpReport.uiImprovements
+        )
+    );
 }
 
-BrowserWorker::BrowserWorker(QObject     *objParent,
-                             LinkRecord  *lrNewLink,
-                             ProxyRecord *prNewProxy,
-                             QString     sNewAgent):
-QThread(objParent) {
-    uiCooldown=0;
-    sError.clear();
-    lrLink=lrNewLink;
-    prProxy=prNewProxy;
-    sAgent=sNewAgent;
-    rmMode=BrowserWorker::RunMode::RM_NETWORK;
+void MultiBrowser::completionChanged(int) {
+    QString sMode=cmbCompletion.currentData().toString();
+    bool    bBrowser=optUseBrowser.isChecked();
+    spbCompletion.setEnabled(bBrowser&&(QStringLiteral("idle")==sMode||QStringLiteral("time")==sMode));
+    txtSelector.setEnabled(bBrowser&&QStringLiteral("selector")==sMode);
 }
 
-LinkRecord *BrowserWorker::getLinkRecord() {
-    return lrLink;
+void MultiBrowser::cooldownChanged(int) {
+    engEngine.setMaxCooldown(spbCooldown.value());
+    crdAgents.setRate(spbThreads.value(),spbCooldown.value(),spbMemoryBudget.value());
 }
 
-ProxyRecord *BrowserWorker::getProxyRecord() {
-    return prProxy;
+void MultiBrowser::diagnosticsTimeout() {
+    // Refreshing a hidden table would only add to what is being measured.
+    if(&wgtProgress==tbwMain.currentWidget()&&bRunning)
+        this->updateThroughput();
+    else if(&wgtDiagnostics==tbwMain.currentWidget())
+        this->updateDiagnostics();
+    else if(&wgtErrors==tbwMain.currentWidget())
+        this->updateErrorStats();
+    else if(&wgtResources==tbwMain.currentWidget())
+        this->updateResourceStats();
 }
 
-void BrowserWorker::run() {
-    emit statusChanged(QString());
-    if(nullptr!=lrLink) {
-        for(int iK=uiCooldown;iK;iK--) {
-            emit statusChanged(QStringLiteral("Starting in %1s").arg(iK));
-            QThread::sleep(1);
-        }
-        emit statusChanged(QStringLiteral("Browsing..."));
-        if(BrowserWorker::RunMode::RM_NETWORK==rmMode)
-            this->runWithNetwork();
-        else if(BrowserWorker::RunMode::RM_WEB_ENGINE==rmMode)
-            this->runWithWebEngine();
+void MultiBrowser::distributeToggled(bool bChecked) {
+    // Agents keep their counters to themselves, so there's nothing to checkpoint.
+    txtRemoteAgents.setEnabled(bChecked);
+    txtAgentToken.setEnabled(bChecked);
+    chkCheckpoint.setEnabled(!bChecked);
+    spbCheckpoint.setEnabled(!bChecked);
+    chkPlan.setEnabled(!bChecked);
+    if(!bRunning) {
+        btnReplay.setEnabled(!bChecked);
+        btnResume.setEnabled(!bChecked);
     }
-    if(nullptr!=lrLink) {
-        if(sError.isEmpty())
-            lrLink->uiHits++;
-        else {
-            lrLink->uiErrors++;
-            lrLink->sLastError=sError;
-        }
-        lrLink->bBusy=false;
+}
+
+void MultiBrowser::exportPlanClicked(bool) {
+    QString          sError=QString(),
+                     sPath;
+    LinkStore        llLinks;
+    ScenarioStepList sslSteps={};
+    // Parsed just like Run does, so that the plan fits the same lists.
+    if(optUseScenario.isChecked()) {
+        ScenarioParser::getStepsFromText(txtScenario.toPlainText(),sslSteps,sError);
+        llLinks=HitEngine::getLinksFromSteps(sslSteps);
     }
-    if(nullptr!=prProxy) {
-        if(sError.isEmpty())
-            prProxy->uiHits++;
-        else
-            prProxy->uiErrors++;
-        prProxy->bBusy=false;
+    else
+        llLinks=HitEngine::getLinksFromText(this->getLinksText(),sError);
+    if(sError.isEmpty()&&llLinks.isEmpty())
+        sError=QStringLiteral("At least one link is required");
+    if(!sError.isEmpty()) {
+        QMessageBox::critical(
+            this,
+            QStringLiteral("Error"),
+            sError
+        );
+        return;
     }
-    emit statusChanged(QStringLiteral("Idle"));
+    sPath=QFileDialog::getSaveFileName(
+        this,
+        QStringLiteral("Export run plan"),
+        QStandardPaths::standardLocations(
+            QStandardPaths::StandardLocation::DocumentsLocation
+        ).at(0),
+        QStringLiteral(FILTER_PLAN_FILES)
+    );
+    if(!sPath.isEmpty())
+        if(!RunPlanner::writeToFile(
+            sPath,
+            RunPlanner::getPlan(
+                spbSeed.value(),
+                spbPlanHits.value(),
+                spbPlanDuration.value(),
+                llLinks.count(),
+                HitEngine::getProxiesFromText(txtProxies.toPlainText()).count(),
+                HitEngine::getUserAgentsFromText(txtAgents.toPlainText()).count(),
+                spbCooldown.value()
+            ),
+            sError))
+            QMessageBox::critical(
+                this,
+                QStringLiteral("Error"),
+                sError
+            );
 }
 
-void BrowserWorker::runWithWebEngine() {
-    sError.clear();
-    if(nullptr!=lrLink) {
-        QString     sBrowserPath;
-        QStringList slBrowserParams;
-        QProcess    proBrowserApp;
-        sBrowserPath=QStringLiteral("%1/%2").arg(
-            QApplication::applicationDirPath(),
-            QStringLiteral(APP_BROWSER_EXE)
-        );
-        slBrowserParams={lrLink->urlLink.toString()};
-        if(nullptr!=prProxy)
-            slBrowserParams.append({
-                QStringLiteral("-p"),
-                ProxyParser::getTextFromProxy(prProxy->npxProxy)
-            });
-        if(!sAgent.isEmpty())
-            slBrowserParams.append({
-                QStringLiteral("-a"),
-                sAgent
-            });
-        proBrowserApp.start(sBrowserPath,slBrowserParams);
-        proBrowserApp.waitForFinished(-1);
-        if(QProcess::ExitStatus::NormalExit==proBrowserApp.exitStatus()) {
-            QString       sJSON=proBrowserApp.readAll();
-            QJsonDocument jsnDoc=QJsonDocument::fromJson(sJSON.toUtf8());
-            QJsonObject   jsnObj=jsnDoc.isObject()?jsnDoc.object():QJsonObject();
-            if(!proBrowserApp.exitCode())
-                if(jsnObj.contains(QStringLiteral("content")))
-                    this->showCurrentIP(
-                        jsnObj.value(QStringLiteral("content")).toString()
-                    );
-                else
-                    sError=QStringLiteral("Wrong browser response"); // Impossible.
-            else
-                if(jsnObj.contains(QStringLiteral("error")))
-                    sError=jsnObj.value(QStringLiteral("error")).toString();
-                else
-                    sError=QStringLiteral("Wrong browser call"); // Impossible.
-        }
-        else
-            sError=QStringLiteral("Browser crashed"); // Improbable.
-    }
+void MultiBrowser::hitFinished(LinkRecord *lrLink,ProxyRecord *prProxy) {
+    QElapsedTimer etmUpdate;
+    etmUpdate.start();
+    // Sessions report their steps as they go, so they come with no link here.
+    if(nullptr!=lrLink)
+        this->updateLinkStats(lrLink);
+    if(nullptr!=prProxy)
+        this->updateProxyStats(prProxy);
+    this->setActive(lrLink,prProxy,false);
+    Diagnostics::uiUpdated(etmUpdate.nsecsElapsed());
 }
 
-void BrowserWorker::runWithNetwork() {
-    sError.clear();
-    if(nullptr!=lrLink) {
-        uint                  uiStatus;
-        QNetworkAccessManager namManager;
-        QNetworkRequest       nrqRequest;
-        QNetworkReply         *nrpReply;
-        connect(
-            &namManager,
-            &QNetworkAccessManager::sslErrors,
-            [](QNetworkReply *nrpError,const QList<QSslError> &) {
-                nrpError->ignoreSslErrors();
-            }
-        );
-        if(nullptr!=prProxy)
-            namManager.setProxy(prProxy->npxProxy);
-        namManager.setTransferTimeout();
-        nrqRequest.setUrl(lrLink->urlLink);
-        if(!sAgent.isEmpty())
-            nrqRequest.setHeader(
-                QNetworkRequest::KnownHeaders::UserAgentHeader,
-                sAgent
+void MultiBrowser::hitStarted(LinkRecord *lrLink,ProxyRecord *prProxy) {
+    QElapsedTimer etmUpdate;
+    etmUpdate.start();
+    this->setActive(lrLink,prProxy,true);
+    Diagnostics::uiUpdated(etmUpdate.nsecsElapsed());
+}
+
+void MultiBrowser::listFileChanged(QString sPath) {
+    QPlainTextEdit *txtTarget=hshWatched.value(sPath);
+    QFile          fFile(sPath);
+    QString        sError;
+    // Editors often save by replacing the file, which ends the watch.
+    if(QFile::exists(sPath)&&!fswLists.files().contains(sPath))
+        fswLists.addPath(sPath);
+    if(nullptr==txtTarget||!chkFollowFiles.isChecked()||!fFile.open(QFile::OpenModeFlag::ReadOnly))
+        return;
+    // A huge list is read from its file anyway.
+    if(&txtLinks!=txtTarget||sLinksFile!=sPath)
+        txtTarget->setPlainText(fFile.readAll());
+    fFile.close();
+    // No dialogs here: nobody may be watching the window.
+    if(bRunning) {
+        if(this->reloadLists(sError))
+            stbMain.showMessage(
+                QStringLiteral("Running... (%1 reloaded)").arg(QFileInfo(sPath).fileName())
             );
-        nrpReply=namManager.get(nrqRequest);
-        while(!nrpReply->isFinished())
-            QApplication::processEvents();
-        uiStatus=nrpReply->attribute(
-            QNetworkRequest::Attribute::HttpStatusCodeAttribute
-        ).toUInt();
-        if(QNetworkReply::NetworkError::NoError!=nrpReply->error())
-            if(uiStatus)
-                sError=QStringLiteral("Unexpected response code: %1").arg(uiStatus);
-            else
-                sError=nrpReply->errorString();
         else
-            if(uiStatus)
-                this->showCurrentIP(nrpReply->readAll());
-            else
-                sError=QStringLiteral("Response timeout expired");
-        nrpReply->~QNetworkReply();
+            stbMain.showMessage(QStringLiteral("Running... (reload failed: %1)").arg(sError));
     }
 }
 
-void BrowserWorker::showCurrentIP(QString sHTML) {
-    if(nullptr!=lrLink) {
-        // Verifies that the anonymizing part (from proxies and user agents) ...
-        // ... is actually working, by showing the client's name/IP and the ...
-        // ... detected browser in the Debug window. -Only for tests-.
-        // Works for IPChicken only. More sites to come.
-        if(!lrLink->urlLink.host().compare(
-            QStringLiteral("www.ipchicken.com"),
-            Qt::CaseSensitivity::CaseInsensitive
-        )) {
-            QRegularExpression      rxIP;
-            QRegularExpressionMatch rxmIP;
-            rxIP.setPattern(QStringLiteral("Name\\nAddress:\\n(.*) "));
-            rxmIP=rxIP.match(sHTML);
-            if(rxmIP.hasCaptured(1))
-                qDebug() << QStringLiteral("Name/IP: %1").arg(rxmIP.captured(1));
-            QRegularExpression      rxAgent;
-            QRegularExpressionMatch rxmAgent;
-            rxAgent.setPattern(QStringLiteral("Browser:\\n(.*) "));
-            rxmAgent=rxAgent.match(sHTML);
-            if(rxmAgent.hasCaptured(1))
-                qDebug() << QStringLiteral("User-Agent: %1").arg(rxmAgent.captured(1));
-        }
+void MultiBrowser::listsChanged() {
+    // Added records get rows of their own, retired ones keep theirs.
+    lsmLinkStats.addRows();
+    lsmLinkStats.refresh();
+    this->addProxyRows(twgProxyStats.rowCount());
+    vtcThroughput.resize(engEngine.getProxies().count());
+    for(const auto &p:engEngine.getProxies())
+        twgProxyStats.item(p.uiIndex,PSTC_PROXY)->setText(
+            p.bRetired?QStringLiteral("%1 (%2)").arg(
+                ProxyParser::getTextFromProxy(p.npxProxy),
+                QStringLiteral(STATUS_RETIRED).toLower()
+            ):ProxyParser::getTextFromProxy(p.npxProxy)
+        );
+}
+
+void MultiBrowser::planToggled(bool bChecked) {
+    spbSeed.setEnabled(bChecked);
+    spbPlanHits.setEnabled(bChecked);
+    spbPlanDuration.setEnabled(bChecked);
+    btnExportPlan.setEnabled(bChecked);
+}
+
+void MultiBrowser::rawEngineToggled(bool bChecked) {
+    spbPipeline.setEnabled(bChecked&&optUseHTTP.isChecked());
+}
+
+void MultiBrowser::revalidateToggled(bool bChecked) {
+    spbColdHits.setEnabled(bChecked&&optUseHTTP.isChecked());
+    chkKeepCache.setEnabled(bChecked&&optUseHTTP.isChecked());
+}
+
+void MultiBrowser::runFinished() {
+    // The plan ran out of hits (or time): same as hitting Stop.
+    if(bRunning) {
+        this->runClicked(false);
+        stbMain.showMessage(QStringLiteral("Run plan completed"));
     }
 }
 
-void BrowserWorker::setCooldown(uint uiNewCooldown) {
-    uiCooldown=uiNewCooldown;
+void MultiBrowser::saveBaselineClicked(bool) {
+    QString sError,
+            sPath=QFileDialog::getSaveFileName(
+                this,
+                QStringLiteral("Save baseline"),
+                QStandardPaths::standardLocations(
+                    QStandardPaths::StandardLocation::DocumentsLocation
+                ).at(0),
+                QStringLiteral(FILTER_BASELINE_FILES)
+            );
+    // Taken from whatever the tables show, mid-run or after it.
+    if(!sPath.isEmpty())
+        if(!Baseline::writeToFile(
+            sPath,
+            Baseline::capture(engEngine.getLinks(),engEngine.getProxies()),
+            sError))
+            QMessageBox::critical(
+                this,
+                QStringLiteral("Error"),
+                sError
+            );
+}
+
+void MultiBrowser::saveTraceClicked(bool) {
+    QString sError,
+            sPath=QFileDialog::getSaveFileName(
+                this,
+                QStringLiteral("Save trace"),
+                QStandardPaths::standardLocations(
+                    QStandardPaths::StandardLocation::DocumentsLocation
+                ).at(0),
+                QStringLiteral(FILTER_TRACE_FILES)
+            );
+    // Works mid-run too: events still being written are just left out.
+    if(!sPath.isEmpty())
+        if(!Tracer::writeToFile(sPath,sError))
+            QMessageBox::critical(
+                this,
+                QStringLiteral("Error"),
+                sError
+            );
 }
 
-void BrowserWorker::setMode(RunMode rmNewMode) {
-    rmMode=rmNewMode;
+void MultiBrowser::statusChanged(LinkRecord *lrLink,ProxyRecord *prProxy,QString sStatus) {
+    QElapsedTimer etmUpdate;
+    etmUpdate.start();
+    lsmLinkStats.setStatus(lrLink->uiIndex,sStatus);
+    this->updateLinkStats(lrLink);
+    if(nullptr!=prProxy)
+        this->updateProxyStats(prProxy);
+    Diagnostics::uiUpdated(etmUpdate.nsecsElapsed());
+}
+
+void MultiBrowser::threadsChanged(int) {
+    // Takes effect on the running engine (or agents) right away.
+    engEngine.setMaxWorkers(spbThreads.value());
+    crdAgents.setRate(spbThreads.value(),spbCooldown.value(),spbMemoryBudget.value());
+}
+
+void MultiBrowser::traceToggled(bool bChecked) {
+    // Takes effect on the running engine right away, like the limits.
+    Tracer::setSampling(bChecked?spbTrace.value():0);
+}
+
+void MultiBrowser::useModeToggled(bool) {
+    // Only the browser helpers need a thread each. HTTP hits and ...
+    // ... sessions are asynchronous, so way more of them can run at once.
+    if(optUseBrowser.isChecked()) {
+        lblThreads.setText(QStringLiteral("Max. threads:"));
+        spbThreads.setMaximum(MAX_THREADS);
+    }
+    else {
+        lblThreads.setText(
+            optUseScenario.isChecked()?QStringLiteral("Max. sessions:"):
+                                       QStringLiteral("Max. in flight:")
+        );
+        spbThreads.setMaximum(MAX_IN_FLIGHT);
+    }
+    // Page completion is up to the browser helpers alone.
+    for(const auto &w:std::initializer_list<QWidget *>{
+        &chkWarmProfile,
+        &lblCompletion,
+        &cmbCompletion,
+        &chkFetchContent,
+        &chkResources,
+        &spbHarSampling
+    })
+        w->setEnabled(optUseBrowser.isChecked());
+    this->completionChanged(cmbCompletion.currentIndex());
+    // Deadlines and retries are only enforced on plain HTTP hits.
+    for(const auto &w:std::initializer_list<QWidget *>{
+        &spbConnectTimeout,
+        &spbFirstByteTimeout,
+        &spbTotalTimeout,
+        &spbRetries,
+        &spbRetryBudget,
+        &chkRevalidate,
+        &chkRawEngine
+    })
+        w->setEnabled(optUseHTTP.isChecked());
+    this->revalidateToggled(chkRevalidate.isChecked());
+    this->rawEngineToggled(chkRawEngine.isChecked());
 }
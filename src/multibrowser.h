@@ -6,29 +6,12 @@
 #include <QtNetwork>
 #include <QMainWindow>
 #include <QApplication>
-#include "agentparser.h"
-#include "proxyparser.h"
-
-using LinkRecord=struct {
-    QUrl    urlLink;
-    bool    bBusy;
-    uint    uiIndex,
-            uiHits,
-            uiErrors;
-    QString sLastError;
-};
-
-using LinkList=QVector<LinkRecord>;
-
-using ProxyRecord=struct {
-    QNetworkProxy npxProxy;
-    bool          bBusy;
-    uint          uiIndex,
-                  uiHits,
-                  uiErrors;
-};
-
-using ProxyList=QVector<ProxyRecord>;
+#include <optional>
+#include "baseline.h"
+#include "coordinator.h"
+#include "hitengine.h"
+#include "linkstatsmodel.h"
+#include "metricsserver.h"
 
 class MultiBrowser:public QMainWindow {
     Q_OBJECT
@@ -36,28 +19,68 @@ public:
     MultiBrowser(QWidget * =nullptr);
     ~MultiBrowser();
 private:
-    void        browse();
-    LinkList    getLinksFromText(QString);
-    ProxyList   getProxiesFromText(QString);
-    QStringList getUserAgentsFromText(QString);
-    QString     getTextFileContents(QString);
-    QString     getTextFromLinks(LinkList);
-    QString     getTextFromProxies(ProxyList);
-    QString     getTextFromUserAgents(QStringList);
+    void    addProxyRows(int);
+    QString getCompletion();
+    QString getLinksText();
+    QString getTextFileContents(QString,QString=QString(),QPlainTextEdit * =nullptr);
+    bool    reloadLists(QString &);
+    void    setActive(LinkRecord *,ProxyRecord *,bool);
+    void    setLinksText(QString);
+    void    updateDiagnostics();
+    void    updateErrorStats();
+    void    updateLinkStats(LinkRecord *);
+    void    updateProxyStats(ProxyRecord *);
+    void    updateResourceStats();
+    void    updateThroughput();
 private slots:
+    void agentFailed(QString);
+    void applyClicked(bool);
+    void checkpointWritten(QString);
+    void compareBaselineClicked(bool);
+    void completionChanged(int);
+    void cooldownChanged(int);
+    void diagnosticsTimeout();
+    void distributeToggled(bool);
+    void exportPlanClicked(bool);
+    void hitFinished(LinkRecord *,ProxyRecord *);
+    void hitStarted(LinkRecord *,ProxyRecord *);
+    void listFileChanged(QString);
+    void listsChanged();
     void loadLinksClicked(bool);
     void loadProxiesClicked(bool);
+    void loadScenarioClicked(bool);
     void loadUserAgentsClicked(bool);
+    void memoryBudgetChanged(int);
+    void metricsListenFailed(QString);
+    void metricsToggled(bool);
+    void planToggled(bool);
+    void rawEngineToggled(bool);
+    void replayClicked(bool);
+    void resumeClicked(bool);
+    void revalidateToggled(bool);
     void runClicked(bool);
-    void workerFinished();
-    void workerStarted();
-    void workerStatusChanged(QString);
+    void runFinished();
+    void saveBaselineClicked(bool);
+    void saveTraceClicked(bool);
+    void statusChanged(LinkRecord *,ProxyRecord *,QString);
+    void threadsChanged(int);
+    void traceToggled(bool);
+    void useModeToggled(bool);
 private:
-    bool           bRunning;
-    uint           uiTotalWorkers;
-    LinkList       llCurrentLinks;
-    ProxyList      plCurrentProxies;
-    QStringList    slCurrentAgents;
+    bool                            bRunning;
+    QString                         sCheckpointPath,
+                                    sLinksFile;
+    HitEngine                       engEngine;
+    Coordinator                     crdAgents;
+    LinkStatsModel                  lsmLinkStats;
+    MetricsServer                   *msvMetrics;
+    std::optional<CheckpointData>   ocdResume;
+    std::optional<RunPlan>          orpReplay;
+    QTimer                          tmrDiagnostics;
+    QElapsedTimer                   etmThroughput;
+    QVector<TrafficCounts>          vtcThroughput;
+    QFileSystemWatcher              fswLists;
+    QHash<QString,QPlainTextEdit *> hshWatched;
     // UI widgets go here:
     QWidget        wgtMain;
         QVBoxLayout    vblMain;
@@ -79,6 +102,11 @@ private:
                                 QLabel         lblAgents;
                                 QPushButton    btnLoadAgents;
                             QPlainTextEdit txtAgents;
+                        QVBoxLayout    vblScenario;
+                            QHBoxLayout    hblScenario;
+                                QLabel         lblScenario;
+                                QPushButton    btnLoadScenario;
+                            QPlainTextEdit txtScenario;
                         QHBoxLayout    hblOptions;
                             QHBoxLayout    hblOptionThreads;
                                 QLabel         lblThreads;
@@ -86,47 +114,92 @@ private:
                             QHBoxLayout    hblOptionCooldown;
                                 QLabel         lblCooldown;
                                 QSpinBox       spbCooldown;
+                            QHBoxLayout    hblOptionMemory;
+                                QLabel         lblMemoryBudget;
+                                QSpinBox       spbMemoryBudget;
                             QHBoxLayout    hblOptionUse;
                                 QRadioButton   optUseBrowser;
+                                QCheckBox      chkWarmProfile;
                                 QRadioButton   optUseHTTP;
+                                QRadioButton   optUseScenario;
+                        QHBoxLayout    hblMonitoring;
+                            QHBoxLayout    hblOptionCheckpoint;
+                                QCheckBox      chkCheckpoint;
+                                QSpinBox       spbCheckpoint;
+                            QHBoxLayout    hblOptionMetrics;
+                                QCheckBox      chkMetrics;
+                                QSpinBox       spbMetrics;
+                            QHBoxLayout    hblOptionTrace;
+                                QCheckBox      chkTrace;
+                                QSpinBox       spbTrace;
+                                QPushButton    btnSaveTrace;
+                        QHBoxLayout    hblNetwork;
+                            QHBoxLayout    hblOptionTimeouts;
+                                QLabel         lblConnectTimeout;
+                                QSpinBox       spbConnectTimeout;
+                                QLabel         lblFirstByteTimeout;
+                                QSpinBox       spbFirstByteTimeout;
+                                QLabel         lblTotalTimeout;
+                                QSpinBox       spbTotalTimeout;
+                            QHBoxLayout    hblOptionRetries;
+                                QLabel         lblRetries;
+                                QSpinBox       spbRetries;
+                                QLabel         lblRetryBudget;
+                                QSpinBox       spbRetryBudget;
+                            QCheckBox      chkResumeTls;
+                        QHBoxLayout    hblPage;
+                            QLabel         lblCompletion;
+                            QComboBox      cmbCompletion;
+                            QSpinBox       spbCompletion;
+                            QLineEdit      txtSelector;
+                            QCheckBox      chkFetchContent;
+                            QCheckBox      chkResources;
+                            QSpinBox       spbHarSampling;
+                        QHBoxLayout    hblCache;
+                            QCheckBox      chkRevalidate;
+                            QSpinBox       spbColdHits;
+                            QCheckBox      chkKeepCache;
+                        QHBoxLayout    hblEngine;
+                            QCheckBox      chkRawEngine;
+                            QSpinBox       spbPipeline;
+                        QHBoxLayout    hblPlan;
+                            QCheckBox      chkPlan;
+                            QSpinBox       spbSeed;
+                            QLabel         lblPlanHits;
+                            QSpinBox       spbPlanHits;
+                            QLabel         lblPlanDuration;
+                            QSpinBox       spbPlanDuration;
+                            QPushButton    btnExportPlan;
+                        QHBoxLayout    hblDistribute;
+                            QCheckBox      chkDistribute;
+                            QLineEdit      txtRemoteAgents,
+                                           txtAgentToken;
                 QWidget        wgtProgress;
                     QVBoxLayout    vblProgress;
                         QVBoxLayout    vblLinkStats;
                             QLabel         lblLinkStats;
-                            QTableWidget   twgLinkStats;
+                            QTableView     tvwLinkStats;
                         QVBoxLayout    vblProxyStats;
                             QLabel         lblProxyStats;
                             QTableWidget   twgProxyStats;
+                QWidget        wgtErrors;
+                    QVBoxLayout    vblErrors;
+                        QTableWidget   twgErrors;
+                QWidget        wgtResources;
+                    QVBoxLayout    vblResources;
+                        QTableWidget   twgResources;
+                QWidget        wgtDiagnostics;
+                    QVBoxLayout    vblDiagnostics;
+                        QTableWidget   twgDiagnostics;
             QHBoxLayout    hblRun;
+                QPushButton    btnSaveBaseline;
+                QPushButton    btnCompareBaseline;
+                QCheckBox      chkFollowFiles;
+                QPushButton    btnApply;
+                QPushButton    btnReplay;
+                QPushButton    btnResume;
                 QPushButton    btnRun;
     QStatusBar     stbMain;
 };
 
-class BrowserWorker:public QThread {
-    Q_OBJECT
-public:
-    using RunMode=enum {
-        RM_WEB_ENGINE,
-        RM_NETWORK
-    };
-    BrowserWorker(QObject * =nullptr,LinkRecord * =nullptr,ProxyRecord * =nullptr,QString=QString());
-    LinkRecord  *getLinkRecord();
-    ProxyRecord *getProxyRecord();
-    void        run() override;
-    void        setCooldown(uint);
-    void        setMode(RunMode);
-signals:
-    void statusChanged(QString);
-private:
-    uint        uiCooldown;
-    QString     sError,
-                sAgent;
-    LinkRecord  *lrLink;
-    ProxyRecord *prProxy;
-    RunMode     rmMode;
-    void runWithWebEngine();
-    void runWithNetwork();
-    void showCurrentIP(QString);
-};
-
 #endif // MULTIBROWSER_H
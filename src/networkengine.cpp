@@ -0,0 +1,1197 @@
+#include "networkengine.h"
+
+#define READ_CHUNK_SIZE 16384
+
+// What Qt adds to every request on its own (Connection, Accept-Encoding, ...
+// ... Accept-Language, a default User-Agent), roughly, in bytes.
+#define QT_HEADERS_SIZE 96
+
+// The status line of a response, roughly, as Qt doesn't expose it.
+#define STATUS_LINE_SIZE 17
+
+// Room kept for the raw requests, so most of them are built without ...
+// ... growing their buffer.
+#define REQUEST_RESERVE 512
+
+// Retries wait a random time, up to an exponentially growing bound (in ms).
+#define RETRY_BACKOFF_BASE 100
+#define RETRY_BACKOFF_MAX  10000
+
+// Retries always allowed on top of the budget, so a run failing from its ...
+// ... very first hits still gets a chance to recover.
+#define RETRY_BUDGET_RESERVE 10
+
+#if defined(Q_OS_WIN)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(Q_OS_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+RawConnection::RawConnection(NetworkLoop         *nlpNewOwner,
+                             const QUrl          &urlLink,
+                             int                 iNewProxy,
+                             const QNetworkProxy &npxProxy):
+QObject(nlpNewOwner) {
+    bClosing=false;
+    bEncrypted=false;
+    bHeadReported=false;
+    bKeepAlive=true;
+    bReady=false;
+    bReused=false;
+    bTicketOffered=false;
+    bTicketStored=false;
+    iProxy=iNewProxy;
+    nlpOwner=nlpNewOwner;
+    urlTarget=urlLink;
+    bytKey=RawConnection::makeKey(urlLink,iProxy);
+    bytOutgoing.reserve(REQUEST_RESERVE);
+    sslSocket=new QSslSocket(this);
+    // Qt's own socket layer tunnels through HTTP (CONNECT) and SOCKS5 proxies.
+    if(iProxy>=0)
+        sslSocket->setProxy(npxProxy);
+    sslSocket->setPeerVerifyMode(QSslSocket::PeerVerifyMode::VerifyNone);
+    // A limited proxy's responses wait in the kernel, not in a growing ...
+    // ... buffer, so the server feels the throttling too.
+    if(Bandwidth::isLimited(iProxy))
+        sslSocket->setReadBufferSize(READ_CHUNK_SIZE);
+    tmrThrottle.setSingleShot(true);
+    connect(
+        &tmrThrottle,
+        &QTimer::timeout,
+        this,
+        &RawConnection::socketReadyRead
+    );
+    connect(
+        sslSocket,
+        &QSslSocket::connected,
+        this,
+        &RawConnection::socketConnected
+    );
+    connect(
+        sslSocket,
+        &QSslSocket::disconnected,
+        this,
+        &RawConnection::socketDisconnected
+    );
+    connect(
+        sslSocket,
+        &QSslSocket::encrypted,
+        this,
+        &RawConnection::socketEncrypted
+    );
+    connect(
+        sslSocket,
+        &QSslSocket::errorOccurred,
+        this,
+        &RawConnection::socketErrorOccurred
+    );
+    connect(
+        sslSocket,
+        &QSslSocket::readyRead,
+        this,
+        &RawConnection::socketReadyRead
+    );
+}
+
+void RawConnection::abort(QString sError,ErrorCode ecError) {
+    this->close(sError,ecError);
+}
+
+bool RawConnection::canSend(uint uiDepth) {
+    // Requests are only pipelined over connections that already kept a ...
+    // ... response alive, as the others may not even speak HTTP/1.1.
+    return !bClosing&&bKeepAlive&&(dqPending.empty()||(bReused&&dqPending.size()<uiDepth));
+}
+
+QByteArray RawConnection::getKey() {
+    return bytKey;
+}
+
+int RawConnection::getPending() {
+    return int(dqPending.size());
+}
+
+void RawConnection::open() {
+    if(QStringLiteral("https")==urlTarget.scheme()) {
+        QSslConfiguration sslConfiguration=sslSocket->sslConfiguration();
+        bTicketOffered=TlsSessionCache::prepare(sslConfiguration,urlTarget,iProxy);
+        sslSocket->setSslConfiguration(sslConfiguration);
+        sslSocket->connectToHostEncrypted(urlTarget.host(),quint16(urlTarget.port(443)));
+    }
+    else
+        sslSocket->connectToHost(urlTarget.host(),quint16(urlTarget.port(80)));
+}
+
+void RawConnection::send(quint64 uiId,const QByteArray &bytRequest) {
+    dqPending.push_back(uiId);
+    if(bReady) {
+        nlpOwner->rawConnected(uiId,TlsSessionCache::Handshake::HS_NONE);
+        sslSocket->write(bytRequest);
+    }
+    else
+        bytOutgoing.append(bytRequest);
+}
+
+QByteArray RawConnection::makeKey(const QUrl &urlLink,int iProxy) {
+    // Connections are only shared by the hits to the same origin, through ...
+    // ... the same proxy.
+    return QStringLiteral("%1://%2:%3|%4").arg(
+        urlLink.scheme(),
+        urlLink.host()
+    ).arg(
+        urlLink.port(QStringLiteral("https")==urlLink.scheme()?443:80)
+    ).arg(
+        iProxy
+    ).toUtf8();
+}
+
+void RawConnection::close(QString sError,ErrorCode ecError) {
+    RawResponse         rrsResponse={false,false,0,QByteArray(),QByteArray(),sError,ecError};
+    std::deque<quint64> dqReturned;
+    bool                bFront=true;
+    // Torn down once, whatever the socket reports while going.
+    if(bClosing)
+        return;
+    bClosing=true;
+    tmrThrottle.stop();
+    this->storeTicket();
+    sslSocket->abort();
+    dqReturned.swap(dqPending);
+    for(auto &i:dqReturned) {
+        // A kept-alive connection dropped before answering is no fault of ...
+        // ... the hit waiting on it, nor of the ones pipelined behind: ...
+        // ... they're all worth sending again.
+        rrsResponse.bReplayable=!bFront||(bReused&&!hppParser.isStarted());
+        rrsResponse.uiStatus=bFront?hppParser.getStatus():0;
+        bFront=false;
+        nlpOwner->rawFinished(i,rrsResponse);
+    }
+    nlpOwner->rawClosed(this);
+}
+
+bool RawConnection::consume(const char *szData,int iSize) {
+    const char *szBody;
+    int        iBody,
+               iUsed=0;
+    while(iUsed<iSize) {
+        quint64 uiId;
+        int     iFed;
+        if(dqPending.empty()) {
+            this->close(QStringLiteral("Unsolicited response data"),ErrorCode::EC_CONNECTION);
+            return false;
+        }
+        uiId=dqPending.front();
+        iFed=hppParser.feed(szData+iUsed,iSize-iUsed,szBody,iBody);
+        iUsed+=iFed;
+        nlpOwner->rawTransferred(uiId,0,quint64(iFed));
+        if(hppParser.hasFailed()) {
+            this->close(QStringLiteral("Malformed HTTP response"),ErrorCode::EC_OTHER);
+            return false;
+        }
+        // Rejected responses can't be skipped reliably, so their connection goes.
+        if(hppParser.isHeadComplete()&&!bHeadReported) {
+            bHeadReported=true;
+            if(!nlpOwner->rawHead(uiId,hppParser.getStatus())) {
+                this->close(QStringLiteral("Response rejected"),ErrorCode::EC_ASSERTION);
+                return false;
+            }
+        }
+        if(iBody&&!nlpOwner->rawBody(uiId,szBody,iBody)) {
+            this->close(QStringLiteral("Response rejected"),ErrorCode::EC_ASSERTION);
+            return false;
+        }
+        if(hppParser.isComplete()) {
+            this->finishFront();
+            if(bClosing)
+                return false;
+        }
+    }
+    return true;
+}
+
+void RawConnection::finishFront() {
+    quint64     uiId=dqPending.front();
+    RawResponse rrsResponse={
+        true,
+        false,
+        hppParser.getStatus(),
+        hppParser.getETag(),
+        hppParser.getLastModified(),
+        QString(),
+        ErrorCode::EC_OTHER
+    };
+    dqPending.pop_front();
+    bReused=true;
+    bKeepAlive=hppParser.isKeepAlive();
+    bHeadReported=false;
+    hppParser.reset();
+    this->storeTicket();
+    nlpOwner->rawFinished(uiId,rrsResponse);
+    // Whatever was pipelined behind a last response is sent elsewhere.
+    if(!bKeepAlive)
+        this->close(QStringLiteral("Connection closed by the server"),ErrorCode::EC_CONNECTION);
+}
+
+void RawConnection::markReady(TlsSessionCache::Handshake hsHandshake) {
+    bReady=true;
+    sslSocket->setSocketOption(QAbstractSocket::SocketOption::LowDelayOption,1);
+    // Only the hits that waited for the connection went through its handshake.
+    for(auto &i:dqPending)
+        nlpOwner->rawConnected(i,hsHandshake);
+    sslSocket->write(bytOutgoing);
+    bytOutgoing.resize(0);
+}
+
+void RawConnection::storeTicket() {
+    // Once per connection, after its first response: by then, TLS 1.3 ...
+    // ... servers have sent their tickets.
+    if(bEncrypted&&!bTicketStored) {
+        bTicketStored=true;
+        TlsSessionCache::finish(sslSocket->sslConfiguration(),urlTarget,iProxy,bTicketOffered);
+    }
+}
+
+void RawConnection::socketConnected() {
+    // Encrypted connections are only ready once negotiated.
+    if(!bClosing&&QStringLiteral("https")!=urlTarget.scheme())
+        this->markReady(TlsSessionCache::Handshake::HS_NONE);
+}
+
+void RawConnection::socketDisconnected() {
+    if(bClosing)
+        return;
+    // Whatever is left is read at once, throttled or not: the connection ...
+    // ... is gone anyway.
+    this->readSocket(true);
+    if(bClosing)
+        return;
+    // Bodies with no length end right here.
+    hppParser.finishOnClose();
+    if(!dqPending.empty()&&hppParser.isComplete())
+        this->finishFront();
+    this->close(QStringLiteral("Connection closed by the server"),ErrorCode::EC_CONNECTION);
+}
+
+void RawConnection::socketEncrypted() {
+    if(!bClosing) {
+        bEncrypted=true;
+        this->markReady(bTicketOffered?TlsSessionCache::Handshake::HS_TICKET_OFFERED:TlsSessionCache::Handshake::HS_FULL);
+    }
+}
+
+void RawConnection::socketErrorOccurred(QAbstractSocket::SocketError sckError) {
+    // The end of the connection is left to socketDisconnected, which ...
+    // ... still has a body to finish, maybe.
+    if(!bClosing&&QAbstractSocket::SocketError::RemoteHostClosedError!=sckError)
+        this->close(sslSocket->errorString(),ErrorTaxonomy::fromSocketError(sckError));
+}
+
+void RawConnection::readSocket(bool bDrain) {
+    char   chrChunk[READ_CHUNK_SIZE];
+    qint64 iGranted,
+           iRead;
+    // Parsed in place, straight from the stack: nothing is buffered.
+    while(!bClosing&&sslSocket->bytesAvailable()>0) {
+        iGranted=bDrain?READ_CHUNK_SIZE:Bandwidth::acquire(
+            iProxy,
+            qMin<qint64>(READ_CHUNK_SIZE,sslSocket->bytesAvailable())
+        );
+        // Out of tokens: the rest is read once the proxy's bucket refills.
+        if(!iGranted) {
+            if(!tmrThrottle.isActive())
+                tmrThrottle.start(Bandwidth::getWait(iProxy));
+            return;
+        }
+        if((iRead=sslSocket->read(chrChunk,iGranted))<=0)
+            return;
+        Bandwidth::received(iProxy,iRead);
+        if(!this->consume(chrChunk,int(iRead)))
+            return;
+    }
+}
+
+void RawConnection::socketReadyRead() {
+    this->readSocket(false);
+}
+
+bool WorkDeque::popFront(NetworkHit &nhtHit) {
+    QMutexLocker mlkHits(&mtxHits);
+    if(dqHits.empty())
+        return false;
+    nhtHit=dqHits.front();
+    dqHits.pop_front();
+    return true;
+}
+
+void WorkDeque::pushBack(const NetworkHit &nhtHit) {
+    QMutexLocker mlkHits(&mtxHits);
+    dqHits.push_back(nhtHit);
+}
+
+bool WorkDeque::stealBack(NetworkHit &nhtHit) {
+    QMutexLocker mlkHits(&mtxHits);
+    // Thieves take from the opposite end, so the owner keeps its FIFO order.
+    if(dqHits.empty())
+        return false;
+    nhtHit=dqHits.back();
+    dqHits.pop_back();
+    return true;
+}
+
+NetworkLoop::NetworkLoop(NetworkEngine *nenNewOwner,int iNewIndex):
+QObject(nullptr) {
+    bAborted=false;
+    iIndex=iNewIndex;
+    iInFlight=0;
+    uiNextRawId=0;
+    nenOwner=nenNewOwner;
+    tmrThrottle=nullptr;
+}
+
+void NetworkLoop::armDeadline(NetworkRequest &nrqPending) {
+    const NetworkPolicy &npcPolicy=nenOwner->getPolicy();
+    qint64              iNext=-1;
+    // Phases are timed from the start of the attempt, so the timer is just ...
+    // ... aimed at the earliest deadline still pending.
+    for(uint uiTimeout:{
+        nrqPending.bConnected?0:npcPolicy.uiConnectTimeout,
+        nrqPending.bFirstByte?0:npcPolicy.uiFirstByteTimeout,
+        npcPolicy.uiTotalTimeout
+    })
+        if(uiTimeout&&(iNext<0||uiTimeout<iNext))
+            iNext=uiTimeout;
+    if(iNext<0)
+        nrqPending.tmrDeadline->stop();
+    else
+        nrqPending.tmrDeadline->start(int(qMax<qint64>(0,iNext-nrqPending.etmAttempt.elapsed())));
+}
+
+void NetworkLoop::completeHit(NetworkRequest &nrqPending,NetworkResult &nrsResult,uint uiStatus) {
+    if(nrqPending.amtMatcher.hasFailed()) {
+        nrsResult.bFailed=true;
+        nrsResult.sError=nrqPending.amtMatcher.getFailure();
+        nrsResult.ecError=ErrorCode::EC_ASSERTION;
+    }
+    nrsResult.uiBytes=nrqPending.amtMatcher.getSize();
+    // Retries carry the traffic of the attempts before them.
+    nrsResult.nhtHit.tcTraffic=nrqPending.nhtHit.tcTraffic;
+    // Only transient trouble is worth another go: timeouts, broken ...
+    // ... connections and overloaded servers, never a failed assertion.
+    if(!nrsResult.bCancelled&&!nrsResult.bFailed&&!nrsResult.sError.isEmpty()&&
+       (!nrqPending.sTimeout.isEmpty()||!uiStatus||429==uiStatus||(uiStatus>=502&&uiStatus<=504))&&
+       this->retryHit(nrsResult))
+        return;
+    this->finishHit(nrsResult);
+}
+
+void NetworkLoop::dispatchRaw(quint64 uiId,const NetworkRequest &nrqPending) {
+    QByteArray               bytKey=RawConnection::makeKey(nrqPending.nhtHit.urlLink,nrqPending.nhtHit.iProxy);
+    QVector<RawConnection *> &vrcPool=hshRawPool[bytKey];
+    RawConnection            *rcCarrier=nullptr;
+    uint                     uiDepth=qMax(1u,nenOwner->getPolicy().uiPipelineDepth);
+    // Replays go out again, so they're counted again.
+    this->rawTransferred(uiId,quint64(nrqPending.bytRawRequest.size()),0);
+    Bandwidth::sent(
+        nrqPending.nhtHit.iProxy,
+        nrqPending.bytRawRequest.size()
+    );
+    // Idle connections first, then the shortest pipelines, and only then ...
+    // ... a new connection.
+    for(auto &c:vrcPool)
+        if(c->canSend(uiDepth)&&(nullptr==rcCarrier||c->getPending()<rcCarrier->getPending()))
+            rcCarrier=c;
+    if(nullptr!=rcCarrier) {
+        hshRawCarriers.insert(uiId,rcCarrier);
+        rcCarrier->send(uiId,nrqPending.bytRawRequest);
+    }
+    else {
+        rcCarrier=new RawConnection(
+            this,
+            nrqPending.nhtHit.urlLink,
+            nrqPending.nhtHit.iProxy,
+            nrqPending.nhtHit.npxProxy
+        );
+        vrcPool.append(rcCarrier);
+        hshRawCarriers.insert(uiId,rcCarrier);
+        // Opened last, as a connection failing right away closes (and ...
+        // ... leaves the pool) on the spot.
+        rcCarrier->send(uiId,nrqPending.bytRawRequest);
+        rcCarrier->open();
+    }
+}
+
+void NetworkLoop::finishHit(const NetworkResult &nrsResult) {
+    // Interrupted hits are neither successes nor failures.
+    Metrics::hitFinished(
+        nrsResult.bCancelled?Metrics::HitResult::HR_CANCEL:
+        nrsResult.bFailed?Metrics::HitResult::HR_FAILURE:
+        nrsResult.bNotModified?Metrics::HitResult::HR_REVALIDATED:
+        nrsResult.sError.isEmpty()?Metrics::HitResult::HR_HIT:
+                                   Metrics::HitResult::HR_ERROR,
+        nrsResult.nhtHit.iProxy,
+        nrsResult.uiBytes,
+        nrsResult.iLatency
+    );
+    if(nrsResult.bNotModified)
+        Metrics::bytesSaved(nrsResult.uiSavedBytes);
+    iInFlight--;
+    Diagnostics::eventQueued();
+    emit hitFinished(nrsResult);
+    this->pump();
+}
+
+int NetworkLoop::getInFlight() {
+    return iInFlight;
+}
+
+QNetworkAccessManager *NetworkLoop::getManager(int iProxy,const QNetworkProxy &npxProxy) {
+    QNetworkAccessManager *namManager=hshManagers.value(iProxy);
+    // One manager per proxy, so every proxy keeps its own connection pool. ...
+    // ... Keyed by index, as a reload may move the records.
+    if(nullptr==namManager) {
+        namManager=new QNetworkAccessManager(this);
+        connect(
+            namManager,
+            &QNetworkAccessManager::sslErrors,
+            [](QNetworkReply *nrpError,const QList<QSslError> &) {
+                nrpError->ignoreSslErrors();
+            }
+        );
+        if(iProxy>=0)
+            namManager->setProxy(npxProxy);
+        // Kept as a last resort, for stalls that no deadline covers.
+        namManager->setTransferTimeout();
+        hshManagers.insert(iProxy,namManager);
+    }
+    return namManager;
+}
+
+bool NetworkLoop::readReply(QNetworkReply *nrpReply,NetworkRequest &nrqPending,bool bDrain) {
+    char   chrChunk[READ_CHUNK_SIZE];
+    qint64 iGranted,
+           iRead;
+    int    iProxy=nrqPending.nhtHit.iProxy;
+    uint   uiStatus=nrpReply->attribute(QNetworkRequest::Attribute::HttpStatusCodeAttribute).toUInt();
+    // A 304 stands for the body that passed the assertions when cached.
+    if(nrqPending.bRevalidating&&304==uiStatus)
+        return true;
+    // The response is checked as it arrives, and never kept as a whole.
+    if(!nrqPending.amtMatcher.checkStatus(uiStatus))
+        return false;
+    while(nrpReply->bytesAvailable()>0) {
+        iGranted=bDrain?READ_CHUNK_SIZE:Bandwidth::acquire(
+            iProxy,
+            qMin<qint64>(READ_CHUNK_SIZE,nrpReply->bytesAvailable())
+        );
+        // Out of tokens: the rest is read once the proxy's bucket refills.
+        if(!iGranted) {
+            this->throttleReply(nrpReply,iProxy);
+            break;
+        }
+        if((iRead=nrpReply->read(chrChunk,iGranted))<=0)
+            break;
+        nrqPending.nhtHit.tcTraffic.uiReceived+=quint64(iRead);
+        Bandwidth::received(iProxy,iRead);
+        if(!nrqPending.amtMatcher.feed(chrChunk,iRead))
+            return false;
+    }
+    return true;
+}
+
+WorkDeque &NetworkLoop::getQueue() {
+    return wdqHits;
+}
+
+bool NetworkLoop::isPastDeadline(NetworkRequest &nrqPending) {
+    const NetworkPolicy &npcPolicy=nenOwner->getPolicy();
+    qint64              iElapsed=nrqPending.etmAttempt.elapsed();
+    if(!nrqPending.bConnected&&npcPolicy.uiConnectTimeout&&iElapsed>=npcPolicy.uiConnectTimeout)
+        nrqPending.sTimeout=QStringLiteral("Connect timeout expired");
+    else if(!nrqPending.bFirstByte&&npcPolicy.uiFirstByteTimeout&&iElapsed>=npcPolicy.uiFirstByteTimeout)
+        nrqPending.sTimeout=QStringLiteral("First byte timeout expired");
+    else if(npcPolicy.uiTotalTimeout&&iElapsed>=npcPolicy.uiTotalTimeout)
+        nrqPending.sTimeout=QStringLiteral("Total timeout expired");
+    else {
+        // Fired a bit early: just aims again.
+        this->armDeadline(nrqPending);
+        return false;
+    }
+    return true;
+}
+
+bool NetworkLoop::rawBody(quint64 uiId,const char *szData,int iSize) {
+    auto itPending=hshRawRequests.find(uiId);
+    return hshRawRequests.end()!=itPending&&itPending->amtMatcher.feed(szData,iSize);
+}
+
+void NetworkLoop::rawClosed(RawConnection *rcConnection) {
+    auto itPool=hshRawPool.find(rcConnection->getKey());
+    if(hshRawPool.end()!=itPool) {
+        itPool->removeOne(rcConnection);
+        if(itPool->isEmpty())
+            hshRawPool.erase(itPool);
+    }
+    rcConnection->deleteLater();
+}
+
+void NetworkLoop::rawConnected(quint64 uiId,TlsSessionCache::Handshake hsHandshake) {
+    auto itPending=hshRawRequests.find(uiId);
+    if(hshRawRequests.end()!=itPending&&!itPending->bConnected) {
+        itPending->hsHandshake=hsHandshake;
+        if(TlsSessionCache::Handshake::HS_NONE!=hsHandshake)
+            Tracer::record(
+                itPending->nhtHit.uiTraceId,
+                TlsSessionCache::Handshake::HS_TICKET_OFFERED==hsHandshake?Tracer::TraceEvent::TE_TICKET_OFFERED:
+                                                                           Tracer::TraceEvent::TE_ENCRYPTED
+            );
+        Tracer::record(itPending->nhtHit.uiTraceId,Tracer::TraceEvent::TE_CONNECTED);
+        itPending->bConnected=true;
+        this->armDeadline(itPending.value());
+    }
+}
+
+void NetworkLoop::rawFinished(quint64 uiId,const RawResponse &rrsResponse) {
+    auto           itPending=hshRawRequests.find(uiId);
+    NetworkRequest nrqPending;
+    NetworkResult  nrsResult;
+    if(hshRawRequests.end()==itPending)
+        return;
+    hshRawCarriers.remove(uiId);
+    // Sent again, once, over another connection: same attempt, same deadlines.
+    if(!rrsResponse.bComplete&&rrsResponse.bReplayable&&!itPending->bReplayed&&
+       !bAborted&&itPending->sTimeout.isEmpty()) {
+        itPending->bReplayed=true;
+        this->dispatchRaw(uiId,itPending.value());
+        return;
+    }
+    nrqPending=hshRawRequests.take(uiId);
+    nrsResult={nrqPending.nhtHit,false,false,-1,0,QString(),ErrorCode::EC_OTHER};
+    Tracer::record(nrqPending.nhtHit.uiTraceId,Tracer::TraceEvent::TE_FINISHED);
+    hshRawDeadlines.remove(nrqPending.tmrDeadline);
+    nrqPending.tmrDeadline->stop();
+    nrqPending.tmrDeadline->deleteLater();
+    if(!nrqPending.sTimeout.isEmpty()) {
+        nrsResult.sError=nrqPending.sTimeout;
+        nrsResult.ecError=ErrorCode::EC_TIMEOUT;
+    }
+    else if(!nrqPending.amtMatcher.hasFailed()&&bAborted&&!rrsResponse.bComplete)
+        nrsResult.bCancelled=true;
+    else if(!rrsResponse.bComplete) {
+        nrsResult.sError=rrsResponse.sError;
+        nrsResult.ecError=rrsResponse.ecError;
+    }
+    // Redirects aren't followed, and count as hits, as they do with Qt's engine.
+    else if(rrsResponse.uiStatus>=400&&!nrqPending.amtMatcher.expectsStatus()) {
+        nrsResult.sError=QStringLiteral("Unexpected response code: %1").arg(rrsResponse.uiStatus);
+        nrsResult.ecError=ErrorTaxonomy::fromStatus(rrsResponse.uiStatus);
+    }
+    else if(nrqPending.bRevalidating&&304==rrsResponse.uiStatus) {
+        nrsResult.bNotModified=true;
+        nrsResult.uiSavedBytes=nrqPending.uiCachedSize;
+        nrsResult.iLatency=nrqPending.nhtHit.etmStarted.elapsed();
+    }
+    else if(nrqPending.amtMatcher.finish().isEmpty()) {
+        nrsResult.iLatency=nrqPending.nhtHit.etmStarted.elapsed();
+        if(nenOwner->getPolicy().bRevalidate)
+            this->storeValidators(nrqPending,rrsResponse.bytETag,rrsResponse.bytLastModified);
+    }
+    nrsResult.hsHandshake=nrqPending.hsHandshake;
+    this->completeHit(nrqPending,nrsResult,rrsResponse.uiStatus);
+}
+
+bool NetworkLoop::rawHead(quint64 uiId,uint uiStatus) {
+    auto itPending=hshRawRequests.find(uiId);
+    if(hshRawRequests.end()==itPending)
+        return false;
+    if(!itPending->bFirstByte) {
+        Tracer::record(itPending->nhtHit.uiTraceId,Tracer::TraceEvent::TE_FIRST_BYTE);
+        itPending->bFirstByte=true;
+        this->armDeadline(itPending.value());
+    }
+    // A 304 stands for the body that passed the assertions when cached.
+    return (itPending->bRevalidating&&304==uiStatus)||itPending->amtMatcher.checkStatus(uiStatus);
+}
+
+void NetworkLoop::rawTransferred(quint64 uiId,quint64 uiSent,quint64 uiReceived) {
+    auto itPending=hshRawRequests.find(uiId);
+    if(hshRawRequests.end()!=itPending) {
+        itPending->nhtHit.tcTraffic.uiSent+=uiSent;
+        itPending->nhtHit.tcTraffic.uiReceived+=uiReceived;
+    }
+}
+
+void NetworkLoop::pinToCore(int iCore) {
+    // Best effort: an unpinned loop works just the same, only less predictably.
+#if defined(Q_OS_WIN)
+    if(iCore<int(sizeof(DWORD_PTR)*8))
+        SetThreadAffinityMask(GetCurrentThread(),DWORD_PTR(1)<<iCore);
+#elif defined(Q_OS_LINUX)
+    cpu_set_t cstCores;
+    CPU_ZERO(&cstCores);
+    CPU_SET(iCore,&cstCores);
+    pthread_setaffinity_np(pthread_self(),sizeof(cstCores),&cstCores);
+#else
+    Q_UNUSED(iCore)
+#endif
+}
+
+bool NetworkLoop::retryHit(const NetworkResult &nrsResult) {
+    NetworkHit nhtRetry=nrsResult.nhtHit;
+    quint32    uiSeeds[]={nhtRetry.uiSeed,nhtRetry.uiRetries};
+    uint       uiBackoff;
+    if(bAborted||nhtRetry.uiRetries>=nenOwner->getPolicy().uiMaxRetries||!nenOwner->takeRetry())
+        return false;
+    // The failed attempt leaves the in-flight hits, and the retry queues up.
+    Metrics::hitFinished(
+        Metrics::HitResult::HR_RETRY,
+        nhtRetry.iProxy,
+        nrsResult.uiBytes,
+        -1
+    );
+    Metrics::hitScheduled();
+    uiBackoff=qMin<uint>(RETRY_BACKOFF_MAX,RETRY_BACKOFF_BASE<<qMin(nhtRetry.uiRetries,16u));
+    nhtRetry.uiRetries++;
+    Tracer::record(nhtRetry.uiTraceId,Tracer::TraceEvent::TE_WAIT_BEGIN);
+    // Full jitter, so a burst of failures doesn't come back as a burst of ...
+    // ... retries. Drawn from the hit's seed and attempt, so seeded runs repeat.
+    this->waitHit(nhtRetry,int(QRandomGenerator(uiSeeds).bounded(uiBackoff+1)));
+    return true;
+}
+
+void NetworkLoop::sendHit(const NetworkHit &nhtHit) {
+    const NetworkPolicy &npcPolicy=nenOwner->getPolicy();
+    NetworkRequest      nrqPending;
+    CachedValidators    cvValidators;
+    nrqPending.bRevalidating=false;
+    nrqPending.uiCachedSize=0;
+    // Cold hits play first-time visitors, so they never send validators. ...
+    // ... Neither do templates: their URLs are one-offs, never cached. ...
+    // ... The choice comes from the hit's seed, so retries make the same one.
+    if(npcPolicy.bRevalidate&&
+       !nhtHit.bTemplated&&
+       QRandomGenerator(nhtHit.uiSeed).bounded(100u)>=npcPolicy.uiColdHits&&
+       nenOwner->getValidators()->get(nhtHit.urlLink.toEncoded(),cvValidators)) {
+        nrqPending.bRevalidating=true;
+        nrqPending.uiCachedSize=cvValidators.uiSize;
+    }
+    nrqPending.bTicketOffered=false;
+    nrqPending.bEncrypted=false;
+    nrqPending.bReplayed=false;
+    nrqPending.hsHandshake=TlsSessionCache::Handshake::HS_NONE;
+    Metrics::hitStarted();
+    nrqPending.nhtHit=nhtHit;
+    // Latencies span all the attempts, as that's what the client waited.
+    if(!nhtHit.uiRetries)
+        nrqPending.nhtHit.etmStarted.start();
+    nrqPending.amtMatcher=AssertionMatcher(nhtHit.lapAssertions);
+    nrqPending.bFirstByte=false;
+    nrqPending.tmrDeadline=new QTimer(this);
+    nrqPending.tmrDeadline->setSingleShot(true);
+    connect(
+        nrqPending.tmrDeadline,
+        &QTimer::timeout,
+        this,
+        &NetworkLoop::deadlineTimeout
+    );
+    nrqPending.etmAttempt.start();
+    Tracer::record(nhtHit.uiTraceId,Tracer::TraceEvent::TE_STARTED);
+    if(npcPolicy.bRawEngine)
+        this->sendRaw(nrqPending,cvValidators);
+    else
+        this->sendReply(nrqPending,cvValidators);
+}
+
+void NetworkLoop::sendRaw(NetworkRequest &nrqPending,const CachedValidators &cvValidators) {
+    const QUrl &urlLink=nrqPending.nhtHit.urlLink;
+    QByteArray bytPath=urlLink.toEncoded(
+        QUrl::UrlFormattingOption::RemoveScheme|
+        QUrl::UrlFormattingOption::RemoveAuthority|
+        QUrl::UrlFormattingOption::RemoveFragment
+    );
+    quint64    uiId=uiNextRawId++;
+    // Written once, as it goes out, so replays just send it again. Bodies ...
+    // ... are asked for as they are, since they're checked as they arrive.
+    nrqPending.bytRawRequest.reserve(REQUEST_RESERVE);
+    nrqPending.bytRawRequest.append("GET ").append(bytPath.isEmpty()?QByteArray("/"):bytPath).append(
+        " HTTP/1.1\r\nHost: "
+    ).append(
+        urlLink.adjusted(QUrl::UrlFormattingOption::RemoveUserInfo).authority(
+            QUrl::ComponentFormattingOption::FullyEncoded
+        ).toLatin1()
+    );
+    if(!nrqPending.nhtHit.sAgent.isEmpty())
+        nrqPending.bytRawRequest.append("\r\nUser-Agent: ").append(nrqPending.nhtHit.sAgent.toUtf8());
+    nrqPending.bytRawRequest.append("\r\nAccept: */*\r\nAccept-Encoding: identity\r\n");
+    if(nrqPending.bRevalidating) {
+        if(!cvValidators.bytETag.isEmpty())
+            nrqPending.bytRawRequest.append("If-None-Match: ").append(cvValidators.bytETag).append("\r\n");
+        if(!cvValidators.bytLastModified.isEmpty())
+            nrqPending.bytRawRequest.append("If-Modified-Since: ").append(cvValidators.bytLastModified).append("\r\n");
+    }
+    nrqPending.bytRawRequest.append("\r\n");
+    // Unlike Qt's engine, this one can tell when the connection is up.
+    nrqPending.bConnected=false;
+    this->armDeadline(nrqPending);
+    hshRawRequests.insert(uiId,nrqPending);
+    hshRawDeadlines.insert(nrqPending.tmrDeadline,uiId);
+    this->dispatchRaw(uiId,nrqPending);
+}
+
+void NetworkLoop::sendReply(NetworkRequest &nrqPending,const CachedValidators &cvValidators) {
+    QNetworkRequest nrqRequest;
+    QNetworkReply   *nrpReply;
+    int             iProxy=nrqPending.nhtHit.iProxy;
+    quint64         uiSent;
+    nrqRequest.setUrl(nrqPending.nhtHit.urlLink);
+    if(!nrqPending.nhtHit.sAgent.isEmpty())
+        nrqRequest.setHeader(
+            QNetworkRequest::KnownHeaders::UserAgentHeader,
+            nrqPending.nhtHit.sAgent
+        );
+    if(nrqPending.bRevalidating) {
+        if(!cvValidators.bytETag.isEmpty())
+            nrqRequest.setRawHeader("If-None-Match",cvValidators.bytETag);
+        if(!cvValidators.bytLastModified.isEmpty())
+            nrqRequest.setRawHeader("If-Modified-Since",cvValidators.bytLastModified);
+    }
+    // Resumes the TLS session any loop last had with the host, if any.
+    nrqPending.bTicketOffered=TlsSessionCache::prepare(nrqRequest,iProxy);
+    // Qt doesn't tell what it actually writes, so the request is estimated ...
+    // ... from its line, its host and its headers.
+    uiSent=QT_HEADERS_SIZE+nrqPending.nhtHit.urlLink.toEncoded().size();
+    for(const auto &h:nrqRequest.rawHeaderList())
+        uiSent+=quint64(h.size()+nrqRequest.rawHeader(h).size())+4;
+    nrqPending.nhtHit.tcTraffic.uiSent+=uiSent;
+    Bandwidth::sent(iProxy,qint64(uiSent));
+#if QT_VERSION>=QT_VERSION_CHECK(6,3,0)
+    nrqPending.bConnected=false;
+#else
+    // Older versions can't tell when the connection is up, so there's no ...
+    // ... connect deadline to enforce there.
+    nrqPending.bConnected=true;
+#endif
+    nrpReply=this->getManager(iProxy,nrqPending.nhtHit.npxProxy)->get(nrqRequest);
+    // Keeps Qt from reading ahead of a limited proxy's bucket.
+    if(Bandwidth::isLimited(iProxy))
+        nrpReply->setReadBufferSize(READ_CHUNK_SIZE);
+    this->armDeadline(nrqPending);
+    hshReplies.insert(nrpReply,nrqPending);
+    hshDeadlines.insert(nrqPending.tmrDeadline,nrpReply);
+#if QT_VERSION>=QT_VERSION_CHECK(6,3,0)
+    connect(
+        nrpReply,
+        &QNetworkReply::requestSent,
+        this,
+        &NetworkLoop::replyRequestSent
+    );
+#endif
+    connect(
+        nrpReply,
+        &QNetworkReply::encrypted,
+        this,
+        &NetworkLoop::replyEncrypted
+    );
+    connect(
+        nrpReply,
+        &QNetworkReply::metaDataChanged,
+        this,
+        &NetworkLoop::replyMetaDataChanged
+    );
+    connect(
+        nrpReply,
+        &QNetworkReply::readyRead,
+        this,
+        &NetworkLoop::replyReadyRead
+    );
+    connect(
+        nrpReply,
+        &QNetworkReply::finished,
+        this,
+        &NetworkLoop::replyFinished
+    );
+}
+
+void NetworkLoop::storeValidators(NetworkRequest &nrqPending,const QByteArray &bytETag,const QByteArray &bytLastModified) {
+    CachedValidators cvValidators;
+    QByteArray       bytUrl;
+    // A template stands for a whole URL space, which would end up ...
+    // ... materialized here, one entry per expansion.
+    if(nrqPending.nhtHit.bTemplated)
+        return;
+    bytUrl=nrqPending.nhtHit.urlLink.toEncoded();
+    cvValidators.bytETag=bytETag;
+    cvValidators.bytLastModified=bytLastModified;
+    cvValidators.uiSize=nrqPending.amtMatcher.getSize();
+    // Responses with no validators can't be revalidated, so they're forgotten.
+    if(cvValidators.bytETag.isEmpty()&&cvValidators.bytLastModified.isEmpty())
+        nenOwner->getValidators()->remove(bytUrl);
+    else
+        nenOwner->getValidators()->put(bytUrl,cvValidators);
+}
+
+void NetworkLoop::throttleReply(QNetworkReply *nrpReply,int iProxy) {
+    int iWait=Bandwidth::getWait(iProxy);
+    setThrottled.insert(nrpReply);
+    // One timer for all the throttled replies of the loop, aimed at the ...
+    // ... earliest refill.
+    if(!tmrThrottle->isActive()||tmrThrottle->remainingTime()>iWait)
+        tmrThrottle->start(iWait);
+}
+
+bool NetworkLoop::takeHit(NetworkHit &nhtHit) {
+    if(wdqHits.popFront(nhtHit))
+        return true;
+    // Nothing left of its own: helps a busier loop instead of idling.
+    return nenOwner->steal(iIndex,nhtHit);
+}
+
+void NetworkLoop::waitHit(const NetworkHit &nhtHit,int iDelay) {
+    QTimer *tmrWait=new QTimer(this);
+    tmrWait->setSingleShot(true);
+    connect(
+        tmrWait,
+        &QTimer::timeout,
+        this,
+        &NetworkLoop::waitTimeout
+    );
+    hshWaiting.insert(tmrWait,nhtHit);
+    tmrWait->start(iDelay);
+}
+
+void NetworkLoop::abort() {
+    NetworkHit nhtHit;
+    bAborted=true;
+    // Queued and cooling-down hits never started, but must be accounted.
+    while(wdqHits.popFront(nhtHit)) {
+        iInFlight++;
+        Metrics::hitStarted();
+        this->finishHit({nhtHit,true,false,-1,0,QString()});
+    }
+    for(auto &t:hshWaiting.keys()) {
+        nhtHit=hshWaiting.take(t);
+        delete t;
+        Tracer::record(nhtHit.uiTraceId,Tracer::TraceEvent::TE_WAIT_END);
+        Metrics::hitStarted();
+        this->finishHit({nhtHit,true,false,-1,0,QString()});
+    }
+    // Each reply finishes right away, as a cancellation.
+    for(auto &r:hshReplies.keys())
+        r->abort();
+    // So do the raw connections, taken from a copy as they leave their pools.
+    for(auto &p:hshRawPool.values())
+        for(auto &c:p)
+            c->abort(QStringLiteral("Operation canceled"),ErrorCode::EC_OTHER);
+}
+
+void NetworkLoop::pump() {
+    NetworkHit nhtHit;
+    while(!bAborted&&iInFlight<nenOwner->getLoopLimit()&&this->takeHit(nhtHit)) {
+        iInFlight++;
+        // Under memory pressure, the start of a hit is only cosmetic: its ...
+        // ... end still gets through, and the rows catch up then.
+        if(MemoryGovernor::isCoalescing())
+            MemoryGovernor::throttled(MemoryGovernor::Throttle::TH_EVENTS);
+        else {
+            Diagnostics::eventQueued();
+            emit hitStarted(nhtHit);
+        }
+        if(nhtHit.uiCooldown) {
+            Tracer::record(nhtHit.uiTraceId,Tracer::TraceEvent::TE_WAIT_BEGIN);
+            this->waitHit(nhtHit,nhtHit.uiCooldown*1000);
+        }
+        else
+            this->sendHit(nhtHit);
+    }
+}
+
+void NetworkLoop::setup() {
+    // Runs in the loop's own thread, once its event loop is up.
+    NetworkLoop::pinToCore(iIndex%QThread::idealThreadCount());
+    tmrThrottle=new QTimer(this);
+    tmrThrottle->setSingleShot(true);
+    connect(
+        tmrThrottle,
+        &QTimer::timeout,
+        this,
+        &NetworkLoop::throttleTimeout
+    );
+    this->pump();
+}
+
+void NetworkLoop::deadlineTimeout() {
+    QTimer *tmrDeadline=qobject_cast<QTimer *>(QObject::sender());
+    if(hshDeadlines.contains(tmrDeadline)) {
+        QNetworkReply *nrpReply=hshDeadlines.value(tmrDeadline);
+        auto          itPending=hshReplies.find(nrpReply);
+        if(hshReplies.end()!=itPending&&this->isPastDeadline(itPending.value()))
+            nrpReply->abort();
+    }
+    else if(hshRawDeadlines.contains(tmrDeadline)) {
+        quint64       uiId=hshRawDeadlines.value(tmrDeadline);
+        auto          itPending=hshRawRequests.find(uiId);
+        RawConnection *rcCarrier=hshRawCarriers.value(uiId);
+        // A stalled response holds up the whole pipeline, so the connection ...
+        // ... goes with it. The hits behind are sent again elsewhere.
+        if(hshRawRequests.end()!=itPending&&nullptr!=rcCarrier&&this->isPastDeadline(itPending.value()))
+            rcCarrier->abort(itPending->sTimeout,ErrorCode::EC_TIMEOUT);
+    }
+}
+
+void NetworkLoop::replyFinished() {
+    QNetworkReply  *nrpReply=qobject_cast<QNetworkReply *>(QObject::sender());
+    NetworkRequest nrqPending=hshReplies.take(nrpReply);
+    NetworkResult  nrsResult={nrqPending.nhtHit,false,false,-1,0,QString(),ErrorCode::EC_OTHER};
+    uint           uiStatus;
+    Tracer::record(nrqPending.nhtHit.uiTraceId,Tracer::TraceEvent::TE_FINISHED);
+    setThrottled.remove(nrpReply);
+    hshDeadlines.remove(nrqPending.tmrDeadline);
+    nrqPending.tmrDeadline->stop();
+    nrqPending.tmrDeadline->deleteLater();
+    uiStatus=nrpReply->attribute(
+        QNetworkRequest::Attribute::HttpStatusCodeAttribute
+    ).toUInt();
+    if(!nrqPending.sTimeout.isEmpty()) {
+        nrsResult.sError=nrqPending.sTimeout;
+        nrsResult.ecError=ErrorCode::EC_TIMEOUT;
+    }
+    else if(!nrqPending.amtMatcher.hasFailed()&&
+            bAborted&&QNetworkReply::NetworkError::OperationCanceledError==nrpReply->error())
+        nrsResult.bCancelled=true;
+    // Whatever is left was received already, throttled or not.
+    else if(this->readReply(nrpReply,nrqPending,true)) {
+        if(!uiStatus)
+            if(QNetworkReply::NetworkError::NoError!=nrpReply->error()) {
+                nrsResult.sError=nrpReply->errorString();
+                nrsResult.ecError=ErrorTaxonomy::fromNetworkError(nrpReply->error());
+            }
+            else {
+                nrsResult.sError=QStringLiteral("Response timeout expired");
+                nrsResult.ecError=ErrorCode::EC_TIMEOUT;
+            }
+        // An explicitly expected status is fine, even when it's not a 2xx.
+        else if(QNetworkReply::NetworkError::NoError!=nrpReply->error()&&
+                !nrqPending.amtMatcher.expectsStatus()) {
+            nrsResult.sError=QStringLiteral("Unexpected response code: %1").arg(uiStatus);
+            nrsResult.ecError=ErrorTaxonomy::fromStatus(uiStatus);
+        }
+        else if(nrqPending.bRevalidating&&304==uiStatus) {
+            nrsResult.bNotModified=true;
+            nrsResult.uiSavedBytes=nrqPending.uiCachedSize;
+            nrsResult.iLatency=nrqPending.nhtHit.etmStarted.elapsed();
+        }
+        else if(nrqPending.amtMatcher.finish().isEmpty()) {
+            // Only successful hits are meaningful for the latency stats.
+            nrsResult.iLatency=nrqPending.nhtHit.etmStarted.elapsed();
+            if(nenOwner->getPolicy().bRevalidate)
+                this->storeValidators(nrqPending,nrpReply->rawHeader("ETag"),nrpReply->rawHeader("Last-Modified"));
+        }
+    }
+    nrsResult.hsHandshake=TlsSessionCache::finish(
+        nrpReply,
+        nrqPending.nhtHit.iProxy,
+        nrqPending.bTicketOffered,
+        nrqPending.bEncrypted
+    );
+    nrpReply->deleteLater();
+    this->completeHit(nrqPending,nrsResult,uiStatus);
+}
+
+void NetworkLoop::replyEncrypted() {
+    QNetworkReply *nrpReply=qobject_cast<QNetworkReply *>(QObject::sender());
+    auto          itPending=hshReplies.find(nrpReply);
+    // Only fired on new connections: kept-alive ones skip the handshake.
+    if(hshReplies.end()!=itPending) {
+        itPending->bEncrypted=true;
+        Tracer::record(
+            itPending->nhtHit.uiTraceId,
+            itPending->bTicketOffered?Tracer::TraceEvent::TE_TICKET_OFFERED:Tracer::TraceEvent::TE_ENCRYPTED
+        );
+    }
+}
+
+void NetworkLoop::replyMetaDataChanged() {
+    QNetworkReply *nrpReply=qobject_cast<QNetworkReply *>(QObject::sender());
+    auto          itPending=hshReplies.find(nrpReply);
+    // The headers are in, so the connect and first byte deadlines are met.
+    if(hshReplies.end()!=itPending&&!itPending->bFirstByte) {
+        quint64 uiHead=STATUS_LINE_SIZE+2;
+        for(const auto &h:nrpReply->rawHeaderPairs())
+            uiHead+=quint64(h.first.size()+h.second.size())+4;
+        itPending->nhtHit.tcTraffic.uiReceived+=uiHead;
+        Bandwidth::received(
+            itPending->nhtHit.iProxy,
+            qint64(uiHead)
+        );
+        Tracer::record(itPending->nhtHit.uiTraceId,Tracer::TraceEvent::TE_FIRST_BYTE);
+        itPending->bConnected=true;
+        itPending->bFirstByte=true;
+        this->armDeadline(itPending.value());
+    }
+}
+
+void NetworkLoop::replyReadyRead() {
+    QNetworkReply *nrpReply=qobject_cast<QNetworkReply *>(QObject::sender());
+    auto          itPending=hshReplies.find(nrpReply);
+    // A failed assertion ends the transfer right away, sparing the bandwidth.
+    if(hshReplies.end()!=itPending)
+        if(!this->readReply(nrpReply,itPending.value(),false))
+            nrpReply->abort();
+}
+
+void NetworkLoop::replyRequestSent() {
+    QNetworkReply *nrpReply=qobject_cast<QNetworkReply *>(QObject::sender());
+    auto          itPending=hshReplies.find(nrpReply);
+    // Only sent over an established (and negotiated) connection.
+    if(hshReplies.end()!=itPending&&!itPending->bConnected) {
+        Tracer::record(itPending->nhtHit.uiTraceId,Tracer::TraceEvent::TE_CONNECTED);
+        itPending->bConnected=true;
+        this->armDeadline(itPending.value());
+    }
+}
+
+void NetworkLoop::throttleTimeout() {
+    QSet<QNetworkReply *> setResumed;
+    setResumed.swap(setThrottled);
+    // Throttled again right away if the bucket is still short.
+    for(auto &r:setResumed) {
+        auto itPending=hshReplies.find(r);
+        if(hshReplies.end()!=itPending&&!this->readReply(r,itPending.value(),false))
+            r->abort();
+    }
+}
+
+void NetworkLoop::waitTimeout() {
+    QTimer     *tmrWait=qobject_cast<QTimer *>(QObject::sender());
+    NetworkHit nhtHit=hshWaiting.take(tmrWait);
+    tmrWait->deleteLater();
+    Tracer::record(nhtHit.uiTraceId,Tracer::TraceEvent::TE_WAIT_END);
+    this->sendHit(nhtHit);
+}
+
+NetworkEngine::NetworkEngine(QObject *objParent,int iLoops):
+QObject(objParent) {
+    iNextLoop=0;
+    iLoopLimit=1;
+    uiFirstAttempts=0;
+    uiRetries=0;
+    npcPolicy=NetworkPolicy();
+    vchValidators=nullptr;
+    qRegisterMetaType<NetworkHit>();
+    qRegisterMetaType<NetworkResult>();
+    // One event loop (and set of connection pools) per core by default.
+    if(iLoops<=0)
+        iLoops=QThread::idealThreadCount();
+    for(int iK=0;iK<iLoops;iK++) {
+        QThread     *thrLoop=new QThread(this);
+        NetworkLoop *nlpLoop=new NetworkLoop(this,iK);
+        nlpLoop->moveToThread(thrLoop);
+        connect(
+            thrLoop,
+            &QThread::started,
+            nlpLoop,
+            &NetworkLoop::setup
+        );
+        connect(
+            thrLoop,
+            &QThread::finished,
+            nlpLoop,
+            &NetworkLoop::deleteLater
+        );
+        connect(
+            nlpLoop,
+            &NetworkLoop::hitFinished,
+            this,
+            &NetworkEngine::hitFinished
+        );
+        connect(
+            nlpLoop,
+            &NetworkLoop::hitStarted,
+            this,
+            &NetworkEngine::hitStarted
+        );
+        vnlLoops.append(nlpLoop);
+        vthThreads.append(thrLoop);
+        thrLoop->start();
+    }
+}
+
+NetworkEngine::~NetworkEngine() {
+    for(auto &t:vthThreads) {
+        t->quit();
+        t->wait();
+    }
+}
+
+void NetworkEngine::cancel() {
+    for(auto &l:vnlLoops)
+        QMetaObject::invokeMethod(l,&NetworkLoop::abort,Qt::ConnectionType::QueuedConnection);
+}
+
+int NetworkEngine::getLoopLimit() {
+    return iLoopLimit;
+}
+
+const NetworkPolicy &NetworkEngine::getPolicy() {
+    return npcPolicy;
+}
+
+ValidatorCache *NetworkEngine::getValidators() {
+    return vchValidators;
+}
+
+void NetworkEngine::setMaxInFlight(uint uiMaxInFlight) {
+    // Every loop may take its even share. The stealing does the balancing.
+    iLoopLimit=qMax(1,int((uiMaxInFlight+vnlLoops.count()-1)/vnlLoops.count()));
+    this->wakeIdleLoops();
+}
+
+void NetworkEngine::setPolicy(NetworkPolicy npcNewPolicy) {
+    // Read by the loops without a lock, so it's only set before any submit.
+    npcPolicy=npcNewPolicy;
+}
+
+void NetworkEngine::setValidators(ValidatorCache *vchNewValidators) {
+    // Shared by all the loops, which is what makes repeat hits find them.
+    vchValidators=vchNewValidators;
+}
+
+bool NetworkEngine::steal(int iThief,NetworkHit &nhtHit) {
+    for(int iK=1;iK<vnlLoops.count();iK++)
+        if(vnlLoops.at((iThief+iK)%vnlLoops.count())->getQueue().stealBack(nhtHit))
+            return true;
+    return false;
+}
+
+void NetworkEngine::submit(const NetworkHit &nhtHit) {
+    NetworkLoop *nlpLoop=vnlLoops.at(iNextLoop);
+    iNextLoop=(iNextLoop+1)%vnlLoops.count();
+    uiFirstAttempts++;
+    nlpLoop->getQueue().pushBack(nhtHit);
+    if(nlpLoop->getInFlight()<iLoopLimit)
+        QMetaObject::invokeMethod(nlpLoop,&NetworkLoop::pump,Qt::ConnectionType::QueuedConnection);
+    else
+        // The chosen loop is saturated: any idle one can steal the hit.
+        this->wakeIdleLoops();
+}
+
+bool NetworkEngine::takeRetry() {
+    quint64 uiAllowed=RETRY_BUDGET_RESERVE+uiFirstAttempts*npcPolicy.uiRetryBudget/100,
+            uiCurrent=uiRetries;
+    // Retries are capped to a share of the traffic, so a failing target ...
+    // ... never gets a storm of them on top of the regular hits.
+    do
+        if(uiCurrent>=uiAllowed)
+            return false;
+    while(!uiRetries.compare_exchange_weak(uiCurrent,uiCurrent+1));
+    return true;
+}
+
+void NetworkEngine::wakeIdleLoops() {
+    for(auto &l:vnlLoops)
+        if(l->getInFlight()<iLoopLimit)
+            QMetaObject::invokeMethod(l,&NetworkLoop::pump,Qt::ConnectionType::QueuedConnection);
+}
@@ -0,0 +1,187 @@
+#ifndef NETWORKENGINE_H
+#define NETWORKENGINE_H
+
+#include <QtCore>
+#include <QtNetwork>
+#include <atomic>
+#include <deque>
+#include "hitengine.h"
+#include "httpparser.h"
+
+using NetworkRequest=struct {
+    NetworkHit                 nhtHit;
+    AssertionMatcher           amtMatcher;
+    bool                       bConnected,
+                               bFirstByte,
+                               bRevalidating,
+                               bTicketOffered,
+                               bEncrypted,
+                               bReplayed;
+    quint64                    uiCachedSize;
+    QElapsedTimer              etmAttempt;
+    QTimer                     *tmrDeadline;
+    QString                    sTimeout;
+    QByteArray                 bytRawRequest;
+    TlsSessionCache::Handshake hsHandshake;
+};
+
+using RawResponse=struct {
+    bool       bComplete,
+               bReplayable;
+    uint       uiStatus;
+    QByteArray bytETag,
+               bytLastModified;
+    QString    sError;
+    ErrorCode  ecError;
+};
+
+class NetworkEngine;
+class NetworkLoop;
+
+class RawConnection:public QObject {
+    Q_OBJECT
+public:
+    RawConnection(NetworkLoop *,const QUrl &,int,const QNetworkProxy &);
+    void              abort(QString,ErrorCode);
+    bool              canSend(uint);
+    QByteArray        getKey();
+    int               getPending();
+    void              open();
+    void              send(quint64,const QByteArray &);
+    static QByteArray makeKey(const QUrl &,int);
+private slots:
+    void socketConnected();
+    void socketDisconnected();
+    void socketEncrypted();
+    void socketErrorOccurred(QAbstractSocket::SocketError);
+    void socketReadyRead();
+private:
+    bool                bClosing,
+                        bEncrypted,
+                        bHeadReported,
+                        bKeepAlive,
+                        bReady,
+                        bReused,
+                        bTicketOffered,
+                        bTicketStored;
+    int                 iProxy;
+    NetworkLoop         *nlpOwner;
+    QUrl                urlTarget;
+    QByteArray          bytKey,
+                        bytOutgoing;
+    HttpParser          hppParser;
+    QSslSocket          *sslSocket;
+    QTimer              tmrThrottle;
+    std::deque<quint64> dqPending;
+    void close(QString,ErrorCode);
+    bool consume(const char *,int);
+    void finishFront();
+    void markReady(TlsSessionCache::Handshake);
+    void readSocket(bool);
+    void storeTicket();
+};
+
+class WorkDeque {
+public:
+    bool popFront(NetworkHit &);
+    void pushBack(const NetworkHit &);
+    bool stealBack(NetworkHit &);
+private:
+    QMutex                 mtxHits;
+    std::deque<NetworkHit> dqHits;
+};
+
+class NetworkLoop:public QObject {
+    Q_OBJECT
+public:
+    NetworkLoop(NetworkEngine * =nullptr,int=0);
+    int       getInFlight();
+    WorkDeque &getQueue();
+    bool      rawBody(quint64,const char *,int);
+    void      rawClosed(RawConnection *);
+    void      rawConnected(quint64,TlsSessionCache::Handshake);
+    void      rawFinished(quint64,const RawResponse &);
+    bool      rawHead(quint64,uint);
+    void      rawTransferred(quint64,quint64,quint64);
+public slots:
+    void abort();
+    void pump();
+    void setup();
+signals:
+    void hitFinished(NetworkResult);
+    void hitStarted(NetworkHit);
+private slots:
+    void deadlineTimeout();
+    void replyFinished();
+    void replyEncrypted();
+    void replyMetaDataChanged();
+    void replyReadyRead();
+    void replyRequestSent();
+    void throttleTimeout();
+    void waitTimeout();
+private:
+    bool                                         bAborted;
+    int                                          iIndex;
+    std::atomic<int>                             iInFlight;
+    quint64                                      uiNextRawId;
+    NetworkEngine                                *nenOwner;
+    QTimer                                       *tmrThrottle;
+    WorkDeque                                    wdqHits;
+    QHash<int,QNetworkAccessManager *>           hshManagers;
+    QHash<QTimer *,NetworkHit>                   hshWaiting;
+    QHash<QNetworkReply *,NetworkRequest>        hshReplies;
+    QHash<QTimer *,QNetworkReply *>              hshDeadlines;
+    QHash<QByteArray,QVector<RawConnection *>>   hshRawPool;
+    QHash<quint64,RawConnection *>               hshRawCarriers;
+    QHash<quint64,NetworkRequest>                hshRawRequests;
+    QHash<QTimer *,quint64>                      hshRawDeadlines;
+    QSet<QNetworkReply *>                        setThrottled;
+    void                  armDeadline(NetworkRequest &);
+    void                  completeHit(NetworkRequest &,NetworkResult &,uint);
+    void                  dispatchRaw(quint64,const NetworkRequest &);
+    void                  finishHit(const NetworkResult &);
+    QNetworkAccessManager *getManager(int,const QNetworkProxy &);
+    bool                  isPastDeadline(NetworkRequest &);
+    bool                  readReply(QNetworkReply *,NetworkRequest &,bool);
+    bool                  retryHit(const NetworkResult &);
+    void                  sendHit(const NetworkHit &);
+    void                  sendRaw(NetworkRequest &,const CachedValidators &);
+    void                  sendReply(NetworkRequest &,const CachedValidators &);
+    void                  storeValidators(NetworkRequest &,const QByteArray &,const QByteArray &);
+    bool                  takeHit(NetworkHit &);
+    void                  throttleReply(QNetworkReply *,int);
+    void                  waitHit(const NetworkHit &,int);
+    static void           pinToCore(int);
+};
+
+class NetworkEngine:public QObject {
+    Q_OBJECT
+public:
+    NetworkEngine(QObject * =nullptr,int=0);
+    ~NetworkEngine();
+    void                cancel();
+    int                 getLoopLimit();
+    const NetworkPolicy &getPolicy();
+    ValidatorCache      *getValidators();
+    void                setMaxInFlight(uint);
+    void                setPolicy(NetworkPolicy);
+    void                setValidators(ValidatorCache *);
+    bool                steal(int,NetworkHit &);
+    void                submit(const NetworkHit &);
+    bool                takeRetry();
+signals:
+    void hitFinished(NetworkResult);
+    void hitStarted(NetworkHit);
+private:
+    int                    iNextLoop;
+    std::atomic<int>       iLoopLimit;
+    std::atomic<quint64>   uiFirstAttempts,
+                           uiRetries;
+    NetworkPolicy          npcPolicy;
+    ValidatorCache         *vchValidators;
+    QVector<NetworkLoop *> vnlLoops;
+    QVector<QThread *>     vthThreads;
+    void wakeIdleLoops();
+};
+
+#endif // NETWORKENGINE_H
@@ -0,0 +1,21 @@
+#include "remoteprotocol.h"
+
+#define MAX_MESSAGE_SIZE 0x4000000
+
+QList<QJsonObject> RemoteProtocol::readMessages(QTcpSocket *tcpSocket) {
+    QList<QJsonObject> lstResult;
+    while(tcpSocket->canReadLine()) {
+        QJsonDocument jsdMessage=QJsonDocument::fromJson(tcpSocket->readLine());
+        if(jsdMessage.isObject())
+            lstResult.append(jsdMessage.object());
+    }
+    // A peer that never ends its line is either broken or hostile.
+    if(tcpSocket->bytesAvailable()>MAX_MESSAGE_SIZE)
+        tcpSocket->abort();
+    return lstResult;
+}
+
+void RemoteProtocol::writeMessage(QTcpSocket *tcpSocket,QJsonObject jsoMessage) {
+    tcpSocket->write(QJsonDocument(jsoMessage).toJson(QJsonDocument::JsonFormat::Compact));
+    tcpSocket->write("\n");
+}
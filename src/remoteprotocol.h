@@ -0,0 +1,52 @@
+#ifndef REMOTEPROTOCOL_H
+#define REMOTEPROTOCOL_H
+
+#include <QtCore>
+#include <QtNetwork>
+
+// Where agents and the coordinator look for the shared token, when not given.
+#define AGENT_TOKEN_VARIABLE "MULTIBROWSER_TOKEN"
+
+/**
+ * Coordinator/agent wire format: one compact JSON object per line.
+ *
+ * Coordinator to agent:
+ *   {"cmd":"hello","token":"..."}
+ *   {"cmd":"start","mode":"network"|"browser","warmProfile":true|false,
+ *    "until":"load"|"dom"|"idle:N"|"selector:..."|"time:N","content":true|false,
+ *    "resources":true|false,"har":N,"workers":N,"cooldown":N,"memory":N,
+ *    "connectTimeout":N,"firstByteTimeout":N,"totalTimeout":N,
+ *    "retries":N,"retryBudget":N,"revalidate":true|false,"coldHits":N,
+ *    "resumeTls":true|false,"rawEngine":true|false,"pipeline":N,
+ *    "links":[[index,link],...],"proxies":[[index,proxy],...],
+ *    "agents":[...],"scenario":"..."}
+ *   {"cmd":"rate","workers":N,"cooldown":N,"memory":N}
+ *   {"cmd":"reload","links":[[index,link],...],"proxies":[[index,proxy],...],
+ *    "agents":[...]}
+ *   {"cmd":"stop"}
+ *
+ * Agent to coordinator:
+ *   {"evt":"stats",
+ *    "links":[[index,hits,errors,failures,cancels,retries,revalidations,kinds,histogram,traffic],...],
+ *    "proxies":[[index,hits,errors,cancels,kinds,histogram,traffic],...]}
+ *   {"evt":"stopped"}
+ *   {"evt":"error","message":"..."}
+ *
+ * Indexes are always the coordinator's ones, and the stats carry totals ...
+ * ... (not deltas), so a lost or late update never skews the merge. Kinds ...
+ * ... are the error counts by kind, keyed by name (e.g. {"timeout":3}). ...
+ * ... Traffic is [sent,received], in bytes. Proxies may carry a limit ...
+ * ... (e.g. "host:port limit=64k"), already split between the agents sharing it. ...
+ * ... A reload carries the agent's whole new share: what it no longer ...
+ * ... lists is retired, but keeps reporting under the same index. The ...
+ * ... memory budget is in MB, per agent (0 for none). The hello comes ...
+ * ... first: an agent ignores everything else until its token matches, ...
+ * ... and drops the connection when it doesn't.
+ */
+class RemoteProtocol {
+public:
+    static QList<QJsonObject> readMessages(QTcpSocket *);
+    static void               writeMessage(QTcpSocket *,QJsonObject);
+};
+
+#endif // REMOTEPROTOCOL_H
@@ -0,0 +1,89 @@
+#include "resourcestats.h"
+
+#include <algorithm>
+
+// Distinct resources tracked per run. Loads of any other one are left out.
+#define RESOURCE_STATS_MAX 10000
+
+// Fields of every resource, as reported by the browser helper.
+#define RESOURCE_FIELD_URL      0
+#define RESOURCE_FIELD_TYPE     1
+#define RESOURCE_FIELD_DURATION 2
+#define RESOURCE_FIELD_BYTES    3
+
+static QHash<QString,ResourceEntry> hshResources;
+static QMutex                       mtxResources;
+
+void ResourceStats::beginRun() {
+    QMutexLocker mlkResources(&mtxResources);
+    hshResources.clear();
+}
+
+QString ResourceStats::getSummary(int iCount) {
+    QStringList slLines;
+    for(auto rkRanking:{Ranking::RK_SLOWEST,Ranking::RK_HEAVIEST})
+        for(const auto &r:ResourceStats::getTop(rkRanking,iCount))
+            slLines.append(QStringLiteral("%1 %2 (%3, %4 loads): avg. %5 ms, avg. %6 bytes").arg(
+                Ranking::RK_SLOWEST==rkRanking?QStringLiteral("Slowest"):QStringLiteral("Heaviest"),
+                r.sResource,
+                r.sType
+            ).arg(
+                r.uiLoads
+            ).arg(
+                r.dTotalTime/r.uiLoads,0,'f',1
+            ).arg(
+                r.uiTotalBytes/r.uiLoads
+            ));
+    return slLines.join(QLatin1Char('\n'));
+}
+
+ResourceEntries ResourceStats::getTop(Ranking rkRanking,int iCount) {
+    ResourceEntries renResult;
+    {
+        QMutexLocker mlkResources(&mtxResources);
+        renResult.reserve(hshResources.count());
+        for(const auto &r:hshResources)
+            renResult.append(r);
+    }
+    // Ranked by the average, so an asset on every page isn't ahead just ...
+    // ... for being loaded more often.
+    std::sort(
+        renResult.begin(),
+        renResult.end(),
+        [rkRanking](const ResourceEntry &renA,const ResourceEntry &renB) {
+            if(Ranking::RK_SLOWEST==rkRanking)
+                return renA.dTotalTime/renA.uiLoads>renB.dTotalTime/renB.uiLoads;
+            return double(renA.uiTotalBytes)/renA.uiLoads>double(renB.uiTotalBytes)/renB.uiLoads;
+        }
+    );
+    if(renResult.count()>iCount)
+        renResult.resize(iCount);
+    return renResult;
+}
+
+void ResourceStats::record(const QJsonArray &jsaResources) {
+    QMutexLocker mlkResources(&mtxResources);
+    for(const auto &v:jsaResources) {
+        QJsonArray jsaResource=v.toArray();
+        // Cache busters would make every load a resource of its own.
+        QString    sResource=QUrl(jsaResource.at(RESOURCE_FIELD_URL).toString()).adjusted(
+            QUrl::UrlFormattingOption::RemoveQuery|QUrl::UrlFormattingOption::RemoveFragment
+        ).toString();
+        double     dDuration=qMax(0.0,jsaResource.at(RESOURCE_FIELD_DURATION).toDouble());
+        quint64    uiBytes=quint64(qMax(0.0,jsaResource.at(RESOURCE_FIELD_BYTES).toDouble()));
+        auto       itEntry=hshResources.find(sResource);
+        if(hshResources.end()==itEntry) {
+            if(hshResources.count()>=RESOURCE_STATS_MAX)
+                continue;
+            itEntry=hshResources.insert(
+                sResource,
+                {sResource,jsaResource.at(RESOURCE_FIELD_TYPE).toString(),0,0.0,0.0,0,0}
+            );
+        }
+        itEntry->uiLoads++;
+        itEntry->dTotalTime+=dDuration;
+        itEntry->dMaxTime=qMax(itEntry->dMaxTime,dDuration);
+        itEntry->uiTotalBytes+=uiBytes;
+        itEntry->uiMaxBytes=qMax(itEntry->uiMaxBytes,uiBytes);
+    }
+}
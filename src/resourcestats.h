@@ -0,0 +1,30 @@
+#ifndef RESOURCESTATS_H
+#define RESOURCESTATS_H
+
+#include <QtCore>
+
+using ResourceEntry=struct {
+    QString sResource,
+            sType;
+    quint64 uiLoads;
+    double  dTotalTime,
+            dMaxTime;
+    quint64 uiTotalBytes,
+            uiMaxBytes;
+};
+
+using ResourceEntries=QVector<ResourceEntry>;
+
+class ResourceStats {
+public:
+    using Ranking=enum {
+        RK_SLOWEST,
+        RK_HEAVIEST
+    };
+    static void            beginRun();
+    static QString         getSummary(int);
+    static ResourceEntries getTop(Ranking,int);
+    static void            record(const QJsonArray &);
+};
+
+#endif // RESOURCESTATS_H
@@ -0,0 +1,110 @@
+#include "runplan.h"
+
+#include <random>
+
+#define RUN_PLAN_MAGIC   0x4D425250
+#define RUN_PLAN_VERSION 1
+
+QDataStream &operator<<(QDataStream &dstStream,const RunPlanHit &rphHit) {
+    return dstStream << rphHit.uiLink << rphHit.iProxy << rphHit.iAgent << rphHit.uiCooldown;
+}
+
+QDataStream &operator>>(QDataStream &dstStream,RunPlanHit &rphHit) {
+    return dstStream >> rphHit.uiLink >> rphHit.iProxy >> rphHit.iAgent >> rphHit.uiCooldown;
+}
+
+RunPlan RunPlanner::getPlan(quint64 uiSeed,
+                            quint32 uiHits,
+                            quint32 uiMaxDuration,
+                            uint    uiLinks,
+                            uint    uiProxies,
+                            uint    uiAgents,
+                            uint    uiMaxCooldown) {
+    RunPlan                         rplResult;
+    std::mt19937_64                 rngPlan(uiSeed);
+    // The engine's sequence is fixed by the standard, unlike the distributions, ...
+    // ... so the draws are reduced by hand to get the same plan from any build.
+    std::function<quint32(quint32)> fnDraw=[&rngPlan](quint32 uiBound) {
+        return quint32(rngPlan()%uiBound);
+    };
+    rplResult.uiSeed=uiSeed;
+    rplResult.uiMaxDuration=uiMaxDuration;
+    rplResult.uiLinks=uiLinks;
+    rplResult.uiProxies=uiProxies;
+    rplResult.uiAgents=uiAgents;
+    rplResult.vphHits.reserve(uiHits);
+    for(quint32 uiK=0;uiK<uiHits;uiK++) {
+        RunPlanHit rphHit;
+        rphHit.uiLink=uiLinks?fnDraw(uiLinks):0;
+        rphHit.iProxy=uiProxies?qint32(fnDraw(uiProxies)):-1;
+        rphHit.iAgent=uiAgents?qint32(fnDraw(uiAgents)):-1;
+        rphHit.uiCooldown=fnDraw(uiMaxCooldown+1);
+        rplResult.vphHits.append(rphHit);
+    }
+    return rplResult;
+}
+
+bool RunPlanner::readFromFile(QString sPath,RunPlan &rplPlan,QString &sError) {
+    quint16     uiVersion;
+    quint32     uiMagic;
+    QFile       fFile;
+    QDataStream dstStream;
+    sError.clear();
+    fFile.setFileName(sPath);
+    if(!fFile.open(QFile::OpenModeFlag::ReadOnly)) {
+        sError=fFile.errorString();
+        return false;
+    }
+    dstStream.setDevice(&fFile);
+    dstStream.setVersion(QDataStream::Version::Qt_5_15);
+    dstStream >> uiMagic >> uiVersion;
+    if(RUN_PLAN_MAGIC!=uiMagic||!uiVersion||RUN_PLAN_VERSION<uiVersion) {
+        sError=QStringLiteral("Not a valid run plan file");
+        return false;
+    }
+    dstStream >> rplPlan.uiSeed
+              >> rplPlan.uiMaxDuration
+              >> rplPlan.uiLinks
+              >> rplPlan.uiProxies
+              >> rplPlan.uiAgents
+              >> rplPlan.vphHits;
+    if(QDataStream::Status::Ok!=dstStream.status()) {
+        sError=QStringLiteral("Truncated or corrupt run plan file");
+        return false;
+    }
+    // Indexes are checked once here, so the engine can trust them blindly.
+    for(const auto &h:rplPlan.vphHits)
+        if(h.uiLink>=qMax(rplPlan.uiLinks,1u)||
+           h.iProxy<-1||h.iProxy>=qint32(rplPlan.uiProxies)||
+           h.iAgent<-1||h.iAgent>=qint32(rplPlan.uiAgents)) {
+            sError=QStringLiteral("The run plan has out of range hits");
+            return false;
+        }
+    return true;
+}
+
+bool RunPlanner::writeToFile(QString sPath,const RunPlan &rplPlan,QString &sError) {
+    QSaveFile   sflFile;
+    QDataStream dstStream;
+    sError.clear();
+    sflFile.setFileName(sPath);
+    if(!sflFile.open(QFile::OpenModeFlag::WriteOnly)) {
+        sError=sflFile.errorString();
+        return false;
+    }
+    dstStream.setDevice(&sflFile);
+    dstStream.setVersion(QDataStream::Version::Qt_5_15);
+    dstStream << quint32(RUN_PLAN_MAGIC)
+              << quint16(RUN_PLAN_VERSION)
+              << rplPlan.uiSeed
+              << rplPlan.uiMaxDuration
+              << rplPlan.uiLinks
+              << rplPlan.uiProxies
+              << rplPlan.uiAgents
+              << rplPlan.vphHits;
+    if(!sflFile.commit()) {
+        sError=sflFile.errorString();
+        return false;
+    }
+    return true;
+}
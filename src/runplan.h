@@ -0,0 +1,29 @@
+#ifndef RUNPLAN_H
+#define RUNPLAN_H
+
+#include <QtCore>
+
+using RunPlanHit=struct {
+    quint32 uiLink;
+    qint32  iProxy,
+            iAgent;
+    quint32 uiCooldown;
+};
+
+using RunPlan=struct {
+    quint64             uiSeed;
+    quint32             uiMaxDuration,
+                        uiLinks,
+                        uiProxies,
+                        uiAgents;
+    QVector<RunPlanHit> vphHits;
+};
+
+class RunPlanner {
+public:
+    static RunPlan getPlan(quint64,quint32,quint32,uint,uint,uint,uint);
+    static bool    readFromFile(QString,RunPlan &,QString &);
+    static bool    writeToFile(QString,const RunPlan &,QString &);
+};
+
+#endif // RUNPLAN_H
@@ -0,0 +1,67 @@
+#include "scenarioparser.h"
+
+/**
+ * @brief Parses a JSON scenario: the ordered steps every virtual user runs.
+ *
+ * {
+ *     "steps": [
+ *         {
+ *             "name":    "login",                      (optional)
+ *             "method":  "POST",                       (optional, GET)
+ *             "url":     "https://staging.example/login",
+ *             "headers": {"Content-Type": "application/x-www-form-urlencoded"},
+ *             "body":    "user=john&pass=secret",      (optional)
+ *             "think":   1500                          (optional, ms)
+ *         },
+ *         ...
+ *     ]
+ * }
+ *
+ * The think-time is waited before the step's request is sent.
+ */
+bool ScenarioParser::getStepsFromText(QString          sText,
+                                      ScenarioStepList &sslSteps,
+                                      QString          &sError) {
+    QJsonParseError jpeError;
+    QJsonDocument   jsnDoc=QJsonDocument::fromJson(sText.toUtf8(),&jpeError);
+    QJsonArray      jsnSteps;
+    sslSteps.clear();
+    sError.clear();
+    if(QJsonParseError::ParseError::NoError!=jpeError.error) {
+        sError=QStringLiteral("Invalid scenario: %1").arg(jpeError.errorString());
+        return false;
+    }
+    jsnSteps=jsnDoc.object().value(QStringLiteral("steps")).toArray();
+    if(jsnSteps.isEmpty()) {
+        sError=QStringLiteral("The scenario has no steps");
+        return false;
+    }
+    for(int iK=0;iK<jsnSteps.count();iK++) {
+        QJsonObject  jsnStep=jsnSteps.at(iK).toObject(),
+                     jsnHeaders=jsnStep.value(QStringLiteral("headers")).toObject();
+        ScenarioStep ssStep;
+        QString      sScheme;
+        ssStep.urlLink.setUrl(jsnStep.value(QStringLiteral("url")).toString().trimmed());
+        sScheme=ssStep.urlLink.scheme().toLower();
+        if(!ssStep.urlLink.isValid()||
+           (sScheme!=QStringLiteral("http")&&sScheme!=QStringLiteral("https"))) {
+            sError=QStringLiteral("Step %1 has an invalid URL").arg(iK+1);
+            return false;
+        }
+        ssStep.sName=jsnStep.value(QStringLiteral("name")).toString(
+            QStringLiteral("Step %1").arg(iK+1)
+        );
+        ssStep.bytMethod=jsnStep.value(QStringLiteral("method")).toString(
+            QStringLiteral("GET")
+        ).toUpper().toLatin1();
+        ssStep.bytBody=jsnStep.value(QStringLiteral("body")).toString().toUtf8();
+        for(const auto &k:jsnHeaders.keys())
+            ssStep.lpHeaders.append({
+                k.toLatin1(),
+                jsnHeaders.value(k).toString().toLatin1()
+            });
+        ssStep.uiThinkTime=qMax(0,jsnStep.value(QStringLiteral("think")).toInt());
+        sslSteps.append(ssStep);
+    }
+    return true;
+}
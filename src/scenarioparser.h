@@ -0,0 +1,22 @@
+#ifndef SCENARIOPARSER_H
+#define SCENARIOPARSER_H
+
+#include <QtCore>
+
+using ScenarioStep=struct {
+    QString                             sName;
+    QByteArray                          bytMethod,
+                                        bytBody;
+    QUrl                                urlLink;
+    QList<QPair<QByteArray,QByteArray>> lpHeaders;
+    uint                                uiThinkTime;
+};
+
+using ScenarioStepList=QVector<ScenarioStep>;
+
+class ScenarioParser {
+public:
+    static bool getStepsFromText(QString,ScenarioStepList &,QString &);
+};
+
+#endif // SCENARIOPARSER_H
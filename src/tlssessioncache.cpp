@@ -0,0 +1,110 @@
+#include "tlssessioncache.h"
+
+#include <atomic>
+
+// Hosts (times proxies) remembered. Past it, only the known ones are renewed.
+#define SESSION_CACHE_MAX 65536
+
+#define HANDSHAKE_NAMES { \
+    "none", \
+    "full", \
+    "ticket_offered" \
+}
+
+// One process-wide cache, shared by every loop and session, so a host met ...
+// ... by any of them resumes in all the others. Tickets are kept per host ...
+// ... and proxy, since a ticket is only good for the server that issued it.
+
+static const char *const            szNames[TlsSessionCache::Handshake::HS_TOTAL]=HANDSHAKE_NAMES;
+static std::atomic<bool>            bEnabled{true};
+static std::atomic<quint64>         uiCounts[TlsSessionCache::Handshake::HS_TOTAL];
+static QReadWriteLock               rwlTickets;
+static QHash<QByteArray,QByteArray> hshTickets;
+
+static QByteArray getKey(const QUrl &urlLink,int iProxy) {
+    return urlLink.host().toUtf8()+':'+QByteArray::number(urlLink.port(443))+'|'+QByteArray::number(iProxy);
+}
+
+void TlsSessionCache::beginRun(bool bNewEnabled) {
+    QWriteLocker wlkTickets(&rwlTickets);
+    // Each run starts cold, so the first handshakes are comparable.
+    hshTickets.clear();
+    bEnabled=bNewEnabled;
+}
+
+TlsSessionCache::Handshake TlsSessionCache::finish(const QSslConfiguration &sslConfiguration,
+                                                   const QUrl              &urlLink,
+                                                   int                     iProxy,
+                                                   bool                    bOffered) {
+    QByteArray bytTicket;
+    // Qt doesn't tell whether the server took the ticket, so only the ...
+    // ... offer is reported: a refused one falls back to a full handshake.
+    Handshake  hsResult=bOffered?Handshake::HS_TICKET_OFFERED:Handshake::HS_FULL;
+    uiCounts[hsResult].fetch_add(1,std::memory_order_relaxed);
+    if(bEnabled.load(std::memory_order_relaxed)) {
+        // TLS 1.3 sends its tickets after the handshake, so they're only ...
+        // ... looked for once a response is in.
+        bytTicket=sslConfiguration.sessionTicket();
+        if(!bytTicket.isEmpty()) {
+            QByteArray   bytKey=getKey(urlLink,iProxy);
+            QWriteLocker wlkTickets(&rwlTickets);
+            if(hshTickets.count()<SESSION_CACHE_MAX||hshTickets.contains(bytKey))
+                hshTickets.insert(bytKey,bytTicket);
+        }
+    }
+    return hsResult;
+}
+
+TlsSessionCache::Handshake TlsSessionCache::finish(QNetworkReply *nrpReply,
+                                                   int           iProxy,
+                                                   bool          bOffered,
+                                                   bool          bEncrypted) {
+    // Replies riding a kept-alive connection did no handshake at all.
+    if(!bEncrypted)
+        return Handshake::HS_NONE;
+    return TlsSessionCache::finish(nrpReply->sslConfiguration(),nrpReply->request().url(),iProxy,bOffered);
+}
+
+quint64 TlsSessionCache::getCount(Handshake hsHandshake) {
+    return uiCounts[hsHandshake].load(std::memory_order_relaxed);
+}
+
+QString TlsSessionCache::getName(Handshake hsHandshake) {
+    return QLatin1String(szNames[hsHandshake]);
+}
+
+bool TlsSessionCache::isEnabled() {
+    return bEnabled.load(std::memory_order_relaxed);
+}
+
+bool TlsSessionCache::prepare(QSslConfiguration &sslConfiguration,const QUrl &urlLink,int iProxy) {
+    QByteArray bytTicket;
+    if(bEnabled.load(std::memory_order_relaxed)) {
+        // Persistence is what makes Qt hand the tickets out at all.
+        sslConfiguration.setSslOption(QSsl::SslOption::SslOptionDisableSessionPersistence,false);
+        {
+            QReadLocker rlkTickets(&rwlTickets);
+            bytTicket=hshTickets.value(getKey(urlLink,iProxy));
+        }
+        if(!bytTicket.isEmpty())
+            sslConfiguration.setSessionTicket(bytTicket);
+    }
+    else {
+        // Not even the connections to the same host share their sessions, ...
+        // ... so every new connection pays for a full handshake.
+        sslConfiguration.setSslOption(QSsl::SslOption::SslOptionDisableSessionTickets,true);
+        sslConfiguration.setSslOption(QSsl::SslOption::SslOptionDisableSessionSharing,true);
+    }
+    return !bytTicket.isEmpty();
+}
+
+bool TlsSessionCache::prepare(QNetworkRequest &nrqRequest,int iProxy) {
+    QSslConfiguration sslConfiguration;
+    bool              bOffered;
+    if(QStringLiteral("https")!=nrqRequest.url().scheme())
+        return false;
+    sslConfiguration=nrqRequest.sslConfiguration();
+    bOffered=TlsSessionCache::prepare(sslConfiguration,nrqRequest.url(),iProxy);
+    nrqRequest.setSslConfiguration(sslConfiguration);
+    return bOffered;
+}
@@ -0,0 +1,25 @@
+#ifndef TLSSESSIONCACHE_H
+#define TLSSESSIONCACHE_H
+
+#include <QtCore>
+#include <QtNetwork>
+
+class TlsSessionCache {
+public:
+    using Handshake=enum {
+        HS_NONE,
+        HS_FULL,
+        HS_TICKET_OFFERED,
+        HS_TOTAL
+    };
+    static void      beginRun(bool);
+    static Handshake finish(const QSslConfiguration &,const QUrl &,int,bool);
+    static Handshake finish(QNetworkReply *,int,bool,bool);
+    static quint64   getCount(Handshake);
+    static QString   getName(Handshake);
+    static bool      isEnabled();
+    static bool      prepare(QSslConfiguration &,const QUrl &,int);
+    static bool      prepare(QNetworkRequest &,int);
+};
+
+#endif // TLSSESSIONCACHE_H
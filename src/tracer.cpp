@@ -0,0 +1,200 @@
+#include "tracer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+// Number of events kept, a power of two. Older ones are overwritten.
+#define TRACE_CAPACITY 65536
+
+// Every slot is a tiny seqlock: writers claim one with a single atomic ...
+// ... increment and readers skip those caught in the middle of a write, ...
+// ... so recording never blocks nor allocates.
+using TraceSlot=struct {
+    std::atomic<quint64> uiSequence,
+                         uiTimestamp,
+                         uiTraceId;
+    std::atomic<quint32> uiEvent,
+                         uiThread;
+    std::atomic<qint32>  iLink,
+                         iProxy;
+};
+
+using TraceRecord=struct {
+    quint64 uiSequence,
+            uiTimestamp,
+            uiTraceId;
+    quint32 uiEvent,
+            uiThread;
+    qint32  iLink,
+            iProxy;
+};
+
+static TraceSlot            tslSlots[TRACE_CAPACITY];
+static std::atomic<quint64> uiNextSlot{0},
+                            uiNextSample{0};
+static std::atomic<quint32> uiNextThread{0},
+                            uiSampling{0};
+static std::atomic<qint64>  iOrigin{0};
+
+static qint64 getNow() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+static quint32 getThread() {
+    // Small and stable ids read better in the viewer than native handles.
+    static thread_local quint32 uiThread=uiNextThread.fetch_add(1,std::memory_order_relaxed)+1;
+    return uiThread;
+}
+
+static QJsonObject getJsonEvent(const TraceRecord &trcRecord,const char *szPhase,const char *szName) {
+    return {
+        {QStringLiteral("name"),QLatin1String(szName)},
+        {QStringLiteral("cat"),QStringLiteral("hit")},
+        {QStringLiteral("ph"),QLatin1String(szPhase)},
+        {QStringLiteral("id"),QStringLiteral("0x%1").arg(trcRecord.uiTraceId,0,16)},
+        {QStringLiteral("ts"),double(trcRecord.uiTimestamp)},
+        {QStringLiteral("pid"),1},
+        {QStringLiteral("tid"),double(trcRecord.uiThread)}
+    };
+}
+
+void Tracer::beginRun(uint uiNewSampling) {
+    for(auto &s:tslSlots)
+        s.uiSequence.store(0,std::memory_order_relaxed);
+    uiNextSlot=0;
+    uiNextSample=0;
+    iOrigin=getNow();
+    uiSampling=uiNewSampling;
+}
+
+void Tracer::record(quint64 uiTraceId,TraceEvent tevEvent,qint32 iLink,qint32 iProxy) {
+    quint64   uiTicket;
+    TraceSlot *tslSlot;
+    // Hits left out of the sample cost a single comparison.
+    if(!uiTraceId)
+        return;
+    uiTicket=uiNextSlot.fetch_add(1,std::memory_order_relaxed);
+    tslSlot=&tslSlots[uiTicket&(TRACE_CAPACITY-1)];
+    tslSlot->uiSequence.store(0,std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    tslSlot->uiTimestamp.store(getNow()-iOrigin.load(std::memory_order_relaxed),std::memory_order_relaxed);
+    tslSlot->uiTraceId.store(uiTraceId,std::memory_order_relaxed);
+    tslSlot->uiEvent.store(tevEvent,std::memory_order_relaxed);
+    tslSlot->uiThread.store(getThread(),std::memory_order_relaxed);
+    tslSlot->iLink.store(iLink,std::memory_order_relaxed);
+    tslSlot->iProxy.store(iProxy,std::memory_order_relaxed);
+    tslSlot->uiSequence.store(uiTicket+1,std::memory_order_release);
+}
+
+quint64 Tracer::sample() {
+    quint32 uiRate=uiSampling.load(std::memory_order_relaxed);
+    quint64 uiHit;
+    if(!uiRate)
+        return 0;
+    // One in every N hits, so the sample is spread evenly over the run.
+    uiHit=uiNextSample.fetch_add(1,std::memory_order_relaxed);
+    return uiHit%uiRate?0:uiHit+1;
+}
+
+void Tracer::setSampling(uint uiNewSampling) {
+    uiSampling=uiNewSampling;
+}
+
+bool Tracer::writeToFile(QString sPath,QString &sError) {
+    QVector<TraceRecord> vtrcRecords;
+    QJsonArray           jsaEvents;
+    QSaveFile            sflFile;
+    sError.clear();
+    vtrcRecords.reserve(TRACE_CAPACITY);
+    for(auto &s:tslSlots) {
+        TraceRecord trcRecord;
+        trcRecord.uiSequence=s.uiSequence.load(std::memory_order_acquire);
+        if(!trcRecord.uiSequence)
+            continue;
+        trcRecord.uiTimestamp=s.uiTimestamp.load(std::memory_order_relaxed);
+        trcRecord.uiTraceId=s.uiTraceId.load(std::memory_order_relaxed);
+        trcRecord.uiEvent=s.uiEvent.load(std::memory_order_relaxed);
+        trcRecord.uiThread=s.uiThread.load(std::memory_order_relaxed);
+        trcRecord.iLink=s.iLink.load(std::memory_order_relaxed);
+        trcRecord.iProxy=s.iProxy.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // Overwritten while being read: it belongs to a newer event.
+        if(s.uiSequence.load(std::memory_order_relaxed)==trcRecord.uiSequence)
+            vtrcRecords.append(trcRecord);
+    }
+    std::sort(
+        vtrcRecords.begin(),
+        vtrcRecords.end(),
+        [](const TraceRecord &trcLeft,const TraceRecord &trcRight) {
+            return trcLeft.uiSequence<trcRight.uiSequence;
+        }
+    );
+    // Async events, keyed by hit, since a hit hops between threads.
+    for(const auto &r:vtrcRecords)
+        switch(r.uiEvent) {
+            case TraceEvent::TE_SCHEDULED: {
+                QJsonObject jsoEvent=getJsonEvent(r,"b","hit");
+                jsoEvent.insert(
+                    QStringLiteral("args"),
+                    QJsonObject({
+                        {QStringLiteral("link"),r.iLink},
+                        {QStringLiteral("proxy"),r.iProxy}
+                    })
+                );
+                jsaEvents.append(jsoEvent);
+                break;
+            }
+            case TraceEvent::TE_WAIT_BEGIN:
+                jsaEvents.append(getJsonEvent(r,"b","wait"));
+                break;
+            case TraceEvent::TE_WAIT_END:
+                jsaEvents.append(getJsonEvent(r,"e","wait"));
+                break;
+            case TraceEvent::TE_STARTED:
+                jsaEvents.append(getJsonEvent(r,"b","request"));
+                break;
+            case TraceEvent::TE_CONNECTED:
+                jsaEvents.append(getJsonEvent(r,"n","connected"));
+                break;
+            case TraceEvent::TE_ENCRYPTED:
+                jsaEvents.append(getJsonEvent(r,"n","TLS ready"));
+                break;
+            case TraceEvent::TE_TICKET_OFFERED:
+                jsaEvents.append(getJsonEvent(r,"n","TLS ready, ticket offered"));
+                break;
+            case TraceEvent::TE_FIRST_BYTE:
+                jsaEvents.append(getJsonEvent(r,"n","first byte"));
+                break;
+            case TraceEvent::TE_FINISHED:
+                jsaEvents.append(getJsonEvent(r,"e","request"));
+                break;
+            case TraceEvent::TE_UI_BEGIN:
+                jsaEvents.append(getJsonEvent(r,"b","UI update"));
+                break;
+            case TraceEvent::TE_UI_END:
+                jsaEvents.append(getJsonEvent(r,"e","UI update"));
+                jsaEvents.append(getJsonEvent(r,"e","hit"));
+                break;
+        }
+    sflFile.setFileName(sPath);
+    if(!sflFile.open(QFile::OpenModeFlag::WriteOnly)) {
+        sError=sflFile.errorString();
+        return false;
+    }
+    sflFile.write(
+        QJsonDocument(
+            QJsonObject({
+                {QStringLiteral("traceEvents"),jsaEvents},
+                {QStringLiteral("displayTimeUnit"),QStringLiteral("ms")}
+            })
+        ).toJson(QJsonDocument::JsonFormat::Compact)
+    );
+    if(!sflFile.commit()) {
+        sError=sflFile.errorString();
+        return false;
+    }
+    return true;
+}
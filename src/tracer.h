@@ -0,0 +1,28 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QtCore>
+
+class Tracer {
+public:
+    using TraceEvent=enum {
+        TE_SCHEDULED,
+        TE_WAIT_BEGIN,
+        TE_WAIT_END,
+        TE_STARTED,
+        TE_CONNECTED,
+        TE_ENCRYPTED,
+        TE_TICKET_OFFERED,
+        TE_FIRST_BYTE,
+        TE_FINISHED,
+        TE_UI_BEGIN,
+        TE_UI_END
+    };
+    static void    beginRun(uint);
+    static void    record(quint64,TraceEvent,qint32=-1,qint32=-1);
+    static quint64 sample();
+    static void    setSampling(uint);
+    static bool    writeToFile(QString,QString &);
+};
+
+#endif // TRACER_H
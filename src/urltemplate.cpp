@@ -0,0 +1,110 @@
+#include "urltemplate.h"
+
+#include <algorithm>
+
+// Room kept per placeholder when expanding, so most URLs are built without ...
+// ... growing their buffer.
+#define PLACEHOLDER_RESERVE 20
+
+QUrl UrlTemplate::expand(LinkTemplatePtr ltpTemplate) {
+    QString          sResult;
+    QRandomGenerator *rngValues=QRandomGenerator::global();
+    sResult.reserve(ltpTemplate->sText.size()+ltpTemplate->vtpPlaceholders.count()*PLACEHOLDER_RESERVE);
+    // Every placeholder is picked on its own, uniformly, each time a hit ...
+    // ... is about to be sent: nothing is ever enumerated.
+    for(int iK=0;iK<ltpTemplate->vtpPlaceholders.count();iK++) {
+        const TemplatePlaceholder &tphPlaceholder=ltpTemplate->vtpPlaceholders.at(iK);
+        sResult.append(ltpTemplate->slLiterals.at(iK));
+        if(PlaceholderKind::PK_RANGE==tphPlaceholder.pkKind) {
+            quint64 uiSpan=tphPlaceholder.uiLast-tphPlaceholder.uiFirst+1,
+                    uiValue=rngValues->generate64();
+            // A span that wraps around is the whole 64-bit range.
+            if(uiSpan)
+                uiValue=tphPlaceholder.uiFirst+uiValue%uiSpan;
+            sResult.append(QString::number(uiValue).rightJustified(tphPlaceholder.iWidth,QLatin1Char('0')));
+        }
+        else if(PlaceholderKind::PK_LIST==tphPlaceholder.pkKind)
+            sResult.append(tphPlaceholder.slValues.at(rngValues->bounded(tphPlaceholder.slValues.count())));
+        else
+            sResult.append(QString::number(rngValues->generate()));
+    }
+    sResult.append(ltpTemplate->slLiterals.last());
+    return QUrl(sResult);
+}
+
+/**
+ * @brief Parses the placeholders of a link, if it has any.
+ *
+ * https://cdn.example/item/{1..5000000}?v={rand}&lang={en,fr,de}
+ *
+ * {A..B}     an integer from A to B, both included (zero-padded to the
+ *            width of A, when A starts with a zero: {001..999})
+ * {X,Y,...}  one of the given values
+ * {rand}     a random 32-bit number
+ *
+ * Links with no placeholders aren't templates, and leave the pointer null.
+ * Literal braces go percent-encoded (%7B, %7D).
+ */
+bool UrlTemplate::getTemplateFromText(QString sText,LinkTemplatePtr &ltpTemplate,QString &sError) {
+    static const QRegularExpression rxRange(QStringLiteral("^(\\d+)\\.\\.(\\d+)$"));
+    QSharedPointer<LinkTemplate>    ltResult(new LinkTemplate());
+    int                             iPos=0,
+                                    iOpen;
+    ltpTemplate.reset();
+    sError.clear();
+    ltResult->sText=sText;
+    while((iOpen=sText.indexOf(QLatin1Char('{'),iPos))>=0) {
+        int                     iClose=sText.indexOf(QLatin1Char('}'),iOpen+1);
+        QString                 sBody;
+        QRegularExpressionMatch rxmRange;
+        TemplatePlaceholder     tphPlaceholder={PlaceholderKind::PK_RANDOM,0,0,0,{}};
+        if(iClose<0) {
+            sError=QStringLiteral("Unclosed placeholder");
+            return false;
+        }
+        ltResult->slLiterals.append(sText.mid(iPos,iOpen-iPos));
+        sBody=sText.mid(iOpen+1,iClose-iOpen-1);
+        iPos=iClose+1;
+        if(sBody.contains(QLatin1Char('{'))) {
+            sError=QStringLiteral("Nested placeholder: {%1}").arg(sBody);
+            return false;
+        }
+        rxmRange=rxRange.match(sBody);
+        if(rxmRange.hasMatch()) {
+            bool bFirstOK,
+                 bLastOK;
+            tphPlaceholder.pkKind=PlaceholderKind::PK_RANGE;
+            tphPlaceholder.uiFirst=rxmRange.captured(1).toULongLong(&bFirstOK);
+            tphPlaceholder.uiLast=rxmRange.captured(2).toULongLong(&bLastOK);
+            if(!bFirstOK||!bLastOK||tphPlaceholder.uiFirst>tphPlaceholder.uiLast) {
+                sError=QStringLiteral("Invalid range: {%1}").arg(sBody);
+                return false;
+            }
+            if(rxmRange.captured(1).size()>1&&rxmRange.captured(1).startsWith(QLatin1Char('0')))
+                tphPlaceholder.iWidth=rxmRange.captured(1).size();
+        }
+        else if(sBody.contains(QLatin1Char(','))) {
+            tphPlaceholder.pkKind=PlaceholderKind::PK_LIST;
+            tphPlaceholder.slValues=sBody.split(QLatin1Char(','));
+        }
+        else if(QStringLiteral("rand")!=sBody) {
+            sError=QStringLiteral("Unknown placeholder: {%1}").arg(sBody);
+            return false;
+        }
+        ltResult->vtpPlaceholders.append(tphPlaceholder);
+    }
+    ltResult->slLiterals.append(sText.mid(iPos));
+    if(std::any_of(
+        ltResult->slLiterals.constBegin(),
+        ltResult->slLiterals.constEnd(),
+        [](const QString &sLiteral) {
+            return sLiteral.contains(QLatin1Char('}'));
+        }
+    )) {
+        sError=QStringLiteral("Unmatched closing brace");
+        return false;
+    }
+    if(!ltResult->vtpPlaceholders.isEmpty())
+        ltpTemplate=ltResult;
+    return true;
+}
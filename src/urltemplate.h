@@ -0,0 +1,34 @@
+#ifndef URLTEMPLATE_H
+#define URLTEMPLATE_H
+
+#include <QtCore>
+
+using PlaceholderKind=enum {
+    PK_RANGE,
+    PK_LIST,
+    PK_RANDOM
+};
+
+using TemplatePlaceholder=struct {
+    PlaceholderKind pkKind;
+    quint64         uiFirst,
+                    uiLast;
+    int             iWidth;
+    QStringList     slValues;
+};
+
+using LinkTemplate=struct {
+    QString                      sText;
+    QStringList                  slLiterals;
+    QVector<TemplatePlaceholder> vtpPlaceholders;
+};
+
+using LinkTemplatePtr=QSharedPointer<const LinkTemplate>;
+
+class UrlTemplate {
+public:
+    static QUrl expand(LinkTemplatePtr);
+    static bool getTemplateFromText(QString,LinkTemplatePtr &,QString &);
+};
+
+#endif // URLTEMPLATE_H
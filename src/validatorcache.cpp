@@ -0,0 +1,100 @@
+#include "validatorcache.h"
+
+#define VALIDATOR_CACHE_MAGIC   0x4D425643
+#define VALIDATOR_CACHE_VERSION 1
+
+// Only the validators (and the size of the body they stand for) are kept, ...
+// ... never the bodies: a 304 is all a returning visitor needs to look real.
+
+QDataStream &operator<<(QDataStream &dstStream,const CachedValidators &cvValidators) {
+    return dstStream << cvValidators.bytETag << cvValidators.bytLastModified << cvValidators.uiSize;
+}
+
+QDataStream &operator>>(QDataStream &dstStream,CachedValidators &cvValidators) {
+    return dstStream >> cvValidators.bytETag >> cvValidators.bytLastModified >> cvValidators.uiSize;
+}
+
+void ValidatorCache::clear() {
+    QWriteLocker wlkValidators(&rwlValidators);
+    hshValidators.clear();
+}
+
+int ValidatorCache::count() {
+    QReadLocker rlkValidators(&rwlValidators);
+    return hshValidators.count();
+}
+
+bool ValidatorCache::get(const QByteArray &bytUrl,CachedValidators &cvValidators) {
+    QReadLocker rlkValidators(&rwlValidators);
+    auto        itValidators=hshValidators.constFind(bytUrl);
+    if(hshValidators.constEnd()==itValidators)
+        return false;
+    cvValidators=itValidators.value();
+    return true;
+}
+
+void ValidatorCache::put(const QByteArray &bytUrl,const CachedValidators &cvValidators) {
+    QWriteLocker wlkValidators(&rwlValidators);
+    hshValidators.insert(bytUrl,cvValidators);
+}
+
+bool ValidatorCache::readFromFile(QString sPath,QString &sError) {
+    quint16                            uiVersion;
+    quint32                            uiMagic;
+    QFile                              fFile;
+    QDataStream                        dstStream;
+    QHash<QByteArray,CachedValidators> hshRead;
+    sError.clear();
+    fFile.setFileName(sPath);
+    if(!fFile.open(QFile::OpenModeFlag::ReadOnly)) {
+        sError=fFile.errorString();
+        return false;
+    }
+    dstStream.setDevice(&fFile);
+    dstStream.setVersion(QDataStream::Version::Qt_5_15);
+    dstStream >> uiMagic >> uiVersion;
+    if(VALIDATOR_CACHE_MAGIC!=uiMagic||!uiVersion||VALIDATOR_CACHE_VERSION<uiVersion) {
+        sError=QStringLiteral("Not a valid validator cache file");
+        return false;
+    }
+    dstStream >> hshRead;
+    if(QDataStream::Status::Ok!=dstStream.status()) {
+        sError=QStringLiteral("Truncated or corrupt validator cache file");
+        return false;
+    }
+    QWriteLocker wlkValidators(&rwlValidators);
+    hshValidators=hshRead;
+    return true;
+}
+
+void ValidatorCache::remove(const QByteArray &bytUrl) {
+    QWriteLocker wlkValidators(&rwlValidators);
+    hshValidators.remove(bytUrl);
+}
+
+bool ValidatorCache::writeToFile(QString sPath,QString &sError) {
+    QSaveFile                          sflFile;
+    QDataStream                        dstStream;
+    QHash<QByteArray,CachedValidators> hshWritten;
+    sError.clear();
+    // Copied first, so the loops aren't kept waiting on the disk.
+    {
+        QReadLocker rlkValidators(&rwlValidators);
+        hshWritten=hshValidators;
+    }
+    sflFile.setFileName(sPath);
+    if(!sflFile.open(QFile::OpenModeFlag::WriteOnly)) {
+        sError=sflFile.errorString();
+        return false;
+    }
+    dstStream.setDevice(&sflFile);
+    dstStream.setVersion(QDataStream::Version::Qt_5_15);
+    dstStream << quint32(VALIDATOR_CACHE_MAGIC)
+              << quint16(VALIDATOR_CACHE_VERSION)
+              << hshWritten;
+    if(!sflFile.commit()) {
+        sError=sflFile.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,26 @@
+#ifndef VALIDATORCACHE_H
+#define VALIDATORCACHE_H
+
+#include <QtCore>
+
+using CachedValidators=struct {
+    QByteArray bytETag,
+               bytLastModified;
+    quint64    uiSize;
+};
+
+class ValidatorCache {
+public:
+    void clear();
+    int  count();
+    bool get(const QByteArray &,CachedValidators &);
+    void put(const QByteArray &,const CachedValidators &);
+    bool readFromFile(QString,QString &);
+    void remove(const QByteArray &);
+    bool writeToFile(QString,QString &);
+private:
+    QReadWriteLock                     rwlValidators;
+    QHash<QByteArray,CachedValidators> hshValidators;
+};
+
+#endif // VALIDATORCACHE_H